@@ -503,6 +503,12 @@
 /* Define to 1 if you have the <search.h> header file. */
 //#define HAVE_SEARCH_H 1
 
+/* Define to 1 if you have the `sendfile' function. */
+/* #undef HAVE_SENDFILE */
+
+/* Define to 1 if you have the `sendmmsg' function. */
+/* #undef HAVE_SENDMMSG */
+
 /* Define to 1 if you have the `sendmsg' function. */
 /* #undef HAVE_SENDMSG */
 
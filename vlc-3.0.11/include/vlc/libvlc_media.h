@@ -637,6 +637,47 @@ LIBVLC_API libvlc_state_t libvlc_media_get_state(
 LIBVLC_API int libvlc_media_get_stats( libvlc_media_t *p_md,
                                            libvlc_media_stats_t *p_stats );
 
+/**
+ * Media latency measurements
+ * \see libvlc_media_get_latency()
+ */
+typedef enum libvlc_media_latency_t
+{
+    /** Time compressed data waits before being decoded */
+    libvlc_media_latency_demux_decode,
+    /** Time from compressed data to the next decoded frame */
+    libvlc_media_latency_decode,
+    /** Time decoded frames wait before being displayed or played */
+    libvlc_media_latency_decode_display,
+} libvlc_media_latency_t;
+
+/** Number of buckets of a latency histogram */
+#define LIBVLC_MEDIA_LATENCY_BUCKETS 24
+
+/**
+ * Get a latency histogram of the media
+ *
+ * Bucket n of the histogram is the number of samples of at least 2^n and
+ * less than 2^(n+1) microseconds. The first bucket also counts the shorter
+ * samples, and the last one the longer samples.
+ *
+ * Like libvlc_media_get_stats(), this only reads the statistics last
+ * aggregated by the input (a few times per second), so it can be called
+ * often without slowing down playback.
+ *
+ * \param p_md: media descriptor object
+ * \param i_latency: the latency to get
+ * \param p_buckets: array of LIBVLC_MEDIA_LATENCY_BUCKETS counts
+ *                   (this array must be allocated by the caller)
+ * \return true if the statistics are available, false otherwise
+ *
+ * \libvlc_return_bool
+ * \version LibVLC 3.0.12 and later.
+ */
+LIBVLC_API int libvlc_media_get_latency( libvlc_media_t *p_md,
+                                         libvlc_media_latency_t i_latency,
+                                         uint64_t *p_buckets );
+
 /* The following method uses libvlc_media_list_t, however, media_list usage is optionnal
  * and this is here for convenience */
 #define VLC_FORWARD_DECLARE_OBJECT(a) struct a
@@ -290,6 +290,50 @@ LIBVLC_API void libvlc_media_player_stop ( libvlc_media_player_t *p_mi );
 LIBVLC_API int libvlc_media_player_set_renderer( libvlc_media_player_t *p_mi,
                                                  libvlc_renderer_item_t *p_item );
 
+/**
+ * Open a media in warm standby
+ *
+ * The media is opened in the background and its last few seconds are kept
+ * (but not decoded nor displayed), so that playing it later with
+ * libvlc_media_player_set_media() and libvlc_media_player_play() starts
+ * almost instantly, reusing the video and audio outputs of the player. This
+ * is meant for live streams, e.g. to keep the previous and next channels
+ * ready for zapping. For other media, only their beginning is read.
+ *
+ * The kept data is only decoded once the media is played (as preroll, up
+ * to the last keyframe), since the decoders would otherwise compete with the
+ * playing media for the outputs; switching thus costs a burst of decoding.
+ *
+ * The media stays in standby until it is played, or until
+ * libvlc_media_player_remove_standby() is called. The media player does not
+ * send events for media in standby.
+ *
+ * Media cannot be opened in standby while a renderer is set or with a
+ * stream output (":sout" option).
+ *
+ * \see the "standby-gop" option to set how much of the stream is kept
+ *
+ * \param p_mi the Media Player
+ * \param p_md the media to open (the media player keeps a reference)
+ * \return 0 on success (or if the media is already in standby), -1 on error
+ * (including when a renderer or a stream output is used).
+ * \version LibVLC 3.0.12 and later.
+ */
+LIBVLC_API int libvlc_media_player_add_standby( libvlc_media_player_t *p_mi,
+                                                libvlc_media_t *p_md );
+
+/**
+ * Close a media opened in warm standby
+ *
+ * \see libvlc_media_player_add_standby
+ *
+ * \param p_mi the Media Player
+ * \param p_md the media (no effect if it is not in standby)
+ * \version LibVLC 3.0.12 and later.
+ */
+LIBVLC_API void libvlc_media_player_remove_standby( libvlc_media_player_t *p_mi,
+                                                    libvlc_media_t *p_md );
+
 /**
  * Callback prototype to allocate and lock a picture buffer.
  *
@@ -257,6 +257,42 @@ VLC_API block_t *block_mmap_Alloc(void *addr, size_t length) VLC_USED VLC_MALLOC
  */
 VLC_API block_t * block_shm_Alloc(void *addr, size_t length) VLC_USED VLC_MALLOC;
 
+/**
+ * Wraps a block in a shared block.
+ *
+ * Creates a @ref block_t whose payload can be referenced by several blocks
+ * at once with block_Share(), without copying it. The payload of a shared
+ * block must be treated as read-only: block_TryRealloc() and block_Realloc()
+ * copy it before extending it if it is still referenced by other blocks.
+ *
+ * The metadata (timestamps, flags...) of each shared block are its own.
+ *
+ * @param block block to wrap (will be released with the last shared block)
+ * @return NULL in case of error (block released in that case), or a valid
+ * block_t pointer.
+ */
+VLC_API block_t *block_shared_Alloc(block_t *block) VLC_USED VLC_MALLOC;
+
+/**
+ * Shares a block payload.
+ *
+ * Creates a new block referencing the payload of a block created with
+ * block_shared_Alloc() (or returned by block_Share()), in constant time.
+ * Other blocks are duplicated with block_Duplicate().
+ *
+ * @return the new block on success, NULL on error.
+ */
+VLC_API block_t *block_Share(block_t *block) VLC_USED;
+
+/**
+ * Makes a block payload writable.
+ *
+ * @return the block itself if its payload is not referenced by other blocks,
+ * or else a private copy of it (the block is released in that case),
+ * NULL on error (the block is released in that case).
+ */
+VLC_API block_t *block_Unshare(block_t *block) VLC_USED;
+
 /**
  * Maps a file handle in memory.
  *
@@ -0,0 +1,95 @@
+/*****************************************************************************
+ * vlc_executor.h: bounded pool of worker threads
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_EXECUTOR_H
+#define VLC_EXECUTOR_H 1
+
+/**
+ * \file
+ * This file declares a bounded pool of worker threads
+ */
+
+/**
+ * A task to run on an executor
+ *
+ * The runnable is owned by the submitter, and must stay valid until its
+ * callback returns. A runnable may be submitted again once it is running
+ * (including from its own callback), but not while it is still queued.
+ */
+struct vlc_runnable {
+    void( *pf_run )( void* data );
+    void* data;
+
+    struct vlc_runnable* next; /**< private to the executor */
+};
+
+/**
+ * Create an executor
+ *
+ * Runnables are run in submission order on at most `max_threads` threads
+ * at a time. Threads are started on demand, and terminated when they have
+ * been idle for a while.
+ *
+ * While runnables are blocked (see \ref vlc_executor_BlockingBegin), up to
+ * `max_blocked` extra threads are started to run the pending runnables, so
+ * there are never more than `max_threads + max_blocked` threads.
+ *
+ * \param max_threads the maximum number of running threads (at least 1)
+ * \param max_blocked the maximum number of extra threads for blocked
+ * runnables
+ * \param priority the priority of the threads (VLC_THREAD_PRIORITY_*)
+ * \return the executor, or NULL on error
+ */
+VLC_API struct vlc_executor *vlc_executor_New( unsigned max_threads,
+                                               unsigned max_blocked,
+                                               int priority );
+
+/**
+ * Delete an executor
+ *
+ * All the submitted runnables must have completed.
+ */
+VLC_API void vlc_executor_Delete( struct vlc_executor *executor );
+
+/**
+ * Submit a runnable
+ *
+ * \return VLC_SUCCESS, or an error if no thread could be started to run it
+ * (the runnable is not queued then)
+ */
+VLC_API int vlc_executor_Submit( struct vlc_executor *executor,
+                                 struct vlc_runnable *runnable );
+
+/**
+ * Mark the calling thread as blocked
+ *
+ * A runnable shall call this before waiting for an event which may depend
+ * on another runnable, and \ref vlc_executor_BlockingEnd after. Blocked
+ * threads are not counted against the maximum number of running threads
+ * (up to the maximum number of blocked threads), so that the other
+ * runnables can make progress. Beyond that limit, the pending runnables
+ * wait for a thread to be unblocked.
+ *
+ * These functions do nothing if the caller is not running on an executor.
+ */
+VLC_API void vlc_executor_BlockingBegin( void );
+VLC_API void vlc_executor_BlockingEnd( void );
+
+#endif
@@ -118,6 +118,13 @@ VLC_API void httpd_UrlDelete( httpd_url_t * );
 VLC_API char* httpd_ClientIP( const httpd_client_t *cl, char *, int * );
 VLC_API char* httpd_ServerIP( const httpd_client_t *cl, char *, int * );
 
+/**
+ * Sends the body of the current answer to a client straight from a chain of
+ * blocks, rather than from the message body (from an url callback).
+ * The server takes ownership of the chain, and releases each block once sent.
+ */
+VLC_API void httpd_ClientSetBodyChain( httpd_client_t *cl, block_t *chain );
+
 /* High level */
 
 typedef struct httpd_file_t     httpd_file_t;
@@ -126,6 +133,22 @@ typedef int (*httpd_file_callback_t)( httpd_file_sys_t *, httpd_file_t *, uint8_
 VLC_API httpd_file_t * httpd_FileNew( httpd_host_t *, const char *psz_url, const char *psz_mime, const char *psz_user, const char *psz_password, httpd_file_callback_t pf_fill, httpd_file_sys_t * ) VLC_USED;
 VLC_API httpd_file_sys_t * httpd_FileDelete( httpd_file_t * );
 
+/* Serves a file straight from the disk, with byte range support */
+typedef struct httpd_disk_file_t httpd_disk_file_t;
+VLC_API httpd_disk_file_t * httpd_DiskFileNew( httpd_host_t *, const char *psz_url, const char *psz_path, const char *psz_mime, const char *psz_user, const char *psz_password ) VLC_USED;
+VLC_API void httpd_DiskFileDelete( httpd_disk_file_t * );
+
+/**
+ * Parses the value of a single byte range request header.
+ * \param i_size size of the resource
+ * \param pi_start first byte of the range [OUT]
+ * \param pi_end byte after the last one of the range [OUT]
+ * \return 0 if the range is satisfiable, a positive value if it is not
+ * (answer 416), and a negative value if the header should be ignored
+ * (answer 200 with the whole resource)
+ */
+VLC_API int httpd_ParseRange( const char *psz_range, uint64_t i_size, uint64_t *pi_start, uint64_t *pi_end ) VLC_USED;
+
 
 typedef struct httpd_handler_t  httpd_handler_t;
 typedef int (*httpd_handler_callback_t)( void *, httpd_handler_t *, char *psz_url, uint8_t *psz_request, int i_type, uint8_t *p_in, int i_in, char *psz_remote_addr, char *psz_remote_host, uint8_t **pp_data, int *pi_data );
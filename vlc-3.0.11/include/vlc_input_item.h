@@ -387,6 +387,21 @@ VLC_API void libvlc_MetadataCancel( libvlc_int_t *, void * );
 /******************
  * Input stats
  ******************/
+enum input_stats_latency_e
+{
+    INPUT_LATENCY_DEMUX_DECODE,   /**< Time blocks wait for the decoder */
+    INPUT_LATENCY_DECODE,         /**< Time from a block to the next decoded
+                                       frame */
+    INPUT_LATENCY_DECODE_DISPLAY, /**< Time decoded frames wait for their
+                                       display date */
+
+    INPUT_LATENCY_COUNT
+};
+
+/** Number of latency histogram buckets: bucket n counts the latencies of
+ * 2^n to 2^(n+1) microseconds (the first and last ones are open-ended) */
+#define INPUT_STATS_LATENCY_BUCKETS 24
+
 struct input_stats_t
 {
     vlc_mutex_t         lock;
@@ -421,6 +436,9 @@ struct input_stats_t
     /* Aout */
     int64_t i_played_abuffers;
     int64_t i_lost_abuffers;
+
+    /* Latency histograms */
+    uint64_t latency[INPUT_LATENCY_COUNT][INPUT_STATS_LATENCY_BUCKETS];
 };
 
 /**
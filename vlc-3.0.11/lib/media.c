@@ -123,6 +123,13 @@ static_assert(
     PROJECTION_MODE_CUBEMAP_LAYOUT_STANDARD == (int) libvlc_video_projection_cubemap_layout_standard,
     "Mismatch between libvlc_video_projection_t and video_projection_mode_t" );
 
+static_assert(
+    INPUT_LATENCY_DEMUX_DECODE   == (int) libvlc_media_latency_demux_decode &&
+    INPUT_LATENCY_DECODE         == (int) libvlc_media_latency_decode &&
+    INPUT_LATENCY_DECODE_DISPLAY == (int) libvlc_media_latency_decode_display &&
+    INPUT_STATS_LATENCY_BUCKETS  == LIBVLC_MEDIA_LATENCY_BUCKETS,
+    "Mismatch between libvlc_media_latency_t and input_stats_latency_e" );
+
 static libvlc_media_list_t *media_get_subitems( libvlc_media_t * p_md,
                                                 bool b_create )
 {
@@ -738,6 +745,32 @@ int libvlc_media_get_stats( libvlc_media_t *p_md,
     return true;
 }
 
+int libvlc_media_get_latency( libvlc_media_t *p_md,
+                              libvlc_media_latency_t i_latency,
+                              uint64_t *p_buckets )
+{
+    input_item_t *item = p_md->p_input_item;
+
+    if( item == NULL || (unsigned)i_latency >= INPUT_LATENCY_COUNT )
+        return false;
+
+    vlc_mutex_lock( &item->lock );
+
+    input_stats_t *p_itm_stats = item->p_stats;
+    if( p_itm_stats == NULL )
+    {
+        vlc_mutex_unlock( &item->lock );
+        return false;
+    }
+
+    vlc_mutex_lock( &p_itm_stats->lock );
+    memcpy( p_buckets, p_itm_stats->latency[i_latency],
+            sizeof( p_itm_stats->latency[i_latency] ) );
+    vlc_mutex_unlock( &p_itm_stats->lock );
+    vlc_mutex_unlock( &item->lock );
+    return true;
+}
+
 /**************************************************************************
  * event_manager
  **************************************************************************/
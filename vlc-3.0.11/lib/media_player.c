@@ -185,6 +185,103 @@ static void release_input_thread( libvlc_media_player_t *p_mi )
     input_Close( p_input_thread );
 }
 
+/*
+ * Remove a media from the warm standby inputs.
+ *
+ * Input lock is held or instance is being destroyed.
+ */
+static libvlc_media_player_standby_t *
+take_standby( libvlc_media_player_t *p_mi, libvlc_media_t *p_md )
+{
+    for( int i = 0; i < p_mi->input.i_standby; i++ )
+    {
+        libvlc_media_player_standby_t *p_standby = p_mi->input.pp_standby[i];
+
+        if( p_standby->p_md == p_md )
+        {
+            TAB_ERASE( p_mi->input.i_standby, p_mi->input.pp_standby, i );
+            return p_standby;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Close a warm standby input (if it was not switched to).
+ */
+static void release_standby( libvlc_media_player_standby_t *p_standby )
+{
+    if( p_standby->p_thread )
+    {
+        input_Stop( p_standby->p_thread );
+        input_Close( p_standby->p_thread );
+    }
+    libvlc_media_release( p_standby->p_md );
+    free( p_standby );
+}
+
+/*
+ * Send the events that a warm standby input emitted before it was switched
+ * to, as the media player did not listen to it then.
+ */
+static void replay_standby_events( input_thread_t *p_input_thread,
+                                   libvlc_media_player_t *p_mi )
+{
+    static const int events[] = {
+        INPUT_EVENT_STATE, INPUT_EVENT_LENGTH, INPUT_EVENT_VOUT,
+    };
+    static const char es_vars[][9] = { "video-es", "audio-es", "spu-es" };
+    vlc_value_t oldval = { .i_int = 0 };
+
+    for( size_t i = 0; i < ARRAY_SIZE( events ); i++ )
+    {
+        vlc_value_t newval = { .i_int = events[i] };
+        input_event_changed( VLC_OBJECT(p_input_thread), "intf-event",
+                             oldval, newval, p_mi );
+    }
+    var_TriggerCallback( p_input_thread, "can-seek" );
+    var_TriggerCallback( p_input_thread, "can-pause" );
+
+    for( size_t i = 0; i < ARRAY_SIZE( es_vars ); i++ )
+    {
+        vlc_value_t list;
+
+        if( var_Change( p_input_thread, es_vars[i], VLC_VAR_GETCHOICES,
+                        &list, NULL ) )
+            continue;
+        for( int j = 0; j < list.p_list->i_count; j++ )
+            input_es_changed( VLC_OBJECT(p_input_thread), es_vars[i],
+                              VLC_VAR_ADDCHOICE, &list.p_list->p_values[j],
+                              p_mi );
+        var_FreeList( &list, NULL );
+    }
+}
+
+/*
+ * Tell whether the media would be played through a stream output, which a
+ * warm standby input cannot share with the playing input.
+ */
+static bool media_has_sout( libvlc_media_player_t *p_mi,
+                            libvlc_media_t *p_md )
+{
+    char *psz_sout = var_InheritString( p_mi, "sout" );
+    bool b_sout = psz_sout != NULL && *psz_sout != '\0';
+    free( psz_sout );
+
+    input_item_t *p_item = p_md->p_input_item;
+    vlc_mutex_lock( &p_item->lock );
+    for( int i = 0; i < p_item->i_options && !b_sout; i++ )
+    {
+        const char *psz_opt = p_item->ppsz_options[i];
+
+        if( *psz_opt == ':' )
+            psz_opt++;
+        b_sout = !strncmp( psz_opt, "sout=", 5 );
+    }
+    vlc_mutex_unlock( &p_item->lock );
+    return b_sout;
+}
+
 /*
  * Retrieve the input thread. Be sure to release the object
  * once you are done with it. (libvlc Internal)
@@ -739,6 +836,7 @@ libvlc_media_player_new( libvlc_instance_t *instance )
     mp->p_libvlc_instance = instance;
     mp->input.p_thread = NULL;
     mp->input.p_renderer = NULL;
+    TAB_INIT( mp->input.i_standby, mp->input.pp_standby );
     mp->input.p_resource = input_resource_New(VLC_OBJECT(mp));
     if (unlikely(mp->input.p_resource == NULL))
     {
@@ -817,6 +915,9 @@ static void libvlc_media_player_destroy( libvlc_media_player_t *p_mi )
     /* No need for lock_input() because no other threads knows us anymore */
     if( p_mi->input.p_thread )
         release_input_thread(p_mi);
+    for( int i = 0; i < p_mi->input.i_standby; i++ )
+        release_standby( p_mi->input.pp_standby[i] );
+    TAB_CLEAN( p_mi->input.i_standby, p_mi->input.pp_standby );
     input_resource_Terminate( p_mi->input.p_resource );
     input_resource_Release( p_mi->input.p_resource );
     if( p_mi->input.p_renderer )
@@ -987,9 +1088,25 @@ int libvlc_media_player_play( libvlc_media_player_t *p_mi )
 
     media_attach_preparsed_event( p_mi->p_md );
 
-    p_input_thread = input_Create( p_mi, p_mi->p_md->p_input_item, NULL,
-                                   p_mi->input.p_resource,
-                                   p_mi->input.p_renderer );
+    /* Switch to the input kept in warm standby, unless it has failed */
+    bool b_standby = false;
+    libvlc_media_player_standby_t *p_standby = take_standby( p_mi, p_mi->p_md );
+    if( p_standby )
+    {
+        int i_state = var_GetInteger( p_standby->p_thread, "state" );
+        if( i_state != END_S && i_state != ERROR_S )
+        {
+            p_input_thread = p_standby->p_thread;
+            p_standby->p_thread = NULL;
+            b_standby = true;
+        }
+        release_standby( p_standby );
+    }
+
+    if( !b_standby )
+        p_input_thread = input_Create( p_mi, p_mi->p_md->p_input_item, NULL,
+                                       p_mi->input.p_resource,
+                                       p_mi->input.p_renderer );
     unlock(p_mi);
     if( !p_input_thread )
     {
@@ -1005,7 +1122,14 @@ int libvlc_media_player_play( libvlc_media_player_t *p_mi )
     var_AddCallback( p_input_thread, "intf-event", input_event_changed, p_mi );
     add_es_callbacks( p_input_thread, p_mi );
 
-    if( input_Start( p_input_thread ) )
+    if( b_standby )
+    {
+        var_SetBool( p_input_thread, "standby", false );
+
+        /* The input is already running: catch up with its state */
+        replay_standby_events( p_input_thread, p_mi );
+    }
+    else if( input_Start( p_input_thread ) )
     {
         unlock_input(p_mi);
         del_es_callbacks( p_input_thread, p_mi );
@@ -1023,6 +1147,83 @@ int libvlc_media_player_play( libvlc_media_player_t *p_mi )
     return 0;
 }
 
+/**************************************************************************
+ * Open a media in warm standby.
+ **************************************************************************/
+int libvlc_media_player_add_standby( libvlc_media_player_t *p_mi,
+                                     libvlc_media_t *p_md )
+{
+    lock_input( p_mi );
+
+    for( int i = 0; i < p_mi->input.i_standby; i++ )
+    {
+        if( p_mi->input.pp_standby[i]->p_md == p_md )
+        {
+            unlock_input( p_mi );
+            return 0;
+        }
+    }
+
+    if( p_mi->input.p_renderer != NULL || media_has_sout( p_mi, p_md ) )
+    {
+        unlock_input( p_mi );
+        libvlc_printerr( "Warm standby is not supported with a stream output" );
+        return -1;
+    }
+
+    libvlc_media_player_standby_t *p_standby = malloc( sizeof( *p_standby ) );
+    if( unlikely(p_standby == NULL) )
+    {
+        unlock_input( p_mi );
+        libvlc_printerr( "Not enough memory" );
+        return -1;
+    }
+
+    /* The input shares the resource of the player, but does not use it
+     * until it is switched to */
+    input_thread_t *p_input_thread = input_Create( p_mi, p_md->p_input_item,
+                                                   NULL, p_mi->input.p_resource,
+                                                   p_mi->input.p_renderer );
+    if( !p_input_thread )
+    {
+        unlock_input( p_mi );
+        free( p_standby );
+        libvlc_printerr( "Not enough memory" );
+        return -1;
+    }
+    var_SetBool( p_input_thread, "standby", true );
+
+    if( input_Start( p_input_thread ) )
+    {
+        unlock_input( p_mi );
+        input_Close( p_input_thread );
+        free( p_standby );
+        libvlc_printerr( "Input initialization failure" );
+        return -1;
+    }
+
+    libvlc_media_retain( p_md );
+    p_standby->p_md = p_md;
+    p_standby->p_thread = p_input_thread;
+    TAB_APPEND( p_mi->input.i_standby, p_mi->input.pp_standby, p_standby );
+    unlock_input( p_mi );
+    return 0;
+}
+
+/**************************************************************************
+ * Close a media opened in warm standby.
+ **************************************************************************/
+void libvlc_media_player_remove_standby( libvlc_media_player_t *p_mi,
+                                         libvlc_media_t *p_md )
+{
+    lock_input( p_mi );
+    libvlc_media_player_standby_t *p_standby = take_standby( p_mi, p_md );
+    unlock_input( p_mi );
+
+    if( p_standby )
+        release_standby( p_standby );
+}
+
 void libvlc_media_player_set_pause( libvlc_media_player_t *p_mi, int paused )
 {
     input_thread_t * p_input_thread = libvlc_get_input_thread( p_mi );
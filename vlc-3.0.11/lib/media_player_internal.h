@@ -36,6 +36,13 @@
 
 #include "../modules/audio_filter/equalizer_presets.h"
 
+/* Media opened in warm standby */
+typedef struct
+{
+    libvlc_media_t *p_md;
+    input_thread_t *p_thread;
+} libvlc_media_player_standby_t;
+
 struct libvlc_media_player_t
 {
     VLC_COMMON_MEMBERS
@@ -49,6 +56,9 @@ struct libvlc_media_player_t
         input_resource_t *p_resource;
         vlc_renderer_item_t *p_renderer;
         vlc_mutex_t       lock;
+
+        int               i_standby;
+        libvlc_media_player_standby_t **pp_standby;
     } input;
 
     struct libvlc_instance_t * p_libvlc_instance; /* Parent instance */
@@ -51,6 +51,9 @@
 #else
 #   include <unistd.h>
 #endif
+#ifdef HAVE_MMAP
+#   include <sys/mman.h>
+#endif
 #include <dirent.h>
 
 #include <vlc_common.h>
@@ -69,6 +72,12 @@ struct access_sys_t
     int fd;
 
     bool b_pace_control;
+#ifdef HAVE_MMAP
+    uint64_t offset; /* memory-mapped mode only */
+#endif
+#ifdef HAVE_PREAD
+    struct readahead *readahead;
+#endif
 };
 
 #if !defined (_WIN32) && !defined (__OS2__)
@@ -126,11 +135,24 @@ static bool IsRemote (const char *path)
 #ifndef HAVE_POSIX_FADVISE
 # define posix_fadvise(fd, off, len, adv)
 #endif
+#ifndef HAVE_POSIX_MADVISE
+# define posix_madvise(addr, len, adv)
+#endif
 
 static ssize_t Read (stream_t *, void *, size_t);
 static int FileSeek (stream_t *, uint64_t);
 static int NoSeek (stream_t *, uint64_t);
 static int FileControl (stream_t *, int, va_list);
+#ifdef HAVE_MMAP
+static block_t *MmapBlock (stream_t *, bool *);
+static int MmapSeek (stream_t *, uint64_t);
+#endif
+#ifdef HAVE_PREAD
+static struct readahead *ReadAheadNew (stream_t *, int, unsigned);
+static void ReadAheadDelete (struct readahead *);
+static block_t *ReadAheadBlock (stream_t *, bool *);
+static int ReadAheadSeek (stream_t *, uint64_t);
+#endif
 
 /*****************************************************************************
  * FileOpen: open the file
@@ -213,6 +235,9 @@ int FileOpen( vlc_object_t *p_this )
     p_access->pf_control = FileControl;
     p_access->p_sys = p_sys;
     p_sys->fd = fd;
+#ifdef HAVE_PREAD
+    p_sys->readahead = NULL;
+#endif
 
     if (S_ISREG (st.st_mode) || S_ISBLK (st.st_mode))
     {
@@ -231,6 +256,36 @@ int FileOpen( vlc_object_t *p_this )
             fcntl (fd, F_RDAHEAD, 0);
         else
             fcntl (fd, F_RDAHEAD, 1);
+#endif
+#ifdef HAVE_MMAP
+        /* Blocks are then handed to the demuxer without any copy. Files on
+         * network file systems are read as usual: a mapping of a file
+         * which gets truncated or becomes unreachable faults on access. */
+        if (S_ISREG (st.st_mode) && var_InheritBool (p_access, "file-mmap")
+         && !IsRemote(fd, p_access->psz_filepath))
+        {
+            msg_Dbg (p_access, "memory-mapping the file");
+            p_access->pf_read = NULL;
+            p_access->pf_block = MmapBlock;
+            p_access->pf_seek = MmapSeek;
+            p_sys->offset = 0;
+        }
+#endif
+#ifdef HAVE_PREAD
+        /* On network file systems, keep several reads in flight to hide
+         * the latency of each of them. */
+        unsigned depth = var_InheritInteger (p_access, "file-readahead");
+        if (p_access->pf_read != NULL && S_ISREG (st.st_mode) && depth > 1
+         && IsRemote(fd, p_access->psz_filepath))
+        {
+            p_sys->readahead = ReadAheadNew (p_access, fd, depth);
+            if (p_sys->readahead != NULL)
+            {
+                p_access->pf_read = NULL;
+                p_access->pf_block = ReadAheadBlock;
+                p_access->pf_seek = ReadAheadSeek;
+            }
+        }
 #endif
     }
     else
@@ -253,7 +308,7 @@ void FileClose (vlc_object_t * p_this)
 {
     stream_t     *p_access = (stream_t*)p_this;
 
-    if (p_access->pf_read == NULL)
+    if (p_access->pf_read == NULL && p_access->pf_block == NULL)
     {
         DirClose (p_this);
         return;
@@ -261,6 +316,10 @@ void FileClose (vlc_object_t * p_this)
 
     access_sys_t *p_sys = p_access->p_sys;
 
+#ifdef HAVE_PREAD
+    if (p_sys->readahead != NULL)
+        ReadAheadDelete (p_sys->readahead);
+#endif
     vlc_close (p_sys->fd);
 }
 
@@ -287,6 +346,506 @@ static ssize_t Read (stream_t *p_access, void *p_buffer, size_t i_len)
     return val;
 }
 
+#ifdef HAVE_MMAP
+/* Each block is a separate private mapping: demuxers and packetizers may
+ * write to the blocks, and this must neither reach the file nor the other
+ * blocks mapping the same pages. */
+#define MMAP_BLOCK_SIZE (1 << 20)
+
+static block_t *MmapBlock (stream_t *p_access, bool *restrict eof)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    struct stat st;
+
+    /* Check the size every time, not to map past the end of a file which
+     * was truncated, and to follow a file which is being written. */
+    if (fstat (p_sys->fd, &st))
+    {
+        msg_Err (p_access, "read error: %s", vlc_strerror_c(errno));
+        *eof = true;
+        return NULL;
+    }
+
+    if ((uint64_t)st.st_size <= p_sys->offset)
+    {
+        *eof = true;
+        return NULL;
+    }
+
+    uint64_t page_mask = sysconf (_SC_PAGESIZE) - 1;
+    uint64_t base = p_sys->offset & ~page_mask;
+    size_t skip = p_sys->offset - base;
+    size_t length = __MIN(st.st_size - p_sys->offset, MMAP_BLOCK_SIZE);
+
+    void *addr = mmap (NULL, skip + length, PROT_READ|PROT_WRITE,
+                       MAP_PRIVATE, p_sys->fd, base);
+    if (addr == MAP_FAILED)
+    {
+        msg_Err (p_access, "cannot map file: %s", vlc_strerror_c(errno));
+        *eof = true;
+        return NULL;
+    }
+
+    posix_madvise (addr, skip + length, POSIX_MADV_SEQUENTIAL);
+    posix_madvise (addr, skip + length, POSIX_MADV_WILLNEED);
+    /* Start reading the next block ahead of time */
+    posix_fadvise (p_sys->fd, base + skip + length, MMAP_BLOCK_SIZE,
+                   POSIX_FADV_WILLNEED);
+
+    block_t *block = block_mmap_Alloc ((uint8_t *)addr + skip, length);
+    if (unlikely(block == NULL))
+        return NULL;
+
+    p_sys->offset += length;
+    return block;
+}
+
+static int MmapSeek (stream_t *p_access, uint64_t i_pos)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    p_sys->offset = i_pos;
+    posix_fadvise (p_sys->fd, i_pos, MMAP_BLOCK_SIZE, POSIX_FADV_WILLNEED);
+    return VLC_SUCCESS;
+}
+#endif
+
+#ifdef HAVE_PREAD
+/*****************************************************************************
+ * Read-ahead: reads of the next chunks of the file are queued in a ring, in
+ * file order, and served by a pool of threads. The number of reads in flight
+ * follows the bandwidth-delay product: the read latency times the rate at
+ * which the demuxer consumes the data.
+ *****************************************************************************/
+#define READAHEAD_CHUNK (256 * 1024)
+
+enum { SLOT_QUEUED, SLOT_BUSY, SLOT_DONE };
+
+struct readahead_slot
+{
+    uint64_t offset;
+    uint64_t seq;       /* request identifier, changed when recycled */
+    int      state;
+    int      error;
+    block_t *block;
+};
+
+struct readahead
+{
+    stream_t     *access;
+    int           fd;
+
+    vlc_mutex_t   lock;
+    vlc_cond_t    wait_request; /* signaled when a read is queued */
+    vlc_cond_t    wait_data;    /* signaled when a read completes */
+    vlc_thread_t *threads;
+    unsigned      thread_count;
+    bool          closing;
+    bool          interrupted;
+
+    struct readahead_slot *slots;
+    unsigned      max_depth;
+    unsigned      depth;        /* current number of reads ahead */
+    unsigned      first;
+    unsigned      count;
+    uint64_t      next_offset;  /* offset of the next read to queue */
+    uint64_t      end_offset;   /* end of file, as far as known */
+    uint64_t      next_seq;
+    size_t        skip;         /* bytes to skip in the first chunk */
+
+    /* Bandwidth estimation */
+    mtime_t       read_time;    /* average duration of a read */
+    mtime_t       consume_time; /* average time between consumed chunks */
+    mtime_t       last_consume;
+    unsigned      since_stall;  /* chunks consumed since the last stall */
+
+    /* Statistics */
+    uint64_t      reads;
+    uint64_t      stalls;
+    uint64_t      cancelled;
+};
+
+static struct readahead_slot *ReadAheadNextQueued (struct readahead *ra)
+{
+    for (unsigned i = 0; i < ra->count; i++)
+    {
+        struct readahead_slot *slot =
+            &ra->slots[(ra->first + i) % ra->max_depth];
+        if (slot->state == SLOT_QUEUED)
+            return slot;
+    }
+    return NULL;
+}
+
+static void *ReadAheadThread (void *data)
+{
+    struct readahead *ra = data;
+    int canc = vlc_savecancel ();
+
+    vlc_mutex_lock (&ra->lock);
+    for (;;)
+    {
+        struct readahead_slot *slot;
+
+        while ((slot = ReadAheadNextQueued (ra)) == NULL && !ra->closing)
+            vlc_cond_wait (&ra->wait_request, &ra->lock);
+        if (ra->closing)
+            break;
+
+        uint64_t seq = slot->seq;
+        uint64_t offset = slot->offset;
+        slot->state = SLOT_BUSY;
+        vlc_mutex_unlock (&ra->lock);
+
+        mtime_t start = mdate ();
+        block_t *block = block_Alloc (READAHEAD_CHUNK);
+        ssize_t val = -1;
+        int error = ENOMEM;
+
+        if (likely(block != NULL))
+        {
+            do
+                val = pread (ra->fd, block->p_buffer, READAHEAD_CHUNK,
+                             offset);
+            while (val < 0 && errno == EINTR);
+            error = errno;
+        }
+        mtime_t duration = mdate () - start;
+
+        vlc_mutex_lock (&ra->lock);
+        /* A seek may have recycled the slot in the mean time */
+        if (slot->seq != seq)
+        {
+            if (block != NULL)
+                block_Release (block);
+            continue;
+        }
+
+        if (val >= 0)
+            block->i_buffer = val;
+        else
+        {
+            if (block != NULL)
+                block_Release (block);
+            block = NULL;
+            slot->error = error;
+        }
+        slot->block = block;
+        slot->state = SLOT_DONE;
+        ra->reads++;
+        ra->read_time = ra->read_time ? (ra->read_time * 7 + duration) / 8
+                                      : duration;
+        vlc_cond_signal (&ra->wait_data);
+    }
+    vlc_mutex_unlock (&ra->lock);
+
+    vlc_restorecancel (canc);
+    return NULL;
+}
+
+static void ReadAheadFill (struct readahead *ra)
+{
+    while (ra->count < ra->depth && ra->next_offset < ra->end_offset)
+    {
+        struct readahead_slot *slot =
+            &ra->slots[(ra->first + ra->count) % ra->max_depth];
+
+        slot->offset = ra->next_offset;
+        slot->seq = ++ra->next_seq;
+        slot->state = SLOT_QUEUED;
+        slot->block = NULL;
+        ra->next_offset += READAHEAD_CHUNK;
+        ra->count++;
+        vlc_cond_signal (&ra->wait_request);
+    }
+}
+
+/* Drops the queued reads from the n-th one, the ones in progress are
+ * discarded when they complete. */
+static void ReadAheadDrop (struct readahead *ra, unsigned n)
+{
+    for (unsigned i = n; i < ra->count; i++)
+    {
+        struct readahead_slot *slot =
+            &ra->slots[(ra->first + i) % ra->max_depth];
+
+        if (slot->block != NULL)
+            block_Release (slot->block);
+        slot->block = NULL;
+        slot->seq = 0;
+    }
+    if (n < ra->count)
+    {
+        ra->next_offset = ra->slots[(ra->first + n) % ra->max_depth].offset;
+        ra->count = n;
+    }
+}
+
+static void ReadAheadInterrupt (void *data)
+{
+    struct readahead *ra = data;
+
+    vlc_mutex_lock (&ra->lock);
+    ra->interrupted = true;
+    vlc_cond_broadcast (&ra->wait_data);
+    vlc_mutex_unlock (&ra->lock);
+}
+
+/* Adapts the number of reads ahead to the bandwidth-delay product */
+static void ReadAheadAdapt (struct readahead *ra, bool stalled)
+{
+    mtime_t now = mdate ();
+
+    if (ra->last_consume != 0)
+    {
+        mtime_t interval = now - ra->last_consume;
+        ra->consume_time = ra->consume_time
+                         ? (ra->consume_time * 7 + interval) / 8 : interval;
+    }
+    ra->last_consume = now;
+
+    if (stalled)
+    {
+        ra->since_stall = 0;
+        if (ra->depth < ra->max_depth)
+            ra->depth++;
+        return;
+    }
+
+    /* Shrink slowly, once the reads have kept up for a while */
+    if (++ra->since_stall < 2 * ra->max_depth || ra->consume_time <= 0)
+        return;
+
+    unsigned needed = ra->read_time / ra->consume_time + 2;
+    if (needed < ra->depth)
+    {
+        ra->depth--;
+        ra->since_stall = 0;
+    }
+}
+
+static block_t *ReadAheadBlock (stream_t *p_access, bool *restrict eof)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    struct readahead *ra = p_sys->readahead;
+    bool stalled = false;
+
+    vlc_mutex_lock (&ra->lock);
+    if (ra->count == 0 && ra->next_offset >= ra->end_offset)
+    {   /* The file may have grown since the end was reached */
+        struct stat st;
+
+        if (fstat (ra->fd, &st) == 0 && (uint64_t)st.st_size > ra->end_offset)
+            ra->end_offset = UINT64_MAX;
+    }
+    ReadAheadFill (ra);
+    if (ra->count == 0)
+    {
+        vlc_mutex_unlock (&ra->lock);
+        *eof = true;
+        return NULL;
+    }
+
+    struct readahead_slot *slot = &ra->slots[ra->first];
+
+    if (slot->state != SLOT_DONE)
+    {
+        stalled = true;
+        ra->stalls++;
+        ra->interrupted = false;
+        vlc_mutex_unlock (&ra->lock);
+
+        vlc_interrupt_register (ReadAheadInterrupt, ra);
+        vlc_mutex_lock (&ra->lock);
+        while (slot->state != SLOT_DONE && !ra->interrupted)
+            vlc_cond_wait (&ra->wait_data, &ra->lock);
+        vlc_mutex_unlock (&ra->lock);
+        vlc_interrupt_unregister ();
+        vlc_mutex_lock (&ra->lock);
+
+        if (slot->state != SLOT_DONE)
+        {
+            vlc_mutex_unlock (&ra->lock);
+            return NULL;
+        }
+    }
+
+    block_t *block = slot->block;
+    slot->block = NULL;
+    slot->seq = 0;
+
+    if (block == NULL)
+    {
+        msg_Err (p_access, "read error: %s", vlc_strerror_c(slot->error));
+        ReadAheadDrop (ra, 0);
+        ra->end_offset = ra->next_offset;
+        vlc_mutex_unlock (&ra->lock);
+        *eof = true;
+        return NULL;
+    }
+
+    if (block->i_buffer < READAHEAD_CHUNK)
+    {   /* End of file: the next reads are moot */
+        ra->first = (ra->first + 1) % ra->max_depth;
+        ra->count--;
+        ReadAheadDrop (ra, 0);
+        ra->next_offset = ra->end_offset = slot->offset + block->i_buffer;
+    }
+    else
+    {
+        ra->first = (ra->first + 1) % ra->max_depth;
+        ra->count--;
+    }
+
+    ReadAheadAdapt (ra, stalled);
+    ReadAheadFill (ra);
+
+    size_t skip = __MIN(ra->skip, block->i_buffer);
+    ra->skip = 0;
+    vlc_mutex_unlock (&ra->lock);
+
+    block->p_buffer += skip;
+    block->i_buffer -= skip;
+    if (block->i_buffer == 0)
+    {
+        block_Release (block);
+        *eof = true;
+        return NULL;
+    }
+    return block;
+}
+
+static int ReadAheadSeek (stream_t *p_access, uint64_t i_pos)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    struct readahead *ra = p_sys->readahead;
+
+    vlc_mutex_lock (&ra->lock);
+    /* Keep the reads still ahead of the new position, if any. */
+    unsigned n = 0;
+    while (n < ra->count
+        && ra->slots[(ra->first + n) % ra->max_depth].offset
+                                            + READAHEAD_CHUNK <= i_pos)
+        n++;
+
+    if (n < ra->count
+     && ra->slots[(ra->first + n) % ra->max_depth].offset <= i_pos)
+    {
+        ra->skip = i_pos - ra->slots[(ra->first + n) % ra->max_depth].offset;
+        /* Drop the reads before the new position */
+        for (unsigned i = 0; i < n; i++)
+        {
+            struct readahead_slot *old = &ra->slots[ra->first];
+
+            if (old->block != NULL)
+                block_Release (old->block);
+            old->block = NULL;
+            old->seq = 0;
+            ra->first = (ra->first + 1) % ra->max_depth;
+            ra->count--;
+        }
+    }
+    else
+    {   /* Cancel everything */
+        ra->cancelled += ra->count;
+        ReadAheadDrop (ra, 0);
+        ra->next_offset = i_pos;
+        ra->end_offset = UINT64_MAX;
+        ra->skip = 0;
+    }
+    vlc_mutex_unlock (&ra->lock);
+    return VLC_SUCCESS;
+}
+
+static struct readahead *ReadAheadNew (stream_t *p_access, int fd,
+                                       unsigned depth)
+{
+    struct readahead *ra = malloc (sizeof (*ra));
+    if (unlikely(ra == NULL))
+        return NULL;
+
+    ra->slots = vlc_alloc (depth, sizeof (*ra->slots));
+    ra->threads = vlc_alloc (depth, sizeof (*ra->threads));
+    if (unlikely(ra->slots == NULL || ra->threads == NULL))
+    {
+        free (ra->threads);
+        free (ra->slots);
+        free (ra);
+        return NULL;
+    }
+
+    ra->access = p_access;
+    ra->fd = fd;
+    vlc_mutex_init (&ra->lock);
+    vlc_cond_init (&ra->wait_request);
+    vlc_cond_init (&ra->wait_data);
+    ra->closing = false;
+    ra->interrupted = false;
+    ra->max_depth = depth;
+    ra->depth = 2;
+    ra->first = 0;
+    ra->count = 0;
+    ra->next_offset = 0;
+    ra->end_offset = UINT64_MAX;
+    ra->next_seq = 0;
+    ra->skip = 0;
+    ra->read_time = 0;
+    ra->consume_time = 0;
+    ra->last_consume = 0;
+    ra->since_stall = 0;
+    ra->reads = ra->stalls = ra->cancelled = 0;
+    for (unsigned i = 0; i < depth; i++)
+    {
+        ra->slots[i].seq = 0;
+        ra->slots[i].block = NULL;
+    }
+
+    for (ra->thread_count = 0; ra->thread_count < depth; ra->thread_count++)
+        if (vlc_clone (&ra->threads[ra->thread_count], ReadAheadThread, ra,
+                       VLC_THREAD_PRIORITY_INPUT))
+            break;
+
+    if (ra->thread_count == 0)
+    {
+        ReadAheadDelete (ra);
+        return NULL;
+    }
+    if (ra->max_depth > ra->thread_count)
+        ra->max_depth = ra->thread_count;
+    if (ra->depth > ra->max_depth)
+        ra->depth = ra->max_depth;
+
+    msg_Dbg (p_access, "reading ahead, up to %u reads in flight",
+             ra->max_depth);
+    return ra;
+}
+
+static void ReadAheadDelete (struct readahead *ra)
+{
+    vlc_mutex_lock (&ra->lock);
+    ReadAheadDrop (ra, 0);
+    ra->closing = true;
+    vlc_cond_broadcast (&ra->wait_request);
+    vlc_mutex_unlock (&ra->lock);
+
+    for (unsigned i = 0; i < ra->thread_count; i++)
+        vlc_join (ra->threads[i], NULL);
+
+    if (ra->reads > 0)
+        msg_Dbg (ra->access, "read-ahead: %"PRIu64" reads (%"PRId64" us "
+                 "average), %"PRIu64" stalls, %"PRIu64" cancelled, %u reads "
+                 "in flight at the end", ra->reads, ra->read_time,
+                 ra->stalls, ra->cancelled, ra->depth);
+
+    vlc_cond_destroy (&ra->wait_data);
+    vlc_cond_destroy (&ra->wait_request);
+    vlc_mutex_destroy (&ra->lock);
+    free (ra->threads);
+    free (ra->slots);
+    free (ra);
+}
+#endif
+
 /*****************************************************************************
  * Seek: seek to a specific location in a file
  *****************************************************************************/
@@ -352,6 +911,13 @@ static int FileControl( stream_t *p_access, int i_query, va_list args )
             /* Nothing to do */
             break;
 
+#ifdef HAVE_MMAP
+        case STREAM_IS_MAPPED:
+            if (p_access->pf_block != MmapBlock)
+                return VLC_EGENERIC;
+            break;
+#endif
+
         default:
             return VLC_EGENERIC;
 
@@ -39,6 +39,20 @@ vlc_module_begin ()
     set_capability( "access", 50 )
     add_shortcut( "file", "fd", "stream" )
     set_callbacks( FileOpen, FileClose )
+#ifdef HAVE_MMAP
+    add_bool( "file-mmap", false, N_("Memory-map local files"),
+              N_("Read local files through memory mappings, avoiding "
+                 "copies of the data. Files on network file systems are "
+                 "always read normally."), true )
+#endif
+#ifdef HAVE_PREAD
+    add_integer_with_range( "file-readahead", 8, 0, 32,
+                            N_("Network file system read-ahead"),
+                            N_("Maximum number of reads in flight for files "
+                               "on network file systems. The actual number "
+                               "adapts to the bandwidth. 0 or 1 disables "
+                               "reading ahead."), true )
+#endif
 
     add_submodule()
     set_section( N_("Directory" ), NULL )
@@ -92,53 +92,133 @@ static char *vlc_http_proxy_find(const char *hostname, unsigned port,
 }
 
 
+/* Connections are pooled by origin: HTTP/2 connections carry any number of
+ * concurrent streams, while HTTP/1.x connections carry one request at a time
+ * and are kept alive for the next one. Idle connections are closed lazily,
+ * on the next request after they expired. */
+#define VLC_HTTP_POOL_MAX  8
+#define VLC_HTTP_POOL_IDLE (30 * CLOCK_FREQ)
+
+struct vlc_http_pool_entry
+{
+    struct vlc_http_conn *conn;
+    char *host;
+    unsigned port;
+    bool https;
+    bool http2;
+    mtime_t last_used;
+};
+
 struct vlc_http_mgr
 {
     vlc_object_t *obj;
     vlc_tls_creds_t *creds;
     struct vlc_http_cookie_jar_t *jar;
-    struct vlc_http_conn *conn;
+    struct vlc_http_pool_entry pool[VLC_HTTP_POOL_MAX];
+    unsigned pool_size;
 };
 
-static struct vlc_http_conn *vlc_http_mgr_find(struct vlc_http_mgr *mgr,
-                                               const char *host, unsigned port)
+static void vlc_http_mgr_release(struct vlc_http_mgr *mgr, unsigned i)
+{
+    struct vlc_http_pool_entry *entry = &mgr->pool[i];
+
+    assert(i < mgr->pool_size);
+    vlc_http_conn_release(entry->conn);
+    free(entry->host);
+
+    mgr->pool[i] = mgr->pool[--mgr->pool_size];
+}
+
+static void vlc_http_mgr_expire(struct vlc_http_mgr *mgr, mtime_t now)
 {
-    (void) host; (void) port;
-    return mgr->conn;
+    for (unsigned i = 0; i < mgr->pool_size;)
+    {
+        if (now - mgr->pool[i].last_used >= VLC_HTTP_POOL_IDLE)
+        {
+            vlc_http_dbg(mgr->obj, "closing idle connection to %s:%u",
+                         mgr->pool[i].host, mgr->pool[i].port);
+            vlc_http_mgr_release(mgr, i);
+        }
+        else
+            i++;
+    }
 }
 
-static void vlc_http_mgr_release(struct vlc_http_mgr *mgr,
-                                 struct vlc_http_conn *conn)
+static int vlc_http_mgr_add(struct vlc_http_mgr *mgr,
+                            struct vlc_http_conn *conn, bool https,
+                            bool http2, const char *host, unsigned port)
 {
-    assert(mgr->conn == conn);
-    mgr->conn = NULL;
+    char *name = strdup(host);
+    if (unlikely(name == NULL))
+        return -1;
+
+    if (mgr->pool_size == VLC_HTTP_POOL_MAX)
+    {   /* Make room by closing the least recently used connection */
+        unsigned lru = 0;
+
+        for (unsigned i = 1; i < mgr->pool_size; i++)
+            if (mgr->pool[i].last_used < mgr->pool[lru].last_used)
+                lru = i;
+        vlc_http_mgr_release(mgr, lru);
+    }
 
-    vlc_http_conn_release(conn);
+    struct vlc_http_pool_entry *entry = &mgr->pool[mgr->pool_size++];
+
+    entry->conn = conn;
+    entry->host = name;
+    entry->port = port;
+    entry->https = https;
+    entry->http2 = http2;
+    entry->last_used = mdate();
+    return 0;
 }
 
 static
-struct vlc_http_msg *vlc_http_mgr_reuse(struct vlc_http_mgr *mgr,
+struct vlc_http_msg *vlc_http_mgr_reuse(struct vlc_http_mgr *mgr, bool https,
                                         const char *host, unsigned port,
                                         const struct vlc_http_msg *req)
 {
-    struct vlc_http_conn *conn = vlc_http_mgr_find(mgr, host, port);
-    if (conn == NULL)
-        return NULL;
-
-    struct vlc_http_stream *stream = vlc_http_stream_open(conn, req);
-    if (stream != NULL)
-    {
-        struct vlc_http_msg *m = vlc_http_msg_get_initial(stream);
-        if (m != NULL)
-            return m;
-
-        /* NOTE: If the request were not idempotent, we would not know if it
-         * was processed by the other end. Thus POST is not used/supported so
-         * far, and CONNECT is treated as if it were idempotent (which works
-         * fine here). */
-    }
-    /* Get rid of closing or reset connection */
-    vlc_http_mgr_release(mgr, conn);
+    mtime_t now = mdate();
+
+    vlc_http_mgr_expire(mgr, now);
+
+    /* Prefer HTTP/2 connections, as they never are busy */
+    for (int pass = 0; pass < 2; pass++)
+        for (unsigned i = 0; i < mgr->pool_size;)
+        {
+            struct vlc_http_pool_entry *entry = &mgr->pool[i];
+
+            if (entry->https != https || entry->http2 != !pass
+             || entry->port != port || strcasecmp(entry->host, host))
+            {
+                i++;
+                continue;
+            }
+
+            struct vlc_http_conn *conn = entry->conn;
+            struct vlc_http_stream *stream = vlc_http_stream_open(conn, req);
+            if (stream != NULL)
+            {
+                struct vlc_http_msg *m = vlc_http_msg_get_initial(stream);
+                if (m != NULL)
+                {
+                    mgr->pool[i].last_used = now;
+                    return m;
+                }
+
+                /* NOTE: If the request were not idempotent, we would not know
+                 * if it was processed by the other end. Thus POST is not
+                 * used/supported so far, and CONNECT is treated as if it were
+                 * idempotent (which works fine here). */
+            }
+            else if (!entry->http2 && conn->tls != NULL)
+            {   /* HTTP/1.x connection busy with another request */
+                i++;
+                continue;
+            }
+            /* Get rid of closing or reset connection */
+            vlc_http_mgr_release(mgr, i);
+        }
     return NULL;
 }
 
@@ -149,8 +229,8 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
     vlc_tls_t *tls;
     bool http2 = true;
 
-    if (mgr->creds == NULL && mgr->conn != NULL)
-        return NULL; /* switch from HTTP to HTTPS not implemented */
+    if (port == 0)
+        port = 443;
 
     if (mgr->creds == NULL)
     {   /* First TLS connection: load x509 credentials */
@@ -160,7 +240,7 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
     }
 
     /* TODO? non-idempotent request support */
-    struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, host, port, req);
+    struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, true, host, port, req);
     if (resp != NULL)
         return resp; /* existing connection reused */
 
@@ -197,19 +277,24 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
         return NULL;
     }
 
-    mgr->conn = conn;
+    if (vlc_http_mgr_add(mgr, conn, true, http2, host, port))
+    {
+        vlc_http_conn_release(conn);
+        return NULL;
+    }
 
-    return vlc_http_mgr_reuse(mgr, host, port, req);
+    return vlc_http_mgr_reuse(mgr, true, host, port, req);
 }
 
 static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
                                              const char *host, unsigned port,
                                              const struct vlc_http_msg *req)
 {
-    if (mgr->creds != NULL && mgr->conn != NULL)
-        return NULL; /* switch from HTTPS to HTTP not implemented */
+    if (port == 0)
+        port = 80;
 
-    struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, host, port, req);
+    struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, false, host, port,
+                                                   req);
     if (resp != NULL)
         return resp;
 
@@ -234,8 +319,7 @@ static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
         vlc_UrlClean(&url);
     }
     else
-        stream = vlc_h1_request(mgr->obj, host, port ? port : 80, false, req,
-                                true, &conn);
+        stream = vlc_h1_request(mgr->obj, host, port, false, req, true, &conn);
 
     if (stream == NULL)
         return NULL;
@@ -247,7 +331,9 @@ static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
         return NULL;
     }
 
-    mgr->conn = conn;
+    /* If the connection cannot be pooled, it is closed with the response. */
+    if (vlc_http_mgr_add(mgr, conn, false, false, host, port))
+        vlc_http_conn_release(conn);
     return resp;
 }
 
@@ -273,14 +359,14 @@ struct vlc_http_mgr *vlc_http_mgr_create(vlc_object_t *obj,
     mgr->obj = obj;
     mgr->creds = NULL;
     mgr->jar = jar;
-    mgr->conn = NULL;
+    mgr->pool_size = 0;
     return mgr;
 }
 
 void vlc_http_mgr_destroy(struct vlc_http_mgr *mgr)
 {
-    if (mgr->conn != NULL)
-        vlc_http_mgr_release(mgr, mgr->conn);
+    while (mgr->pool_size > 0)
+        vlc_http_mgr_release(mgr, mgr->pool_size - 1);
     if (mgr->creds != NULL)
         vlc_tls_Delete(mgr->creds);
     free(mgr);
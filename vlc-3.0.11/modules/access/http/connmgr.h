@@ -35,9 +35,10 @@ struct vlc_http_cookie_jar_t;
 /**
  * Sends an HTTP request
  *
- * Sends an HTTP request, by either reusing an existing HTTP connection or
- * establishing a new one. If succesful, the initial HTTP response header is
- * returned.
+ * Sends an HTTP request, by either reusing an existing HTTP connection to the
+ * same origin or establishing a new one. HTTP/2 connections are shared by
+ * concurrent requests, whereas HTTP/1.x connections are reused once idle.
+ * If succesful, the initial HTTP response header is returned.
  *
  * @param mgr HTTP connection manager
  * @param https whether to use HTTPS (true) or unencrypted HTTP (false)
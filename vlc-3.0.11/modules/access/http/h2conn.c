@@ -76,6 +76,7 @@ struct vlc_h2_stream
     int recv_err; /**< Standard C error code */
     struct vlc_http_msg *recv_hdr; /**< Latest received headers (or NULL) */
 
+    size_t recv_window; /**< Receive congestion window size */
     size_t recv_cwnd; /**< Free space in receive congestion window */
     struct vlc_h2_frame *recv_head; /**< Earliest pending received buffer */
     struct vlc_h2_frame **recv_tailp; /**< Tail of receive queue */
@@ -303,10 +304,28 @@ static block_t *vlc_h2_stream_read(struct vlc_http_stream *stream)
     }
 
     /* Credit the receive window if missing credit exceeds 50%. */
-    uint_fast32_t credit = VLC_H2_INIT_WINDOW - s->recv_cwnd;
-    if (credit >= (VLC_H2_INIT_WINDOW / 2)
-     && !vlc_h2_conn_queue(conn, vlc_h2_frame_window_update(s->id, credit)))
-        s->recv_cwnd += credit;
+    uint_fast32_t credit = s->recv_window - s->recv_cwnd;
+    if (credit >= (s->recv_window / 2))
+    {
+        size_t window = s->recv_window;
+
+        /* If the reader caught up with the peer, the window is likely too
+         * small for the bandwidth-delay product: grow it, up to a limit. */
+        if (s->recv_head == NULL && window < VLC_H2_MAX_WINDOW)
+        {
+            window *= 2;
+            if (window > VLC_H2_MAX_WINDOW)
+                window = VLC_H2_MAX_WINDOW;
+            credit += window - s->recv_window;
+        }
+
+        if (!vlc_h2_conn_queue(conn,
+                               vlc_h2_frame_window_update(s->id, credit)))
+        {
+            s->recv_window = window;
+            s->recv_cwnd += credit;
+        }
+    }
 
     vlc_h2_stream_unlock(s);
 
@@ -411,6 +430,7 @@ static struct vlc_http_stream *vlc_h2_stream_open(struct vlc_http_conn *c,
     s->recv_end = false;
     s->recv_err = 0;
     s->recv_hdr = NULL;
+    s->recv_window = VLC_H2_INIT_WINDOW;
     s->recv_cwnd = VLC_H2_INIT_WINDOW;
     s->recv_head = NULL;
     s->recv_tailp = &s->recv_head;
@@ -84,6 +84,34 @@ static void conn_expect(uint_fast8_t wanted)
     while (got != wanted);
 }
 
+/* Skips frames until a stream window update, and returns its credit */
+static uint_fast32_t conn_expect_credit(uint_fast32_t id)
+{
+    ssize_t val;
+    uint8_t hdr[9];
+
+    for (;;)
+    {
+        val = vlc_tls_Read(external_tls, hdr, 9, true);
+        assert(val == 9);
+
+        size_t len = (hdr[0] << 16) | (hdr[1] << 8) | hdr[2];
+        uint8_t buf[len ? len : 1];
+
+        if (len > 0)
+        {
+            val = vlc_tls_Read(external_tls, buf, len, true);
+            assert(val == (ssize_t)len);
+        }
+
+        if (hdr[3] == WINDOW_UPDATE && GetDWBE(hdr + 5) == id)
+        {
+            assert(len == 4);
+            return GetDWBE(buf) & 0x7fffffff;
+        }
+    }
+}
+
 static void conn_create(void)
 {
     ssize_t val;
@@ -148,6 +176,15 @@ static void stream_data(uint_fast32_t id, const char *str, bool eos)
     conn_send(vlc_h2_frame_data(id, str, strlen(str), eos));
 }
 
+static void stream_blob(uint_fast32_t id, size_t len, bool eos)
+{
+    char *buf = malloc(len);
+    assert(buf != NULL);
+    memset(buf, 'x', len);
+    conn_send(vlc_h2_frame_data(id, buf, len, eos));
+    free(buf);
+}
+
 /* TODO: check messages coming from the connection under test */
 
 int main(void)
@@ -273,6 +310,31 @@ int main(void)
     conn_expect(RST_STREAM);
     /* might or might not seen one or two extra RST_STREAM now */
 
+    /* Test large frames and receive window growth */
+    sid += 2;
+    s = stream_open();
+    assert(s != NULL);
+    stream_reply(sid, false);
+    m = vlc_http_msg_get_initial(s);
+    assert(m != NULL);
+    stream_blob(sid, VLC_H2_INIT_WINDOW / 2 + 1, false);
+    b = vlc_http_msg_read(m);
+    assert(b != NULL);
+    assert(b->i_buffer == VLC_H2_INIT_WINDOW / 2 + 1); /* not split/copied */
+    block_Release(b);
+    /* Reader caught up: the window is credited and doubled */
+    assert(conn_expect_credit(sid) == VLC_H2_INIT_WINDOW / 2 + 1
+                                      + VLC_H2_INIT_WINDOW);
+    /* The peer can now send more than the initial window */
+    stream_blob(sid, VLC_H2_INIT_WINDOW + 1, true);
+    b = vlc_http_msg_read(m);
+    assert(b != NULL);
+    assert(b->i_buffer == VLC_H2_INIT_WINDOW + 1);
+    block_Release(b);
+    b = vlc_http_msg_read(m);
+    assert(b == NULL);
+    vlc_http_msg_destroy(m);
+
     /* Test graceful connection termination */
     sid += 2;
     s = stream_open();
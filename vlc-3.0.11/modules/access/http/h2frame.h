@@ -90,6 +90,7 @@ const char *vlc_h2_setting_name(uint_fast16_t);
 #define VLC_H2_INIT_WINDOW     1048575 /* Initial congestion window size */
 #define VLC_H2_MAX_FRAME       1048576 /* Frame size */
 #define VLC_H2_MAX_HEADER_LIST   65536 /* Header (decompressed) list size */
+#define VLC_H2_MAX_WINDOW     16777215 /* Largest stream receive window */
 
 /* Protocol default settings */
 #define VLC_H2_DEFAULT_MAX_HEADER_TABLE  4096
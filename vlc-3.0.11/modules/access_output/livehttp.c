@@ -43,6 +43,8 @@
 #include <vlc_fs.h>
 #include <vlc_strings.h>
 #include <vlc_charset.h>
+#include <vlc_httpd.h>
+#include <vlc_memstream.h>
 
 #include <gcrypt.h>
 #include <vlc_gcrypt.h>
@@ -105,6 +107,20 @@ static void Close( vlc_object_t * );
 #define INTITIAL_SEG_TEXT N_("Number of first segment")
 #define INITIAL_SEG_LONGTEXT N_("The number of the first segment generated")
 
+#define HTTP_TEXT N_("Serve from memory")
+#define HTTP_LONGTEXT N_("Keep the segments in memory and serve them, along "\
+                         "with the index, through the HTTP server instead of "\
+                         "writing files. The index and segment paths are then "\
+                         "URL paths, and segments are served as "\
+                         "<path>?seq=<number>. Requires a number of segments.")
+
+#define PARTLEN_TEXT N_("Partial segment length")
+#define PARTLEN_LONGTEXT N_("Target duration in milliseconds of the "\
+                            "low-latency partial segments listed in the index "\
+                            "when serving from memory (0 to disable). Parts "\
+                            "are cut between blocks, before the one that "\
+                            "would make them longer.")
+
 vlc_module_begin ()
     set_description( N_("HTTP Live streaming output") )
     set_shortname( N_("LiveHTTP" ))
@@ -135,6 +151,10 @@ vlc_module_begin ()
                 KEYFILE_TEXT, KEYFILE_LONGTEXT, true )
     add_loadfile( SOUT_CFG_PREFIX "key-loadfile", NULL,
                 KEYLOADFILE_TEXT, KEYLOADFILE_LONGTEXT, true )
+    add_bool( SOUT_CFG_PREFIX "http", false,
+              HTTP_TEXT, HTTP_LONGTEXT, false )
+    add_integer( SOUT_CFG_PREFIX "part-length", 0,
+                 PARTLEN_TEXT, PARTLEN_LONGTEXT, true )
     set_callbacks( Open, Close )
 vlc_module_end ()
 
@@ -156,12 +176,22 @@ static const char *const ppsz_sout_options[] = {
     "key-loadfile",
     "generate-iv",
     "initial-segment-number",
+    "http",
+    "part-length",
     NULL
 };
 
 static ssize_t Write( sout_access_out_t *, block_t * );
 static int Control( sout_access_out_t *, int, va_list );
 
+typedef struct output_part
+{
+    size_t i_offset;
+    size_t i_size;
+    mtime_t i_duration;
+    bool b_independent;
+} output_part_t;
+
 typedef struct output_segment
 {
     char *psz_filename;
@@ -171,6 +201,13 @@ typedef struct output_segment
     float f_seglength;
     uint32_t i_segment_number;
     uint8_t aes_ivs[16];
+
+    /* In-memory segment contents */
+    block_t *p_data;
+    block_t **pp_data_last;
+    size_t i_data;
+    output_part_t *p_parts;
+    unsigned i_parts;
 } output_segment_t;
 
 struct sout_access_out_sys_t
@@ -205,6 +242,24 @@ struct sout_access_out_sys_t
     uint8_t stuffing_bytes[16];
     ssize_t stuffing_size;
     vlc_array_t segments_t;
+
+    /* In-memory origin */
+    bool b_memory;
+    bool b_ongoing_published;
+    httpd_host_t *p_httpd_host;
+    httpd_url_t *p_index_url;
+    httpd_url_t *p_segment_url;
+    vlc_mutex_t lock; /* segments and index, as seen by the HTTP server */
+    char *psz_index;
+    size_t i_index;
+    output_segment_t *p_memseg;
+    mtime_t i_partlenm;
+    mtime_t i_part_target; /* longest part, at least i_partlenm */
+    mtime_t i_part_start;
+    mtime_t i_memseg_end; /* end time of the data in the open segment */
+    size_t i_part_offset;
+    bool b_part_independent;
+    bool b_part_cut; /* parts were added since the index was updated */
 };
 
 static int LoadCryptFile( sout_access_out_t *p_access);
@@ -212,6 +267,8 @@ static int CryptSetup( sout_access_out_t *p_access, char *keyfile );
 static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer );
 static ssize_t writeSegment( sout_access_out_t *p_access );
 static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys );
+static int memOriginOpen( sout_access_out_t *p_access );
+static void memOriginClose( sout_access_out_t *p_access );
 /*****************************************************************************
  * Open: open the file
  *****************************************************************************/
@@ -250,6 +307,7 @@ static int Open( vlc_object_t *p_this )
     p_sys->b_caching = var_GetBool( p_access, SOUT_CFG_PREFIX "caching") ;
     p_sys->b_generate_iv = var_GetBool( p_access, SOUT_CFG_PREFIX "generate-iv") ;
     p_sys->b_segment_has_data = false;
+    p_sys->b_memory = var_GetBool( p_access, SOUT_CFG_PREFIX "http" );
 
     vlc_array_init( &p_sys->segments_t );
 
@@ -270,10 +328,19 @@ static int Open( vlc_object_t *p_this )
             return VLC_ENOMEM;
         }
         p_sys->psz_indexPath = psz_tmp;
-        if( p_sys->i_initial_segment != 1 )
+        if( p_sys->i_initial_segment != 1 && !p_sys->b_memory )
             vlc_unlink( p_sys->psz_indexPath );
     }
 
+    if( p_sys->b_memory && ( !p_sys->psz_indexPath || !p_sys->i_numsegs ) )
+    {
+        msg_Err( p_access, "serving from memory needs an index and a number "
+                 "of segments" );
+        free( p_sys->psz_indexPath );
+        free( p_sys );
+        return VLC_EGENERIC;
+    }
+
     p_sys->psz_indexUrl = var_GetNonEmptyString( p_access, SOUT_CFG_PREFIX "index-url" );
     p_sys->psz_keyfile  = var_GetNonEmptyString( p_access, SOUT_CFG_PREFIX "key-loadfile" );
     p_sys->key_uri      = var_GetNonEmptyString( p_access, SOUT_CFG_PREFIX "key-uri" );
@@ -300,6 +367,22 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_handle = -1;
     p_sys->i_segment = p_sys->i_initial_segment-1;
     p_sys->psz_cursegPath = NULL;
+    vlc_mutex_init( &p_sys->lock );
+
+    if( p_sys->b_memory && memOriginOpen( p_access ) )
+    {
+        vlc_mutex_destroy( &p_sys->lock );
+        if( p_sys->key_uri )
+        {
+            gcry_cipher_close( p_sys->aes_ctx );
+            free( p_sys->key_uri );
+        }
+        free( p_sys->psz_keyfile );
+        free( p_sys->psz_indexUrl );
+        free( p_sys->psz_indexPath );
+        free( p_sys );
+        return VLC_EGENERIC;
+    }
 
     p_access->pf_write = Write;
     p_access->pf_control = Control;
@@ -510,9 +593,285 @@ static void destroySegment( output_segment_t *segment )
     free( segment->psz_duration );
     free( segment->psz_uri );
     free( segment->psz_key_uri );
+    block_ChainRelease( segment->p_data );
+    free( segment->p_parts );
     free( segment );
 }
 
+static bool segmentIsOpen( const sout_access_out_sys_t *p_sys )
+{
+    return p_sys->b_memory ? p_sys->p_memseg != NULL : p_sys->i_handle >= 0;
+}
+
+/*****************************************************************************
+ * In-memory origin: the index and the segment window are kept in memory and
+ * served by httpd. Segments are served with byte ranges, so that the partial
+ * segments of the one being filled can be listed as byte ranges thereof.
+ *****************************************************************************/
+static void memSegmentAppend( sout_access_out_t *p_access, block_t *p_block )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    output_segment_t *segment = p_sys->p_memseg;
+
+    if( segment->i_data == p_sys->i_part_offset )
+        p_sys->b_part_independent = ( p_block->i_flags & BLOCK_FLAG_HEADER ) != 0;
+
+    /* The HTTP server sends references to the payload */
+    p_block = block_shared_Alloc( p_block );
+    if( unlikely( p_block == NULL ) )
+        return;
+
+    vlc_mutex_lock( &p_sys->lock );
+    segment->i_data += p_block->i_buffer;
+    block_ChainLastAppend( &segment->pp_data_last, p_block );
+    vlc_mutex_unlock( &p_sys->lock );
+}
+
+/************************************************************************
+ * memPartCheck: ends the current partial segment before the data up to
+ * i_next would make it longer than the part length, or if the segment
+ * ends. A part is only longer than that if a single block is.
+ ************************************************************************/
+static void memPartCheck( sout_access_out_t *p_access, mtime_t i_next,
+                          bool b_final )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    output_segment_t *segment = p_sys->p_memseg;
+
+    if( p_sys->i_partlenm == 0 || segment->i_data == p_sys->i_part_offset )
+        return;
+
+    mtime_t i_end = p_sys->i_memseg_end;
+    if( !b_final && i_next - p_sys->i_part_start <= p_sys->i_partlenm )
+        return;
+
+    output_part_t *p_parts = realloc( segment->p_parts,
+                                      ( segment->i_parts + 1 ) * sizeof( *p_parts ) );
+    if( unlikely( !p_parts ) )
+        return;
+
+    output_part_t *part = &p_parts[segment->i_parts];
+    part->i_offset = p_sys->i_part_offset;
+    part->i_size = segment->i_data - p_sys->i_part_offset;
+    part->i_duration = i_end - p_sys->i_part_start;
+    part->b_independent = p_sys->b_part_independent;
+
+    /* Only the sout thread ever looks at the parts */
+    segment->p_parts = p_parts;
+    segment->i_parts++;
+    if( part->i_duration > p_sys->i_part_target ) /* in whole ms */
+        p_sys->i_part_target = ( part->i_duration + 999 ) / 1000 * 1000;
+
+    p_sys->i_part_offset = segment->i_data;
+    p_sys->i_part_start = i_end;
+    p_sys->b_part_cut = true;
+}
+
+static void memAnswerInit( httpd_message_t *answer, int i_status )
+{
+    answer->i_proto  = HTTPD_PROTO_HTTP;
+    answer->i_version= 1;
+    answer->i_type   = HTTPD_MSG_ANSWER;
+    answer->i_status = i_status;
+    answer->i_body   = 0;
+    answer->p_body   = NULL;
+}
+
+static int memIndexCallback( httpd_callback_sys_t *p_cbsys, httpd_client_t *cl,
+                             httpd_message_t *answer,
+                             const httpd_message_t *query )
+{
+    sout_access_out_t *p_access = (sout_access_out_t *)p_cbsys;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    VLC_UNUSED(cl);
+
+    if( !answer || !query )
+        return VLC_SUCCESS;
+
+    vlc_mutex_lock( &p_sys->lock );
+    if( p_sys->psz_index == NULL )
+    {
+        vlc_mutex_unlock( &p_sys->lock );
+        memAnswerInit( answer, 404 );
+        httpd_MsgAdd( answer, "Content-Length", "0" );
+        return VLC_SUCCESS;
+    }
+
+    memAnswerInit( answer, 200 );
+    httpd_MsgAdd( answer, "Content-Type", "application/vnd.apple.mpegurl" );
+    httpd_MsgAdd( answer, "Cache-Control", "no-cache" );
+    httpd_MsgAdd( answer, "Content-Length", "%zu", p_sys->i_index );
+    if( query->i_type != HTTPD_MSG_HEAD )
+    {
+        answer->p_body = malloc( p_sys->i_index );
+        if( likely( answer->p_body != NULL ) )
+        {
+            memcpy( answer->p_body, p_sys->psz_index, p_sys->i_index );
+            answer->i_body = p_sys->i_index;
+        }
+    }
+    vlc_mutex_unlock( &p_sys->lock );
+    return VLC_SUCCESS;
+}
+
+static int memSegmentCallback( httpd_callback_sys_t *p_cbsys, httpd_client_t *cl,
+                               httpd_message_t *answer,
+                               const httpd_message_t *query )
+{
+    sout_access_out_t *p_access = (sout_access_out_t *)p_cbsys;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    uint32_t i_number;
+    VLC_UNUSED(cl);
+
+    if( !answer || !query )
+        return VLC_SUCCESS;
+
+    const char *psz_args = (const char *)query->psz_args;
+    if( psz_args == NULL
+     || sscanf( psz_args, "seq=%"SCNu32, &i_number ) != 1 )
+    {
+        memAnswerInit( answer, 400 );
+        httpd_MsgAdd( answer, "Content-Length", "0" );
+        return VLC_SUCCESS;
+    }
+
+    vlc_mutex_lock( &p_sys->lock );
+
+    output_segment_t *segment = NULL;
+    for( size_t i = 0; i < vlc_array_count( &p_sys->segments_t ); i++ )
+    {
+        output_segment_t *cur = vlc_array_item_at_index( &p_sys->segments_t, i );
+        if( cur->i_segment_number == i_number )
+        {
+            segment = cur;
+            break;
+        }
+    }
+
+    /* Segments are listed once complete; only parts of the one being filled
+     * can be requested, by range */
+    const char *psz_range = httpd_MsgGet( query, "Range" );
+    bool b_complete = segment != NULL && segment->psz_duration != NULL;
+    uint64_t i_start = 0, i_end = 0;
+    int i_range = ( segment != NULL && psz_range != NULL )
+        ? httpd_ParseRange( psz_range, segment->i_data, &i_start, &i_end ) : -1;
+
+    if( segment == NULL || i_range > 0 || ( !b_complete && i_range < 0 ) )
+    {
+        memAnswerInit( answer, segment != NULL && psz_range != NULL ? 416 : 404 );
+        if( i_range > 0 && b_complete )
+            httpd_MsgAdd( answer, "Content-Range", "bytes */%zu",
+                          segment->i_data );
+        vlc_mutex_unlock( &p_sys->lock );
+        httpd_MsgAdd( answer, "Content-Length", "0" );
+        return VLC_SUCCESS;
+    }
+
+    if( i_range < 0 )
+    {
+        i_start = 0;
+        i_end = segment->i_data;
+    }
+
+    memAnswerInit( answer, i_range == 0 ? 206 : 200 );
+    httpd_MsgAdd( answer, "Content-Type", "video/MP2T" );
+    httpd_MsgAdd( answer, "Accept-Ranges", "bytes" );
+    httpd_MsgAdd( answer, "Content-Length", "%"PRIu64, i_end - i_start );
+    if( i_range == 0 )
+    {
+        if( b_complete )
+            httpd_MsgAdd( answer, "Content-Range",
+                          "bytes %"PRIu64"-%"PRIu64"/%zu",
+                          i_start, i_end - 1, segment->i_data );
+        else
+            httpd_MsgAdd( answer, "Content-Range",
+                          "bytes %"PRIu64"-%"PRIu64"/*", i_start, i_end - 1 );
+    }
+
+    if( query->i_type != HTTPD_MSG_HEAD && i_end > i_start )
+    {
+        /* Hand references to the (shared) segment blocks to the server */
+        block_t *p_chain = NULL, **pp_last = &p_chain;
+        uint64_t i_offset = 0;
+
+        for( block_t *p_block = segment->p_data;
+             p_block != NULL && i_offset < i_end;
+             p_block = p_block->p_next )
+        {
+            uint64_t i_from = __MAX( i_start, i_offset );
+            uint64_t i_to = __MIN( i_end, i_offset + p_block->i_buffer );
+
+            if( i_from < i_to )
+            {
+                block_t *p_ref = block_Share( p_block );
+                if( unlikely( p_ref == NULL ) )
+                    break;
+                p_ref->p_buffer += i_from - i_offset;
+                p_ref->i_buffer = i_to - i_from;
+                block_ChainLastAppend( &pp_last, p_ref );
+            }
+            i_offset += p_block->i_buffer;
+        }
+        httpd_ClientSetBodyChain( cl, p_chain );
+    }
+    vlc_mutex_unlock( &p_sys->lock );
+    return VLC_SUCCESS;
+}
+
+static int memOriginOpen( sout_access_out_t *p_access )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    if( p_sys->key_uri == NULL )
+        p_sys->i_partlenm = (mtime_t)1000 *
+            var_GetInteger( p_access, SOUT_CFG_PREFIX "part-length" );
+    else if( var_GetInteger( p_access, SOUT_CFG_PREFIX "part-length" ) > 0 )
+        msg_Warn( p_access, "partial segments are not available "
+                  "with encryption" );
+    p_sys->i_part_target = p_sys->i_partlenm;
+
+    p_sys->p_httpd_host = vlc_http_HostNew( VLC_OBJECT(p_access) );
+    if( p_sys->p_httpd_host == NULL )
+        return VLC_EGENERIC;
+
+    p_sys->p_index_url = httpd_UrlNew( p_sys->p_httpd_host,
+                                       p_sys->psz_indexPath, NULL, NULL );
+    p_sys->p_segment_url = httpd_UrlNew( p_sys->p_httpd_host,
+                                         p_access->psz_path, NULL, NULL );
+    if( p_sys->p_index_url == NULL || p_sys->p_segment_url == NULL )
+    {
+        msg_Err( p_access, "cannot serve %s and %s", p_sys->psz_indexPath,
+                 p_access->psz_path );
+        memOriginClose( p_access );
+        return VLC_EGENERIC;
+    }
+
+    httpd_UrlCatch( p_sys->p_index_url, HTTPD_MSG_GET, memIndexCallback,
+                    (httpd_callback_sys_t *)p_access );
+    httpd_UrlCatch( p_sys->p_index_url, HTTPD_MSG_HEAD, memIndexCallback,
+                    (httpd_callback_sys_t *)p_access );
+    httpd_UrlCatch( p_sys->p_segment_url, HTTPD_MSG_GET, memSegmentCallback,
+                    (httpd_callback_sys_t *)p_access );
+    httpd_UrlCatch( p_sys->p_segment_url, HTTPD_MSG_HEAD, memSegmentCallback,
+                    (httpd_callback_sys_t *)p_access );
+
+    msg_Dbg( p_access, "serving %s and %s from memory", p_sys->psz_indexPath,
+             p_access->psz_path );
+    return VLC_SUCCESS;
+}
+
+static void memOriginClose( sout_access_out_t *p_access )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    if( p_sys->p_index_url )
+        httpd_UrlDelete( p_sys->p_index_url );
+    if( p_sys->p_segment_url )
+        httpd_UrlDelete( p_sys->p_segment_url );
+    httpd_HostDelete( p_sys->p_httpd_host );
+    free( p_sys->psz_index );
+}
+
 /************************************************************************
  * segmentAmountNeeded: check that playlist has atleast 3*p_sys->i_seglength of segments
  * return how many segments are needed for that (max of p_sys->i_segment )
@@ -555,6 +914,110 @@ static bool isFirstItemRemovable( sout_access_out_sys_t *p_sys, uint32_t i_first
     return duration >= (first->f_seglength + (float)(p_sys->i_numsegs * p_sys->i_seglen));
 }
 
+#define PRINTF_MS( d ) (unsigned)( (d) / CLOCK_FREQ ), \
+                       (unsigned)( (d) % CLOCK_FREQ / 1000 )
+
+/************************************************************************
+ * formatIndex: write the index contents
+ ************************************************************************/
+static char *formatIndex( sout_access_out_sys_t *p_sys, uint32_t i_firstseg,
+                          unsigned i_index_offset, bool b_isend, size_t *pi_len )
+{
+    struct vlc_memstream ms;
+    bool b_parts = p_sys->i_partlenm > 0;
+    uint32_t i_firstpartseg = p_sys->i_segment + 1;
+
+    if( vlc_memstream_open( &ms ) )
+        return NULL;
+
+    vlc_memstream_printf( &ms, "#EXTM3U\n#EXT-X-TARGETDURATION:%zu\n#EXT-X-VERSION:%d\n#EXT-X-ALLOW-CACHE:%s"
+                      "%s\n#EXT-X-MEDIA-SEQUENCE:%"PRIu32"\n%s", p_sys->i_seglen,
+                      b_parts ? 6 : 3,
+                      p_sys->b_caching ? "YES" : "NO",
+                      p_sys->i_numsegs > 0 ? "" : b_isend ? "\n#EXT-X-PLAYLIST-TYPE:VOD" : "\n#EXT-X-PLAYLIST-TYPE:EVENT",
+                      i_firstseg, ((p_sys->i_initial_segment > 1) && (p_sys->i_initial_segment == i_firstseg)) ? "#EXT-X-DISCONTINUITY\n" : ""
+                      );
+
+    if( b_parts )
+    {
+        /* Parts are listed for the last 3 target durations */
+        float duration = .0f;
+
+        vlc_memstream_printf( &ms, "#EXT-X-SERVER-CONTROL:PART-HOLD-BACK=%u.%03u\n"
+                              "#EXT-X-PART-INF:PART-TARGET=%u.%03u\n",
+                              PRINTF_MS( 3 * p_sys->i_part_target ),
+                              PRINTF_MS( p_sys->i_part_target ) );
+
+        while( i_firstpartseg > i_firstseg &&
+               duration < (float)( 3 * p_sys->i_seglen ) )
+        {
+            i_firstpartseg--;
+            output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t,
+                                    i_firstpartseg - i_firstseg + i_index_offset );
+            duration += segment->f_seglength;
+        }
+    }
+
+    char *psz_current_uri=NULL;
+
+    for ( uint32_t i = i_firstseg; i <= p_sys->i_segment; i++ )
+    {
+        //scale to i_index_offset..numsegs + i_index_offset
+        uint32_t index = i - i_firstseg + i_index_offset;
+
+        output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, index );
+        if( p_sys->key_uri &&
+            ( !psz_current_uri ||  strcmp( psz_current_uri, segment->psz_key_uri ) )
+          )
+        {
+            free( psz_current_uri );
+            psz_current_uri = strdup( segment->psz_key_uri );
+            if( p_sys->b_generate_iv )
+            {
+                unsigned long long iv_hi = segment->aes_ivs[0];
+                unsigned long long iv_lo = segment->aes_ivs[8];
+                for( unsigned short j = 1; j < 8; j++ )
+                {
+                    iv_hi <<= 8;
+                    iv_hi |= segment->aes_ivs[j] & 0xff;
+                    iv_lo <<= 8;
+                    iv_lo |= segment->aes_ivs[8+j] & 0xff;
+                }
+                vlc_memstream_printf( &ms, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\",IV=0X%16.16llx%16.16llx\n",
+                                      segment->psz_key_uri, iv_hi, iv_lo );
+
+            } else {
+                vlc_memstream_printf( &ms, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\"\n", segment->psz_key_uri );
+            }
+        }
+
+        if( i >= i_firstpartseg )
+            for( unsigned j = 0; j < segment->i_parts; j++ )
+            {
+                const output_part_t *part = &segment->p_parts[j];
+
+                vlc_memstream_printf( &ms, "#EXT-X-PART:DURATION=%u.%03u,URI=\"%s\","
+                                      "BYTERANGE=\"%zu@%zu\"%s\n",
+                                      PRINTF_MS( part->i_duration ), segment->psz_uri,
+                                      part->i_size, part->i_offset,
+                                      part->b_independent ? ",INDEPENDENT=YES" : "" );
+            }
+
+        /* The segment being filled only has parts so far */
+        if( segment->psz_duration != NULL )
+            vlc_memstream_printf( &ms, "#EXTINF:%s,\n%s\n", segment->psz_duration, segment->psz_uri);
+    }
+    free( psz_current_uri );
+
+    if ( b_isend )
+        vlc_memstream_puts( &ms, STR_ENDLIST );
+
+    if( vlc_memstream_close( &ms ) )
+        return NULL;
+    *pi_len = ms.length;
+    return ms.ptr;
+}
+
 /************************************************************************
  * updateIndexAndDel: If necessary, update index file & delete old segments
  ************************************************************************/
@@ -564,6 +1027,8 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
     uint32_t i_firstseg;
     unsigned i_index_offset = 0;
 
+    p_sys->b_part_cut = false;
+
     if ( p_sys->i_numsegs == 0 ||
          p_sys->i_segment < ( p_sys->i_numsegs + p_sys->i_initial_segment ) )
     {
@@ -582,91 +1047,45 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
         int val;
         FILE *fp;
         char *psz_idxTmp;
+        size_t i_index;
+        char *psz_index = formatIndex( p_sys, i_firstseg, i_index_offset,
+                                       b_isend, &i_index );
+        if ( !psz_index )
+            return -1;
+
+        if ( p_sys->b_memory )
+        {
+            vlc_mutex_lock( &p_sys->lock );
+            free( p_sys->psz_index );
+            p_sys->psz_index = psz_index;
+            p_sys->i_index = i_index;
+            vlc_mutex_unlock( &p_sys->lock );
+            goto delete;
+        }
+
         if ( asprintf( &psz_idxTmp, "%s.tmp", p_sys->psz_indexPath ) < 0)
+        {
+            free( psz_index );
             return -1;
+        }
 
         fp = vlc_fopen( psz_idxTmp, "wt");
         if ( !fp )
         {
             msg_Err( p_access, "cannot open index file `%s'", psz_idxTmp );
+            free( psz_index );
             free( psz_idxTmp );
             return -1;
         }
 
-        if ( fprintf( fp, "#EXTM3U\n#EXT-X-TARGETDURATION:%zu\n#EXT-X-VERSION:3\n#EXT-X-ALLOW-CACHE:%s"
-                          "%s\n#EXT-X-MEDIA-SEQUENCE:%"PRIu32"\n%s", p_sys->i_seglen,
-                          p_sys->b_caching ? "YES" : "NO",
-                          p_sys->i_numsegs > 0 ? "" : b_isend ? "\n#EXT-X-PLAYLIST-TYPE:VOD" : "\n#EXT-X-PLAYLIST-TYPE:EVENT",
-                          i_firstseg, ((p_sys->i_initial_segment > 1) && (p_sys->i_initial_segment == i_firstseg)) ? "#EXT-X-DISCONTINUITY\n" : ""
-                          ) < 0 )
+        val = fwrite( psz_index, 1, i_index, fp ) == i_index ? 0 : -1;
+        free( psz_index );
+        if ( val < 0 )
         {
             free( psz_idxTmp );
             fclose( fp );
             return -1;
         }
-        char *psz_current_uri=NULL;
-
-
-        for ( uint32_t i = i_firstseg; i <= p_sys->i_segment; i++ )
-        {
-            //scale to i_index_offset..numsegs + i_index_offset
-            uint32_t index = i - i_firstseg + i_index_offset;
-
-            output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, index );
-            if( p_sys->key_uri &&
-                ( !psz_current_uri ||  strcmp( psz_current_uri, segment->psz_key_uri ) )
-              )
-            {
-                int ret = 0;
-                free( psz_current_uri );
-                psz_current_uri = strdup( segment->psz_key_uri );
-                if( p_sys->b_generate_iv )
-                {
-                    unsigned long long iv_hi = segment->aes_ivs[0];
-                    unsigned long long iv_lo = segment->aes_ivs[8];
-                    for( unsigned short j = 1; j < 8; j++ )
-                    {
-                        iv_hi <<= 8;
-                        iv_hi |= segment->aes_ivs[j] & 0xff;
-                        iv_lo <<= 8;
-                        iv_lo |= segment->aes_ivs[8+j] & 0xff;
-                    }
-                    ret = fprintf( fp, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\",IV=0X%16.16llx%16.16llx\n",
-                                   segment->psz_key_uri, iv_hi, iv_lo );
-
-                } else {
-                    ret = fprintf( fp, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\"\n", segment->psz_key_uri );
-                }
-                if( ret < 0 )
-                {
-                    free( psz_current_uri );
-                    free( psz_idxTmp );
-                    fclose( fp );
-                    return -1;
-                }
-            }
-
-            val = fprintf( fp, "#EXTINF:%s,\n%s\n", segment->psz_duration, segment->psz_uri);
-            if ( val < 0 )
-            {
-                free( psz_current_uri );
-                free( psz_idxTmp );
-                fclose( fp );
-                return -1;
-            }
-        }
-        free( psz_current_uri );
-
-        if ( b_isend )
-        {
-            if ( fputs ( STR_ENDLIST, fp ) < 0)
-            {
-                free( psz_idxTmp );
-                fclose( fp ) ;
-                return -1;
-            }
-
-        }
         fclose( fp );
 
         val = vlc_rename ( psz_idxTmp, p_sys->psz_indexPath);
@@ -682,15 +1101,19 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
         free( psz_idxTmp );
     }
 
+delete:
     // Then take care of deletion
     // Try to follow pantos draft 11 section 6.2.2
-    while( p_sys->b_delsegs && p_sys->i_numsegs &&
+    // (segments in memory are always deleted)
+    while( ( p_sys->b_delsegs || p_sys->b_memory ) && p_sys->i_numsegs &&
            isFirstItemRemovable( p_sys, i_firstseg, i_index_offset )
          )
     {
          output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, 0 );
          msg_Dbg( p_access, "Removing segment number %d", segment->i_segment_number );
+         vlc_mutex_lock( &p_sys->lock );
          vlc_array_remove( &p_sys->segments_t, 0 );
+         vlc_mutex_unlock( &p_sys->lock );
 
          if ( segment->psz_filename )
          {
@@ -710,7 +1133,7 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
  *****************************************************************************/
 static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys, bool b_isend )
 {
-    if ( p_sys->i_handle >= 0 )
+    if ( segmentIsOpen( p_sys ) )
     {
         output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, vlc_array_count( &p_sys->segments_t ) - 1 );
 
@@ -722,6 +1145,13 @@ static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sy
 
             if( err ) {
                msg_Err( p_access, "Couldn't encrypt 16 bytes: %s", gpg_strerror(err) );
+            } else if( p_sys->b_memory ) {
+                block_t *p_stuffing = block_Alloc( 16 );
+                if( likely( p_stuffing ) )
+                {
+                    memcpy( p_stuffing->p_buffer, p_sys->stuffing_bytes, 16 );
+                    memSegmentAppend( p_access, p_stuffing );
+                }
             } else {
 
             int ret = vlc_write( p_sys->i_handle, p_sys->stuffing_bytes, 16 );
@@ -732,14 +1162,27 @@ static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sy
         }
 
 
-        vlc_close( p_sys->i_handle );
-        p_sys->i_handle = -1;
+        if( p_sys->b_memory )
+        {
+            memPartCheck( p_access, 0, true );
+            p_sys->p_memseg = NULL;
+        }
+        else
+        {
+            vlc_close( p_sys->i_handle );
+            p_sys->i_handle = -1;
+        }
 
-        if( ! ( us_asprintf( &segment->psz_duration, "%.2f", p_sys->f_seglen ) ) )
+        char *psz_duration;
+        if( ! ( us_asprintf( &psz_duration, "%.2f", p_sys->f_seglen ) ) )
         {
             msg_Err( p_access, "Couldn't set duration on closed segment");
             return;
         }
+        /* The segment is now complete */
+        vlc_mutex_lock( &p_sys->lock );
+        segment->psz_duration = psz_duration;
+        vlc_mutex_unlock( &p_sys->lock );
         segment->f_seglength = p_sys->f_seglen;
 
         segment->i_segment_number = p_sys->i_segment;
@@ -804,6 +1247,9 @@ static void Close( vlc_object_t * p_this )
         free( p_sys->key_uri );
     }
 
+    if( p_sys->b_memory )
+        memOriginClose( p_access );
+
     while( vlc_array_count( &p_sys->segments_t ) > 0 )
     {
         output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, 0 );
@@ -817,6 +1263,7 @@ static void Close( vlc_object_t * p_this )
         destroySegment( segment );
     }
 
+    vlc_mutex_destroy( &p_sys->lock );
     free( p_sys->psz_indexUrl );
     free( p_sys->psz_indexPath );
     free( p_sys );
@@ -859,28 +1306,45 @@ static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t
         return -1;
 
     segment->i_segment_number = i_newseg;
-    segment->psz_filename = formatSegmentPath( p_access->psz_path, i_newseg );
+    segment->pp_data_last = &segment->p_data;
     char *psz_idxFormat = p_sys->psz_indexUrl ? p_sys->psz_indexUrl : p_access->psz_path;
-    segment->psz_uri = formatSegmentPath( psz_idxFormat , i_newseg );
 
-    if ( unlikely( !segment->psz_filename ) )
+    if ( p_sys->b_memory )
     {
-        msg_Err( p_access, "Format segmentpath failed");
-        destroySegment( segment );
-        return -1;
+        /* All segments are served from the same URL */
+        if ( asprintf( &segment->psz_uri, "%s?seq=%"PRIu32, psz_idxFormat, i_newseg ) < 0 )
+        {
+            free( segment );
+            return -1;
+        }
+        fd = 0;
     }
-
-    fd = vlc_open( segment->psz_filename, O_WRONLY | O_CREAT | O_LARGEFILE |
-                     O_TRUNC, 0666 );
-    if ( fd == -1 )
+    else
     {
-        msg_Err( p_access, "cannot open `%s' (%s)", segment->psz_filename,
-                 vlc_strerror_c(errno) );
-        destroySegment( segment );
-        return -1;
+        segment->psz_filename = formatSegmentPath( p_access->psz_path, i_newseg );
+        segment->psz_uri = formatSegmentPath( psz_idxFormat , i_newseg );
+
+        if ( unlikely( !segment->psz_filename ) )
+        {
+            msg_Err( p_access, "Format segmentpath failed");
+            destroySegment( segment );
+            return -1;
+        }
+
+        fd = vlc_open( segment->psz_filename, O_WRONLY | O_CREAT | O_LARGEFILE |
+                         O_TRUNC, 0666 );
+        if ( fd == -1 )
+        {
+            msg_Err( p_access, "cannot open `%s' (%s)", segment->psz_filename,
+                     vlc_strerror_c(errno) );
+            destroySegment( segment );
+            return -1;
+        }
     }
 
+    vlc_mutex_lock( &p_sys->lock );
     vlc_array_append_or_abort( &p_sys->segments_t, segment );
+    vlc_mutex_unlock( &p_sys->lock );
 
     if( p_sys->psz_keyfile )
     {
@@ -894,10 +1358,22 @@ static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t
         if( p_sys->b_generate_iv )
             memcpy( segment->aes_ivs, p_sys->aes_ivs, sizeof(uint8_t)*16 );
     }
-    msg_Dbg( p_access, "Successfully opened livehttp file: %s (%"PRIu32")" , segment->psz_filename, i_newseg );
-
-    p_sys->psz_cursegPath = strdup(segment->psz_filename);
-    p_sys->i_handle = fd;
+    if ( p_sys->b_memory )
+    {
+        msg_Dbg( p_access, "Successfully opened livehttp segment: %s (%"PRIu32")" , segment->psz_uri, i_newseg );
+        p_sys->psz_cursegPath = strdup(segment->psz_uri);
+        p_sys->p_memseg = segment;
+        p_sys->f_seglen = 0;
+        p_sys->i_memseg_end = 0;
+        p_sys->i_part_start = 0;
+        p_sys->i_part_offset = 0;
+    }
+    else
+    {
+        msg_Dbg( p_access, "Successfully opened livehttp file: %s (%"PRIu32")" , segment->psz_filename, i_newseg );
+        p_sys->psz_cursegPath = strdup(segment->psz_filename);
+        p_sys->i_handle = fd;
+    }
     p_sys->i_segment = i_newseg;
     p_sys->b_segment_has_data = false;
     return fd;
@@ -910,7 +1386,7 @@ static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer )
     sout_access_out_sys_t *p_sys = p_access->p_sys;
     ssize_t writevalue = 0;
 
-    if( p_sys->i_handle > 0 && p_sys->b_segment_has_data &&
+    if( segmentIsOpen( p_sys ) && p_sys->b_segment_has_data &&
        (( p_buffer->i_length + p_buffer->i_dts - p_sys->i_opendts ) >= p_sys->i_seglenm ) )
     {
         writevalue = writeSegment( p_access );
@@ -923,7 +1399,7 @@ static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer )
         return writevalue;
     }
 
-    if ( unlikely( p_sys->i_handle < 0 ) )
+    if ( unlikely( !segmentIsOpen( p_sys ) ) )
     {
         p_sys->i_opendts = p_buffer->i_dts;
 
@@ -944,7 +1420,8 @@ static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer )
 static ssize_t writeSegment( sout_access_out_t *p_access )
 {
     sout_access_out_sys_t *p_sys = p_access->p_sys;
-    msg_Dbg( p_access, "Writing all full segments" );
+    if( !p_sys->b_memory )
+        msg_Dbg( p_access, "Writing all full segments" );
 
     block_t *output = p_sys->full_segments;
     mtime_t output_last_length = 0;
@@ -990,6 +1467,23 @@ static ssize_t writeSegment( sout_access_out_t *p_access )
 
         }
 
+        if ( p_sys->b_memory )
+        {
+            block_t *p_next = output->p_next;
+            output->p_next = NULL;
+
+            mtime_t i_next = output_last_length + output->i_dts
+                           - p_sys->i_opendts;
+            memPartCheck( p_access, i_next, false );
+            p_sys->i_memseg_end = i_next;
+            p_sys->f_seglen = (float)i_next / CLOCK_FREQ;
+            i_write += output->i_buffer;
+            memSegmentAppend( p_access, output );
+            output = p_next;
+            crypted=false;
+            continue;
+        }
+
         ssize_t val = vlc_write( p_sys->i_handle, output->p_buffer, output->i_buffer );
         if ( val == -1 )
         {
@@ -1031,12 +1525,17 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
         /* Check if current block is already past segment-length
             and we want to write gathered blocks into segment
             and update playlist */
-        if( p_sys->ongoing_segment && ( p_sys->b_splitanywhere  || ( p_buffer->i_flags & BLOCK_FLAG_HEADER ) ) )
+        if( ( p_sys->ongoing_segment || p_sys->b_ongoing_published ) &&
+            ( p_sys->b_splitanywhere  || ( p_buffer->i_flags & BLOCK_FLAG_HEADER ) ) )
         {
-            msg_Dbg( p_access, "Moving ongoing segment to full segments-queue" );
-            block_ChainLastAppend( &p_sys->full_segments_end, p_sys->ongoing_segment );
+            if( p_sys->ongoing_segment )
+            {
+                msg_Dbg( p_access, "Moving ongoing segment to full segments-queue" );
+                block_ChainLastAppend( &p_sys->full_segments_end, p_sys->ongoing_segment );
+            }
             p_sys->ongoing_segment = NULL;
             p_sys->ongoing_segment_end = &p_sys->ongoing_segment;
+            p_sys->b_ongoing_published = false;
             p_sys->b_segment_has_data = true;
         }
 
@@ -1052,6 +1551,28 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
         p_buffer->p_next = NULL;
         block_ChainLastAppend( &p_sys->ongoing_segment_end, p_buffer );
         p_buffer = p_temp;
+
+        /* When serving from memory, the data goes to the open segment right
+         * away, so that it can be served as partial segments */
+        if( p_sys->b_memory && segmentIsOpen( p_sys ) )
+        {
+            block_ChainLastAppend( &p_sys->full_segments_end, p_sys->ongoing_segment );
+            p_sys->ongoing_segment = NULL;
+            p_sys->ongoing_segment_end = &p_sys->ongoing_segment;
+            p_sys->b_ongoing_published = true;
+
+            ret = writeSegment( p_access );
+            if( ret < 0 )
+            {
+                msg_Err( p_access, "Error in write loop");
+                block_ChainRelease( p_buffer );
+                return ret;
+            }
+            i_write += ret;
+
+            if( p_sys->b_part_cut )
+                updateIndexAndDel( p_access, p_sys, false );
+        }
     }
 
     return i_write;
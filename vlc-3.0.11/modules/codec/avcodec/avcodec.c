@@ -97,6 +97,10 @@ vlc_module_begin ()
 
     add_obsolete_bool( "ffmpeg-dr" ) /* removed since 2.1.0 */
     add_bool( "avcodec-dr", true, DR_TEXT, DR_TEXT, true )
+    add_integer_with_range( "avcodec-pool-width", 0, 0, 8192,
+                            POOL_WIDTH_TEXT, POOL_SIZE_LONGTEXT, true )
+    add_integer_with_range( "avcodec-pool-height", 0, 0, 8192,
+                            POOL_HEIGHT_TEXT, POOL_SIZE_LONGTEXT, true )
     add_bool( "avcodec-corrupted", true, CORRUPTED_TEXT, CORRUPTED_LONGTEXT, false )
     add_obsolete_integer ( "ffmpeg-error-resilience" ) /* removed since 2.1.0 */
     add_integer ( "avcodec-error-resilience", 1, ERROR_TEXT,
@@ -136,6 +140,7 @@ vlc_module_begin ()
 #if defined(FF_THREAD_FRAME)
     add_obsolete_integer( "ffmpeg-threads" ) /* removed since 2.1.0 */
     add_integer( "avcodec-threads", 0, THREADS_TEXT, THREADS_LONGTEXT, true );
+    add_string( "avcodec-cpuset", NULL, CPUSET_TEXT, CPUSET_LONGTEXT, true )
 #endif
     add_string( "avcodec-options", NULL, AV_OPTIONS_TEXT, AV_OPTIONS_LONGTEXT, true )
 
@@ -56,6 +56,13 @@ int ffmpeg_OpenCodec( decoder_t *p_dec, AVCodecContext *, const AVCodec * );
 #define DR_TEXT N_("Direct rendering")
 /* FIXME Does somebody who knows what it does, explain */
 
+#define POOL_WIDTH_TEXT N_("Picture pool width")
+#define POOL_HEIGHT_TEXT N_("Picture pool height")
+#define POOL_SIZE_LONGTEXT N_("Allocate output pictures at least this " \
+    "large, so that resolution changes up to this size do not reallocate " \
+    "the picture pool. 0 meaning the size of the decoded video. The " \
+    "pictures are also kept at the largest size decoded so far.")
+
 #define CORRUPTED_TEXT N_("Show corrupted frames")
 #define CORRUPTED_LONGTEXT N_("Prefer visual artifacts instead of missing frames")
 
@@ -116,6 +123,12 @@ int ffmpeg_OpenCodec( decoder_t *p_dec, AVCodecContext *, const AVCodec * );
 #define THREADS_TEXT N_( "Threads" )
 #define THREADS_LONGTEXT N_( "Number of threads used for decoding, 0 meaning auto" )
 
+#define CPUSET_TEXT N_( "Decoding threads CPU set" )
+#define CPUSET_LONGTEXT N_( "Bind the decoding threads to this list of " \
+    "CPUs (e.g. \"0-7,16-23\"). Frame buffers are first written by these " \
+    "threads, so that they get allocated on the matching NUMA node. " \
+    "Empty meaning no binding." )
+
 /*
  * Encoder options
  */
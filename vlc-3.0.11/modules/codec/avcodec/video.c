@@ -35,6 +35,9 @@
 #include <vlc_cpu.h>
 #include <vlc_atomic.h>
 #include <assert.h>
+#ifdef __linux__
+# include <sched.h>
+#endif
 
 #include <libavcodec/avcodec.h>
 #include <libavutil/mem.h>
@@ -77,6 +80,11 @@ struct decoder_sys_t
     bool        b_direct_rendering;
     atomic_bool b_dr_failure;
 
+    /* Size the output pictures are allocated at, kept as long as the
+     * decoded frames fit in it */
+    int i_pool_width;
+    int i_pool_height;
+
     /* Hack to force display of still pictures */
     bool b_first_frame;
 
@@ -91,6 +99,12 @@ struct decoder_sys_t
     int profile;
     int level;
 
+#ifdef __linux__
+    /* CPUs the codec threads are bound to */
+    bool      b_cpuset;
+    cpu_set_t cpuset;
+#endif
+
     vlc_sem_t sem_mt;
 };
 
@@ -151,6 +165,20 @@ static int lavc_GetVideoFormat(decoder_t *dec, video_format_t *restrict fmt,
             fmt->i_chroma = VLC_CODEC_RGB32;
 
         avcodec_align_dimensions2(ctx, &width, &height, aligns);
+
+        /* Keep the current picture pool if the new frames fit in it: only
+         * the visible area changes then, and the video output does not
+         * reallocate its pictures (see vout_update_format()). */
+        const decoder_sys_t *sys = dec->p_sys;
+        if (sys->i_pool_width > 0 && sys->i_pool_height > 0)
+        {
+            int pool_width = sys->i_pool_width;
+            int pool_height = sys->i_pool_height;
+
+            avcodec_align_dimensions2(ctx, &pool_width, &pool_height, aligns);
+            width = __MAX(width, pool_width);
+            height = __MAX(height, pool_height);
+        }
     }
     else /* hardware decoding */
         fmt->i_chroma = vlc_va_GetChroma(pix_fmt, sw_pix_fmt);
@@ -332,6 +360,12 @@ static int lavc_UpdateVideoFormat(decoder_t *dec, AVCodecContext *ctx,
                                     __MAX(ctx->ticks_per_frame, 1),
                                     fmt_out.i_frame_rate_base);
 
+    if (fmt == swfmt)
+    {
+        dec->p_sys->i_pool_width = fmt_out.i_width;
+        dec->p_sys->i_pool_height = fmt_out.i_height;
+    }
+
     fmt_out.p_palette = dec->fmt_out.video.p_palette;
     dec->fmt_out.video.p_palette = NULL;
 
@@ -391,6 +425,41 @@ static int lavc_CopyPicture(decoder_t *dec, picture_t *pic, AVFrame *frame)
     return VLC_SUCCESS;
 }
 
+#ifdef __linux__
+/**
+ * Parses a CPU list such as "0-3,8,10-11".
+ */
+static int ParseCpuSet( const char *psz, cpu_set_t *set )
+{
+    CPU_ZERO( set );
+    while( *psz )
+    {
+        char *end;
+        unsigned long first = strtoul( psz, &end, 10 ), last = first;
+        if( end == psz )
+            return VLC_EGENERIC;
+        if( *end == '-' )
+        {
+            psz = end + 1;
+            last = strtoul( psz, &end, 10 );
+            if( end == psz || last < first )
+                return VLC_EGENERIC;
+        }
+        if( last >= CPU_SETSIZE )
+            return VLC_EGENERIC;
+        for( unsigned long i = first; i <= last; i++ )
+            CPU_SET( i, set );
+
+        psz = end;
+        if( *psz == ',' )
+            psz++;
+        else if( *psz )
+            return VLC_EGENERIC;
+    }
+    return CPU_COUNT( set ) > 0 ? VLC_SUCCESS : VLC_EGENERIC;
+}
+#endif
+
 static int OpenVideoCodec( decoder_t *p_dec )
 {
     decoder_sys_t *p_sys = p_dec->p_sys;
@@ -430,9 +499,30 @@ static int OpenVideoCodec( decoder_t *p_dec )
         ctx->flags |= AV_CODEC_FLAG_LOW_DELAY;
     }
 
+#ifdef __linux__
+    /* libavcodec creates its worker threads while opening the codec, and
+     * they inherit the affinity of the calling thread: bind it meanwhile. */
+    cpu_set_t saved_cpuset;
+    bool b_bound = false;
+    if( p_sys->b_cpuset )
+    {
+        if( sched_getaffinity( 0, sizeof(saved_cpuset), &saved_cpuset ) == 0
+         && sched_setaffinity( 0, sizeof(p_sys->cpuset), &p_sys->cpuset ) == 0 )
+            b_bound = true;
+        else
+            msg_Warn( p_dec, "cannot bind decoding threads: %s",
+                      vlc_strerror_c(errno) );
+    }
+#endif
+
     post_mt( p_sys );
     ret = ffmpeg_OpenCodec( p_dec, ctx, codec );
     wait_mt( p_sys );
+
+#ifdef __linux__
+    if( b_bound )
+        sched_setaffinity( 0, sizeof(saved_cpuset), &saved_cpuset );
+#endif
     if( ret < 0 )
         return ret;
 
@@ -550,16 +640,43 @@ int InitVideoDec( vlc_object_t *obj )
         p_sys->b_direct_rendering = true;
     }
 
+    /* Adaptive streams announce their largest representation, so that the
+     * pictures are allocated once for all the resolution switches */
+    p_sys->i_pool_width = var_InheritInteger( p_dec, "avcodec-pool-width" );
+    p_sys->i_pool_height = var_InheritInteger( p_dec, "avcodec-pool-height" );
+    if( p_sys->i_pool_width > 0 && p_sys->i_pool_height > 0 )
+        msg_Dbg( p_dec, "allocating pictures of at least %dx%d",
+                 p_sys->i_pool_width, p_sys->i_pool_height );
+
     p_context->get_format = ffmpeg_GetFormat;
     /* Always use our get_buffer wrapper so we can calculate the
      * PTS correctly */
     p_context->get_buffer2 = lavc_GetFrame;
     p_context->opaque = p_dec;
 
+    int i_cpu_count = vlc_GetCPUCount();
+    char *psz_cpuset = var_InheritString( p_dec, "avcodec-cpuset" );
+    if( psz_cpuset != NULL )
+    {
+#ifdef __linux__
+        if( ParseCpuSet( psz_cpuset, &p_sys->cpuset ) == VLC_SUCCESS )
+        {
+            p_sys->b_cpuset = true;
+            i_cpu_count = CPU_COUNT( &p_sys->cpuset );
+            msg_Dbg( p_dec, "binding decoding threads to CPUs %s", psz_cpuset );
+        }
+        else
+            msg_Err( p_dec, "invalid CPU set \"%s\"", psz_cpuset );
+#else
+        msg_Warn( p_dec, "decoding threads binding is not supported" );
+#endif
+        free( psz_cpuset );
+    }
+
     int i_thread_count = var_InheritInteger( p_dec, "avcodec-threads" );
     if( i_thread_count <= 0 )
     {
-        i_thread_count = vlc_GetCPUCount();
+        i_thread_count = i_cpu_count;
         if( i_thread_count > 1 )
             i_thread_count++;
 
@@ -87,6 +87,10 @@ struct decoder_sys_t
 
     /* */
     ASS_Track      *p_track;
+
+    /* Subpicture rendered by the last ass_render_frame() call, which libass
+     * change detection is relative to */
+    const subpicture_updater_sys_t *p_last_render;
 };
 static void DecSysRelease( decoder_sys_t *p_sys );
 static void DecSysHold( decoder_sys_t *p_sys );
@@ -102,6 +106,27 @@ static void SubpictureUpdate( subpicture_t *,
                               mtime_t );
 static void SubpictureDestroy( subpicture_t * );
 
+/* Identity of a libass image, relative to the first image of its list */
+typedef struct
+{
+    const unsigned char *p_bitmap;
+    int      i_w;
+    int      i_h;
+    int      i_stride;
+    uint32_t i_color;
+    int      i_dx;
+    int      i_dy;
+} image_entry_t;
+
+/* Identity of a libass image list, up to a translation */
+typedef struct
+{
+    image_entry_t *p_entries;
+    int      i_count;
+    int      i_x;
+    int      i_y;
+} image_signature_t;
+
 struct subpicture_updater_sys_t
 {
     decoder_sys_t *p_dec_sys;
@@ -110,6 +135,7 @@ struct subpicture_updater_sys_t
     mtime_t       i_pts;
 
     ASS_Image     *p_img;
+    image_signature_t signature; /* of the images the regions were drawn from */
 };
 
 typedef struct
@@ -120,8 +146,15 @@ typedef struct
     int y1;
 } rectangle_t;
 
+/* libass tends to create a lot of small images, they are merged into at most
+ * this many regions */
+#define ASS_MAX_REGION 4
+
 static int BuildRegions( rectangle_t *p_region, int i_max_region, ASS_Image *p_img_list, int i_width, int i_height );
 static void RegionDraw( subpicture_region_t *p_region, ASS_Image *p_img );
+static int ImageSignature( image_signature_t *p_sig, const ASS_Image *p_img );
+static bool ImageSignatureEqual( const image_signature_t *p_a,
+                                 const image_signature_t *p_b );
 
 //#define DEBUG_REGION
 
@@ -151,6 +184,7 @@ static int Create( vlc_object_t *p_this )
     p_sys->p_library  = NULL;
     p_sys->p_renderer = NULL;
     p_sys->p_track    = NULL;
+    p_sys->p_last_render = NULL;
 
     /* Create libass library */
     ASS_Library *p_library = p_sys->p_library = ass_library_init();
@@ -374,6 +408,8 @@ static int DecodeBlock( decoder_t *p_dec, block_t *p_block )
     }
 
     p_spu_sys->p_img = NULL;
+    p_spu_sys->signature.p_entries = NULL;
+    p_spu_sys->signature.i_count = 0;
     p_spu_sys->p_dec_sys = p_sys;
     p_spu_sys->i_subs_len = p_block->i_buffer;
     p_spu_sys->p_subs_data = malloc( p_block->i_buffer );
@@ -418,7 +454,8 @@ static int SubpictureValidate( subpicture_t *p_subpic,
                                bool b_fmt_dst, const video_format_t *p_fmt_dst,
                                mtime_t i_ts )
 {
-    decoder_sys_t *p_sys = p_subpic->updater.p_sys->p_dec_sys;
+    subpicture_updater_sys_t *p_upd_sys = p_subpic->updater.p_sys;
+    decoder_sys_t *p_sys = p_upd_sys->p_dec_sys;
 
     vlc_mutex_lock( &p_sys->lock );
 
@@ -437,10 +474,12 @@ static int SubpictureValidate( subpicture_t *p_subpic,
     }
 
     /* */
-    const mtime_t i_stream_date = p_subpic->updater.p_sys->i_pts + (i_ts - p_subpic->i_start);
+    const mtime_t i_stream_date = p_upd_sys->i_pts + (i_ts - p_subpic->i_start);
     int i_changed;
     ASS_Image *p_img = ass_render_frame( p_sys->p_renderer, p_sys->p_track,
                                          i_stream_date/1000, &i_changed );
+    const bool b_last_render = p_sys->p_last_render == p_upd_sys;
+    p_sys->p_last_render = p_upd_sys;
 
     if( !i_changed && !b_fmt_src && !b_fmt_dst &&
         (p_img != NULL) == (p_subpic->p_region != NULL) )
@@ -448,7 +487,41 @@ static int SubpictureValidate( subpicture_t *p_subpic,
         vlc_mutex_unlock( &p_sys->lock );
         return VLC_SUCCESS;
     }
-    p_subpic->updater.p_sys->p_img = p_img;
+
+    /* libass change detection is relative to the previous ass_render_frame()
+     * call, which may have been done for another subpicture. Compare with
+     * the images our regions were drawn from: if they are the same bitmaps,
+     * possibly moved as a whole (\move), the regions are kept and only
+     * translated instead of being reallocated and redrawn. A bitmap freed
+     * from the libass cache may be replaced at the same address: when the
+     * last rendering was ours, libass must also agree that only positions
+     * changed. */
+    const bool b_content_changed = i_changed == 2 && b_last_render;
+
+    image_signature_t signature;
+    if( ImageSignature( &signature, p_img ) )
+        signature.i_count = -1; /* never equal, always redraw */
+
+    if( !b_fmt_src && !b_fmt_dst && p_subpic->p_region != NULL &&
+        !b_content_changed && signature.i_count > 0 &&
+        ImageSignatureEqual( &signature, &p_upd_sys->signature ) )
+    {
+        const int i_dx = signature.i_x - p_upd_sys->signature.i_x;
+        const int i_dy = signature.i_y - p_upd_sys->signature.i_y;
+
+        for( subpicture_region_t *r = p_subpic->p_region; r; r = r->p_next )
+        {
+            r->i_x += i_dx;
+            r->i_y += i_dy;
+        }
+        free( p_upd_sys->signature.p_entries );
+        p_upd_sys->signature = signature;
+        vlc_mutex_unlock( &p_sys->lock );
+        return VLC_SUCCESS;
+    }
+    p_upd_sys->p_img = p_img;
+    free( p_upd_sys->signature.p_entries );
+    p_upd_sys->signature = signature;
 
     /* The lock is released by SubpictureUpdate */
     return VLC_EGENERIC;
@@ -476,20 +549,12 @@ static void SubpictureUpdate( subpicture_t *p_subpic,
      * reinstanciate a lot the scaler, and as we do not support subpel blending
      * it looks ugly (text unaligned).
      */
-    const int i_max_region = 4;
-#ifdef __STDC_NO_VLA__
-    rectangle_t* region = (rectangle_t*)malloc(sizeof(rectangle_t) * i_max_region);
-#else
-    rectangle_t region[i_max_region];
-#endif
-    const int i_region = BuildRegions( region, i_max_region, p_img, fmt.i_width, fmt.i_height );
+    rectangle_t region[ASS_MAX_REGION];
+    const int i_region = BuildRegions( region, ASS_MAX_REGION, p_img, fmt.i_width, fmt.i_height );
 
     if( i_region <= 0 )
     {
         vlc_mutex_unlock( &p_sys->lock );
-#ifdef __STDC_NO_VLA__
-        free(region);
-#endif
         return;
     }
 
@@ -523,16 +588,19 @@ static void SubpictureUpdate( subpicture_t *p_subpic,
         pp_region_last = &r->p_next;
     }
     vlc_mutex_unlock( &p_sys->lock );
-#ifdef __STDC_NO_VLA__
-	free(region);
-#endif
-
 }
 static void SubpictureDestroy( subpicture_t *p_subpic )
 {
     subpicture_updater_sys_t *p_sys = p_subpic->updater.p_sys;
+    decoder_sys_t *p_dec_sys = p_sys->p_dec_sys;
+
+    vlc_mutex_lock( &p_dec_sys->lock );
+    if( p_dec_sys->p_last_render == p_sys )
+        p_dec_sys->p_last_render = NULL;
+    vlc_mutex_unlock( &p_dec_sys->lock );
 
-    DecSysRelease( p_sys->p_dec_sys );
+    DecSysRelease( p_dec_sys );
+    free( p_sys->signature.p_entries );
     free( p_sys->p_subs_data );
     free( p_sys );
 }
@@ -592,11 +660,9 @@ static int BuildRegions( rectangle_t *p_region, int i_max_region, ASS_Image *p_i
     int i_maxh = i_w_inc;
     int i_maxw = i_h_inc;
     int i_region;
-#ifdef __STDC_NO_VLA__
-    rectangle_t* region = (rectangle_t*)malloc(sizeof(rectangle_t) * (i_max_region + 1));
-#elif
-    rectangle_t region[i_max_region+1];
-#endif
+    rectangle_t region[ASS_MAX_REGION+1];
+
+    assert( i_max_region <= ASS_MAX_REGION );
 
     i_region = 0;
     for( int i_used = 0; i_used < i_count; )
@@ -691,12 +757,73 @@ static int BuildRegions( rectangle_t *p_region, int i_max_region, ASS_Image *p_i
 #endif
 
     free( pp_img );
-#ifdef __STDC_NO_VLA__
-    free(region);
-#endif
     return i_region;
 }
 
+/* The bitmaps are owned by the libass cache, so identical glyphs/shapes
+ * keep the same pointer from one frame to another; this is also what libass
+ * itself uses to detect changes. */
+static int ImageSignature( image_signature_t *p_sig, const ASS_Image *p_img )
+{
+    int i_count = 0;
+
+    p_sig->p_entries = NULL;
+    p_sig->i_count = 0;
+    p_sig->i_x = 0;
+    p_sig->i_y = 0;
+
+    for( const ASS_Image *p_tmp = p_img; p_tmp != NULL; p_tmp = p_tmp->next )
+        if( p_tmp->w > 0 && p_tmp->h > 0 )
+            i_count++;
+    if( i_count == 0 )
+        return VLC_SUCCESS;
+
+    p_sig->p_entries = vlc_alloc( i_count, sizeof( *p_sig->p_entries ) );
+    if( !p_sig->p_entries )
+        return VLC_ENOMEM;
+
+    for( ; p_img != NULL; p_img = p_img->next )
+    {
+        if( p_img->w <= 0 || p_img->h <= 0 )
+            continue;
+        if( p_sig->i_count == 0 )
+        {
+            p_sig->i_x = p_img->dst_x;
+            p_sig->i_y = p_img->dst_y;
+        }
+
+        image_entry_t *p_entry = &p_sig->p_entries[p_sig->i_count++];
+        p_entry->p_bitmap = p_img->bitmap;
+        p_entry->i_w      = p_img->w;
+        p_entry->i_h      = p_img->h;
+        p_entry->i_stride = p_img->stride;
+        p_entry->i_color  = p_img->color;
+        p_entry->i_dx     = p_img->dst_x - p_sig->i_x;
+        p_entry->i_dy     = p_img->dst_y - p_sig->i_y;
+    }
+    return VLC_SUCCESS;
+}
+
+static bool ImageSignatureEqual( const image_signature_t *p_a,
+                                 const image_signature_t *p_b )
+{
+    if( p_a->i_count != p_b->i_count )
+        return false;
+
+    for( int i = 0; i < p_a->i_count; i++ )
+    {
+        const image_entry_t *a = &p_a->p_entries[i];
+        const image_entry_t *b = &p_b->p_entries[i];
+
+        if( a->p_bitmap != b->p_bitmap || a->i_w != b->i_w ||
+            a->i_h != b->i_h || a->i_stride != b->i_stride ||
+            a->i_color != b->i_color ||
+            a->i_dx != b->i_dx || a->i_dy != b->i_dy )
+            return false;
+    }
+    return true;
+}
+
 static void RegionDraw( subpicture_region_t *p_region, ASS_Image *p_img )
 {
     const plane_t *p = &p_region->p_picture->p[0];
@@ -385,6 +385,12 @@ struct sout_stream_id_sys_t
 
     block_fifo_t     *p_fifo;
     int64_t           i_caching;
+
+    /* Pacing statistics (owned by the send thread) */
+    uint64_t          i_sent_packets;
+    uint64_t          i_sent_batches;
+    mtime_t           i_jitter_sum;
+    mtime_t           i_jitter_max;
 };
 
 /*****************************************************************************
@@ -982,6 +988,10 @@ static sout_stream_id_sys_t *Add( sout_stream_t *p_stream,
     id->b_first_packet = true;
     id->i_caching =
         (int64_t)1000 * var_GetInteger( p_stream, SOUT_CFG_PREFIX "caching");
+    id->i_sent_packets = 0;
+    id->i_sent_batches = 0;
+    id->i_jitter_sum = 0;
+    id->i_jitter_max = 0;
 
     vlc_rand_bytes (&id->i_sequence, sizeof (id->i_sequence));
     vlc_rand_bytes (id->ssrc, sizeof (id->ssrc));
@@ -1230,6 +1240,13 @@ static void Del( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
         vlc_cancel( id->thread );
         vlc_join( id->thread, NULL );
         block_FifoRelease( id->p_fifo );
+
+        if( id->i_sent_packets > 0 )
+            msg_Dbg( p_stream, "sent %"PRIu64" RTP packets in %"PRIu64
+                     " batches, pacing jitter %"PRId64" us average, %"PRId64
+                     " us max", id->i_sent_packets, id->i_sent_batches,
+                     id->i_jitter_sum / (mtime_t)id->i_sent_packets,
+                     id->i_jitter_max );
     }
 
     free( id->rtp_fmt.fmtp );
@@ -1392,53 +1409,175 @@ static int  HttpCallback( httpd_file_sys_t *p_args,
 /****************************************************************************
  * RTP send
  ****************************************************************************/
-static void* ThreadSend( void *data )
-{
 #ifdef _WIN32
 # define ENOBUFS      WSAENOBUFS
 # define EAGAIN       WSAEWOULDBLOCK
 # define EWOULDBLOCK  WSAEWOULDBLOCK
 #endif
+
+/* Up to RTP_SEND_BATCH packets due within RTP_SEND_SLACK are sent together,
+ * so a packet may leave up to RTP_SEND_SLACK before its due time */
+#define RTP_SEND_BATCH 32
+#define RTP_SEND_SLACK (CLOCK_FREQ / 2000)
+
+#ifdef HAVE_SRTP
+static block_t *rtp_srtp_protect( sout_stream_id_sys_t *id, block_t *out )
+{
+    /* FIXME: this is awfully inefficient */
+    size_t len = out->i_buffer;
+    out = block_Realloc( out, 0, len + 10 );
+    if( unlikely(out == NULL) )
+        return NULL;
+    out->i_buffer = len;
+
+    int canc = vlc_savecancel ();
+    int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
+    vlc_restorecancel (canc);
+    if( val )
+    {
+        msg_Dbg( id->p_stream, "SRTP sending error: %s",
+                 vlc_strerror_c(val) );
+        block_Release( out );
+        return NULL;
+    }
+    out->i_buffer = len;
+    return out;
+}
+#endif
+
+/* Sends one packet to one sink, returns false if the sink is broken */
+static bool rtp_sink_send_one( int fd, const block_t *out )
+{
+    if( send( fd, out->p_buffer, out->i_buffer, 0 ) == -1
+     && net_errno != EAGAIN && net_errno != EWOULDBLOCK
+     && net_errno != ENOBUFS && net_errno != ENOMEM )
+    {
+        int type;
+        getsockopt( fd, SOL_SOCKET, SO_TYPE, &type,
+                    &(socklen_t){ sizeof(type) });
+        if( type != SOCK_DGRAM )
+            return false; /* Broken connection */
+
+        /* ICMP soft error: ignore and retry */
+        send( fd, out->p_buffer, out->i_buffer, 0 );
+    }
+    return true;
+}
+
+/* Sends a batch of packets to one sink, returns false if the sink is broken */
+static bool rtp_sink_send( int fd, block_t *const *pktv,
+#ifdef HAVE_SENDMMSG
+                           struct mmsghdr *msgv,
+#endif
+                           unsigned pktc )
+{
+    for( unsigned i = 0; i < pktc; )
+    {
+#ifdef HAVE_SENDMMSG
+        int val = sendmmsg( fd, msgv + i, pktc - i, 0 );
+        if( val > 0 )
+        {
+            i += val;
+            continue;
+        }
+        /* Let the single packet path sort the error out */
+#endif
+        if( !rtp_sink_send_one( fd, pktv[i] ) )
+            return false;
+        i++;
+    }
+    return true;
+}
+
+static void rtp_release_batch( void *data )
+{
+    block_t **pktv = data;
+
+    for( unsigned i = 0; i < RTP_SEND_BATCH && pktv[i] != NULL; i++ )
+        block_Release( pktv[i] );
+}
+
+static void* ThreadSend( void *data )
+{
     sout_stream_id_sys_t *id = data;
     unsigned i_caching = id->i_caching;
+    block_t *pktv[RTP_SEND_BATCH + 1] = { NULL };
+    block_t *next = NULL;
+#ifdef HAVE_SENDMMSG
+    struct mmsghdr msgv[RTP_SEND_BATCH];
+    struct iovec iov[RTP_SEND_BATCH];
+
+    memset( msgv, 0, sizeof(msgv) );
+    for( unsigned i = 0; i < RTP_SEND_BATCH; i++ )
+    {
+        msgv[i].msg_hdr.msg_iov = &iov[i];
+        msgv[i].msg_hdr.msg_iovlen = 1;
+    }
+#endif
 
     for (;;)
     {
-        block_t *out = block_FifoGet( id->p_fifo );
-        block_cleanup_push (out);
+        /* The packet following the previous batch, if any, is already
+         * dequeued. Only the cancellation points below can interrupt. */
+        block_t *out = (next != NULL) ? next : block_FifoGet( id->p_fifo );
+        next = NULL;
+#ifdef HAVE_SRTP
+        if( id->srtp )
+        {
+            out = rtp_srtp_protect( id, out );
+            if( out == NULL )
+                continue;
+        }
+#endif
+        pktv[0] = out;
+        vlc_cleanup_push( rtp_release_batch, pktv );
+        mwait (out->i_dts + i_caching);
+        vlc_cleanup_pop ();
+
+        int canc = vlc_savecancel ();
 
+        /* Gather the packets due shortly after this one, so that all sinks
+         * get them in one system call each. These are sent early. */
+        mtime_t now = mdate();
+        unsigned pktc = 1;
+
+        vlc_fifo_Lock( id->p_fifo );
+        while( pktc < RTP_SEND_BATCH && !vlc_fifo_IsEmpty( id->p_fifo ) )
+        {
+            block_t *pkt = vlc_fifo_DequeueUnlocked( id->p_fifo );
+
+            if( pkt->i_dts + i_caching > now + RTP_SEND_SLACK )
+            {
+                next = pkt;
+                break;
+            }
+            pktv[pktc++] = pkt;
+        }
+        vlc_fifo_Unlock( id->p_fifo );
 #ifdef HAVE_SRTP
+        /* Encrypt outside the lock, not to block the muxer meanwhile */
         if( id->srtp )
-        {   /* FIXME: this is awfully inefficient */
-            size_t len = out->i_buffer;
-            out = block_Realloc( out, 0, len + 10 );
-            out->i_buffer = len;
-
-            int canc = vlc_savecancel ();
-            int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
-            vlc_restorecancel (canc);
-            if( val )
+        {
+            unsigned protc = 1;
+
+            for( unsigned i = 1; i < pktc; i++ )
             {
-                msg_Dbg( id->p_stream, "SRTP sending error: %s",
-                         vlc_strerror_c(val) );
-                block_Release( out );
-                out = NULL;
+                block_t *pkt = rtp_srtp_protect( id, pktv[i] );
+                if( pkt != NULL )
+                    pktv[protc++] = pkt;
             }
-            else
-                out->i_buffer = len;
+            pktc = protc;
         }
-        if (out)
-            mwait (out->i_dts + i_caching);
-        vlc_cleanup_pop ();
-        if (out == NULL)
-            continue;
-#else
-        mwait (out->i_dts + i_caching);
-        vlc_cleanup_pop ();
 #endif
+        pktv[pktc] = NULL;
 
-        ssize_t len = out->i_buffer;
-        int canc = vlc_savecancel ();
+#ifdef HAVE_SENDMMSG
+        for( unsigned i = 0; i < pktc; i++ )
+        {
+            iov[i].iov_base = pktv[i]->p_buffer;
+            iov[i].iov_len = pktv[i]->i_buffer;
+        }
+#endif
 
         vlc_mutex_lock( &id->lock_sink );
         unsigned deadc = 0; /* How many dead sockets? */
@@ -1453,26 +1592,36 @@ static void* ThreadSend( void *data )
 #ifdef HAVE_SRTP
             if( !id->srtp ) /* FIXME: SRTCP support */
 #endif
-                SendRTCP( id->sinkv[i].rtcp, out );
+                for( unsigned j = 0; j < pktc; j++ )
+                    SendRTCP( id->sinkv[i].rtcp, pktv[j] );
 
-            if( send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 ) == -1
-             && net_errno != EAGAIN && net_errno != EWOULDBLOCK
-             && net_errno != ENOBUFS && net_errno != ENOMEM )
-            {
-                int type;
-                getsockopt( id->sinkv[i].rtp_fd, SOL_SOCKET, SO_TYPE,
-                            &type, &(socklen_t){ sizeof(type) });
-                if( type == SOCK_DGRAM )
-                    /* ICMP soft error: ignore and retry */
-                    send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 );
-                else
-                    /* Broken connection */
-                    deadv[deadc++] = id->sinkv[i].rtp_fd;
-            }
+            if( !rtp_sink_send( id->sinkv[i].rtp_fd, pktv,
+#ifdef HAVE_SENDMMSG
+                                msgv,
+#endif
+                                pktc ) )
+                deadv[deadc++] = id->sinkv[i].rtp_fd;
         }
-        id->i_seq_sent_next = ntohs(((uint16_t *) out->p_buffer)[1]) + 1;
+        id->i_seq_sent_next =
+            ntohs(((uint16_t *) pktv[pktc - 1]->p_buffer)[1]) + 1;
         vlc_mutex_unlock( &id->lock_sink );
-        block_Release( out );
+
+        /* Pacing accuracy: distance between actual and ideal send times */
+        now = mdate();
+        for( unsigned i = 0; i < pktc; i++ )
+        {
+            mtime_t jitter = now - ( pktv[i]->i_dts + i_caching );
+
+            if( jitter < 0 )
+                jitter = -jitter;
+            id->i_jitter_sum += jitter;
+            if( jitter > id->i_jitter_max )
+                id->i_jitter_max = jitter;
+            block_Release( pktv[i] );
+            pktv[i] = NULL;
+        }
+        id->i_sent_packets += pktc;
+        id->i_sent_batches++;
 
         for( unsigned i = 0; i < deadc; i++ )
         {
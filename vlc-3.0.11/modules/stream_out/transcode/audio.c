@@ -85,10 +85,6 @@ static int transcode_audio_initialize_filters( sout_stream_t *p_stream, sout_str
     if( id->p_af_chain == NULL )
     {
         msg_Err( p_stream, "Unable to initialize audio filters" );
-        module_unneed( id->p_encoder, id->p_encoder->p_module );
-        id->p_encoder->p_module = NULL;
-        module_unneed( id->p_decoder, id->p_decoder->p_module );
-        id->p_decoder->p_module = NULL;
         return VLC_EGENERIC;
     }
     id->fmt_audio.i_rate = id->audio_dec_out.i_rate;
@@ -192,6 +188,7 @@ static int transcode_audio_new( sout_stream_t *p_stream,
     id->p_decoder->pf_queue_audio = decoder_queue_audio;
     id->p_decoder->p_queue_ctx = id;
     id->p_decoder->pf_aout_format_update = audio_update_format;
+    id->p_decoder->p_owner = (decoder_owner_sys_t*) p_stream;
     /* id->p_decoder->p_cfg = p_sys->p_audio_cfg; */
     id->p_decoder->p_module =
         module_need( id->p_decoder, "audio decoder", "$codec", false );
@@ -236,6 +233,10 @@ static int transcode_audio_new( sout_stream_t *p_stream,
 
     if( unlikely( transcode_audio_initialize_filters( p_stream, id, p_sys ) != VLC_SUCCESS ) )
     {
+        module_unneed( id->p_encoder, id->p_encoder->p_module );
+        id->p_encoder->p_module = NULL;
+        module_unneed( id->p_decoder, id->p_decoder->p_module );
+        id->p_decoder->p_module = NULL;
         vlc_mutex_unlock(&id->fifo.lock);
         return VLC_EGENERIC;
     }
@@ -246,6 +247,10 @@ static int transcode_audio_new( sout_stream_t *p_stream,
 
 void transcode_audio_close( sout_stream_id_sys_t *id )
 {
+    if( id->p_encode_stage )
+        transcode_stage_Delete( id->p_encode_stage );
+    id->p_encode_stage = NULL;
+
     /* Close decoder */
     if( id->p_decoder->p_module )
         module_unneed( id->p_decoder, id->p_decoder->p_module );
@@ -265,6 +270,49 @@ void transcode_audio_close( sout_stream_id_sys_t *id )
         aout_FiltersDelete( (vlc_object_t *)NULL, id->p_af_chain );
 }
 
+/* Runs the filters and the encoder. Called from the encoder stage thread,
+ * if any. */
+static int transcode_audio_encode( void *opaque, void *item, block_t **out )
+{
+    sout_stream_id_sys_t *id = opaque;
+    block_t *p_audio_buf = item;
+
+    if( p_audio_buf == NULL )
+    {
+        /* Drain encoder */
+        if( id->p_encoder->p_module )
+        {
+            block_t *p_block;
+            do {
+               p_block = id->p_encoder->pf_encode_audio(id->p_encoder, NULL );
+               block_ChainAppend( out, p_block );
+            } while( p_block );
+        }
+        return VLC_SUCCESS;
+    }
+
+    p_audio_buf->i_dts = p_audio_buf->i_pts;
+
+    /* Run filter chain */
+    p_audio_buf = aout_FiltersPlay( id->p_af_chain, p_audio_buf,
+                                    INPUT_RATE_DEFAULT );
+    if( !p_audio_buf )
+        return VLC_EGENERIC;
+
+    p_audio_buf->i_dts = p_audio_buf->i_pts;
+
+    block_t *p_block = id->p_encoder->pf_encode_audio( id->p_encoder, p_audio_buf );
+
+    block_ChainAppend( out, p_block );
+    block_Release( p_audio_buf );
+    return VLC_SUCCESS;
+}
+
+static void transcode_audio_release( void *item )
+{
+    block_Release( item );
+}
+
 int transcode_audio_process( sout_stream_t *p_stream,
                                     sout_stream_id_sys_t *id,
                                     block_t *in, block_t **out )
@@ -272,7 +320,13 @@ int transcode_audio_process( sout_stream_t *p_stream,
     sout_stream_sys_t *p_sys = p_stream->p_sys;
     *out = NULL;
 
+    mtime_t i_start = mdate();
     int ret = id->p_decoder->pf_decode( id->p_decoder, in );
+    if( in != NULL )
+    {
+        id->i_decode_time += mdate() - i_start;
+        id->i_decoded++;
+    }
     if( ret != VLCDEC_SUCCESS )
         return VLC_EGENERIC;
 
@@ -303,6 +357,10 @@ int transcode_audio_process( sout_stream_t *p_stream,
             }
             if( unlikely( transcode_audio_initialize_filters( p_stream, id, p_sys ) != VLC_SUCCESS ) )
             {
+                module_unneed( id->p_encoder, id->p_encoder->p_module );
+                id->p_encoder->p_module = NULL;
+                module_unneed( id->p_decoder, id->p_decoder->p_module );
+                id->p_decoder->p_module = NULL;
                 vlc_mutex_unlock(&id->fifo.lock);
                 goto error;
             }
@@ -319,14 +377,17 @@ int transcode_audio_process( sout_stream_t *p_stream,
                 }
             }
         }
-
         /* Check if audio format has changed, and filters need reinit */
-        if( unlikely( ( id->audio_dec_out.i_rate != id->fmt_audio.i_rate ) ||
-                      ( id->audio_dec_out.i_physical_channels != id->fmt_audio.i_physical_channels ) ) )
+        else if( unlikely( ( id->audio_dec_out.i_rate != id->fmt_audio.i_rate ) ||
+                           ( id->audio_dec_out.i_physical_channels != id->fmt_audio.i_physical_channels ) ) )
         {
             msg_Info( p_stream, "Audio changed, trying to reinitialize filters" );
+            /* The filters may be running on the encoder stage */
+            if( id->p_encode_stage )
+                transcode_stage_Wait( id->p_encode_stage );
             if( id->p_af_chain != NULL )
                 aout_FiltersDelete( (vlc_object_t *)NULL, id->p_af_chain );
+            id->p_af_chain = NULL;
 
             if( transcode_audio_initialize_filters( p_stream, id, p_sys ) != VLC_SUCCESS )
             {
@@ -340,6 +401,7 @@ int transcode_audio_process( sout_stream_t *p_stream,
         }
         vlc_mutex_unlock(&id->fifo.lock);
 
+        /* The drift is read by the subtitles, on this thread */
         if( p_sys->b_master_sync )
         {
             mtime_t i_pts = date_Get( &id->next_input_pts );
@@ -363,41 +425,32 @@ int transcode_audio_process( sout_stream_t *p_stream,
             date_Increment( &id->next_input_pts, p_audio_buf->i_nb_samples );
         }
 
-        p_audio_buf->i_dts = p_audio_buf->i_pts;
-
-        /* Run filter chain */
-        p_audio_buf = aout_FiltersPlay( id->p_af_chain, p_audio_buf,
-                                        INPUT_RATE_DEFAULT );
-        if( !p_audio_buf )
-            goto error;
-
-        p_audio_buf->i_dts = p_audio_buf->i_pts;
-
-        block_t *p_block = id->p_encoder->pf_encode_audio( id->p_encoder, p_audio_buf );
-
-        block_ChainAppend( out, p_block );
-        block_Release( p_audio_buf );
+        if( id->p_encode_stage )
+            transcode_stage_Push( id->p_encode_stage, p_audio_buf );
+        else if( transcode_audio_encode( id, p_audio_buf, out ) != VLC_SUCCESS )
+            id->b_error = true;
         continue;
 error:
-        if( p_audio_buf )
-            block_Release( p_audio_buf );
+        block_Release( p_audio_buf );
         id->b_error = true;
     } while( p_audio_bufs );
 
 end:
+    if( id->p_encode_stage && transcode_stage_Failed( id->p_encode_stage ) )
+        id->b_error = true;
+
     /* Drain encoder */
     if( unlikely( !id->b_error && in == NULL ) )
     {
-        if( id->p_encoder->p_module )
-        {
-            block_t *p_block;
-            do {
-               p_block = id->p_encoder->pf_encode_audio(id->p_encoder, NULL );
-               block_ChainAppend( out, p_block );
-            } while( p_block );
-        }
+        if( id->p_encode_stage )
+            transcode_stage_Drain( id->p_encode_stage );
+        else
+            transcode_audio_encode( id, NULL, out );
     }
 
+    if( id->p_encode_stage )
+        block_ChainAppend( out, transcode_stage_Pull( id->p_encode_stage ) );
+
     return id->b_error ? VLC_EGENERIC : VLC_SUCCESS;
 }
 
@@ -437,6 +490,23 @@ bool transcode_audio_add( sout_stream_t *p_stream, const es_format_t *p_fmt,
         return false;
     }
 
+    /* Filter and encode on another thread */
+    if( p_sys->b_pipeline )
+    {
+        int i_priority = p_sys->b_high_priority ? VLC_THREAD_PRIORITY_OUTPUT :
+                           VLC_THREAD_PRIORITY_AUDIO;
+        id->p_encode_stage = transcode_stage_New( VLC_OBJECT(p_stream),
+                                                  "audio encoder",
+                                                  p_sys->pool_size, i_priority,
+                                                  transcode_audio_encode,
+                                                  transcode_audio_release, id );
+        if( id->p_encode_stage == NULL )
+        {
+            transcode_audio_close( id );
+            return false;
+        }
+    }
+
     /* Open output stream */
     id->b_transcode = true;
 
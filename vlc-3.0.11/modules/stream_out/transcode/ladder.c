@@ -0,0 +1,383 @@
+/*****************************************************************************
+ * ladder.c: transcoding stream output module (video renditions)
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#include "transcode.h"
+
+#include <stdlib.h>
+#include <vlc_modules.h>
+
+/* The pictures fed to the main encoder of a video ES are also handed to
+ * each rendition of the ladder. Every rendition scales them on its own
+ * pipeline stage and encodes them into a distinct ES, so that the source is
+ * decoded and filtered only once for the whole ladder. */
+
+struct transcode_rendition_t
+{
+    encoder_t       *p_encoder;
+    void            *id;            /**< output ES */
+    transcode_stage_t *p_stage;     /**< scaler and encoder */
+
+    /* Only used by the stage thread */
+    filter_chain_t  *p_chain;       /**< scaler and chroma converter */
+    video_format_t   fmt_src;       /**< input format of p_chain */
+};
+
+int transcode_ladder_parse( sout_stream_t *p_stream, const char *psz_ladder )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    const char *psz = psz_ladder;
+
+    while( *psz )
+    {
+        transcode_rung_t rung = { 0, 0, 0 };
+        char *psz_end;
+
+        rung.i_width = strtoul( psz, &psz_end, 10 );
+        if( *psz_end != 'x' )
+            goto error;
+        psz = psz_end + 1;
+        rung.i_height = strtoul( psz, &psz_end, 10 );
+        psz = psz_end;
+        if( *psz == '@' )
+        {
+            rung.i_bitrate = strtoul( psz + 1, &psz_end, 10 );
+            if( psz_end == psz + 1 || psz[1] == '-' || rung.i_bitrate == 0 )
+                goto error;
+            if( rung.i_bitrate < 16000 )
+                rung.i_bitrate *= 1000;
+            psz = psz_end;
+        }
+        if( ( *psz != ',' && *psz != '\0' ) ||
+            ( rung.i_width == 0 && rung.i_height == 0 ) )
+            goto error;
+        if( *psz == ',' )
+            psz++;
+
+        transcode_rung_t *p_ladder = realloc( p_sys->p_ladder,
+                            ( p_sys->i_ladder + 1 ) * sizeof(*p_ladder) );
+        if( unlikely(p_ladder == NULL) )
+            return VLC_ENOMEM;
+        p_ladder[p_sys->i_ladder++] = rung;
+        p_sys->p_ladder = p_ladder;
+
+        msg_Dbg( p_stream, "ladder rendition %ux%u %ukb/s", rung.i_width,
+                 rung.i_height, rung.i_bitrate / 1000 );
+    }
+    return VLC_SUCCESS;
+
+error:
+    msg_Err( p_stream, "invalid ladder rendition at \"%s\"", psz );
+    return VLC_EGENERIC;
+}
+
+static picture_t *rendition_filter_buffer_new( filter_t *p_filter )
+{
+    p_filter->fmt_out.video.i_chroma = p_filter->fmt_out.i_codec;
+    return picture_NewFromFormat( &p_filter->fmt_out.video );
+}
+
+static int RenditionSetupChain( transcode_rendition_t *p_rd,
+                                const video_format_t *p_fmt )
+{
+    filter_owner_t owner = {
+        .video = {
+            .buffer_new = rendition_filter_buffer_new,
+        },
+    };
+    es_format_t fmt_src;
+
+    if( p_rd->p_chain )
+        filter_chain_Delete( p_rd->p_chain );
+    p_rd->p_chain = filter_chain_NewVideo( p_rd->p_encoder, false, &owner );
+    if( unlikely(p_rd->p_chain == NULL) )
+        return VLC_ENOMEM;
+
+    es_format_InitFromVideo( &fmt_src, p_fmt );
+    filter_chain_Reset( p_rd->p_chain, &fmt_src, &p_rd->p_encoder->fmt_in );
+    int i_ret = filter_chain_AppendConverter( p_rd->p_chain, &fmt_src,
+                                              &p_rd->p_encoder->fmt_in );
+    es_format_Clean( &fmt_src );
+    if( i_ret != VLC_SUCCESS )
+    {
+        msg_Err( p_rd->p_encoder, "cannot scale %ux%u to %ux%u",
+                 p_fmt->i_visible_width, p_fmt->i_visible_height,
+                 p_rd->p_encoder->fmt_in.video.i_visible_width,
+                 p_rd->p_encoder->fmt_in.video.i_visible_height );
+        filter_chain_Delete( p_rd->p_chain );
+        p_rd->p_chain = NULL;
+        return i_ret;
+    }
+    p_rd->fmt_src = *p_fmt;
+    p_rd->fmt_src.p_palette = NULL;
+    return VLC_SUCCESS;
+}
+
+/* Scales and encodes a picture, or flushes the encoder. Called from the
+ * rendition stage thread. */
+static int RenditionEncode( void *opaque, void *item, block_t **out )
+{
+    transcode_rendition_t *p_rd = opaque;
+    picture_t *p_pic = item;
+    block_t *p_block;
+
+    if( p_pic == NULL )
+    {
+        do {
+            p_block = p_rd->p_encoder->pf_encode_video( p_rd->p_encoder,
+                                                        NULL );
+            block_ChainAppend( out, p_block );
+        } while( p_block );
+        return VLC_SUCCESS;
+    }
+
+    /* The chain follows the format changes of the main filters */
+    if( p_rd->p_chain == NULL ||
+        !video_format_IsSimilar( &p_rd->fmt_src, &p_pic->format ) )
+    {
+        if( RenditionSetupChain( p_rd, &p_pic->format ) != VLC_SUCCESS )
+        {
+            picture_Release( p_pic );
+            return VLC_SUCCESS;
+        }
+    }
+
+    p_pic = filter_chain_VideoFilter( p_rd->p_chain, p_pic );
+    if( p_pic == NULL )
+        return VLC_SUCCESS;
+
+    p_block = p_rd->p_encoder->pf_encode_video( p_rd->p_encoder, p_pic );
+    picture_Release( p_pic );
+    block_ChainAppend( out, p_block );
+    return VLC_SUCCESS;
+}
+
+static void RenditionRelease( void *item )
+{
+    picture_Release( item );
+}
+
+static void RenditionDelete( transcode_rendition_t *p_rd )
+{
+    encoder_t *p_enc = p_rd->p_encoder;
+
+    if( p_enc->p_module )
+        module_unneed( p_enc, p_enc->p_module );
+    es_format_Clean( &p_enc->fmt_in );
+    es_format_Clean( &p_enc->fmt_out );
+    vlc_object_release( p_enc );
+    free( p_rd );
+}
+
+static transcode_rendition_t *RenditionNew( sout_stream_t *p_stream,
+                                            sout_stream_id_sys_t *id,
+                                            const transcode_rung_t *p_rung,
+                                            unsigned i_index )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    const encoder_t *p_main = id->p_encoder;
+    const video_format_t *p_src = &p_main->fmt_in.video;
+
+    unsigned i_src_width = p_src->i_visible_width ? p_src->i_visible_width
+                                                  : p_src->i_width;
+    unsigned i_src_height = p_src->i_visible_height ? p_src->i_visible_height
+                                                    : p_src->i_height;
+    if( i_src_width == 0 || i_src_height == 0 )
+        return NULL;
+
+    /* Missing dimension: keep the source picture aspect */
+    unsigned i_width = p_rung->i_width;
+    unsigned i_height = p_rung->i_height;
+    if( i_width == 0 )
+        i_width = ( (uint64_t)i_height * i_src_width / i_src_height + 1 ) & ~1;
+    if( i_height == 0 )
+        i_height = ( (uint64_t)i_width * i_src_height / i_src_width + 1 ) & ~1;
+
+    /* Not larger than the main output */
+    const video_format_t *p_out = &p_main->fmt_out.video;
+    unsigned i_out_width = p_out->i_visible_width ? p_out->i_visible_width
+                                                  : p_out->i_width;
+    unsigned i_out_height = p_out->i_visible_height ? p_out->i_visible_height
+                                                    : p_out->i_height;
+    if( i_out_width == 0 || i_out_height == 0 )
+    {
+        i_out_width = i_src_width;
+        i_out_height = i_src_height;
+    }
+    if( i_width > i_out_width || i_height > i_out_height )
+    {
+        msg_Dbg( p_stream, "skipping rendition %ux%u larger than the main "
+                 "output %ux%u", i_width, i_height, i_out_width, i_out_height );
+        return NULL;
+    }
+
+    transcode_rendition_t *p_rd = calloc( 1, sizeof(*p_rd) );
+    if( unlikely(p_rd == NULL) )
+        return NULL;
+
+    encoder_t *p_enc = sout_EncoderCreate( p_stream );
+    if( unlikely(p_enc == NULL) )
+    {
+        free( p_rd );
+        return NULL;
+    }
+    p_rd->p_encoder = p_enc;
+    p_enc->p_module = NULL;
+
+    /* Same picture as the main encoder input, scaled */
+    es_format_Init( &p_enc->fmt_in, VIDEO_ES, p_main->fmt_in.i_codec );
+    p_enc->fmt_in.video = *p_src;
+    p_enc->fmt_in.video.p_palette = NULL;
+    p_enc->fmt_in.video.i_chroma = p_main->fmt_in.i_codec;
+    p_enc->fmt_in.video.i_width =
+    p_enc->fmt_in.video.i_visible_width = i_width;
+    p_enc->fmt_in.video.i_height =
+    p_enc->fmt_in.video.i_visible_height = i_height;
+    p_enc->fmt_in.video.i_x_offset =
+    p_enc->fmt_in.video.i_y_offset = 0;
+    vlc_ureduce( &p_enc->fmt_in.video.i_sar_num,
+                 &p_enc->fmt_in.video.i_sar_den,
+                 (uint64_t)p_src->i_sar_num * i_src_width * i_height,
+                 (uint64_t)p_src->i_sar_den * i_src_height * i_width, 0 );
+
+    es_format_Init( &p_enc->fmt_out, VIDEO_ES, p_sys->i_vcodec );
+    p_enc->fmt_out.video = p_enc->fmt_in.video;
+    p_enc->fmt_out.video.i_chroma = 0;
+    p_enc->fmt_out.video.i_frame_rate = p_main->fmt_out.video.i_frame_rate;
+    p_enc->fmt_out.video.i_frame_rate_base =
+        p_main->fmt_out.video.i_frame_rate_base;
+    p_enc->fmt_out.i_bitrate = p_rung->i_bitrate ? p_rung->i_bitrate
+                                                 : p_main->fmt_out.i_bitrate;
+    /* Above the ids of all the ES and renditions seen so far */
+    p_enc->fmt_out.i_id = ++p_sys->i_max_es_id;
+    p_enc->fmt_out.i_group = p_main->fmt_out.i_group;
+    if( p_main->fmt_out.psz_language )
+        p_enc->fmt_out.psz_language = strdup( p_main->fmt_out.psz_language );
+    if( asprintf( &p_enc->fmt_out.psz_description, "%ux%u",
+                  i_width, i_height ) == -1 )
+        p_enc->fmt_out.psz_description = NULL;
+
+    p_enc->i_threads = p_sys->i_threads;
+    p_enc->p_cfg = p_sys->p_video_cfg;
+
+    p_enc->p_module = module_need( p_enc, "encoder", p_sys->psz_venc, true );
+    if( !p_enc->p_module )
+    {
+        msg_Err( p_stream, "cannot find video encoder for rendition %ux%u",
+                 i_width, i_height );
+        goto error;
+    }
+    p_enc->fmt_in.video.i_chroma = p_enc->fmt_in.i_codec;
+    p_enc->fmt_out.i_codec =
+        vlc_fourcc_GetCodec( VIDEO_ES, p_enc->fmt_out.i_codec );
+
+    p_rd->id = sout_StreamIdAdd( p_stream->p_next, &p_enc->fmt_out );
+    if( !p_rd->id )
+    {
+        msg_Err( p_stream, "cannot add rendition %ux%u", i_width, i_height );
+        goto error;
+    }
+
+    int i_priority = p_sys->b_high_priority ? VLC_THREAD_PRIORITY_OUTPUT :
+                       VLC_THREAD_PRIORITY_VIDEO;
+    p_rd->p_stage = transcode_stage_New( VLC_OBJECT(p_stream),
+                                         "video rendition", p_sys->pool_size,
+                                         i_priority, RenditionEncode,
+                                         RenditionRelease, p_rd );
+    if( p_rd->p_stage == NULL )
+        goto error_id;
+
+    msg_Dbg( p_stream, "rendition %u: %ux%u %ukb/s, ES id %d", i_index,
+             i_width, i_height, p_enc->fmt_out.i_bitrate / 1000,
+             p_enc->fmt_out.i_id );
+    return p_rd;
+
+error_id:
+    sout_StreamIdDel( p_stream->p_next, p_rd->id );
+error:
+    RenditionDelete( p_rd );
+    return NULL;
+}
+
+void transcode_ladder_open( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+
+    if( p_sys->i_ladder == 0 )
+        return;
+
+    id->pp_renditions = vlc_alloc( p_sys->i_ladder,
+                                   sizeof(*id->pp_renditions) );
+    if( unlikely(id->pp_renditions == NULL) )
+        return;
+
+    for( size_t i = 0; i < p_sys->i_ladder; i++ )
+    {
+        transcode_rendition_t *p_rd = RenditionNew( p_stream, id,
+                                            &p_sys->p_ladder[i],
+                                            id->i_renditions );
+        if( p_rd != NULL )
+            id->pp_renditions[id->i_renditions++] = p_rd;
+    }
+}
+
+void transcode_ladder_push( sout_stream_id_sys_t *id, picture_t *p_pic )
+{
+    for( size_t i = 0; i < id->i_renditions; i++ )
+        transcode_stage_Push( id->pp_renditions[i]->p_stage,
+                              picture_Hold( p_pic ) );
+}
+
+void transcode_ladder_output( sout_stream_t *p_stream,
+                              sout_stream_id_sys_t *id, bool b_drain )
+{
+    for( size_t i = 0; i < id->i_renditions; i++ )
+    {
+        transcode_rendition_t *p_rd = id->pp_renditions[i];
+
+        if( b_drain )
+            transcode_stage_Drain( p_rd->p_stage );
+
+        block_t *p_out = transcode_stage_Pull( p_rd->p_stage );
+        if( p_out )
+            sout_StreamIdSend( p_stream->p_next, p_rd->id, p_out );
+    }
+}
+
+void transcode_ladder_close( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
+{
+    for( size_t i = 0; i < id->i_renditions; i++ )
+    {
+        transcode_rendition_t *p_rd = id->pp_renditions[i];
+
+        transcode_stage_Delete( p_rd->p_stage );
+        if( p_rd->p_chain )
+            filter_chain_Delete( p_rd->p_chain );
+
+        sout_StreamIdDel( p_stream->p_next, p_rd->id );
+        RenditionDelete( p_rd );
+    }
+    free( id->pp_renditions );
+    id->pp_renditions = NULL;
+    id->i_renditions = 0;
+}
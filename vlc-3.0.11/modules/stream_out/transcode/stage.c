@@ -0,0 +1,291 @@
+/*****************************************************************************
+ * stage.c: transcoding stream output module (pipeline stages)
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#include "transcode.h"
+
+/* A stage runs one step of the transcoding (filtering, encoding...) on its
+ * own thread, fed through a bounded queue: a full queue blocks the previous
+ * stage, so that no stage can run arbitrarily ahead of the next one.
+ *
+ * The state used by the processing callback belongs to the stage thread.
+ * The owner may only change it after transcode_stage_Wait(), or after
+ * transcode_stage_Drain() has stopped the thread. Pushing an item to a
+ * drained stage starts a new thread. */
+
+struct transcode_stage_t
+{
+    vlc_object_t *p_obj;
+    const char   *psz_name;
+    int         (*pf_process)( void *, void *, block_t ** );
+    void        (*pf_release)( void * );
+    void         *opaque;
+
+    vlc_thread_t  thread;
+    vlc_mutex_t   lock;
+    vlc_cond_t    wait;     /**< signaled when an item is queued */
+    vlc_cond_t    room;     /**< signaled when an item is dequeued */
+    vlc_cond_t    idle;     /**< signaled when the queue is done */
+    int           i_priority;
+    struct
+    {
+        void     *p_item;
+        mtime_t   i_date;
+    }            *p_queue;
+    unsigned      i_depth;
+    unsigned      i_first;
+    unsigned      i_count;
+    block_t      *p_out;
+    bool          b_running;
+    bool          b_busy;   /**< an item is being processed */
+    bool          b_drain;
+    bool          b_error;
+
+    /* Statistics */
+    uint64_t      i_items;
+    uint64_t      i_stalls;     /**< pushes blocked on a full queue */
+    uint64_t      i_depth_sum;  /**< queue depth seen by each push */
+    unsigned      i_depth_max;
+    mtime_t       i_queued;     /**< time spent by the items in the queue */
+    mtime_t       i_busy;       /**< time spent processing the items */
+};
+
+static void *StageThread( void *data )
+{
+    transcode_stage_t *p_stage = data;
+    int canc = vlc_savecancel();
+
+    vlc_mutex_lock( &p_stage->lock );
+    for( ;; )
+    {
+        while( p_stage->i_count == 0 && !p_stage->b_drain )
+            vlc_cond_wait( &p_stage->wait, &p_stage->lock );
+        if( p_stage->i_count == 0 )
+            break;
+
+        void *p_item = p_stage->p_queue[p_stage->i_first].p_item;
+        mtime_t i_date = p_stage->p_queue[p_stage->i_first].i_date;
+        p_stage->i_first = ( p_stage->i_first + 1 ) % p_stage->i_depth;
+        p_stage->i_count--;
+        p_stage->b_busy = true;
+        vlc_cond_signal( &p_stage->room );
+
+        bool b_error = p_stage->b_error;
+        vlc_mutex_unlock( &p_stage->lock );
+
+        /* After a failure, just release what is left */
+        block_t *p_out = NULL;
+        int i_ret = VLC_SUCCESS;
+        mtime_t i_start = mdate();
+        if( b_error )
+            p_stage->pf_release( p_item );
+        else
+            i_ret = p_stage->pf_process( p_stage->opaque, p_item, &p_out );
+        mtime_t i_end = mdate();
+
+        vlc_mutex_lock( &p_stage->lock );
+        p_stage->i_items++;
+        p_stage->i_queued += i_start - i_date;
+        p_stage->i_busy += i_end - i_start;
+        if( i_ret != VLC_SUCCESS )
+            p_stage->b_error = true;
+        block_ChainAppend( &p_stage->p_out, p_out );
+        p_stage->b_busy = false;
+        if( p_stage->i_count == 0 )
+            vlc_cond_broadcast( &p_stage->idle );
+    }
+    bool b_error = p_stage->b_error;
+    vlc_mutex_unlock( &p_stage->lock );
+
+    /* Now flush the stage */
+    if( !b_error )
+    {
+        block_t *p_out = NULL;
+
+        p_stage->pf_process( p_stage->opaque, NULL, &p_out );
+        vlc_mutex_lock( &p_stage->lock );
+        block_ChainAppend( &p_stage->p_out, p_out );
+        vlc_mutex_unlock( &p_stage->lock );
+    }
+
+    vlc_restorecancel( canc );
+    return NULL;
+}
+
+/* The lock must be held */
+static int StageStart( transcode_stage_t *p_stage )
+{
+    if( vlc_clone( &p_stage->thread, StageThread, p_stage,
+                   p_stage->i_priority ) )
+    {
+        msg_Err( p_stage->p_obj, "cannot spawn %s thread", p_stage->psz_name );
+        return VLC_EGENERIC;
+    }
+    p_stage->b_running = true;
+    return VLC_SUCCESS;
+}
+
+transcode_stage_t *transcode_stage_New( vlc_object_t *p_obj,
+                                        const char *psz_name,
+                                        unsigned i_depth, int i_priority,
+                                        int (*pf_process)( void *, void *,
+                                                           block_t ** ),
+                                        void (*pf_release)( void * ),
+                                        void *opaque )
+{
+    transcode_stage_t *p_stage = calloc( 1, sizeof(*p_stage) );
+    if( unlikely(p_stage == NULL) )
+        return NULL;
+
+    p_stage->p_queue = vlc_alloc( i_depth, sizeof(*p_stage->p_queue) );
+    if( unlikely(p_stage->p_queue == NULL) )
+    {
+        free( p_stage );
+        return NULL;
+    }
+
+    p_stage->p_obj = p_obj;
+    p_stage->psz_name = psz_name;
+    p_stage->pf_process = pf_process;
+    p_stage->pf_release = pf_release;
+    p_stage->opaque = opaque;
+    p_stage->i_depth = i_depth;
+    p_stage->i_priority = i_priority;
+    vlc_mutex_init( &p_stage->lock );
+    vlc_cond_init( &p_stage->wait );
+    vlc_cond_init( &p_stage->room );
+    vlc_cond_init( &p_stage->idle );
+
+    if( StageStart( p_stage ) )
+    {
+        vlc_cond_destroy( &p_stage->idle );
+        vlc_cond_destroy( &p_stage->room );
+        vlc_cond_destroy( &p_stage->wait );
+        vlc_mutex_destroy( &p_stage->lock );
+        free( p_stage->p_queue );
+        free( p_stage );
+        return NULL;
+    }
+    return p_stage;
+}
+
+void transcode_stage_Push( transcode_stage_t *p_stage, void *p_item )
+{
+    vlc_mutex_lock( &p_stage->lock );
+    /* Restart a drained stage, e.g. after a discontinuity */
+    if( unlikely(!p_stage->b_running) && StageStart( p_stage ) )
+    {
+        p_stage->b_error = true;
+        vlc_mutex_unlock( &p_stage->lock );
+        p_stage->pf_release( p_item );
+        return;
+    }
+
+    p_stage->i_depth_sum += p_stage->i_count;
+    if( p_stage->i_count == p_stage->i_depth )
+    {
+        p_stage->i_stalls++;
+        do
+            vlc_cond_wait( &p_stage->room, &p_stage->lock );
+        while( p_stage->i_count == p_stage->i_depth );
+    }
+
+    unsigned i_last = ( p_stage->i_first + p_stage->i_count )
+                    % p_stage->i_depth;
+    p_stage->p_queue[i_last].p_item = p_item;
+    p_stage->p_queue[i_last].i_date = mdate();
+    if( ++p_stage->i_count > p_stage->i_depth_max )
+        p_stage->i_depth_max = p_stage->i_count;
+
+    vlc_cond_signal( &p_stage->wait );
+    vlc_mutex_unlock( &p_stage->lock );
+}
+
+void transcode_stage_Wait( transcode_stage_t *p_stage )
+{
+    vlc_mutex_lock( &p_stage->lock );
+    while( p_stage->b_running && ( p_stage->i_count > 0 || p_stage->b_busy ) )
+        vlc_cond_wait( &p_stage->idle, &p_stage->lock );
+    vlc_mutex_unlock( &p_stage->lock );
+}
+
+block_t *transcode_stage_Pull( transcode_stage_t *p_stage )
+{
+    vlc_mutex_lock( &p_stage->lock );
+    block_t *p_out = p_stage->p_out;
+    p_stage->p_out = NULL;
+    vlc_mutex_unlock( &p_stage->lock );
+
+    return p_out;
+}
+
+bool transcode_stage_Failed( transcode_stage_t *p_stage )
+{
+    vlc_mutex_lock( &p_stage->lock );
+    bool b_error = p_stage->b_error;
+    vlc_mutex_unlock( &p_stage->lock );
+
+    return b_error;
+}
+
+void transcode_stage_Drain( transcode_stage_t *p_stage )
+{
+    vlc_mutex_lock( &p_stage->lock );
+    if( !p_stage->b_running )
+    {
+        vlc_mutex_unlock( &p_stage->lock );
+        return;
+    }
+    p_stage->b_drain = true;
+    vlc_cond_signal( &p_stage->wait );
+    vlc_mutex_unlock( &p_stage->lock );
+
+    vlc_join( p_stage->thread, NULL );
+
+    vlc_mutex_lock( &p_stage->lock );
+    p_stage->b_drain = false;
+    p_stage->b_running = false;
+    vlc_mutex_unlock( &p_stage->lock );
+}
+
+void transcode_stage_Delete( transcode_stage_t *p_stage )
+{
+    transcode_stage_Drain( p_stage );
+
+    if( p_stage->i_items > 0 )
+        msg_Dbg( p_stage->p_obj, "%s stage: %"PRIu64" items, latency "
+                 "%"PRId64" us queued + %"PRId64" us processing, queue depth "
+                 "%.1f average, %u max, %"PRIu64" stalls", p_stage->psz_name,
+                 p_stage->i_items, p_stage->i_queued / p_stage->i_items,
+                 p_stage->i_busy / p_stage->i_items,
+                 (double)p_stage->i_depth_sum / p_stage->i_items,
+                 p_stage->i_depth_max, p_stage->i_stalls );
+
+    block_ChainRelease( p_stage->p_out );
+    vlc_cond_destroy( &p_stage->idle );
+    vlc_cond_destroy( &p_stage->room );
+    vlc_cond_destroy( &p_stage->wait );
+    vlc_mutex_destroy( &p_stage->lock );
+    free( p_stage->p_queue );
+    free( p_stage );
+}
@@ -76,6 +76,13 @@
 #define MAXHEIGHT_TEXT N_("Maximum video height")
 #define MAXHEIGHT_LONGTEXT N_( \
     "Maximum output video height." )
+#define LADDER_TEXT N_("Video renditions")
+#define LADDER_LONGTEXT N_( \
+    "Additional renditions encoded from the same decoded video, each on its " \
+    "own thread and in its own elementary stream, as a comma-separated list " \
+    "of WIDTHxHEIGHT[@BITRATE] (eg: 1280x720@3000,x480@1500,x360@800). " \
+    "A missing dimension keeps the aspect ratio. Renditions larger than " \
+    "the main one are skipped." )
 #define VFILTER_TEXT N_("Video filter")
 #define VFILTER_LONGTEXT N_( \
     "Video filters will be applied to the video streams (after overlays " \
@@ -130,6 +137,11 @@
 #define POOL_TEXT N_("Picture pool size")
 #define POOL_LONGTEXT N_( "Defines how many pictures we allow to be in pool "\
     "between decoder/encoder threads when threads > 0" )
+#define PIPELINE_TEXT N_("Pipelined transcoding")
+#define PIPELINE_LONGTEXT N_( \
+    "Runs the video filters, the video encoder and the audio filters and " \
+    "encoder on their own threads, separated by queues of pool-size " \
+    "elements, so that decoding, filtering and encoding overlap." )
 
 
 static const char *const ppsz_deinterlace_type[] =
@@ -176,6 +188,8 @@ vlc_module_begin ()
                  MAXWIDTH_LONGTEXT, true )
     add_integer( SOUT_CFG_PREFIX "maxheight", 0, MAXHEIGHT_TEXT,
                  MAXHEIGHT_LONGTEXT, true )
+    add_string( SOUT_CFG_PREFIX "ladder", NULL, LADDER_TEXT,
+                LADDER_LONGTEXT, true )
     add_module_list( SOUT_CFG_PREFIX "vfilter", "video filter",
                      NULL, VFILTER_TEXT, VFILTER_LONGTEXT, false )
 
@@ -215,6 +229,8 @@ vlc_module_begin ()
         change_integer_range( 1, 1000 )
     add_bool( SOUT_CFG_PREFIX "high-priority", false, HP_TEXT, HP_LONGTEXT,
               true )
+    add_bool( SOUT_CFG_PREFIX "pipeline", false, PIPELINE_TEXT,
+              PIPELINE_LONGTEXT, true )
 
 vlc_module_end ()
 
@@ -224,7 +240,7 @@ static const char *const ppsz_sout_options[] = {
     "deinterlace-module", "threads", "aenc", "acodec", "ab", "alang",
     "afilter", "samplerate", "channels", "senc", "scodec", "soverlay",
     "sfilter", "high-priority", "maxwidth", "maxheight", "pool-size",
-    NULL
+    "ladder", "pipeline", NULL
 };
 
 /*****************************************************************************
@@ -348,6 +364,16 @@ static int Open( vlc_object_t *p_this )
 
     p_sys->i_maxheight = var_GetInteger( p_stream, SOUT_CFG_PREFIX "maxheight" );
 
+    psz_string = var_GetString( p_stream, SOUT_CFG_PREFIX "ladder" );
+    if( psz_string && *psz_string &&
+        transcode_ladder_parse( p_stream, psz_string ) != VLC_SUCCESS )
+    {
+        free( p_sys->p_ladder );
+        p_sys->p_ladder = NULL;
+        p_sys->i_ladder = 0;
+    }
+    free( psz_string );
+
     psz_string = var_GetString( p_stream, SOUT_CFG_PREFIX "vfilter" );
     if( psz_string && *psz_string )
         p_sys->psz_vf2 = strdup(psz_string );
@@ -368,6 +394,7 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_threads = var_GetInteger( p_stream, SOUT_CFG_PREFIX "threads" );
     p_sys->pool_size = var_GetInteger( p_stream, SOUT_CFG_PREFIX "pool-size" );
     p_sys->b_high_priority = var_GetBool( p_stream, SOUT_CFG_PREFIX "high-priority" );
+    p_sys->b_pipeline = var_GetBool( p_stream, SOUT_CFG_PREFIX "pipeline" );
 
     if( p_sys->i_vcodec )
     {
@@ -378,7 +405,6 @@ static int Open( vlc_object_t *p_this )
 
     /* Subpictures transcoding parameters */
     p_sys->p_spu = NULL;
-    p_sys->p_spu_blend = NULL;
     p_sys->psz_senc = NULL;
     p_sys->p_spu_cfg = NULL;
     p_sys->i_scodec = 0;
@@ -442,6 +468,7 @@ static void Close( vlc_object_t * p_this )
     free( p_sys->psz_alang );
 
     free( p_sys->psz_vf2 );
+    free( p_sys->p_ladder );
 
     config_ChainDestroy( p_sys->p_video_cfg );
     free( p_sys->psz_venc );
@@ -453,7 +480,6 @@ static void Close( vlc_object_t * p_this )
     free( p_sys->psz_senc );
 
     if( p_sys->p_spu ) spu_Destroy( p_sys->p_spu );
-    if( p_sys->p_spu_blend ) filter_DeleteBlend( p_sys->p_spu_blend );
 
     free( p_sys );
 }
@@ -491,6 +517,10 @@ static sout_stream_id_sys_t *Add( sout_stream_t *p_stream,
     if( !id )
         goto error;
 
+    /* Keep the ids of the ladder renditions clear of the incoming ES */
+    if( p_fmt->i_id > p_sys->i_max_es_id )
+        p_sys->i_max_es_id = p_fmt->i_id;
+
     vlc_mutex_init(&id->fifo.lock);
     id->id = NULL;
     id->p_decoder = NULL;
@@ -555,6 +585,11 @@ static void Del( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
 {
     if( id->b_transcode )
     {
+        if( id->i_decoded > 0 )
+            msg_Dbg( p_stream, "decoder stage: %"PRIu64" blocks, latency "
+                     "%"PRId64" us", id->i_decoded,
+                     id->i_decode_time / (mtime_t)id->i_decoded );
+
         switch( id->p_decoder->fmt_in.i_cat )
         {
         case AUDIO_ES:
@@ -14,17 +14,20 @@
 /*100ms is around the limit where people are noticing lipsync issues*/
 #define MASTER_SYNC_MAX_DRIFT 100000
 
+typedef struct
+{
+    unsigned int    i_width;    /* 0 to keep the source aspect */
+    unsigned int    i_height;   /* 0 to keep the source aspect */
+    unsigned int    i_bitrate;  /* 0 for the main video bitrate */
+} transcode_rung_t;
+
+typedef struct transcode_rendition_t transcode_rendition_t;
+typedef struct transcode_stage_t transcode_stage_t;
+
 struct sout_stream_sys_t
 {
-    sout_stream_id_sys_t *id_video;
-    block_t         *p_buffers;
-    vlc_mutex_t     lock_out;
-    vlc_cond_t      cond;
-    bool            b_abort;
-    picture_fifo_t *pp_pics;
-    vlc_sem_t       picture_pool_has_room;
     uint32_t        pool_size;
-    vlc_thread_t    thread;
+    bool            b_pipeline;
 
     /* Audio */
     vlc_fourcc_t    i_acodec;   /* codec audio (0 if not transcode) */
@@ -54,13 +57,16 @@ struct sout_stream_sys_t
 
     char            *psz_vf2;
 
+    transcode_rung_t *p_ladder; /* additional renditions */
+    size_t          i_ladder;
+    int             i_max_es_id; /* renditions are numbered above it */
+
     /* SPU */
     vlc_fourcc_t    i_scodec;   /* codec spu (0 if not transcode) */
     char            *psz_senc;
     bool            b_soverlay;
     config_chain_t  *p_spu_cfg;
     spu_t           *p_spu;
-    filter_t        *p_spu_blend;
 
     /* Sync */
     bool            b_master_sync;
@@ -107,6 +113,7 @@ struct sout_stream_id_sys_t
          {
              filter_chain_t  *p_f_chain; /**< Video filters */
              filter_chain_t  *p_uf_chain; /**< User-specified video filters */
+             filter_t        *p_spu_blend; /**< Subpictures overlay */
              video_format_t  fmt_input_video;
              video_format_t  video_dec_out; /* only rw from pf_vout_format_update() */
          };
@@ -122,6 +129,16 @@ struct sout_stream_id_sys_t
     /* Encoder */
     encoder_t       *p_encoder;
 
+    /* Additional video renditions */
+    transcode_rendition_t **pp_renditions;
+    size_t          i_renditions;
+
+    /* Pipeline */
+    transcode_stage_t *p_filter_stage; /**< video filters */
+    transcode_stage_t *p_encode_stage; /**< encoder, after audio filters */
+    uint64_t        i_decoded;
+    mtime_t         i_decode_time;
+
     /* Sync */
     date_t          next_input_pts; /**< Incoming calculated PTS */
     date_t          next_output_pts; /**< output calculated PTS */
@@ -150,3 +167,24 @@ int  transcode_video_process( sout_stream_t *, sout_stream_id_sys_t *,
                                      block_t *, block_t ** );
 bool transcode_video_add    ( sout_stream_t *, const es_format_t *,
                                 sout_stream_id_sys_t *);
+
+/* PIPELINE */
+
+transcode_stage_t *transcode_stage_New( vlc_object_t *, const char *,
+                                        unsigned, int,
+                                        int (*)( void *, void *, block_t ** ),
+                                        void (*)( void * ), void * );
+void     transcode_stage_Push  ( transcode_stage_t *, void * );
+void     transcode_stage_Wait  ( transcode_stage_t * );
+block_t *transcode_stage_Pull  ( transcode_stage_t * );
+bool     transcode_stage_Failed( transcode_stage_t * );
+void     transcode_stage_Drain ( transcode_stage_t * );
+void     transcode_stage_Delete( transcode_stage_t * );
+
+/* VIDEO LADDER */
+
+int  transcode_ladder_parse ( sout_stream_t *, const char * );
+void transcode_ladder_open  ( sout_stream_t *, sout_stream_id_sys_t * );
+void transcode_ladder_push  ( sout_stream_id_sys_t *, picture_t * );
+void transcode_ladder_output( sout_stream_t *, sout_stream_id_sys_t *, bool );
+void transcode_ladder_close ( sout_stream_t *, sout_stream_id_sys_t * );
@@ -101,60 +101,38 @@ static picture_t *transcode_video_filter_buffer_new( filter_t *p_filter )
     return picture_NewFromFormat( &p_filter->fmt_out.video );
 }
 
-static void* EncoderThread( void *obj )
+static int transcode_video_encode( void *opaque, void *item, block_t **out )
 {
-    sout_stream_sys_t *p_sys = (sout_stream_sys_t*)obj;
-    sout_stream_id_sys_t *id = p_sys->id_video;
-    picture_t *p_pic = NULL;
-    int canc = vlc_savecancel ();
-    block_t *p_block = NULL;
+    sout_stream_id_sys_t *id = opaque;
+    picture_t *p_pic = item;
+    block_t *p_block;
 
-    vlc_mutex_lock( &p_sys->lock_out );
-
-    for( ;; )
-    {
-        while( !p_sys->b_abort &&
-               (p_pic = picture_fifo_Pop( p_sys->pp_pics )) == NULL )
-            vlc_cond_wait( &p_sys->cond, &p_sys->lock_out );
-        vlc_sem_post( &p_sys->picture_pool_has_room );
-
-        if( p_pic )
-        {
-            /* release lock while encoding */
-            vlc_mutex_unlock( &p_sys->lock_out );
-            p_block = id->p_encoder->pf_encode_video( id->p_encoder, p_pic );
-            picture_Release( p_pic );
-            vlc_mutex_lock( &p_sys->lock_out );
-
-            block_ChainAppend( &p_sys->p_buffers, p_block );
-        }
-
-        if( p_sys->b_abort )
-            break;
-    }
-
-    /*Encode what we have in the buffer on closing*/
-    while( (p_pic = picture_fifo_Pop( p_sys->pp_pics )) != NULL )
+    if( p_pic == NULL )
     {
-        vlc_sem_post( &p_sys->picture_pool_has_room );
-        p_block = id->p_encoder->pf_encode_video( id->p_encoder, p_pic );
-        picture_Release( p_pic );
-        block_ChainAppend( &p_sys->p_buffers, p_block );
+        if( !id->p_encoder->p_module )
+            return VLC_SUCCESS;
+
+        /* Now flush encoder */
+        do {
+            p_block = id->p_encoder->pf_encode_video( id->p_encoder, NULL );
+            block_ChainAppend( out, p_block );
+        } while( p_block );
+        return VLC_SUCCESS;
     }
 
-    /*Now flush encoder*/
-    do {
-        p_block = id->p_encoder->pf_encode_video(id->p_encoder, NULL );
-        block_ChainAppend( &p_sys->p_buffers, p_block );
-    } while( p_block );
-
-    vlc_mutex_unlock( &p_sys->lock_out );
-
-    vlc_restorecancel (canc);
+    p_block = id->p_encoder->pf_encode_video( id->p_encoder, p_pic );
+    picture_Release( p_pic );
+    block_ChainAppend( out, p_block );
+    return VLC_SUCCESS;
+}
 
-    return NULL;
+static void transcode_video_release( void *item )
+{
+    picture_Release( item );
 }
 
+static int transcode_video_filter( void *, void *, block_t ** );
+
 static int decoder_queue_video( decoder_t *p_dec, picture_t *p_pic )
 {
     sout_stream_id_sys_t *id = p_dec->p_queue_ctx;
@@ -265,37 +243,39 @@ static int transcode_video_new( sout_stream_t *p_stream, sout_stream_id_sys_t *i
     id->p_encoder->fmt_in.video.i_chroma = id->p_encoder->fmt_in.i_codec;
     id->p_encoder->p_module = NULL;
 
-    if( p_sys->i_threads <= 0 )
+    if( p_sys->i_threads <= 0 && !p_sys->b_pipeline )
         return VLC_SUCCESS;
 
     int i_priority = p_sys->b_high_priority ? VLC_THREAD_PRIORITY_OUTPUT :
                        VLC_THREAD_PRIORITY_VIDEO;
-    p_sys->id_video = id;
-    p_sys->pp_pics = picture_fifo_New();
-    if( p_sys->pp_pics == NULL )
-    {
-        msg_Err( p_stream, "cannot create picture fifo" );
-        module_unneed( id->p_decoder, id->p_decoder->p_module );
-        id->p_decoder->p_module = NULL;
-        return VLC_ENOMEM;
-    }
+    id->p_encode_stage = transcode_stage_New( VLC_OBJECT(p_stream),
+                                              "video encoder",
+                                              p_sys->pool_size, i_priority,
+                                              transcode_video_encode,
+                                              transcode_video_release, id );
+    if( id->p_encode_stage == NULL )
+        goto error;
+
+    if( !p_sys->b_pipeline )
+        return VLC_SUCCESS;
 
-    vlc_sem_init( &p_sys->picture_pool_has_room, p_sys->pool_size );
-    vlc_mutex_init( &p_sys->lock_out );
-    vlc_cond_init( &p_sys->cond );
-    p_sys->p_buffers = NULL;
-    p_sys->b_abort = false;
-    if( vlc_clone( &p_sys->thread, EncoderThread, p_sys, i_priority ) )
+    id->p_filter_stage = transcode_stage_New( VLC_OBJECT(p_stream),
+                                              "video filter",
+                                              p_sys->pool_size, i_priority,
+                                              transcode_video_filter,
+                                              transcode_video_release, id );
+    if( id->p_filter_stage == NULL )
     {
-        msg_Err( p_stream, "cannot spawn encoder thread" );
-        vlc_mutex_destroy( &p_sys->lock_out );
-        vlc_cond_destroy( &p_sys->cond );
-        picture_fifo_Delete( p_sys->pp_pics );
-        module_unneed( id->p_decoder, id->p_decoder->p_module );
-        id->p_decoder->p_module = NULL;
-        return VLC_EGENERIC;
+        transcode_stage_Delete( id->p_encode_stage );
+        id->p_encode_stage = NULL;
+        goto error;
     }
     return VLC_SUCCESS;
+
+error:
+    module_unneed( id->p_decoder, id->p_decoder->p_module );
+    id->p_decoder->p_module = NULL;
+    return VLC_EGENERIC;
 }
 
 static void transcode_video_filter_init( sout_stream_t *p_stream,
@@ -658,24 +638,11 @@ static int transcode_video_encoder_open( sout_stream_t *p_stream,
 void transcode_video_close( sout_stream_t *p_stream,
                                    sout_stream_id_sys_t *id )
 {
-    if( p_stream->p_sys->i_threads >= 1 && !p_stream->p_sys->b_abort )
-    {
-        vlc_mutex_lock( &p_stream->p_sys->lock_out );
-        p_stream->p_sys->b_abort = true;
-        vlc_cond_signal( &p_stream->p_sys->cond );
-        vlc_mutex_unlock( &p_stream->p_sys->lock_out );
-
-        vlc_join( p_stream->p_sys->thread, NULL );
-
-        picture_fifo_Delete( p_stream->p_sys->pp_pics );
-        block_ChainRelease( p_stream->p_sys->p_buffers );
-    }
-
-    if( p_stream->p_sys->i_threads >= 1 )
-    {
-        vlc_mutex_destroy( &p_stream->p_sys->lock_out );
-        vlc_cond_destroy( &p_stream->p_sys->cond );
-    }
+    /* Stop the pipeline, in order */
+    if( id->p_filter_stage )
+        transcode_stage_Delete( id->p_filter_stage );
+    if( id->p_encode_stage )
+        transcode_stage_Delete( id->p_encode_stage );
 
     /* Close decoder */
     if( id->p_decoder->p_module )
@@ -687,11 +654,16 @@ void transcode_video_close( sout_stream_t *p_stream,
     if( id->p_encoder->p_module )
         module_unneed( id->p_encoder, id->p_encoder->p_module );
 
+    /* Close renditions */
+    transcode_ladder_close( p_stream, id );
+
     /* Close filters */
     if( id->p_f_chain )
         filter_chain_Delete( id->p_f_chain );
     if( id->p_uf_chain )
         filter_chain_Delete( id->p_uf_chain );
+    if( id->p_spu_blend )
+        filter_DeleteBlend( id->p_spu_blend );
 }
 
 static void OutputFrame( sout_stream_t *p_stream, picture_t *p_pic, sout_stream_id_sys_t *id, block_t **out )
@@ -714,7 +686,7 @@ static void OutputFrame( sout_stream_t *p_stream, picture_t *p_pic, sout_stream_
         }
 
         subpicture_t *p_subpic = spu_Render( p_sys->p_spu, NULL, &fmt,
-                                             &id->p_decoder->fmt_out.video,
+                                             &id->fmt_input_video,
                                              p_pic->date, p_pic->date, false );
 
         /* Overlay subpicture */
@@ -732,42 +704,100 @@ static void OutputFrame( sout_stream_t *p_stream, picture_t *p_pic, sout_stream_
                     p_pic = p_tmp;
                 }
             }
-            if( unlikely( !p_sys->p_spu_blend ) )
-                p_sys->p_spu_blend = filter_NewBlend( VLC_OBJECT( p_sys->p_spu ), &fmt );
-            if( likely( p_sys->p_spu_blend ) )
-                picture_BlendSubpicture( p_pic, p_sys->p_spu_blend, p_subpic );
+            if( unlikely( !id->p_spu_blend ) )
+                id->p_spu_blend = filter_NewBlend( VLC_OBJECT( p_sys->p_spu ), &fmt );
+            if( likely( id->p_spu_blend ) )
+                picture_BlendSubpicture( p_pic, id->p_spu_blend, p_subpic );
             subpicture_Delete( p_subpic );
         }
     }
 
-    if( p_sys->i_threads == 0 )
-    {
-        block_t *p_block;
+    /* Hand the picture to the other renditions */
+    transcode_ladder_push( id, p_pic );
 
-        p_block = id->p_encoder->pf_encode_video( id->p_encoder, p_pic );
-        block_ChainAppend( out, p_block );
-    }
+    if( id->p_encode_stage )
+        transcode_stage_Push( id->p_encode_stage, p_pic );
+    else
+        transcode_video_encode( id, p_pic, out );
+}
 
-    if( p_sys->i_threads )
-    {
-        vlc_sem_wait( &p_sys->picture_pool_has_room );
-        vlc_mutex_lock( &p_sys->lock_out );
-        picture_fifo_Push( p_sys->pp_pics, p_pic );
-        vlc_cond_signal( &p_sys->cond );
-        vlc_mutex_unlock( &p_sys->lock_out );
+/* Runs the filters, then encodes or hands the pictures to the encoder stage.
+ * Called from the filter stage thread, if any. */
+static int transcode_video_filter( void *opaque, void *item, block_t **out )
+{
+    sout_stream_id_sys_t *id = opaque;
+    sout_stream_t *p_stream = (sout_stream_t *)id->p_decoder->p_owner;
+    picture_t *p_pic = item;
+
+    if( p_pic == NULL )
+        return VLC_SUCCESS;
+
+    /* Run the filter and output chains; first with the picture,
+     * and then with NULL as many times as we need until they
+     * stop outputting frames.
+     */
+    for ( ;; ) {
+        picture_t *p_filtered_pic = p_pic;
+
+        /* Run filter chain */
+        if( id->p_f_chain )
+            p_filtered_pic = filter_chain_VideoFilter( id->p_f_chain, p_filtered_pic );
+        if( !p_filtered_pic )
+            break;
+
+        for ( ;; ) {
+            picture_t *p_user_filtered_pic = p_filtered_pic;
+
+            /* Run user specified filter chain */
+            if( id->p_uf_chain )
+                p_user_filtered_pic = filter_chain_VideoFilter( id->p_uf_chain, p_user_filtered_pic );
+            if( !p_user_filtered_pic )
+                break;
+
+            OutputFrame( p_stream, p_user_filtered_pic, id, out );
+
+            p_filtered_pic = NULL;
+        }
+
+        p_pic = NULL;
     }
+    return VLC_SUCCESS;
+}
 
-    if ( p_sys->i_threads == 0 )
-        picture_Release( p_pic );
+/* (Re)creates the filters and sets the encoder input format up for the
+ * given decoded picture. The pipeline stages must be idle. */
+static int transcode_video_reinit( sout_stream_t *p_stream,
+                                   sout_stream_id_sys_t *id,
+                                   picture_t *p_pic )
+{
+    if( id->p_f_chain )
+        filter_chain_Delete( id->p_f_chain );
+    if( id->p_uf_chain )
+        filter_chain_Delete( id->p_uf_chain );
+    id->p_f_chain = id->p_uf_chain = NULL;
+
+    transcode_video_encoder_init( p_stream, id, p_pic );
+    transcode_video_filter_init( p_stream, id );
+    if( conversion_video_filter_append( id, p_pic ) != VLC_SUCCESS )
+        return VLC_EGENERIC;
+    memcpy( &id->fmt_input_video, &p_pic->format, sizeof(video_format_t));
+    return VLC_SUCCESS;
 }
 
 int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
                                     block_t *in, block_t **out )
 {
     sout_stream_sys_t *p_sys = p_stream->p_sys;
+
     *out = NULL;
 
+    mtime_t i_start = mdate();
     int ret = id->p_decoder->pf_decode( id->p_decoder, in );
+    if( in != NULL )
+    {
+        id->i_decode_time += mdate() - i_start;
+        id->i_decoded++;
+    }
     if( ret != VLCDEC_SUCCESS )
         return VLC_EGENERIC;
 
@@ -787,133 +817,71 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
             continue;
         }
 
-        if( unlikely (
-             id->p_encoder->p_module && p_pic &&
-             !video_format_IsSimilar( &id->fmt_input_video, &p_pic->format )
-            )
-          )
+        if( unlikely( !id->p_encoder->p_module ) )
+        {
+            if( transcode_video_reinit( p_stream, id, p_pic ) != VLC_SUCCESS )
+                goto error;
+
+            if( transcode_video_encoder_open( p_stream, id ) != VLC_SUCCESS )
+                goto error;
+            transcode_ladder_open( p_stream, id );
+        }
+        else if( unlikely( !video_format_IsSimilar( &id->fmt_input_video,
+                                                    &p_pic->format ) ) )
         {
             msg_Info( p_stream, "aspect-ratio changed, reiniting. %i -> %i : %i -> %i.",
                         id->fmt_input_video.i_sar_num, p_pic->format.i_sar_num,
                         id->fmt_input_video.i_sar_den, p_pic->format.i_sar_den
                     );
-            /* Close filters */
-            if( id->p_f_chain )
-                filter_chain_Delete( id->p_f_chain );
-            id->p_f_chain = NULL;
-            if( id->p_uf_chain )
-                filter_chain_Delete( id->p_uf_chain );
-            id->p_uf_chain = NULL;
+            /* The filters and the encoder may be running on their stages */
+            if( id->p_filter_stage )
+                transcode_stage_Wait( id->p_filter_stage );
+            if( id->p_encode_stage )
+                transcode_stage_Wait( id->p_encode_stage );
 
             /* Reinitialize filters */
             id->p_encoder->fmt_out.video.i_visible_width  = p_sys->i_width & ~1;
             id->p_encoder->fmt_out.video.i_visible_height = p_sys->i_height & ~1;
             id->p_encoder->fmt_out.video.i_sar_num = id->p_encoder->fmt_out.video.i_sar_den = 0;
 
-            transcode_video_encoder_init( p_stream, id, p_pic );
-            transcode_video_filter_init( p_stream, id );
-            if( conversion_video_filter_append( id, p_pic ) != VLC_SUCCESS )
-                goto error;
-            memcpy( &id->fmt_input_video, &p_pic->format, sizeof(video_format_t));
-        }
-
-
-        if( unlikely( !id->p_encoder->p_module && p_pic ) )
-        {
-            if( id->p_f_chain )
-                filter_chain_Delete( id->p_f_chain );
-            if( id->p_uf_chain )
-                filter_chain_Delete( id->p_uf_chain );
-            id->p_f_chain = id->p_uf_chain = NULL;
-
-            transcode_video_encoder_init( p_stream, id, p_pic );
-            transcode_video_filter_init( p_stream, id );
-            if( conversion_video_filter_append( id, p_pic ) != VLC_SUCCESS )
-                goto error;
-            memcpy( &id->fmt_input_video, &p_pic->format, sizeof(video_format_t));
-
-            if( transcode_video_encoder_open( p_stream, id ) != VLC_SUCCESS )
+            if( transcode_video_reinit( p_stream, id, p_pic ) != VLC_SUCCESS )
                 goto error;
         }
 
-        /* Run the filter and output chains; first with the picture,
-         * and then with NULL as many times as we need until they
-         * stop outputting frames.
-         */
-        for ( ;; ) {
-            picture_t *p_filtered_pic = p_pic;
-
-            /* Run filter chain */
-            if( id->p_f_chain )
-                p_filtered_pic = filter_chain_VideoFilter( id->p_f_chain, p_filtered_pic );
-            if( !p_filtered_pic )
-                break;
-
-            for ( ;; ) {
-                picture_t *p_user_filtered_pic = p_filtered_pic;
-
-                /* Run user specified filter chain */
-                if( id->p_uf_chain )
-                    p_user_filtered_pic = filter_chain_VideoFilter( id->p_uf_chain, p_user_filtered_pic );
-                if( !p_user_filtered_pic )
-                    break;
-
-                OutputFrame( p_stream, p_user_filtered_pic, id, out );
-
-                p_filtered_pic = NULL;
-            }
-
-            p_pic = NULL;
-        }
+        if( id->p_filter_stage )
+            transcode_stage_Push( id->p_filter_stage, p_pic );
+        else if( transcode_video_filter( id, p_pic, out ) != VLC_SUCCESS )
+            id->b_error = true;
         continue;
 error:
-        if( p_pic )
-            picture_Release( p_pic );
+        picture_Release( p_pic );
         id->b_error = true;
     } while( p_pics );
 
-    if( p_sys->i_threads >= 1 )
-    {
-        /* Pick up any return data the encoder thread wants to output. */
-        vlc_mutex_lock( &p_sys->lock_out );
-        *out = p_sys->p_buffers;
-        p_sys->p_buffers = NULL;
-        vlc_mutex_unlock( &p_sys->lock_out );
-    }
-
 end:
-    /* Drain encoder */
+    if( id->p_filter_stage && transcode_stage_Failed( id->p_filter_stage ) )
+        id->b_error = true;
+
+    /* Drain the pipeline */
     if( unlikely( !id->b_error && in == NULL ) )
     {
-        if( p_sys->i_threads == 0 )
-        {
-            if( id->p_encoder->p_module )
-            {
-                block_t *p_block;
-                do {
-                    p_block = id->p_encoder->pf_encode_video(id->p_encoder, NULL );
-                    block_ChainAppend( out, p_block );
-                } while( p_block );
-            }
-        }
+        msg_Dbg( p_stream, "Flushing pipeline and waiting that");
+        if( id->p_filter_stage )
+            transcode_stage_Drain( id->p_filter_stage );
+        if( id->p_encode_stage )
+            transcode_stage_Drain( id->p_encode_stage );
         else
-        {
-            msg_Dbg( p_stream, "Flushing thread and waiting that");
-            vlc_mutex_lock( &p_stream->p_sys->lock_out );
-            p_stream->p_sys->b_abort = true;
-            vlc_cond_signal( &p_stream->p_sys->cond );
-            vlc_mutex_unlock( &p_stream->p_sys->lock_out );
-
-            vlc_join( p_stream->p_sys->thread, NULL );
-            vlc_mutex_lock( &p_sys->lock_out );
-            *out = p_sys->p_buffers;
-            p_sys->p_buffers = NULL;
-            vlc_mutex_unlock( &p_sys->lock_out );
-
-            msg_Dbg( p_stream, "Flushing done");
-        }
+            transcode_video_encode( id, NULL, out );
+        msg_Dbg( p_stream, "Flushing done");
     }
 
+    /* Pick up any return data the encoder thread wants to output. */
+    if( id->p_encode_stage )
+        block_ChainAppend( out, transcode_stage_Pull( id->p_encode_stage ) );
+
+    /* The renditions are sent straight to their own ES */
+    transcode_ladder_output( p_stream, id, in == NULL );
+
     return id->b_error ? VLC_EGENERIC : VLC_SUCCESS;
 }
 
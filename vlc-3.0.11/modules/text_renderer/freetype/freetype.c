@@ -70,6 +70,7 @@
 #include "platform_fonts.h"
 #include "freetype.h"
 #include "text_layout.h"
+#include "glyph_cache.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -1347,6 +1348,9 @@ static int Create( vlc_object_t *p_this )
 
     p_sys->i_scale = 100;
 
+    /* Glyphs are kept across renders; the renderer works without the cache */
+    p_sys->p_glyph_cache = GlyphCache_New( GLYPH_CACHE_MAX_ENTRIES );
+
     /* default style to apply to uncomplete segmeents styles */
     p_sys->p_default_style = text_style_Create( STYLE_FULLY_SET );
     if(unlikely(!p_sys->p_default_style))
@@ -1469,6 +1473,19 @@ static void Destroy( vlc_object_t *p_this )
     text_style_Delete( p_sys->p_default_style );
     text_style_Delete( p_sys->p_forced_style );
 
+    /* Glyph cache, before the faces it refers to */
+    if( p_sys->p_glyph_cache )
+    {
+        unsigned i_bitmap_hits, i_bitmap_misses, i_outline_hits, i_outline_misses;
+        GlyphCache_GetStats( p_sys->p_glyph_cache,
+                             &i_bitmap_hits, &i_bitmap_misses,
+                             &i_outline_hits, &i_outline_misses );
+        msg_Dbg( p_filter, "glyph cache: %u rasterizations avoided (%u done), "
+                 "%u glyph loads avoided (%u done)",
+                 i_bitmap_hits, i_bitmap_misses, i_outline_hits, i_outline_misses );
+        GlyphCache_Delete( p_sys->p_glyph_cache );
+    }
+
     /* Fonts dicts */
     vlc_dictionary_clear( &p_sys->fallback_map, FreeFamilies, p_filter );
     vlc_dictionary_clear( &p_sys->face_map, FreeFace, p_filter );
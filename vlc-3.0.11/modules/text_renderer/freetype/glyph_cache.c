@@ -0,0 +1,337 @@
+/*****************************************************************************
+ * glyph_cache.c : Glyph outline and bitmap cache
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/** \ingroup freetype
+ * @{
+ * \file
+ * Glyph outline and bitmap cache
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_GLYPH_H
+
+#include "glyph_cache.h"
+
+#define GLYPH_CACHE_BUCKETS 1024 /* power of 2 */
+#define GLYPH_CACHE_BITMAPS 4    /* bitmaps per glyph (source, sub-pixel origin) */
+
+typedef struct glyph_cache_entry_t glyph_cache_entry_t;
+struct glyph_cache_entry_t
+{
+    glyph_cache_key_t    key;
+
+    FT_Glyph             p_glyph;
+    FT_Glyph             p_outline;
+    FT_Vector            advance;
+
+    struct
+    {
+        FT_Glyph         p_bitmap;
+        int              i_source;
+        FT_Pos           i_frac_x;
+        FT_Pos           i_frac_y;
+    } bitmaps[GLYPH_CACHE_BITMAPS];
+    unsigned             i_next_bitmap;
+
+    glyph_cache_entry_t *p_hash_next;
+    glyph_cache_entry_t *p_lru_prev;    /* more recently used */
+    glyph_cache_entry_t *p_lru_next;    /* less recently used */
+};
+
+struct glyph_cache_t
+{
+    glyph_cache_entry_t *pp_buckets[GLYPH_CACHE_BUCKETS];
+    glyph_cache_entry_t *p_lru_first;
+    glyph_cache_entry_t *p_lru_last;
+    unsigned             i_entries;
+    unsigned             i_max_entries;
+
+    unsigned             i_bitmap_hits;
+    unsigned             i_bitmap_misses;
+    unsigned             i_outline_hits;
+    unsigned             i_outline_misses;
+};
+
+static unsigned KeyHash( const glyph_cache_key_t *p_key )
+{
+    uintptr_t i_hash = (uintptr_t)p_key->p_face >> 4;
+    i_hash ^= p_key->i_index * 2654435761u;
+    i_hash ^= (uintptr_t)p_key->i_style_flags << 20;
+    i_hash ^= (uintptr_t)p_key->i_outline_radius * 40503u;
+    return i_hash & (GLYPH_CACHE_BUCKETS - 1);
+}
+
+static bool KeyEquals( const glyph_cache_key_t *p_a, const glyph_cache_key_t *p_b )
+{
+    return p_a->p_face == p_b->p_face
+        && p_a->i_index == p_b->i_index
+        && p_a->i_style_flags == p_b->i_style_flags
+        && p_a->i_outline_radius == p_b->i_outline_radius;
+}
+
+static void LruUnlink( glyph_cache_t *p_cache, glyph_cache_entry_t *p_entry )
+{
+    if( p_entry->p_lru_prev )
+        p_entry->p_lru_prev->p_lru_next = p_entry->p_lru_next;
+    else
+        p_cache->p_lru_first = p_entry->p_lru_next;
+
+    if( p_entry->p_lru_next )
+        p_entry->p_lru_next->p_lru_prev = p_entry->p_lru_prev;
+    else
+        p_cache->p_lru_last = p_entry->p_lru_prev;
+
+    p_entry->p_lru_prev = p_entry->p_lru_next = NULL;
+}
+
+static void LruPushFront( glyph_cache_t *p_cache, glyph_cache_entry_t *p_entry )
+{
+    p_entry->p_lru_prev = NULL;
+    p_entry->p_lru_next = p_cache->p_lru_first;
+    if( p_cache->p_lru_first )
+        p_cache->p_lru_first->p_lru_prev = p_entry;
+    else
+        p_cache->p_lru_last = p_entry;
+    p_cache->p_lru_first = p_entry;
+}
+
+static glyph_cache_entry_t *Lookup( glyph_cache_t *p_cache,
+                                    const glyph_cache_key_t *p_key )
+{
+    glyph_cache_entry_t *p_entry = p_cache->pp_buckets[KeyHash( p_key )];
+
+    while( p_entry && !KeyEquals( &p_entry->key, p_key ) )
+        p_entry = p_entry->p_hash_next;
+
+    if( p_entry && p_entry != p_cache->p_lru_first )
+    {
+        LruUnlink( p_cache, p_entry );
+        LruPushFront( p_cache, p_entry );
+    }
+    return p_entry;
+}
+
+static void EntryDelete( glyph_cache_entry_t *p_entry )
+{
+    for( unsigned i = 0; i < GLYPH_CACHE_BITMAPS; i++ )
+        if( p_entry->bitmaps[i].p_bitmap )
+            FT_Done_Glyph( p_entry->bitmaps[i].p_bitmap );
+    if( p_entry->p_outline )
+        FT_Done_Glyph( p_entry->p_outline );
+    FT_Done_Glyph( p_entry->p_glyph );
+    free( p_entry );
+}
+
+static void Evict( glyph_cache_t *p_cache )
+{
+    glyph_cache_entry_t *p_entry = p_cache->p_lru_last;
+    if( !p_entry )
+        return;
+
+    glyph_cache_entry_t **pp = &p_cache->pp_buckets[KeyHash( &p_entry->key )];
+    while( *pp != p_entry )
+        pp = &(*pp)->p_hash_next;
+    *pp = p_entry->p_hash_next;
+
+    LruUnlink( p_cache, p_entry );
+    EntryDelete( p_entry );
+    p_cache->i_entries--;
+}
+
+glyph_cache_t *GlyphCache_New( unsigned i_max_entries )
+{
+    glyph_cache_t *p_cache = calloc( 1, sizeof( *p_cache ) );
+    if( !p_cache )
+        return NULL;
+
+    p_cache->i_max_entries = __MAX( i_max_entries, 1 );
+    return p_cache;
+}
+
+void GlyphCache_Delete( glyph_cache_t *p_cache )
+{
+    if( !p_cache )
+        return;
+
+    while( p_cache->p_lru_last )
+        Evict( p_cache );
+    free( p_cache );
+}
+
+bool GlyphCache_GetOutlines( glyph_cache_t *p_cache,
+                             const glyph_cache_key_t *p_key,
+                             FT_Glyph *pp_glyph, FT_Glyph *pp_outline,
+                             FT_Vector *p_advance )
+{
+    if( !p_cache )
+        return false;
+
+    glyph_cache_entry_t *p_entry = Lookup( p_cache, p_key );
+    if( !p_entry )
+    {
+        p_cache->i_outline_misses++;
+        return false;
+    }
+
+    FT_Glyph p_glyph, p_outline = NULL;
+    if( FT_Glyph_Copy( p_entry->p_glyph, &p_glyph ) )
+        return false;
+    if( p_entry->p_outline && FT_Glyph_Copy( p_entry->p_outline, &p_outline ) )
+    {
+        FT_Done_Glyph( p_glyph );
+        return false;
+    }
+
+    *pp_glyph = p_glyph;
+    *pp_outline = p_outline;
+    *p_advance = p_entry->advance;
+    p_cache->i_outline_hits++;
+    return true;
+}
+
+void GlyphCache_PutOutlines( glyph_cache_t *p_cache,
+                             const glyph_cache_key_t *p_key,
+                             FT_Glyph p_glyph, FT_Glyph p_outline,
+                             const FT_Vector *p_advance )
+{
+    if( !p_cache || !p_glyph )
+        return;
+
+    glyph_cache_entry_t *p_entry = calloc( 1, sizeof( *p_entry ) );
+    if( !p_entry )
+        return;
+
+    if( FT_Glyph_Copy( p_glyph, &p_entry->p_glyph ) )
+    {
+        free( p_entry );
+        return;
+    }
+    if( p_outline && FT_Glyph_Copy( p_outline, &p_entry->p_outline ) )
+    {
+        FT_Done_Glyph( p_entry->p_glyph );
+        free( p_entry );
+        return;
+    }
+    p_entry->key = *p_key;
+    p_entry->advance = *p_advance;
+
+    if( p_cache->i_entries >= p_cache->i_max_entries )
+        Evict( p_cache );
+
+    glyph_cache_entry_t **pp_bucket = &p_cache->pp_buckets[KeyHash( p_key )];
+    p_entry->p_hash_next = *pp_bucket;
+    *pp_bucket = p_entry;
+    LruPushFront( p_cache, p_entry );
+    p_cache->i_entries++;
+}
+
+FT_Error GlyphCache_ToBitmap( glyph_cache_t *p_cache,
+                              const glyph_cache_key_t *p_key, int i_source,
+                              FT_Glyph *pp_glyph, const FT_Vector *p_origin,
+                              bool b_destroy )
+{
+    glyph_cache_entry_t *p_entry = NULL;
+
+    /* Glyphs already in bitmap form ignore the origin */
+    if( p_cache && (*pp_glyph)->format != FT_GLYPH_FORMAT_BITMAP )
+        p_entry = Lookup( p_cache, p_key );
+    if( !p_entry )
+    {
+        FT_Error i_error = FT_Glyph_To_Bitmap( pp_glyph, FT_RENDER_MODE_NORMAL,
+                                               (FT_Vector *)p_origin, b_destroy );
+        if( p_cache && !i_error )
+            p_cache->i_bitmap_misses++;
+        return i_error;
+    }
+
+    /* Split the origin into its sub-pixel part, which changes the
+     * rasterization, and whole pixels, which only translate the bitmap */
+    const FT_Pos i_frac_x = p_origin->x & 63;
+    const FT_Pos i_frac_y = p_origin->y & 63;
+    const FT_Int i_dx = ( p_origin->x - i_frac_x ) / 64;
+    const FT_Int i_dy = ( p_origin->y - i_frac_y ) / 64;
+
+    FT_Glyph p_bitmap = NULL;
+    for( unsigned i = 0; i < GLYPH_CACHE_BITMAPS; i++ )
+    {
+        if( p_entry->bitmaps[i].p_bitmap
+         && p_entry->bitmaps[i].i_source == i_source
+         && p_entry->bitmaps[i].i_frac_x == i_frac_x
+         && p_entry->bitmaps[i].i_frac_y == i_frac_y )
+        {
+            if( FT_Glyph_Copy( p_entry->bitmaps[i].p_bitmap, &p_bitmap ) )
+                p_bitmap = NULL;
+            else
+                p_cache->i_bitmap_hits++;
+            break;
+        }
+    }
+
+    if( !p_bitmap )
+    {
+        FT_Vector frac = { .x = i_frac_x, .y = i_frac_y };
+        FT_Glyph p_cached;
+
+        p_bitmap = *pp_glyph;
+        FT_Error i_error = FT_Glyph_To_Bitmap( &p_bitmap, FT_RENDER_MODE_NORMAL,
+                                               &frac, false );
+        if( i_error )
+            return i_error;
+        p_cache->i_bitmap_misses++;
+
+        if( !FT_Glyph_Copy( p_bitmap, &p_cached ) )
+        {
+            unsigned i_slot = p_entry->i_next_bitmap++ % GLYPH_CACHE_BITMAPS;
+            if( p_entry->bitmaps[i_slot].p_bitmap )
+                FT_Done_Glyph( p_entry->bitmaps[i_slot].p_bitmap );
+            p_entry->bitmaps[i_slot].p_bitmap = p_cached;
+            p_entry->bitmaps[i_slot].i_source = i_source;
+            p_entry->bitmaps[i_slot].i_frac_x = i_frac_x;
+            p_entry->bitmaps[i_slot].i_frac_y = i_frac_y;
+        }
+    }
+
+    ((FT_BitmapGlyph)p_bitmap)->left += i_dx;
+    ((FT_BitmapGlyph)p_bitmap)->top  += i_dy;
+
+    if( b_destroy )
+        FT_Done_Glyph( *pp_glyph );
+    *pp_glyph = p_bitmap;
+    return 0;
+}
+
+void GlyphCache_GetStats( const glyph_cache_t *p_cache,
+                          unsigned *pi_bitmap_hits, unsigned *pi_bitmap_misses,
+                          unsigned *pi_outline_hits, unsigned *pi_outline_misses )
+{
+    *pi_bitmap_hits = p_cache->i_bitmap_hits;
+    *pi_bitmap_misses = p_cache->i_bitmap_misses;
+    *pi_outline_hits = p_cache->i_outline_hits;
+    *pi_outline_misses = p_cache->i_outline_misses;
+}
+
+/** @} */
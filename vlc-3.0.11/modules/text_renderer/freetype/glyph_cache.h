@@ -0,0 +1,105 @@
+/*****************************************************************************
+ * glyph_cache.h : Glyph outline and bitmap cache
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+/** \ingroup freetype
+ * @{
+ * \file
+ * Glyph outline and bitmap cache
+ *
+ * Loaded (emboldened, slanted and stroked) glyph outlines and their
+ * rasterized bitmaps are kept across renders, so that strings sharing glyphs
+ * with previously rendered ones (karaoke, OSD, repeated subtitle lines) do not
+ * hit FT_Load_Glyph() and the rasterizer again. Since a FT_Face is loaded
+ * once per font file and pixel size (see LoadFace()), the face pointer
+ * identifies both the font and its size.
+ *
+ * Bitmaps depend on the sub-pixel part of the pen position only: they are
+ * rasterized at that fractional origin and translated by whole pixels.
+ * Least recently used entries are evicted first.
+ */
+
+#define GLYPH_CACHE_MAX_ENTRIES 2048
+
+typedef struct glyph_cache_t glyph_cache_t;
+
+typedef struct
+{
+    FT_Face  p_face;            /**< font face, also defining the size */
+    FT_UInt  i_index;           /**< glyph index within the face */
+    int      i_style_flags;     /**< synthesized styles (bold, italic, outline) */
+    FT_Fixed i_outline_radius;  /**< stroker radius if outlined */
+} glyph_cache_key_t;
+
+enum glyph_cache_source_e
+{
+    GLYPH_CACHE_GLYPH,
+    GLYPH_CACHE_OUTLINE,
+};
+
+glyph_cache_t *GlyphCache_New( unsigned i_max_entries );
+void GlyphCache_Delete( glyph_cache_t *p_cache );
+
+/**
+ * Retrieves copies of the cached glyph and outline.
+ *
+ * \param pp_glyph the glyph copy [OUT]
+ * \param pp_outline the outline copy, NULL if the glyph has none [OUT]
+ * \param p_advance the glyph advance [OUT]
+ * \return true on cache hit, false otherwise (outputs are left untouched)
+ */
+bool GlyphCache_GetOutlines( glyph_cache_t *p_cache,
+                             const glyph_cache_key_t *p_key,
+                             FT_Glyph *pp_glyph, FT_Glyph *pp_outline,
+                             FT_Vector *p_advance );
+
+/**
+ * Stores copies of a freshly loaded glyph and outline.
+ */
+void GlyphCache_PutOutlines( glyph_cache_t *p_cache,
+                             const glyph_cache_key_t *p_key,
+                             FT_Glyph p_glyph, FT_Glyph p_outline,
+                             const FT_Vector *p_advance );
+
+/**
+ * Cached replacement for FT_Glyph_To_Bitmap( pp_glyph, FT_RENDER_MODE_NORMAL,
+ * p_origin, b_destroy ).
+ *
+ * \param i_source whether *pp_glyph is the glyph or the outline of the
+ * entry designated by \p p_key
+ */
+FT_Error GlyphCache_ToBitmap( glyph_cache_t *p_cache,
+                              const glyph_cache_key_t *p_key, int i_source,
+                              FT_Glyph *pp_glyph, const FT_Vector *p_origin,
+                              bool b_destroy );
+
+/**
+ * Returns how many rasterizations and glyph loads the cache avoided, and
+ * how many it could not.
+ */
+void GlyphCache_GetStats( const glyph_cache_t *p_cache,
+                          unsigned *pi_bitmap_hits, unsigned *pi_bitmap_misses,
+                          unsigned *pi_outline_hits, unsigned *pi_outline_misses );
+
+/** @} */
+
+#endif
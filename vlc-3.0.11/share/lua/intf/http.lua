@@ -224,6 +224,10 @@ function file(h,path,url,mime)
 end
 
 function rawfile(h,path,url)
+    if password and password ~= "" then
+        -- Served straight from the disk, without loading it
+        return h:diskfile(url or path,path,nil,nil,password)
+    end
     local filename = path
     local mtime = 0    -- vlc.net.stat(filename).modification_time
     local page = false -- io.open(filename):read("*a")
@@ -199,14 +199,9 @@ static block_t *AStreamReadBlock(stream_t *s, bool *restrict eof)
 
     if (block != NULL && input != NULL)
     {
-        uint64_t total;
-
-        vlc_mutex_lock(&input_priv(input)->counters.counters_lock);
         stats_Update(input_priv(input)->counters.p_read_bytes,
-                     block->i_buffer, &total);
-        stats_Update(input_priv(input)->counters.p_input_bitrate, total, NULL);
-        stats_Update(input_priv(input)->counters.p_read_packets, 1, NULL);
-        vlc_mutex_unlock(&input_priv(input)->counters.counters_lock);
+                     block->i_buffer);
+        stats_Update(input_priv(input)->counters.p_read_packets, 1);
     }
 
     return block;
@@ -227,13 +222,8 @@ static ssize_t AStreamReadStream(stream_t *s, void *buf, size_t len)
 
     if (val > 0 && input != NULL)
     {
-        uint64_t total;
-
-        vlc_mutex_lock(&input_priv(input)->counters.counters_lock);
-        stats_Update(input_priv(input)->counters.p_read_bytes, val, &total);
-        stats_Update(input_priv(input)->counters.p_input_bitrate, total, NULL);
-        stats_Update(input_priv(input)->counters.p_read_packets, 1, NULL);
-        vlc_mutex_unlock(&input_priv(input)->counters.counters_lock);
+        stats_Update(input_priv(input)->counters.p_read_bytes, val);
+        stats_Update(input_priv(input)->counters.p_read_packets, 1);
     }
 
     return val;
@@ -291,7 +281,12 @@ stream_t *stream_AccessNew(vlc_object_t *parent, input_thread_t *input,
     if (access->pf_block != NULL)
     {
         s->pf_block = AStreamReadBlock;
-        cachename = "prefetch,cache_block";
+        /* Memory-mapped blocks are passed through as is: the cache would
+         * only copy them */
+        if (vlc_stream_Control(access, STREAM_IS_MAPPED) == VLC_SUCCESS)
+            cachename = NULL;
+        else
+            cachename = "prefetch,cache_block";
     }
     else
     if (access->pf_read != NULL)
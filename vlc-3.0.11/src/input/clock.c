@@ -99,6 +99,19 @@
 /* Due to some problems in es_out, we cannot use a large value yet */
 #define CR_BUFFERING_TARGET (100000)
 
+/* Adaptive delay: the arrival jitter is measured over windows of
+ * CR_ADAPTIVE_WINDOW, and the largest of the last CR_ADAPTIVE_WINDOWS
+ * windows is used. */
+#define CR_ADAPTIVE_WINDOW (2 * CLOCK_FREQ)
+#define CR_ADAPTIVE_WINDOWS (8)
+
+/* Delay kept on top of twice the jitter */
+#define CR_ADAPTIVE_MARGIN (CLOCK_FREQ / 20)
+
+/* Rate (in 1/256) at which the adaptive delay changes. It must stay well
+ * below the resampling range of the audio output (AOUT_MAX_RESAMPLING). */
+#define CR_ADAPTIVE_RATE (4)
+
 /*****************************************************************************
  * Structures
  *****************************************************************************/
@@ -178,12 +191,35 @@ struct input_clock_t
     int     i_rate;
     mtime_t i_pts_delay;
     mtime_t i_pause_date;
+
+    /* Adaptive delay */
+    struct
+    {
+        bool     b_enabled;
+        mtime_t  i_min;
+        mtime_t  i_reduction;   /* of i_pts_delay */
+        mtime_t  i_last_update;
+        mtime_t  i_target_logged;
+
+        /* Arrival deviation over the current window */
+        mtime_t  i_window_start;
+        mtime_t  i_deviation_min;
+        mtime_t  i_deviation_max;
+
+        /* Jitter of the last windows */
+        mtime_t  pi_jitter[CR_ADAPTIVE_WINDOWS];
+        unsigned i_index;
+        unsigned i_count;
+    } adaptive;
 };
 
 static mtime_t ClockStreamToSystem( input_clock_t *, mtime_t i_stream );
 static mtime_t ClockSystemToStream( input_clock_t *, mtime_t i_system );
 
 static mtime_t ClockGetTsOffset( input_clock_t * );
+static mtime_t ClockGetDelay( input_clock_t * );
+static void    ClockAdaptiveUpdate( input_clock_t *, vlc_object_t *p_log,
+                                    mtime_t i_ck_stream, mtime_t i_ck_system );
 
 /*****************************************************************************
  * input_clock_New: create a new clock
@@ -217,6 +253,15 @@ input_clock_t *input_clock_New( int i_rate )
     cl->b_paused = false;
     cl->i_pause_date = VLC_TS_INVALID;
 
+    cl->adaptive.b_enabled = false;
+    cl->adaptive.i_min = 0;
+    cl->adaptive.i_reduction = 0;
+    cl->adaptive.i_last_update = VLC_TS_INVALID;
+    cl->adaptive.i_target_logged = VLC_TS_INVALID;
+    cl->adaptive.i_window_start = VLC_TS_INVALID;
+    cl->adaptive.i_index = 0;
+    cl->adaptive.i_count = 0;
+
     return cl;
 }
 
@@ -291,6 +336,10 @@ void input_clock_Update( input_clock_t *cl, vlc_object_t *p_log,
         cl->i_next_drift_update = i_ck_system + CLOCK_FREQ/5; /* FIXME why that */
     }
 
+    /* Adapt the delay to the arrival jitter */
+    if( cl->adaptive.b_enabled && !b_can_pace_control && !b_reset_reference )
+        ClockAdaptiveUpdate( cl, p_log, i_ck_stream, i_ck_system );
+
     /* Update the extra buffering value */
     if( !b_can_pace_control || b_reset_reference )
     {
@@ -315,7 +364,19 @@ void input_clock_Update( input_clock_t *cl, vlc_object_t *p_log,
     /* It does not take the decoder latency into account but it is not really
      * the goal of the clock here */
     const mtime_t i_system_expected = ClockStreamToSystem( cl, i_ck_stream + AvgGet( &cl->drift ) );
-    const mtime_t i_late = ( i_ck_system - cl->i_pts_delay ) - i_system_expected;
+    mtime_t i_late = ( i_ck_system - ClockGetDelay( cl ) ) - i_system_expected;
+    if( i_late > 0 && cl->adaptive.i_reduction > 0 )
+    {
+        /* The adaptive delay is too low: raise it at once */
+        const mtime_t i_raise = __MIN( i_late + CR_ADAPTIVE_MARGIN,
+                                       cl->adaptive.i_reduction );
+
+        cl->adaptive.i_reduction -= i_raise;
+        i_late -= i_raise;
+        msg_Warn( p_log, "adaptive caching raised to %"PRId64" ms "
+                  "(late by %"PRId64" ms)", ClockGetDelay( cl ) / 1000,
+                  ( i_late + i_raise ) / 1000 );
+    }
     *pb_late = i_late > 0;
     if( i_late > 0 )
     {
@@ -338,6 +399,12 @@ void input_clock_Reset( input_clock_t *cl )
     cl->b_has_external_clock = false;
     cl->i_ts_max = VLC_TS_INVALID;
 
+    /* The input buffers with the full delay again, the measured jitter is
+     * kept to lower it faster */
+    cl->adaptive.i_reduction = 0;
+    cl->adaptive.i_last_update = VLC_TS_INVALID;
+    cl->adaptive.i_window_start = VLC_TS_INVALID;
+
     vlc_mutex_unlock( &cl->lock );
 }
 
@@ -427,7 +494,7 @@ int input_clock_ConvertTS( vlc_object_t *p_object, input_clock_t *cl,
 
     /* */
     const mtime_t i_ts_buffering = cl->i_buffering_duration * cl->i_rate / INPUT_RATE_DEFAULT;
-    const mtime_t i_ts_delay = cl->i_pts_delay + ClockGetTsOffset( cl );
+    const mtime_t i_ts_delay = ClockGetDelay( cl ) + ClockGetTsOffset( cl );
 
     /* */
     if( *pi_ts0 > VLC_TS_INVALID )
@@ -531,7 +598,7 @@ void input_clock_GetSystemOrigin( input_clock_t *cl, mtime_t *pi_system, mtime_t
 
     *pi_system = cl->ref.i_system;
     if( pi_delay )
-        *pi_delay  = cl->i_pts_delay;
+        *pi_delay  = ClockGetDelay( cl );
 
     vlc_mutex_unlock( &cl->lock );
 }
@@ -598,6 +665,16 @@ mtime_t input_clock_GetJitter( input_clock_t *cl )
     return i_pts_delay + i_late_median;
 }
 
+void input_clock_SetAdaptive( input_clock_t *cl, mtime_t i_min )
+{
+    vlc_mutex_lock( &cl->lock );
+
+    cl->adaptive.b_enabled = true;
+    cl->adaptive.i_min = __MAX( i_min, 0 );
+
+    vlc_mutex_unlock( &cl->lock );
+}
+
 /*****************************************************************************
  * ClockStreamToSystem: converts a movie clock to system date
  *****************************************************************************/
@@ -631,6 +708,84 @@ static mtime_t ClockGetTsOffset( input_clock_t *cl )
     return cl->i_pts_delay * ( cl->i_rate - INPUT_RATE_DEFAULT ) / INPUT_RATE_DEFAULT;
 }
 
+/**
+ * It returns the delay currently applied (lowered by the adaptive delay)
+ */
+static mtime_t ClockGetDelay( input_clock_t *cl )
+{
+    return cl->i_pts_delay - cl->adaptive.i_reduction;
+}
+
+/*****************************************************************************
+ * ClockAdaptiveUpdate: measures the arrival jitter and adapts the delay
+ *****************************************************************************
+ * The deviation of the arrival date of each clock reference from the
+ * (drift corrected) clock is measured. Its spread over a window is the
+ * jitter, and the delay targets twice the largest jitter of the last windows
+ * plus a margin. The delay is only changed once enough windows have been
+ * measured, and then moves toward the target at CR_ADAPTIVE_RATE.
+ *****************************************************************************/
+static void ClockAdaptiveUpdate( input_clock_t *cl, vlc_object_t *p_log,
+                                 mtime_t i_ck_stream, mtime_t i_ck_system )
+{
+    const mtime_t i_deviation = i_ck_system -
+        ClockStreamToSystem( cl, i_ck_stream + AvgGet( &cl->drift ) );
+
+    if( cl->adaptive.i_window_start <= VLC_TS_INVALID )
+    {
+        cl->adaptive.i_window_start = i_ck_system;
+        cl->adaptive.i_deviation_min = i_deviation;
+        cl->adaptive.i_deviation_max = i_deviation;
+    }
+    cl->adaptive.i_deviation_min = __MIN( cl->adaptive.i_deviation_min, i_deviation );
+    cl->adaptive.i_deviation_max = __MAX( cl->adaptive.i_deviation_max, i_deviation );
+
+    /* The current window counts as soon as its jitter is the largest */
+    mtime_t i_jitter = cl->adaptive.i_deviation_max - cl->adaptive.i_deviation_min;
+
+    if( i_ck_system - cl->adaptive.i_window_start >= CR_ADAPTIVE_WINDOW )
+    {
+        cl->adaptive.pi_jitter[cl->adaptive.i_index] = i_jitter;
+        cl->adaptive.i_index = ( cl->adaptive.i_index + 1 ) % CR_ADAPTIVE_WINDOWS;
+        if( cl->adaptive.i_count < CR_ADAPTIVE_WINDOWS )
+            cl->adaptive.i_count++;
+        cl->adaptive.i_window_start = VLC_TS_INVALID;
+    }
+
+    const mtime_t i_elapsed = cl->adaptive.i_last_update > VLC_TS_INVALID ?
+        __MAX( i_ck_system - cl->adaptive.i_last_update, 0 ) : 0;
+    cl->adaptive.i_last_update = i_ck_system;
+
+    if( cl->adaptive.i_count < CR_ADAPTIVE_WINDOWS )
+        return;
+
+    for( unsigned i = 0; i < CR_ADAPTIVE_WINDOWS; i++ )
+        i_jitter = __MAX( i_jitter, cl->adaptive.pi_jitter[i] );
+
+    mtime_t i_target = 2 * i_jitter + CR_ADAPTIVE_MARGIN;
+    i_target = __MAX( i_target, cl->adaptive.i_min );
+    i_target = __MIN( i_target, cl->i_pts_delay );
+
+    /* Move slowly toward the target */
+    const mtime_t i_reduction = cl->i_pts_delay - i_target;
+    const mtime_t i_step = ( i_elapsed * CR_ADAPTIVE_RATE + 255 ) / 256;
+
+    if( cl->adaptive.i_reduction < i_reduction )
+        cl->adaptive.i_reduction = __MIN( cl->adaptive.i_reduction + i_step,
+                                          i_reduction );
+    else
+        cl->adaptive.i_reduction = __MAX( cl->adaptive.i_reduction - i_step,
+                                          i_reduction );
+
+    if( cl->adaptive.i_target_logged <= VLC_TS_INVALID ||
+        llabs( i_target - cl->adaptive.i_target_logged ) >= CLOCK_FREQ / 100 )
+    {
+        msg_Dbg( p_log, "adaptive caching: jitter %"PRId64" ms, "
+                 "caching %"PRId64" ms", i_jitter / 1000, i_target / 1000 );
+        cl->adaptive.i_target_logged = i_target;
+    }
+}
+
 /*****************************************************************************
  * Long term average helpers
  *****************************************************************************/
@@ -136,4 +136,14 @@ void input_clock_SetJitter( input_clock_t *,
  */
 mtime_t input_clock_GetJitter( input_clock_t * );
 
+/**
+ * This function enables the adaptive delay for real-time sources.
+ *
+ * The arrival jitter of the clock references is measured, and the delay set
+ * by input_clock_SetJitter is lowered down to i_min when the jitter allows
+ * it. The delay changes slowly, so that the audio output can follow by
+ * resampling, except when a clock reference arrives late.
+ */
+void input_clock_SetAdaptive( input_clock_t *, mtime_t i_min );
+
 #endif
@@ -43,6 +43,7 @@
 #include <vlc_meta.h>
 #include <vlc_dialog.h>
 #include <vlc_modules.h>
+#include <vlc_executor.h>
 
 #include "audio_output/aout_internal.h"
 #include "stream_output/stream_output.h"
@@ -80,6 +81,10 @@ struct decoder_owner_sys_t
 
     vlc_thread_t     thread;
 
+    /* Shared executor, NULL if the decoder runs on its own thread */
+    struct vlc_executor *p_executor;
+    struct vlc_runnable runnable;
+
     void (*pf_update_stat)( decoder_owner_sys_t *, unsigned decoded, unsigned lost );
 
     /* Some decoders require already packetized data (ie. not truncated) */
@@ -88,6 +93,11 @@ struct decoder_owner_sys_t
 
     /* Current format in use by the output */
     es_format_t    fmt;
+    /* Format the video output and its picture pools were created with */
+    video_format_t fmt_pool;
+    /* Same, with the visible area and aspect ratio the pictures are tagged
+     * with */
+    video_format_t fmt_vout;
 
     /* */
     bool           b_fmt_description;
@@ -116,6 +126,7 @@ struct decoder_owner_sys_t
     mtime_t pause_date;
     unsigned frames_countdown;
     bool paused;
+    bool output_paused; /* only accessed by the decoder loop */
 
     bool error;
 
@@ -130,6 +141,11 @@ struct decoder_owner_sys_t
     atomic_bool drained;
     bool b_idle;
 
+    /* Executor task (protected by the fifo lock) */
+    bool b_scheduled;
+    bool b_running; /* the task is on a thread, not only queued */
+    bool b_closing;
+
     /* CC */
 #define MAX_CC_DECODERS 64 /* The es_out only creates one type of es */
     struct
@@ -141,6 +157,20 @@ struct decoder_owner_sys_t
 
     /* Delay */
     mtime_t i_ts_delay;
+
+    /* Latency statistics */
+#define DECODER_QUEUE_DATES 64
+    struct
+    {
+        const block_t *p_block;
+        mtime_t date;
+    } queue_dates[DECODER_QUEUE_DATES]; /* protected by the fifo lock */
+    unsigned i_queue_date_first;
+    unsigned i_queue_dates;
+    atomic_int_fast64_t decode_date;
+
+    /* Latency trace (NULL if disabled) */
+    es_trace_t *p_trace;
 };
 
 /* Pictures which are DECODER_BOGUS_VIDEO_DELAY or more in advance probably have
@@ -411,6 +441,40 @@ static int aout_update_format( decoder_t *p_dec )
     return 0;
 }
 
+/**
+ * Tells whether the pictures of the current video output can hold pictures
+ * of the given format, which then differs only by its visible area or its
+ * aspect ratio.
+ *
+ * The visible area must fit in the one the video output was created with:
+ * the private and display pools of the video output keep that geometry,
+ * and copying a picture to them copies at most that area.
+ */
+static bool vout_can_reuse_pool( const decoder_owner_sys_t *p_owner,
+                                 const video_format_t *p_fmt )
+{
+    const video_format_t *p_cur = &p_owner->fmt_pool;
+
+    return p_owner->p_vout != NULL
+        && p_fmt->p_palette == NULL
+        && p_fmt->i_x_offset >= p_cur->i_x_offset
+        && p_fmt->i_y_offset >= p_cur->i_y_offset
+        && p_fmt->i_x_offset + p_fmt->i_visible_width
+           <= p_cur->i_x_offset + p_cur->i_visible_width
+        && p_fmt->i_y_offset + p_fmt->i_visible_height
+           <= p_cur->i_y_offset + p_cur->i_visible_height
+        && p_fmt->i_chroma == p_cur->i_chroma
+        && p_fmt->i_width == p_cur->i_width
+        && p_fmt->i_height == p_cur->i_height
+        && p_fmt->orientation == p_cur->orientation
+        && p_fmt->multiview_mode == p_cur->multiview_mode
+        && p_fmt->projection_mode == p_cur->projection_mode
+        && p_fmt->b_color_range_full == p_cur->b_color_range_full
+        && p_fmt->primaries == p_cur->primaries
+        && p_fmt->transfer == p_cur->transfer
+        && p_fmt->space == p_cur->space;
+}
+
 static int vout_update_format( decoder_t *p_dec )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
@@ -496,6 +560,24 @@ static int vout_update_format( decoder_t *p_dec )
 
         video_format_AdjustColorSpace( &fmt );
 
+        if( vout_can_reuse_pool( p_owner, &fmt ) )
+        {
+            /* Same picture allocation: keep the video output and its pools,
+             * only the visible area and aspect ratio change, and they are
+             * carried by each picture (see vout_new_buffer()). */
+            msg_Dbg( p_dec, "reusing video output pool, visible area %ux%u",
+                     fmt.i_visible_width, fmt.i_visible_height );
+            vlc_mutex_lock( &p_owner->lock );
+            DecoderUpdateFormatLocked( p_dec );
+            p_owner->fmt.video.i_chroma = p_dec->fmt_out.i_codec;
+            vlc_mutex_unlock( &p_owner->lock );
+
+            video_format_CopyCrop( &p_owner->fmt_vout, &fmt );
+            p_owner->fmt_vout.i_sar_num = fmt.i_sar_num;
+            p_owner->fmt_vout.i_sar_den = fmt.i_sar_den;
+            return 0;
+        }
+
         vlc_mutex_lock( &p_owner->lock );
 
         p_vout = p_owner->p_vout;
@@ -520,11 +602,15 @@ static int vout_update_format( decoder_t *p_dec )
             dpb_size = 2;
             break;
         }
+        if( p_vout != NULL && p_owner->p_trace != NULL )
+            vout_SetTrace( p_vout, NULL );
         p_vout = input_resource_RequestVout( p_owner->p_resource,
                                              p_vout, &fmt,
                                              dpb_size +
                                              p_dec->i_extra_picture_buffers + 1,
                                              true );
+        if( p_vout != NULL && p_owner->p_trace != NULL )
+            vout_SetTrace( p_vout, p_owner->p_trace );
         vlc_mutex_lock( &p_owner->lock );
         p_owner->p_vout = p_vout;
 
@@ -532,6 +618,10 @@ static int vout_update_format( decoder_t *p_dec )
         p_owner->fmt.video.i_chroma = p_dec->fmt_out.i_codec;
         vlc_mutex_unlock( &p_owner->lock );
 
+        p_owner->fmt_pool = fmt;
+        p_owner->fmt_pool.p_palette = NULL;
+        p_owner->fmt_vout = p_owner->fmt_pool;
+
         if( p_owner->p_input != NULL )
             input_SendEventVout( p_owner->p_input );
         if( p_vout == NULL )
@@ -562,7 +652,44 @@ static picture_t *vout_new_buffer( decoder_t *p_dec )
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
     assert( p_owner->p_vout );
 
-    return vout_GetPicture( p_owner->p_vout );
+    /* Waits for the video output to release a picture if the pool is empty */
+    vlc_executor_BlockingBegin();
+    picture_t *p_pic = vout_GetPicture( p_owner->p_vout );
+    vlc_executor_BlockingEnd();
+    if( p_pic == NULL )
+        return NULL;
+
+    /* The pool may have been allocated for another visible area, see
+     * vout_can_reuse_pool() */
+    const video_format_t *p_fmt = &p_owner->fmt_vout;
+    if( p_pic->format.i_visible_width != p_fmt->i_visible_width
+     || p_pic->format.i_visible_height != p_fmt->i_visible_height
+     || p_pic->format.i_x_offset != p_fmt->i_x_offset
+     || p_pic->format.i_y_offset != p_fmt->i_y_offset
+     || p_pic->format.i_sar_num != p_fmt->i_sar_num
+     || p_pic->format.i_sar_den != p_fmt->i_sar_den )
+    {
+        const vlc_chroma_description_t *p_dsc =
+            vlc_fourcc_GetChromaDescription( p_pic->format.i_chroma );
+
+        video_format_CopyCrop( &p_pic->format, p_fmt );
+        p_pic->format.i_sar_num = p_fmt->i_sar_num;
+        p_pic->format.i_sar_den = p_fmt->i_sar_den;
+
+        for( int i = 0; p_dsc != NULL && i < p_pic->i_planes; i++ )
+        {
+            plane_t *p = &p_pic->p[i];
+
+            p->i_visible_lines = __MIN( p->i_lines,
+                (int)(p_fmt->i_visible_height + p_dsc->p[i].h.den - 1)
+                    / (int)p_dsc->p[i].h.den * (int)p_dsc->p[i].h.num );
+            p->i_visible_pitch = __MIN( p->i_pitch,
+                (int)(p_fmt->i_visible_width + p_dsc->p[i].w.den - 1)
+                    / (int)p_dsc->p[i].w.den * (int)p_dsc->p[i].w.num
+                    * (int)p_dsc->pixel_size );
+        }
+    }
+    return p_pic;
 }
 
 static subpicture_t *spu_new_buffer( decoder_t *p_dec,
@@ -738,7 +865,9 @@ static void DecoderWaitUnblock( decoder_t *p_dec )
     {
         if( !p_owner->b_waiting || !p_owner->b_has_data )
             break;
+        vlc_executor_BlockingBegin();
         vlc_cond_wait( &p_owner->wait_request, &p_owner->lock );
+        vlc_executor_BlockingEnd();
     }
 }
 
@@ -751,10 +880,12 @@ static int DecoderTimedWait( decoder_t *p_dec, mtime_t deadline )
     if (deadline - mdate() <= 0)
         return VLC_SUCCESS;
 
+    vlc_executor_BlockingBegin();
     vlc_fifo_Lock( p_owner->p_fifo );
     while( !p_owner->flushing
         && vlc_fifo_TimedWaitCond( p_owner->p_fifo, &p_owner->wait_timed,
                                    deadline ) == 0 );
+    vlc_executor_BlockingEnd();
     int ret = p_owner->flushing ? VLC_EGENERIC : VLC_SUCCESS;
     vlc_fifo_Unlock( p_owner->p_fifo );
     return ret;
@@ -992,6 +1123,27 @@ static int DecoderQueueCc( decoder_t *p_videodec, block_t *p_cc,
     return 0;
 }
 
+static void DecoderUpdateLatency( decoder_owner_sys_t *p_owner,
+                                  enum input_stats_latency_e i_stage,
+                                  mtime_t i_latency )
+{
+    input_thread_t *p_input = p_owner->p_input;
+
+    if( p_input != NULL )
+        stats_Update( input_priv(p_input)->counters.p_latency[i_stage],
+                      __MAX( i_latency, 0 ) );
+}
+
+/* Account for the time between the last block taken from the fifo and a
+ * decoded frame */
+static void DecoderUpdateDecodeLatency( decoder_owner_sys_t *p_owner )
+{
+    mtime_t i_date = atomic_exchange( &p_owner->decode_date, VLC_TS_INVALID );
+
+    if( i_date > VLC_TS_INVALID )
+        DecoderUpdateLatency( p_owner, INPUT_LATENCY_DECODE, mdate() - i_date );
+}
+
 static int DecoderPlayVideo( decoder_t *p_dec, picture_t *p_picture,
                              unsigned *restrict pi_lost_sum )
 {
@@ -1046,12 +1198,21 @@ static int DecoderPlayVideo( decoder_t *p_dec, picture_t *p_picture,
     }
 
     const bool b_dated = p_picture->date > VLC_TS_INVALID;
+    const mtime_t i_ts = p_picture->date;
     int i_rate = INPUT_RATE_DEFAULT;
     DecoderFixTs( p_dec, &p_picture->date, NULL, NULL,
                   &i_rate, DECODER_BOGUS_VIDEO_DELAY );
 
     vlc_mutex_unlock( &p_owner->lock );
 
+    if( p_owner->p_trace )
+        es_trace_Add( p_owner->p_trace, ES_TRACE_OUTPUT, i_ts,
+                      p_picture->date );
+
+    if( p_picture->date > VLC_TS_INVALID )
+        DecoderUpdateLatency( p_owner, INPUT_LATENCY_DECODE_DISPLAY,
+                              p_picture->date - mdate() );
+
     /* FIXME: The *input* FIFO should not be locked here. This will not work
      * properly if/when pictures are queued asynchronously. */
     vlc_fifo_Lock( p_owner->p_fifo );
@@ -1108,11 +1269,9 @@ static void DecoderUpdateStatVideo( decoder_owner_sys_t *p_owner,
         lost += vout_lost;
     }
 
-    vlc_mutex_lock( &input_priv(p_input)->counters.counters_lock );
-    stats_Update( input_priv(p_input)->counters.p_decoded_video, decoded, NULL );
-    stats_Update( input_priv(p_input)->counters.p_lost_pictures, lost , NULL);
-    stats_Update( input_priv(p_input)->counters.p_displayed_pictures, displayed, NULL);
-    vlc_mutex_unlock( &input_priv(p_input)->counters.counters_lock );
+    stats_Update( input_priv(p_input)->counters.p_decoded_video, decoded );
+    stats_Update( input_priv(p_input)->counters.p_lost_pictures, lost );
+    stats_Update( input_priv(p_input)->counters.p_displayed_pictures, displayed );
 }
 
 static int DecoderQueueVideo( decoder_t *p_dec, picture_t *p_pic )
@@ -1121,6 +1280,8 @@ static int DecoderQueueVideo( decoder_t *p_dec, picture_t *p_pic )
     unsigned i_lost = 0;
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
 
+    DecoderUpdateDecodeLatency( p_owner );
+
     int ret = DecoderPlayVideo( p_dec, p_pic, &i_lost );
 
     p_owner->pf_update_stat( p_owner, 1, i_lost );
@@ -1174,12 +1335,21 @@ static int DecoderPlayAudio( decoder_t *p_dec, block_t *p_audio,
 
     /* */
     int i_rate = INPUT_RATE_DEFAULT;
+    const mtime_t i_ts = p_audio->i_pts;
 
     DecoderWaitUnblock( p_dec );
     DecoderFixTs( p_dec, &p_audio->i_pts, NULL, &p_audio->i_length,
                   &i_rate, AOUT_MAX_ADVANCE_TIME );
     vlc_mutex_unlock( &p_owner->lock );
 
+    if( p_owner->p_trace )
+        es_trace_Add( p_owner->p_trace, ES_TRACE_OUTPUT, i_ts,
+                      p_audio->i_pts );
+
+    if( p_audio->i_pts > VLC_TS_INVALID )
+        DecoderUpdateLatency( p_owner, INPUT_LATENCY_DECODE_DISPLAY,
+                              p_audio->i_pts - mdate() );
+
     audio_output_t *p_aout = p_owner->p_aout;
 
     if( p_aout != NULL && p_audio->i_pts > VLC_TS_INVALID
@@ -1228,11 +1398,9 @@ static void DecoderUpdateStatAudio( decoder_owner_sys_t *p_owner,
         lost += aout_lost;
     }
 
-    vlc_mutex_lock( &input_priv(p_input)->counters.counters_lock);
-    stats_Update( input_priv(p_input)->counters.p_lost_abuffers, lost, NULL );
-    stats_Update( input_priv(p_input)->counters.p_played_abuffers, played, NULL );
-    stats_Update( input_priv(p_input)->counters.p_decoded_audio, decoded, NULL );
-    vlc_mutex_unlock( &input_priv(p_input)->counters.counters_lock);
+    stats_Update( input_priv(p_input)->counters.p_lost_abuffers, lost );
+    stats_Update( input_priv(p_input)->counters.p_played_abuffers, played );
+    stats_Update( input_priv(p_input)->counters.p_decoded_audio, decoded );
 }
 
 static int DecoderQueueAudio( decoder_t *p_dec, block_t *p_aout_buf )
@@ -1240,6 +1408,8 @@ static int DecoderQueueAudio( decoder_t *p_dec, block_t *p_aout_buf )
     unsigned lost = 0;
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
 
+    DecoderUpdateDecodeLatency( p_owner );
+
     int ret = DecoderPlayAudio( p_dec, p_aout_buf, &lost );
 
     p_owner->pf_update_stat( p_owner, 1, lost );
@@ -1297,11 +1467,7 @@ static int DecoderQueueSpu( decoder_t *p_dec, subpicture_t *p_spu )
     input_thread_t *p_input = p_owner->p_input;
 
     if( p_input != NULL )
-    {
-        vlc_mutex_lock( &input_priv(p_input)->counters.counters_lock );
-        stats_Update( input_priv(p_input)->counters.p_decoded_sub, 1, NULL );
-        vlc_mutex_unlock( &input_priv(p_input)->counters.counters_lock );
-    }
+        stats_Update( input_priv(p_input)->counters.p_decoded_sub, 1 );
 
     int i_ret = -1;
     vout_thread_t *p_vout = input_resource_HoldVout( p_owner->p_resource );
@@ -1404,6 +1570,11 @@ static void DecoderProcess( decoder_t *p_dec, block_t *p_block )
             /* This block has already been packetized */
             packetize = false;
         }
+        else if( p_owner->p_trace )
+            es_trace_Add( p_owner->p_trace, ES_TRACE_DECODE,
+                          p_block->i_dts > VLC_TS_INVALID ? p_block->i_dts
+                                                          : p_block->i_pts,
+                          VLC_TS_INVALID );
     }
 
 #ifdef ENABLE_SOUT
@@ -1528,117 +1699,295 @@ static void DecoderProcessFlush( decoder_t *p_dec )
     vlc_mutex_unlock( &p_owner->lock );
 }
 
+/**
+ * Remember when a block is queued, for the latency statistics
+ *
+ * The fifo must be locked.
+ */
+static void DecoderQueueDate( decoder_owner_sys_t *p_owner,
+                              const block_t *p_block )
+{
+    /* If too many blocks are queued, the next ones are not accounted for */
+    if( p_owner->i_queue_dates >= DECODER_QUEUE_DATES )
+        return;
+
+    unsigned i = ( p_owner->i_queue_date_first + p_owner->i_queue_dates++ )
+                 % DECODER_QUEUE_DATES;
+    p_owner->queue_dates[i].p_block = p_block;
+    p_owner->queue_dates[i].date = mdate();
+}
+
+/**
+ * Account for the time a block spent in the fifo
+ *
+ * The fifo must be locked.
+ */
+static void DecoderDequeueDate( decoder_owner_sys_t *p_owner,
+                                const block_t *p_block )
+{
+    mtime_t now = mdate();
+
+    atomic_store( &p_owner->decode_date, now );
+
+    /* Blocks queued while the dates were full, or not queued by
+     * input_DecoderDecode() (closed captions), have no date */
+    unsigned i = p_owner->i_queue_date_first;
+    if( p_owner->i_queue_dates == 0
+     || p_owner->queue_dates[i].p_block != p_block )
+        return;
+
+    DecoderUpdateLatency( p_owner, INPUT_LATENCY_DEMUX_DECODE,
+                          now - p_owner->queue_dates[i].date );
+    p_owner->i_queue_date_first = ( i + 1 ) % DECODER_QUEUE_DATES;
+    p_owner->i_queue_dates--;
+}
+
 /**
  * The decoding main loop
  *
  * \param p_dec the decoder
  */
-static void *DecoderThread( void *p_data )
+/**
+ * Runs one iteration of the decoder main loop
+ *
+ * The fifo must be locked, and is locked on return.
+ *
+ * \return false if the decoder is idle, until the fifo is signaled
+ */
+static bool DecoderStep( decoder_t *p_dec )
 {
-    decoder_t *p_dec = (decoder_t *)p_data;
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
-    bool paused = false;
 
-    /* The decoder's main loop */
-    vlc_fifo_Lock( p_owner->p_fifo );
-    vlc_fifo_CleanupPush( p_owner->p_fifo );
+    if( p_owner->flushing )
+    {   /* Flush before/regardless of pause. We do not want to resume just
+         * for the sake of flushing (glitches could otherwise happen). */
+        int canc = vlc_savecancel();
 
-    for( ;; )
-    {
-        if( p_owner->flushing )
-        {   /* Flush before/regardless of pause. We do not want to resume just
-             * for the sake of flushing (glitches could otherwise happen). */
-            int canc = vlc_savecancel();
+        vlc_fifo_Unlock( p_owner->p_fifo );
 
-            vlc_fifo_Unlock( p_owner->p_fifo );
+        /* Flush the decoder (and the output) */
+        DecoderProcessFlush( p_dec );
 
-            /* Flush the decoder (and the output) */
-            DecoderProcessFlush( p_dec );
+        vlc_fifo_Lock( p_owner->p_fifo );
+        vlc_restorecancel( canc );
 
-            vlc_fifo_Lock( p_owner->p_fifo );
-            vlc_restorecancel( canc );
+        /* Reset flushing after DecoderProcess in case input_DecoderFlush
+         * is called again. This will avoid a second useless flush (but
+         * harmless). */
+        p_owner->flushing = false;
 
-            /* Reset flushing after DecoderProcess in case input_DecoderFlush
-             * is called again. This will avoid a second useless flush (but
-             * harmless). */
-            p_owner->flushing = false;
+        return true;
+    }
 
-            continue;
-        }
+    if( p_owner->output_paused != p_owner->paused )
+    {   /* Update playing/paused status of the output */
+        int canc = vlc_savecancel();
+        mtime_t date = p_owner->pause_date;
+        bool paused = p_owner->paused;
 
-        if( paused != p_owner->paused )
-        {   /* Update playing/paused status of the output */
-            int canc = vlc_savecancel();
-            mtime_t date = p_owner->pause_date;
+        p_owner->output_paused = paused;
+        vlc_fifo_Unlock( p_owner->p_fifo );
 
-            paused = p_owner->paused;
-            vlc_fifo_Unlock( p_owner->p_fifo );
+        /* NOTE: Only the audio and video outputs care about pause. */
+        msg_Dbg( p_dec, "toggling %s", paused ? "resume" : "pause" );
+        if( p_owner->p_vout != NULL )
+            vout_ChangePause( p_owner->p_vout, paused, date );
+        if( p_owner->p_aout != NULL )
+            aout_DecChangePause( p_owner->p_aout, paused, date );
 
-            /* NOTE: Only the audio and video outputs care about pause. */
-            msg_Dbg( p_dec, "toggling %s", paused ? "resume" : "pause" );
-            if( p_owner->p_vout != NULL )
-                vout_ChangePause( p_owner->p_vout, paused, date );
-            if( p_owner->p_aout != NULL )
-                aout_DecChangePause( p_owner->p_aout, paused, date );
+        vlc_restorecancel( canc );
+        vlc_fifo_Lock( p_owner->p_fifo );
+        return true;
+    }
 
-            vlc_restorecancel( canc );
-            vlc_fifo_Lock( p_owner->p_fifo );
-            continue;
-        }
+    if( p_owner->paused && p_owner->frames_countdown == 0 )
+    {   /* Wait for resumption from pause */
+        p_owner->b_idle = true;
+        vlc_cond_signal( &p_owner->wait_acknowledge );
+        return false;
+    }
+
+    vlc_cond_signal( &p_owner->wait_fifo );
 
-        if( p_owner->paused && p_owner->frames_countdown == 0 )
-        {   /* Wait for resumption from pause */
+    block_t *p_block = vlc_fifo_DequeueUnlocked( p_owner->p_fifo );
+    if( p_block == NULL )
+    {
+        if( likely(!p_owner->b_draining) )
+        {   /* Wait for a block to decode (or a request to drain) */
             p_owner->b_idle = true;
             vlc_cond_signal( &p_owner->wait_acknowledge );
-            vlc_fifo_Wait( p_owner->p_fifo );
-            p_owner->b_idle = false;
-            continue;
+            return false;
         }
+        /* We have emptied the FIFO and there is a pending request to
+         * drain. Pass p_block = NULL to decoder just once. */
+    }
+    else
+        DecoderDequeueDate( p_owner, p_block );
+
+    vlc_fifo_Unlock( p_owner->p_fifo );
+
+    int canc = vlc_savecancel();
+    DecoderProcess( p_dec, p_block );
+
+    if( p_block == NULL )
+    {   /* Draining: the decoder is drained and all decoded buffers are
+         * queued to the output at this point. Now drain the output. */
+        if( p_owner->p_aout != NULL )
+            aout_DecFlush( p_owner->p_aout, true );
+    }
+    vlc_restorecancel( canc );
 
-        vlc_cond_signal( &p_owner->wait_fifo );
+    /* TODO? Wait for draining instead of polling. */
+    vlc_mutex_lock( &p_owner->lock );
+    if( p_owner->b_draining && (p_block == NULL) )
+    {
+        p_owner->b_draining = false;
+        p_owner->drained = true;
+    }
+    vlc_fifo_Lock( p_owner->p_fifo );
+    vlc_cond_signal( &p_owner->wait_acknowledge );
+    vlc_mutex_unlock( &p_owner->lock );
+    return true;
+}
+
+static void *DecoderThread( void *p_data )
+{
+    decoder_t *p_dec = (decoder_t *)p_data;
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+
+    /* The decoder's main loop */
+    vlc_fifo_Lock( p_owner->p_fifo );
+    vlc_fifo_CleanupPush( p_owner->p_fifo );
+
+    for( ;; )
+    {
         vlc_testcancel(); /* forced expedited cancellation in case of stop */
 
-        block_t *p_block = vlc_fifo_DequeueUnlocked( p_owner->p_fifo );
-        if( p_block == NULL )
+        if( !DecoderStep( p_dec ) )
         {
-            if( likely(!p_owner->b_draining) )
-            {   /* Wait for a block to decode (or a request to drain) */
-                p_owner->b_idle = true;
-                vlc_cond_signal( &p_owner->wait_acknowledge );
-                vlc_fifo_Wait( p_owner->p_fifo );
-                p_owner->b_idle = false;
-                continue;
-            }
-            /* We have emptied the FIFO and there is a pending request to
-             * drain. Pass p_block = NULL to decoder just once. */
+            vlc_fifo_Wait( p_owner->p_fifo );
+            p_owner->b_idle = false;
         }
+    }
+    vlc_cleanup_pop();
+    vlc_assert_unreachable();
+}
 
-        vlc_fifo_Unlock( p_owner->p_fifo );
+/* Number of iterations before a task yields to the other decoders */
+#define DECODER_TASK_STEPS 8
+/* Delay after which a decoder task not yet started is deemed starved */
+#define DECODER_TASK_WAIT (CLOCK_FREQ / 2)
 
-        int canc = vlc_savecancel();
-        DecoderProcess( p_dec, p_block );
+/**
+ * Runs the decoder main loop on the shared executor, until the decoder is
+ * idle
+ */
+static void DecoderTask( void *p_data )
+{
+    decoder_t *p_dec = (decoder_t *)p_data;
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+
+    vlc_fifo_Lock( p_owner->p_fifo );
+    p_owner->b_idle = false;
+    p_owner->b_running = true;
 
-        if( p_block == NULL )
-        {   /* Draining: the decoder is drained and all decoded buffers are
-             * queued to the output at this point. Now drain the output. */
-            if( p_owner->p_aout != NULL )
-                aout_DecFlush( p_owner->p_aout, true );
+    for( unsigned i = 0; !p_owner->b_closing; i++ )
+    {
+        if( i == DECODER_TASK_STEPS )
+        {   /* Go back to the end of the queue, the task stays scheduled */
+            p_owner->b_running = false;
+            vlc_fifo_Unlock( p_owner->p_fifo );
+            if( vlc_executor_Submit( p_owner->p_executor,
+                                     &p_owner->runnable ) == VLC_SUCCESS )
+                return;
+            vlc_fifo_Lock( p_owner->p_fifo );
+            p_owner->b_running = true;
+            i = 0;
         }
-        vlc_restorecancel( canc );
 
-        /* TODO? Wait for draining instead of polling. */
-        vlc_mutex_lock( &p_owner->lock );
-        if( p_owner->b_draining && (p_block == NULL) )
+        if( !DecoderStep( p_dec ) )
+            break;
+    }
+
+    /* Signal input_DecoderDelete */
+    p_owner->b_scheduled = false;
+    p_owner->b_running = false;
+    vlc_cond_signal( &p_owner->wait_fifo );
+    vlc_fifo_Unlock( p_owner->p_fifo );
+}
+
+/**
+ * Wakes the decoder up
+ *
+ * The fifo must be locked.
+ */
+static void DecoderSignal( decoder_t *p_dec )
+{
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+
+    if( p_owner->p_executor == NULL )
+    {
+        vlc_fifo_Signal( p_owner->p_fifo );
+        return;
+    }
+
+    if( p_owner->b_scheduled || p_owner->b_closing )
+        return;
+
+    p_owner->b_scheduled = true;
+    if( vlc_executor_Submit( p_owner->p_executor, &p_owner->runnable ) )
+    {
+        msg_Err( p_dec, "cannot run decoder task" );
+        p_owner->b_scheduled = false;
+    }
+}
+
+/* Executor shared by the decoders of all the inputs */
+static vlc_mutex_t executor_lock = VLC_STATIC_MUTEX;
+static struct vlc_executor *executor;
+static unsigned executor_refs;
+static unsigned executor_threads;
+
+static struct vlc_executor *DecoderHoldExecutor( decoder_t *p_dec )
+{
+    int64_t i_threads = var_InheritInteger( p_dec, "decoder-pool-threads" );
+    if( i_threads <= 0 )
+        return NULL;
+
+    vlc_mutex_lock( &executor_lock );
+    if( executor_refs == 0 )
+    {
+        /* Decoders blocked on their outputs (or buffering) may use as many
+         * extra threads */
+        executor = vlc_executor_New( i_threads, i_threads,
+                                     VLC_THREAD_PRIORITY_VIDEO );
+        if( executor == NULL )
         {
-            p_owner->b_draining = false;
-            p_owner->drained = true;
+            vlc_mutex_unlock( &executor_lock );
+            return NULL;
         }
-        vlc_fifo_Lock( p_owner->p_fifo );
-        vlc_cond_signal( &p_owner->wait_acknowledge );
-        vlc_mutex_unlock( &p_owner->lock );
+        executor_threads = i_threads;
+        msg_Dbg( p_dec, "decoding on %"PRId64" shared threads", i_threads );
     }
-    vlc_cleanup_pop();
-    vlc_assert_unreachable();
+    else if( executor_threads != i_threads )
+        msg_Warn( p_dec, "shared decoder threads already running, "
+                  "ignoring %"PRId64" threads (using %u)", i_threads,
+                  executor_threads );
+    executor_refs++;
+    vlc_mutex_unlock( &executor_lock );
+    return executor;
+}
+
+static void DecoderReleaseExecutor( void )
+{
+    vlc_mutex_lock( &executor_lock );
+    assert( executor_refs > 0 );
+    if( --executor_refs == 0 )
+    {
+        vlc_executor_Delete( executor );
+        executor = NULL;
+    }
+    vlc_mutex_unlock( &executor_lock );
 }
 
 /**
@@ -1653,7 +2002,8 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
                                   input_thread_t *p_input,
                                   const es_format_t *fmt,
                                   input_resource_t *p_resource,
-                                  sout_instance_t *p_sout )
+                                  sout_instance_t *p_sout,
+                                  es_trace_t *p_trace )
 {
     decoder_t *p_dec;
     decoder_owner_sys_t *p_owner;
@@ -1675,17 +2025,22 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
     p_owner->p_resource = p_resource;
     p_owner->p_aout = NULL;
     p_owner->p_vout = NULL;
+    video_format_Init( &p_owner->fmt_pool, 0 );
+    video_format_Init( &p_owner->fmt_vout, 0 );
     p_owner->p_spu_vout = NULL;
     p_owner->i_spu_channel = 0;
     p_owner->i_spu_order = 0;
     p_owner->p_sout = p_sout;
     p_owner->p_sout_input = NULL;
     p_owner->p_packetizer = NULL;
+    p_owner->p_trace = p_trace;
+    p_owner->p_executor = NULL;
 
     p_owner->b_fmt_description = false;
     p_owner->p_description = NULL;
 
     p_owner->paused = false;
+    p_owner->output_paused = false;
     p_owner->pause_date = VLC_TS_INVALID;
     p_owner->frames_countdown = 0;
 
@@ -1700,6 +2055,13 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
     p_owner->drained = false;
     atomic_init( &p_owner->reload, RELOAD_NO_REQUEST );
     p_owner->b_idle = false;
+    p_owner->b_scheduled = false;
+    p_owner->b_running = false;
+    p_owner->b_closing = false;
+
+    p_owner->i_queue_date_first = 0;
+    p_owner->i_queue_dates = 0;
+    atomic_init( &p_owner->decode_date, VLC_TS_INVALID );
 
     es_format_Init( &p_owner->fmt, fmt->i_cat, 0 );
 
@@ -1820,6 +2182,9 @@ static void DeleteDecoder( decoder_t * p_dec )
     /* Free all packets still in the decoder fifo. */
     block_FifoRelease( p_owner->p_fifo );
 
+    if( p_owner->p_executor != NULL )
+        DecoderReleaseExecutor();
+
     /* Cleanup */
     if( p_owner->p_aout )
     {
@@ -1835,6 +2200,8 @@ static void DeleteDecoder( decoder_t * p_dec )
         /* Reset the cancel state that was set before joining the decoder
          * thread */
         vout_Cancel( p_owner->p_vout, false );
+        if( p_owner->p_trace )
+            vout_SetTrace( p_owner->p_vout, NULL );
 
         input_resource_RequestVout( p_owner->p_resource, p_owner->p_vout, NULL,
                                     0, true );
@@ -1903,14 +2270,15 @@ static void DecoderUnsupportedCodec( decoder_t *p_dec, const es_format_t *fmt, b
 static decoder_t *decoder_New( vlc_object_t *p_parent, input_thread_t *p_input,
                                const es_format_t *fmt, input_clock_t *p_clock,
                                input_resource_t *p_resource,
-                               sout_instance_t *p_sout  )
+                               sout_instance_t *p_sout, es_trace_t *p_trace )
 {
     decoder_t *p_dec = NULL;
     const char *psz_type = p_sout ? N_("packetizer") : N_("decoder");
     int i_priority;
 
     /* Create the decoder configuration structure */
-    p_dec = CreateDecoder( p_parent, p_input, fmt, p_resource, p_sout );
+    p_dec = CreateDecoder( p_parent, p_input, fmt, p_resource, p_sout,
+                           p_trace );
     if( p_dec == NULL )
     {
         msg_Err( p_parent, "could not create %s", psz_type );
@@ -1933,8 +2301,19 @@ static decoder_t *decoder_New( vlc_object_t *p_parent, input_thread_t *p_input,
     if( p_dec->fmt_out.i_cat == AUDIO_ES )
         i_priority = VLC_THREAD_PRIORITY_AUDIO;
     else
+    {
         i_priority = VLC_THREAD_PRIORITY_VIDEO;
 
+        /* Audio decoders keep their own thread, for its priority */
+        p_dec->p_owner->p_executor = DecoderHoldExecutor( p_dec );
+        if( p_dec->p_owner->p_executor != NULL )
+        {
+            p_dec->p_owner->runnable.pf_run = DecoderTask;
+            p_dec->p_owner->runnable.data = p_dec;
+            return p_dec;
+        }
+    }
+
     /* Spawn the decoder thread */
     if( vlc_clone( &p_dec->p_owner->thread, DecoderThread, p_dec, i_priority ) )
     {
@@ -1952,14 +2331,15 @@ static decoder_t *decoder_New( vlc_object_t *p_parent, input_thread_t *p_input,
  *
  * \param p_input the input thread
  * \param p_es the es descriptor
+ * \param p_trace the latency trace of the es (or NULL)
  * \return the spawned decoder object
  */
 decoder_t *input_DecoderNew( input_thread_t *p_input,
                              es_format_t *fmt, input_clock_t *p_clock,
-                             sout_instance_t *p_sout  )
+                             sout_instance_t *p_sout, es_trace_t *p_trace )
 {
     return decoder_New( VLC_OBJECT(p_input), p_input, fmt, p_clock,
-                        input_priv(p_input)->p_resource, p_sout );
+                        input_priv(p_input)->p_resource, p_sout, p_trace );
 }
 
 /**
@@ -1968,7 +2348,7 @@ decoder_t *input_DecoderNew( input_thread_t *p_input,
 decoder_t *input_DecoderCreate( vlc_object_t *p_parent, const es_format_t *fmt,
                                 input_resource_t *p_resource )
 {
-    return decoder_New( p_parent, NULL, fmt, NULL, p_resource, NULL );
+    return decoder_New( p_parent, NULL, fmt, NULL, p_resource, NULL, NULL );
 }
 
 
@@ -1983,11 +2363,13 @@ void input_DecoderDelete( decoder_t *p_dec )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
 
-    vlc_cancel( p_owner->thread );
+    if( p_owner->p_executor == NULL )
+        vlc_cancel( p_owner->thread );
 
     vlc_fifo_Lock( p_owner->p_fifo );
     /* Signal DecoderTimedWait */
     p_owner->flushing = true;
+    p_owner->b_closing = true;
     vlc_cond_signal( &p_owner->wait_timed );
     vlc_fifo_Unlock( p_owner->p_fifo );
 
@@ -2007,7 +2389,15 @@ void input_DecoderDelete( decoder_t *p_dec )
         vout_Cancel( p_owner->p_vout, true );
     vlc_mutex_unlock( &p_owner->lock );
 
-    vlc_join( p_owner->thread, NULL );
+    if( p_owner->p_executor != NULL )
+    {   /* Wait for the task to end */
+        vlc_fifo_Lock( p_owner->p_fifo );
+        while( p_owner->b_scheduled )
+            vlc_fifo_WaitCond( p_owner->p_fifo, &p_owner->wait_fifo );
+        vlc_fifo_Unlock( p_owner->p_fifo );
+    }
+    else
+        vlc_join( p_owner->thread, NULL );
 
     /* */
     if( p_dec->p_owner->cc.b_supported )
@@ -2042,6 +2432,7 @@ void input_DecoderDecode( decoder_t *p_dec, block_t *p_block, bool b_do_pace )
             msg_Warn( p_dec, "decoder/packetizer fifo full (data not "
                       "consumed quickly enough), resetting fifo!" );
             block_ChainRelease( vlc_fifo_DequeueAllUnlocked( p_owner->p_fifo ) );
+            p_owner->i_queue_dates = 0;
             p_block->i_flags |= BLOCK_FLAG_DISCONTINUITY;
         }
     }
@@ -2054,7 +2445,10 @@ void input_DecoderDecode( decoder_t *p_dec, block_t *p_block, bool b_do_pace )
             vlc_fifo_WaitCond( p_owner->p_fifo, &p_owner->wait_fifo );
     }
 
+    DecoderQueueDate( p_owner, p_block );
     vlc_fifo_QueueUnlocked( p_owner->p_fifo, p_block );
+    if( p_owner->p_executor != NULL )
+        DecoderSignal( p_dec );
     vlc_fifo_Unlock( p_owner->p_fifo );
 }
 
@@ -2105,7 +2499,7 @@ void input_DecoderDrain( decoder_t *p_dec )
 
     vlc_fifo_Lock( p_owner->p_fifo );
     p_owner->b_draining = true;
-    vlc_fifo_Signal( p_owner->p_fifo );
+    DecoderSignal( p_dec );
     vlc_fifo_Unlock( p_owner->p_fifo );
 }
 
@@ -2121,6 +2515,7 @@ void input_DecoderFlush( decoder_t *p_dec )
 
     /* Empty the fifo */
     block_ChainRelease( vlc_fifo_DequeueAllUnlocked( p_owner->p_fifo ) );
+    p_owner->i_queue_dates = 0;
 
     /* Don't need to wait for the DecoderThread to flush. Indeed, if called a
      * second time, this function will clear the FIFO again before anything was
@@ -2135,7 +2530,7 @@ void input_DecoderFlush( decoder_t *p_dec )
      && p_owner->frames_countdown == 0 )
         p_owner->frames_countdown++;
 
-    vlc_fifo_Signal( p_owner->p_fifo );
+    DecoderSignal( p_dec );
     vlc_cond_signal( &p_owner->wait_timed );
 
     vlc_fifo_Unlock( p_owner->p_fifo );
@@ -2192,7 +2587,7 @@ int input_DecoderSetCcState( decoder_t *p_dec, vlc_fourcc_t codec,
         fmt.subs.cc.i_channel = i_channel;
         fmt.subs.cc.i_reorder_depth = p_owner->cc.desc.i_reorder_depth;
         p_cc = input_DecoderNew( p_owner->p_input, &fmt,
-                              p_dec->p_owner->p_clock, p_owner->p_sout );
+                              p_dec->p_owner->p_clock, p_owner->p_sout, NULL );
         if( !p_cc )
         {
             msg_Err( p_dec, "could not create decoder" );
@@ -2253,7 +2648,7 @@ void input_DecoderChangePause( decoder_t *p_dec, bool b_paused, mtime_t i_date )
     p_owner->paused = b_paused;
     p_owner->pause_date = i_date;
     p_owner->frames_countdown = 0;
-    vlc_fifo_Signal( p_owner->p_fifo );
+    DecoderSignal( p_dec );
     vlc_fifo_Unlock( p_owner->p_fifo );
 }
 
@@ -2298,6 +2693,11 @@ void input_DecoderWait( decoder_t *p_dec )
 
     assert( p_owner->b_waiting );
 
+    /* A decoder task may not get a shared thread while the others are
+     * blocked, possibly waiting for the end of buffering as well */
+    mtime_t deadline = mdate() + DECODER_TASK_WAIT;
+    bool b_timeout = false;
+
     vlc_mutex_lock( &p_owner->lock );
     while( !p_owner->b_has_data )
     {
@@ -2306,14 +2706,21 @@ void input_DecoderWait( decoder_t *p_dec )
         if( p_owner->paused )
             break;
         vlc_fifo_Lock( p_owner->p_fifo );
-        if( p_owner->b_idle && vlc_fifo_IsEmpty( p_owner->p_fifo ) )
+        /* A task still queued has never run, or yielded: it is not idle
+         * yet, but it may not get a thread before the end of buffering */
+        if( ( p_owner->b_idle && vlc_fifo_IsEmpty( p_owner->p_fifo ) )
+         || ( b_timeout && !p_owner->b_running ) )
         {
             msg_Err( p_dec, "buffer deadlock prevented" );
             vlc_fifo_Unlock( p_owner->p_fifo );
             break;
         }
         vlc_fifo_Unlock( p_owner->p_fifo );
-        vlc_cond_wait( &p_owner->wait_acknowledge, &p_owner->lock );
+        if( p_owner->p_executor != NULL && !b_timeout )
+            b_timeout = vlc_cond_timedwait( &p_owner->wait_acknowledge,
+                                            &p_owner->lock, deadline ) != 0;
+        else
+            vlc_cond_wait( &p_owner->wait_acknowledge, &p_owner->lock );
     }
     vlc_mutex_unlock( &p_owner->lock );
 }
@@ -2327,7 +2734,7 @@ void input_DecoderFrameNext( decoder_t *p_dec, mtime_t *pi_duration )
 
     vlc_fifo_Lock( p_owner->p_fifo );
     p_owner->frames_countdown++;
-    vlc_fifo_Signal( p_owner->p_fifo );
+    DecoderSignal( p_dec );
     vlc_fifo_Unlock( p_owner->p_fifo );
 
     vlc_mutex_lock( &p_owner->lock );
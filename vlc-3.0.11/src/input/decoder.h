@@ -28,8 +28,10 @@
 #include <vlc_common.h>
 #include <vlc_codec.h>
 
+#include "trace.h"
+
 decoder_t *input_DecoderNew( input_thread_t *, es_format_t *, input_clock_t *,
-                             sout_instance_t * ) VLC_USED;
+                             sout_instance_t *, es_trace_t * ) VLC_USED;
 
 /**
  * This function changes the pause state.
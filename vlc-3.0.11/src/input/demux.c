@@ -29,6 +29,7 @@
 #include <limits.h>
 
 #include "demux.h"
+#include "demux_signature.h"
 #include <libvlc.h>
 #include <vlc_codec.h>
 #include <vlc_meta.h>
@@ -138,6 +139,18 @@ static const char* DemuxNameFromExtension( char const* ext,
     return result ? result->name : NULL;
 }
 
+#define DEMUX_SIGNATURE_PEEK 512
+
+static const char *DemuxNameFromSignature( stream_t *s )
+{
+    const uint8_t *p_peek;
+    ssize_t i_peek = vlc_stream_Peek( s, &p_peek, DEMUX_SIGNATURE_PEEK );
+    if( i_peek <= 0 )
+        return NULL;
+
+    return demux_NameFromSignature( p_peek, i_peek );
+}
+
 /*****************************************************************************
  * demux_New:
  *  if s is NULL then load a access_demux
@@ -155,6 +168,7 @@ typedef struct demux_priv_t
 {
     demux_t demux;
     void (*destroy)(demux_t *);
+    unsigned probes;
 } demux_priv_t;
 
 static void demux_DestroyDemux(demux_t *demux)
@@ -180,6 +194,8 @@ static int demux_Probe(void *func, va_list ap)
     int (*probe)(vlc_object_t *) = func;
     demux_t *demux = va_arg(ap, demux_t *);
 
+    ((demux_priv_t *)demux)->probes++;
+
     /* Restore input stream offset (in case previous probed demux failed to
      * to do so). */
     if (vlc_stream_Tell(demux->s) != 0 && vlc_stream_Seek(demux->s, 0))
@@ -245,12 +261,20 @@ demux_t *demux_NewAdvanced( vlc_object_t *p_obj, input_thread_t *p_parent_input,
     p_demux->info.i_title  = 0;
     p_demux->info.i_seekpoint = 0;
     priv->destroy = s ? demux_DestroyDemux : demux_DestroyAccessDemux;
+    priv->probes = 0;
 
     if( s != NULL )
     {
         const char *psz_module = NULL;
+        mtime_t i_start = mdate();
 
-        if( !strcmp( p_demux->psz_demux, "any" ) && p_demux->psz_file )
+        /* The content signature prevails over the file extension. Either
+         * way, the other modules are still probed if the hinted one fails. */
+        if( !strcmp( p_demux->psz_demux, "any" ) )
+            psz_module = DemuxNameFromSignature( s );
+
+        if( psz_module == NULL
+         && !strcmp( p_demux->psz_demux, "any" ) && p_demux->psz_file )
         {
             char const* psz_ext = strrchr( p_demux->psz_file, '.' );
 
@@ -263,6 +287,11 @@ demux_t *demux_NewAdvanced( vlc_object_t *p_obj, input_thread_t *p_parent_input,
 
         p_demux->p_module = vlc_module_load(p_demux, "demux", psz_module,
              !strcmp(psz_module, p_demux->psz_demux), demux_Probe, p_demux);
+
+        if( p_demux->p_module != NULL )
+            msg_Dbg( p_demux, "demux probed in %"PRId64" us (%u modules "
+                     "tried, hint '%s')", mdate() - i_start, priv->probes,
+                     psz_module );
     }
     else
     {
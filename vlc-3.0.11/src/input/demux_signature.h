@@ -0,0 +1,94 @@
+/*****************************************************************************
+ * demux_signature.h
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef INPUT_DEMUX_SIGNATURE_H
+#define INPUT_DEMUX_SIGNATURE_H
+
+#include <string.h>
+
+#include <vlc_common.h>
+
+typedef const struct
+{
+    unsigned short offset;
+    unsigned char length;
+    char const magic[20];
+    /* second part of the signature, if any */
+    unsigned short offset2;
+    char const magic2[5];
+    char const name[8];
+
+} demux_signature;
+
+/**
+ * Finds the demux module of a content from its first bytes.
+ *
+ * \param p_peek first bytes of the content
+ * \param i_peek number of bytes available
+ * \return the name of the demux module to probe first, or NULL if the
+ * content is not identified
+ */
+static inline const char *demux_NameFromSignature( const uint8_t *p_peek,
+                                                   size_t i_peek )
+{
+    /* NOTE: Add only formats which are identified without doubt by their
+     * first bytes, and which no other module may claim depending on the
+     * rest of the content (e.g. no RIFF WAVE, which can hold DTS handled by
+     * the es module). The formats whose module is probed early anyway are
+     * not worth listing either. */
+    static demux_signature signatures[] =
+    {
+        { 0,  4, "\x1A\x45\xDF\xA3",    0, "",     "mkv" },
+        { 0,  4, "OggS",                0, "",     "ogg" },
+        { 0,  4, "fLaC",                0, "",     "flac" },
+        { 0,  4, "caff",                0, "",     "caf" },
+        { 0,  4, "MPCK",                0, "",     "mpc" },
+        { 0,  3, "MP+",                 0, "",     "mpc" },
+        { 0,  4, "TTA1",                0, "",     "tta" },
+        { 0,  4, ".snd",                0, "",     "au" },
+        { 0,  4, "FORM",                8, "AIFF", "aiff" },
+        { 0,  4, "FORM",                8, "AIFC", "aiff" },
+        { 0,  4, "MThd",                0, "",     "smf" },
+        { 0, 19, "Creative Voice File", 0, "",     "voc" },
+        { 0,  4, "NSVf",                0, "",     "nsv" },
+        { 0,  4, "NSVs",                0, "",     "nsv" },
+    };
+
+    for( size_t i = 0; i < ARRAY_SIZE( signatures ); i++ )
+    {
+        demux_signature *sig = &signatures[i];
+        size_t length2 = strlen( sig->magic2 );
+
+        if( sig->offset + sig->length <= i_peek
+         && !memcmp( p_peek + sig->offset, sig->magic, sig->length )
+         && sig->offset2 + length2 <= i_peek
+         && !memcmp( p_peek + sig->offset2, sig->magic2, length2 ) )
+            return sig->name;
+    }
+
+    /* MPEG transport stream: three consecutive sync bytes */
+    if( i_peek > 2 * 188 && p_peek[0] == 0x47 && p_peek[188] == 0x47
+     && p_peek[2 * 188] == 0x47 )
+        return "ts";
+
+    return NULL;
+}
+
+#endif
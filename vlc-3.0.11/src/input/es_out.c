@@ -92,6 +92,9 @@ struct es_out_id_t
     decoder_t   *p_dec;
     decoder_t   *p_dec_record;
 
+    /* Latency trace (NULL if disabled) */
+    es_trace_t  *p_trace;
+
     /* Fields for Video with CC */
     struct
     {
@@ -107,6 +110,23 @@ struct es_out_id_t
     int         i_meta_id;
 };
 
+/* Data kept while in warm standby */
+typedef struct es_out_cached_t es_out_cached_t;
+struct es_out_cached_t
+{
+    es_out_cached_t *p_next;
+
+    es_out_id_t *p_es;      /* NULL for a PCR */
+    block_t     *p_block;
+
+    int         i_group;    /* PCR program */
+    mtime_t     i_pcr;      /* PCR, or last master PCR before the block */
+    mtime_t     i_date;     /* system date of the PCR */
+};
+
+/* Upper bound of the data kept in warm standby */
+#define ES_OUT_STANDBY_MAX_SIZE (64 << 20)
+
 typedef struct
 {
     int         i_count;    /* es count */
@@ -156,6 +176,7 @@ struct es_out_sys_t
     mtime_t     i_pts_jitter;
     int         i_cr_average;
     int         i_rate;
+    mtime_t     i_adaptive_min; /* adaptive delay, -1 if disabled */
 
     /* */
     bool        b_paused;
@@ -173,6 +194,18 @@ struct es_out_sys_t
     /* Record */
     sout_instance_t *p_sout_record;
 
+    /* Warm standby */
+    struct
+    {
+        bool            b_active;
+        mtime_t         i_gop;
+        es_out_cached_t *p_first;
+        es_out_cached_t **pp_last;
+        size_t          i_size;
+        mtime_t         i_first_pcr; /* of the master program */
+        mtime_t         i_last_pcr;
+    } standby;
+
     /* Used only to limit debugging output */
     int         i_prev_stream_level;
 };
@@ -195,6 +228,10 @@ static void EsUnselect( es_out_t *out, es_out_id_t *es, bool b_update );
 static void EsOutDecoderChangeDelay( es_out_t *out, es_out_id_t *p_es );
 static void EsOutDecodersChangePause( es_out_t *out, bool b_paused, mtime_t i_date );
 static void EsOutProgramChangePause( es_out_t *out, bool b_paused, mtime_t i_date );
+static void EsOutSendLocked( es_out_t *, es_out_id_t *, block_t * );
+static es_out_pgrm_t *EsOutProgramFind( es_out_t *p_out, int i_group );
+static void EsOutStandbyDrop( es_out_t *, es_out_id_t * );
+static void EsOutProgramSetPcr( es_out_t *, es_out_pgrm_t *, mtime_t i_pcr, mtime_t i_date );
 static void EsOutProgramsChangeRate( es_out_t *out );
 static void EsOutDecodersStopBuffering( es_out_t *out, bool b_forced );
 static void EsOutGlobalMeta( es_out_t *p_out, const vlc_meta_t *p_meta );
@@ -329,10 +366,22 @@ es_out_t *input_EsOutNew( input_thread_t *p_input, int i_rate )
 
     p_sys->i_rate = i_rate;
 
+    p_sys->i_adaptive_min = -1;
+    if( var_InheritBool( p_input, "network-caching-auto" ) )
+        p_sys->i_adaptive_min =
+            INT64_C(1000) * var_InheritInteger( p_input, "network-caching-min" );
+
     p_sys->b_buffering = true;
     p_sys->i_preroll_end = -1;
     p_sys->i_prev_stream_level = -1;
 
+    p_sys->standby.b_active = false;
+    p_sys->standby.i_gop = INT64_C(1000) * var_InheritInteger( p_input, "standby-gop" );
+    p_sys->standby.p_first = NULL;
+    p_sys->standby.pp_last = &p_sys->standby.p_first;
+    p_sys->standby.i_first_pcr = VLC_TS_INVALID;
+    p_sys->standby.i_last_pcr = VLC_TS_INVALID;
+
     return out;
 }
 
@@ -360,6 +409,8 @@ static void EsOutTerminate( es_out_t *out )
     if( p_sys->p_sout_record )
         EsOutSetRecord( out, false );
 
+    EsOutStandbyDrop( out, NULL );
+
     for( int i = 0; i < p_sys->i_es; i++ )
     {
         if( p_sys->es[i]->p_dec )
@@ -523,7 +574,7 @@ static int EsOutSetRecord(  es_out_t *out, bool b_record )
             if( !p_es->p_dec || p_es->p_master )
                 continue;
 
-            p_es->p_dec_record = input_DecoderNew( p_input, &p_es->fmt, p_es->p_pgrm->p_clock, p_sys->p_sout_record );
+            p_es->p_dec_record = input_DecoderNew( p_input, &p_es->fmt, p_es->p_pgrm->p_clock, p_sys->p_sout_record, NULL );
             if( p_es->p_dec_record && p_sys->b_buffering )
                 input_DecoderStartWait( p_es->p_dec_record );
         }
@@ -630,7 +681,175 @@ static void EsOutChangePosition( es_out_t *out )
     p_sys->i_prev_stream_level = -1;
 }
 
+/* Warm standby
+ *
+ * The selected ES decoders are created, but the data sent by the demuxer is
+ * kept (with the PCR and their arrival dates) instead of being decoded. For
+ * live streams, only the last few seconds are kept, so that a key frame is
+ * available. When the standby is cleared, the kept data is sent as if it had
+ * just been received, and the data older than the input caching is decoded
+ * but not displayed (preroll).
+ *
+ * Nothing is decoded during the standby itself, as the decoders would then
+ * request the video and audio outputs still used by the playing input: the
+ * switch costs a burst of decoding from the last key frame. */
+static void EsOutStandbyKeep( es_out_t *out, es_out_id_t *es, block_t *p_block,
+                              int i_group, mtime_t i_pcr )
+{
+    es_out_sys_t *p_sys = out->p_sys;
 
+    es_out_cached_t *p_cached = malloc( sizeof( *p_cached ) );
+    if( unlikely(p_cached == NULL) )
+    {
+        if( p_block )
+            block_Release( p_block );
+        return;
+    }
+    p_cached->p_next = NULL;
+    p_cached->p_es = es;
+    p_cached->p_block = p_block;
+    p_cached->i_group = i_group;
+    p_cached->i_pcr = i_pcr;
+    p_cached->i_date = mdate();
+
+    *p_sys->standby.pp_last = p_cached;
+    p_sys->standby.pp_last = &p_cached->p_next;
+    if( p_block )
+        p_sys->standby.i_size += p_block->i_buffer;
+}
+
+static void EsOutStandbyFree( es_out_t *out, es_out_cached_t *p_cached )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    if( p_cached->p_block )
+    {
+        p_sys->standby.i_size -= p_cached->p_block->i_buffer;
+        block_Release( p_cached->p_block );
+    }
+    free( p_cached );
+}
+
+/* Drops the kept data of an ES, or all of it if es is NULL */
+static void EsOutStandbyDrop( es_out_t *out, es_out_id_t *es )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+    es_out_cached_t **pp_cached = &p_sys->standby.p_first;
+
+    while( *pp_cached != NULL )
+    {
+        es_out_cached_t *p_cached = *pp_cached;
+
+        if( es != NULL && p_cached->p_es != es )
+        {
+            pp_cached = &p_cached->p_next;
+            continue;
+        }
+        *pp_cached = p_cached->p_next;
+        EsOutStandbyFree( out, p_cached );
+    }
+    p_sys->standby.pp_last = pp_cached;
+
+    if( es == NULL )
+    {
+        p_sys->standby.i_first_pcr = VLC_TS_INVALID;
+        p_sys->standby.i_last_pcr = VLC_TS_INVALID;
+    }
+}
+
+/* Drops the kept data older than needed (live streams only) */
+static void EsOutStandbyTrim( es_out_t *out )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    if( input_priv(p_sys->p_input)->b_can_pace_control )
+        return;
+
+    const mtime_t i_oldest = p_sys->standby.i_last_pcr
+                           - p_sys->i_pts_delay - p_sys->standby.i_gop;
+    while( p_sys->standby.p_first != NULL )
+    {
+        es_out_cached_t *p_cached = p_sys->standby.p_first;
+        mtime_t i_pcr = p_cached->i_pcr;
+
+        /* Data received before the first PCR */
+        if( i_pcr <= VLC_TS_INVALID )
+            i_pcr = p_sys->standby.i_first_pcr;
+
+        if( i_pcr >= i_oldest
+         && p_sys->standby.i_size <= ES_OUT_STANDBY_MAX_SIZE )
+            break;
+
+        p_sys->standby.p_first = p_cached->p_next;
+        if( p_sys->standby.p_first == NULL )
+            p_sys->standby.pp_last = &p_sys->standby.p_first;
+        EsOutStandbyFree( out, p_cached );
+    }
+}
+
+/* Tells whether the input should stop demuxing (pace controlled inputs) */
+static bool EsOutStandbyIsFull( es_out_t *out )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    if( !p_sys->standby.b_active
+     || !input_priv(p_sys->p_input)->b_can_pace_control )
+        return false;
+    if( p_sys->standby.i_size >= ES_OUT_STANDBY_MAX_SIZE )
+        return true;
+    return p_sys->standby.i_first_pcr > VLC_TS_INVALID
+        && p_sys->standby.i_last_pcr - p_sys->standby.i_first_pcr
+               >= p_sys->i_pts_delay + p_sys->standby.i_gop;
+}
+
+static void EsOutSetStandby( es_out_t *out, bool b_standby )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    if( p_sys->standby.b_active == b_standby )
+        return;
+
+    msg_Dbg( p_sys->p_input, "%s warm standby (%zu bytes kept)",
+             b_standby ? "entering" : "leaving", p_sys->standby.i_size );
+    p_sys->standby.b_active = b_standby;
+
+    /* Restart buffering in both cases */
+    EsOutChangePosition( out );
+    if( b_standby )
+        return;
+
+    /* Live streams: start the display where it would have been, had the
+     * input been playing all along */
+    const mtime_t i_last_pcr = p_sys->standby.i_last_pcr;
+    if( i_last_pcr > VLC_TS_INVALID
+     && !input_priv(p_sys->p_input)->b_can_pace_control )
+        p_sys->i_preroll_end = __MAX( i_last_pcr - p_sys->i_pts_delay, 0 );
+
+    es_out_cached_t *p_cached = p_sys->standby.p_first;
+
+    p_sys->standby.p_first = NULL;
+    p_sys->standby.pp_last = &p_sys->standby.p_first;
+    p_sys->standby.i_size = 0;
+    p_sys->standby.i_first_pcr = VLC_TS_INVALID;
+    p_sys->standby.i_last_pcr = VLC_TS_INVALID;
+
+    while( p_cached != NULL )
+    {
+        es_out_cached_t *p_next = p_cached->p_next;
+
+        if( p_cached->p_es != NULL )
+            EsOutSendLocked( out, p_cached->p_es, p_cached->p_block );
+        else
+        {
+            es_out_pgrm_t *p_pgrm = EsOutProgramFind( out, p_cached->i_group );
+            if( p_pgrm )
+                EsOutProgramSetPcr( out, p_pgrm, p_cached->i_pcr,
+                                    p_cached->i_date );
+        }
+        free( p_cached );
+        p_cached = p_next;
+    }
+}
 
 static void EsOutDecodersStopBuffering( es_out_t *out, bool b_forced )
 {
@@ -1105,6 +1324,8 @@ static es_out_pgrm_t *EsOutProgramAdd( es_out_t *out, int i_group )
     if( p_sys->b_paused )
         input_clock_ChangePause( p_pgrm->p_clock, p_sys->b_paused, p_sys->i_pause_date );
     input_clock_SetJitter( p_pgrm->p_clock, p_sys->i_pts_delay, p_sys->i_cr_average );
+    if( p_sys->i_adaptive_min >= 0 )
+        input_clock_SetAdaptive( p_pgrm->p_clock, p_sys->i_adaptive_min );
 
     /* Append it */
     TAB_APPEND( p_sys->i_pgrm, p_sys->pgrm, p_pgrm );
@@ -1639,6 +1860,10 @@ static es_out_id_t *EsOutAddSlave( es_out_t *out, const es_format_t *fmt, es_out
     es->cc.type = 0;
     es->cc.i_bitmap = 0;
     es->p_master = p_master;
+    es->p_trace = NULL;
+    if( !p_master && input_priv(p_input)->p_trace )
+        es->p_trace = input_trace_GetEs( input_priv(p_input)->p_trace,
+                                         &es->fmt );
 
     TAB_APPEND( p_sys->i_es, p_sys->es, es );
 
@@ -1687,7 +1912,8 @@ static void EsCreateDecoder( es_out_t *out, es_out_id_t *p_es )
     es_out_sys_t   *p_sys = out->p_sys;
     input_thread_t *p_input = p_sys->p_input;
 
-    p_es->p_dec = input_DecoderNew( p_input, &p_es->fmt, p_es->p_pgrm->p_clock, input_priv(p_input)->p_sout );
+    p_es->p_dec = input_DecoderNew( p_input, &p_es->fmt, p_es->p_pgrm->p_clock, input_priv(p_input)->p_sout,
+                                p_es->p_trace );
     if( p_es->p_dec )
     {
         if( p_sys->b_buffering )
@@ -1695,7 +1921,7 @@ static void EsCreateDecoder( es_out_t *out, es_out_id_t *p_es )
 
         if( !p_es->p_master && p_sys->p_sout_record )
         {
-            p_es->p_dec_record = input_DecoderNew( p_input, &p_es->fmt, p_es->p_pgrm->p_clock, p_sys->p_sout_record );
+            p_es->p_dec_record = input_DecoderNew( p_input, &p_es->fmt, p_es->p_pgrm->p_clock, p_sys->p_sout_record, NULL );
             if( p_es->p_dec_record && p_sys->b_buffering )
                 input_DecoderStartWait( p_es->p_dec_record );
         }
@@ -2052,28 +2278,38 @@ static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
 
     if( libvlc_stats( p_input ) )
     {
-        uint64_t i_total;
-
-        vlc_mutex_lock( &input_priv(p_input)->counters.counters_lock );
         stats_Update( input_priv(p_input)->counters.p_demux_read,
-                      p_block->i_buffer, &i_total );
-        stats_Update( input_priv(p_input)->counters.p_demux_bitrate, i_total, NULL );
+                      p_block->i_buffer );
 
         /* Update number of corrupted data packats */
         if( p_block->i_flags & BLOCK_FLAG_CORRUPTED )
         {
-            stats_Update( input_priv(p_input)->counters.p_demux_corrupted, 1, NULL );
+            stats_Update( input_priv(p_input)->counters.p_demux_corrupted, 1 );
         }
         /* Update number of discontinuities */
         if( p_block->i_flags & BLOCK_FLAG_DISCONTINUITY )
         {
-            stats_Update( input_priv(p_input)->counters.p_demux_discontinuity, 1, NULL );
+            stats_Update( input_priv(p_input)->counters.p_demux_discontinuity, 1 );
         }
-        vlc_mutex_unlock( &input_priv(p_input)->counters.counters_lock );
     }
 
     vlc_mutex_lock( &p_sys->lock );
 
+    if( p_sys->standby.b_active && es->p_dec )
+        EsOutStandbyKeep( out, es, p_block, 0, p_sys->standby.i_last_pcr );
+    else
+        EsOutSendLocked( out, es, p_block );
+
+    vlc_mutex_unlock( &p_sys->lock );
+
+    return VLC_SUCCESS;
+}
+
+static void EsOutSendLocked( es_out_t *out, es_out_id_t *es, block_t *p_block )
+{
+    es_out_sys_t   *p_sys = out->p_sys;
+    input_thread_t *p_input = p_sys->p_input;
+
     /* Mark preroll blocks */
     if( p_sys->i_preroll_end >= 0 )
     {
@@ -2088,8 +2324,7 @@ static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
     if( !es->p_dec )
     {
         block_Release( p_block );
-        vlc_mutex_unlock( &p_sys->lock );
-        return VLC_SUCCESS;
+        return;
     }
 
     /* Check for sout mode */
@@ -2118,6 +2353,11 @@ static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
             input_DecoderDecode( es->p_dec_record, p_dup,
                                  input_priv(p_input)->b_out_pace_control );
     }
+    if( es->p_trace )
+        es_trace_Add( es->p_trace, ES_TRACE_DEMUX,
+                      p_block->i_dts > VLC_TS_INVALID ? p_block->i_dts
+                                                      : p_block->i_pts,
+                      VLC_TS_INVALID );
     input_DecoderDecode( es->p_dec, p_block,
                          input_priv(p_input)->b_out_pace_control );
 
@@ -2141,10 +2381,6 @@ static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
                                _("DTVCC Closed captions %u"), es );
     EsOutCreateCCChannels( out, VLC_CODEC_CEA608, desc.i_608_channels,
                            _("Closed captions %u"), es );
-
-    vlc_mutex_unlock( &p_sys->lock );
-
-    return VLC_SUCCESS;
 }
 
 /*****************************************************************************
@@ -2158,6 +2394,8 @@ static void EsOutDel( es_out_t *out, es_out_id_t *es )
 
     vlc_mutex_lock( &p_sys->lock );
 
+    EsOutStandbyDrop( out, es );
+
     es_out_es_props_t *p_esprops = GetPropsByCat( p_sys, es->fmt.i_cat );
 
     /* We don't try to reselect */
@@ -2233,6 +2471,66 @@ static void EsOutDel( es_out_t *out, es_out_id_t *es )
     free( es );
 }
 
+/* Updates the clock of a program, and the buffering state */
+static void EsOutProgramSetPcr( es_out_t *out, es_out_pgrm_t *p_pgrm,
+                                mtime_t i_pcr, mtime_t i_date )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    bool b_late;
+    input_clock_Update( p_pgrm->p_clock, VLC_OBJECT(p_sys->p_input),
+                        &b_late,
+                        input_priv(p_sys->p_input)->b_can_pace_control || p_sys->b_buffering,
+                        EsOutIsExtraBufferingAllowed( out ),
+                        i_pcr, i_date );
+
+    if( !p_sys->p_pgrm )
+        return;
+
+    if( p_sys->b_buffering )
+    {
+        /* Check buffering state on master clock update */
+        EsOutDecodersStopBuffering( out, false );
+    }
+    else if( p_pgrm == p_sys->p_pgrm )
+    {
+        if( b_late && ( !input_priv(p_sys->p_input)->p_sout ||
+                        !input_priv(p_sys->p_input)->b_out_pace_control ) )
+        {
+            const mtime_t i_pts_delay_base = p_sys->i_pts_delay - p_sys->i_pts_jitter;
+            mtime_t i_pts_delay = input_clock_GetJitter( p_pgrm->p_clock );
+
+            /* Avoid dangerously high value */
+            const mtime_t i_jitter_max = INT64_C(1000) * var_InheritInteger( p_sys->p_input, "clock-jitter" );
+            if( i_pts_delay > __MIN( i_pts_delay_base + i_jitter_max, INPUT_PTS_DELAY_MAX ) )
+            {
+                msg_Err( p_sys->p_input,
+                         "ES_OUT_SET_(GROUP_)PCR  is called too late (jitter of %d ms ignored)",
+                         (int)(i_pts_delay - i_pts_delay_base) / 1000 );
+                i_pts_delay = p_sys->i_pts_delay;
+
+                /* reset clock */
+                for( int i = 0; i < p_sys->i_pgrm; i++ )
+                  input_clock_Reset( p_sys->pgrm[i]->p_clock );
+            }
+            else
+            {
+                msg_Err( p_sys->p_input,
+                         "ES_OUT_SET_(GROUP_)PCR  is called too late (pts_delay increased to %d ms)",
+                         (int)(i_pts_delay/1000) );
+
+                /* Force a rebufferization when we are too late */
+
+                /* It is not really good, as we throw away already buffered data
+                 * TODO have a mean to correctly reenter bufferization */
+                es_out_Control( out, ES_OUT_RESET_PCR );
+            }
+
+            es_out_SetJitter( out, i_pts_delay_base, i_pts_delay - i_pts_delay_base, p_sys->i_cr_average );
+        }
+    }
+}
+
 /**
  * Control query handler
  *
@@ -2492,64 +2790,28 @@ static int EsOutControlLocked( es_out_t *out, int i_query, va_list args )
             return VLC_EGENERIC;
         }
 
-        /* TODO do not use mdate() but proper stream acquisition date */
-        bool b_late;
-        input_clock_Update( p_pgrm->p_clock, VLC_OBJECT(p_sys->p_input),
-                            &b_late,
-                            input_priv(p_sys->p_input)->b_can_pace_control || p_sys->b_buffering,
-                            EsOutIsExtraBufferingAllowed( out ),
-                            i_pcr, mdate() );
-
-        if( !p_sys->p_pgrm )
-            return VLC_SUCCESS;
-
-        if( p_sys->b_buffering )
+        if( p_sys->standby.b_active )
         {
-            /* Check buffering state on master clock update */
-            EsOutDecodersStopBuffering( out, false );
-        }
-        else if( p_pgrm == p_sys->p_pgrm )
-        {
-            if( b_late && ( !input_priv(p_sys->p_input)->p_sout ||
-                            !input_priv(p_sys->p_input)->b_out_pace_control ) )
+            EsOutStandbyKeep( out, NULL, NULL, p_pgrm->i_id, i_pcr );
+            if( p_pgrm == p_sys->p_pgrm )
             {
-                const mtime_t i_pts_delay_base = p_sys->i_pts_delay - p_sys->i_pts_jitter;
-                mtime_t i_pts_delay = input_clock_GetJitter( p_pgrm->p_clock );
-
-                /* Avoid dangerously high value */
-                const mtime_t i_jitter_max = INT64_C(1000) * var_InheritInteger( p_sys->p_input, "clock-jitter" );
-                if( i_pts_delay > __MIN( i_pts_delay_base + i_jitter_max, INPUT_PTS_DELAY_MAX ) )
-                {
-                    msg_Err( p_sys->p_input,
-                             "ES_OUT_SET_(GROUP_)PCR  is called too late (jitter of %d ms ignored)",
-                             (int)(i_pts_delay - i_pts_delay_base) / 1000 );
-                    i_pts_delay = p_sys->i_pts_delay;
-
-                    /* reset clock */
-                    for( int i = 0; i < p_sys->i_pgrm; i++ )
-                      input_clock_Reset( p_sys->pgrm[i]->p_clock );
-                }
-                else
-                {
-                    msg_Err( p_sys->p_input,
-                             "ES_OUT_SET_(GROUP_)PCR  is called too late (pts_delay increased to %d ms)",
-                             (int)(i_pts_delay/1000) );
-
-                    /* Force a rebufferization when we are too late */
-
-                    /* It is not really good, as we throw away already buffered data
-                     * TODO have a mean to correctly reenter bufferization */
-                    es_out_Control( out, ES_OUT_RESET_PCR );
-                }
-
-                es_out_SetJitter( out, i_pts_delay_base, i_pts_delay - i_pts_delay_base, p_sys->i_cr_average );
+                if( p_sys->standby.i_first_pcr <= VLC_TS_INVALID )
+                    p_sys->standby.i_first_pcr = i_pcr;
+                p_sys->standby.i_last_pcr = i_pcr;
+                EsOutStandbyTrim( out );
             }
+            return VLC_SUCCESS;
         }
+
+        /* TODO do not use mdate() but proper stream acquisition date */
+        EsOutProgramSetPcr( out, p_pgrm, i_pcr, mdate() );
         return VLC_SUCCESS;
     }
 
     case ES_OUT_RESET_PCR:
         msg_Dbg( p_sys->p_input, "ES_OUT_RESET_PCR called" );
+        if( p_sys->standby.b_active )
+            EsOutStandbyDrop( out, NULL );
         EsOutChangePosition( out );
         return VLC_SUCCESS;
 
@@ -2735,6 +2997,20 @@ static int EsOutControlLocked( es_out_t *out, int i_query, va_list args )
         return VLC_SUCCESS;
     }
 
+    case ES_OUT_SET_STANDBY:
+    {
+        bool b = va_arg( args, int );
+        EsOutSetStandby( out, b );
+        return VLC_SUCCESS;
+    }
+
+    case ES_OUT_GET_STANDBY_FULL:
+    {
+        bool *pb = va_arg( args, bool* );
+        *pb = EsOutStandbyIsFull( out );
+        return VLC_SUCCESS;
+    }
+
     case ES_OUT_SET_DELAY:
     {
         const int i_cat = va_arg( args, int );
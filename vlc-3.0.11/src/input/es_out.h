@@ -88,6 +88,13 @@ enum es_out_query_private_e
 
     /* Set End Of Stream */
     ES_OUT_SET_EOS,                                 /* res=cannot fail */
+
+    /* Set warm standby: data is kept instead of being decoded, and replayed
+     * when the standby is cleared */
+    ES_OUT_SET_STANDBY,                             /* arg1=bool                res=cannot fail */
+
+    /* Get if enough data is kept in standby (the input shall stop demuxing) */
+    ES_OUT_GET_STANDBY_FULL,                        /* arg1=bool*               res=cannot fail */
 };
 
 static inline void es_out_SetMode( es_out_t *p_out, int i_mode )
@@ -173,6 +180,19 @@ static inline void es_out_Eos( es_out_t *p_out )
     int i_ret = es_out_Control( p_out, ES_OUT_SET_EOS );
     assert( !i_ret );
 }
+static inline void es_out_SetStandby( es_out_t *p_out, bool b_standby )
+{
+    int i_ret = es_out_Control( p_out, ES_OUT_SET_STANDBY, b_standby );
+    assert( !i_ret );
+}
+static inline bool es_out_GetStandbyFull( es_out_t *p_out )
+{
+    bool b;
+    int i_ret = es_out_Control( p_out, ES_OUT_GET_STANDBY_FULL, &b );
+
+    assert( !i_ret );
+    return b;
+}
 
 es_out_t  *input_EsOutNew( input_thread_t *, int i_rate );
 
@@ -725,6 +725,8 @@ static int ControlLocked( es_out_t *p_out, int i_query, va_list args )
         /* fall through */
     case ES_OUT_GET_GROUP_FORCED:
     case ES_OUT_POST_SUBNODE:
+    case ES_OUT_SET_STANDBY:
+    case ES_OUT_GET_STANDBY_FULL:
         return es_out_vaControl( p_sys->p_out, i_query, args );
 
     case ES_OUT_MODIFY_PCR_SYSTEM:
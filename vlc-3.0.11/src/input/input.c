@@ -245,6 +245,9 @@ static void input_Destructor( vlc_object_t *obj )
     if( priv->p_es_out_display )
         es_out_Delete( priv->p_es_out_display );
 
+    if( priv->p_trace )
+        input_trace_Release( priv->p_trace );
+
     if( priv->p_resource )
         input_resource_Release( priv->p_resource );
     if( priv->p_resource_private )
@@ -252,8 +255,6 @@ static void input_Destructor( vlc_object_t *obj )
 
     input_item_Release( priv->p_item );
 
-    vlc_mutex_destroy( &priv->counters.counters_lock );
-
     for( int i = 0; i < priv->i_control; i++ )
     {
         input_control_t *p_ctrl = &priv->control[i];
@@ -396,7 +397,6 @@ static input_thread_t *Create( vlc_object_t *p_parent, input_item_t *p_item,
         priv->p_resource_private = input_resource_New( VLC_OBJECT( p_input ) );
         priv->p_resource = input_resource_Hold( priv->p_resource_private );
     }
-    input_resource_SetInput( priv->p_resource, p_input );
 
     /* Init control buffer */
     vlc_mutex_init( &priv->lock_control );
@@ -470,7 +470,14 @@ static input_thread_t *Create( vlc_object_t *p_parent, input_item_t *p_item,
 
     /* */
     memset( &priv->counters, 0, sizeof( priv->counters ) );
-    vlc_mutex_init( &priv->counters.counters_lock );
+
+    priv->p_trace = NULL;
+    if( !priv->b_preparsing )
+    {
+        char *psz_trace_name = input_item_GetName( p_item );
+        priv->p_trace = input_trace_New( p_input, psz_trace_name );
+        free( psz_trace_name );
+    }
 
     priv->p_es_out_display = input_EsOutNew( p_input, priv->i_rate );
     priv->p_es_out = NULL;
@@ -713,6 +720,9 @@ static void MainLoop( input_thread_t *p_input, bool b_interactive )
         if( b_paused )
             b_paused = !es_out_GetBuffering( input_priv(p_input)->p_es_out )
                     || input_priv(p_input)->master->b_eof;
+        /* Warm standby: stop demuxing once enough data is kept */
+        if( !b_paused && input_priv(p_input)->b_standby )
+            b_paused = es_out_GetStandbyFull( input_priv(p_input)->p_es_out );
 
         if( !b_paused )
         {
@@ -838,6 +848,11 @@ static void InitStatistics( input_thread_t *p_input )
         INIT_COUNTER( decoded_audio, COUNTER );
         INIT_COUNTER( decoded_video, COUNTER );
         INIT_COUNTER( decoded_sub, COUNTER );
+        for( unsigned i = 0; i < INPUT_LATENCY_COUNT; i++ )
+        {
+            free( priv->counters.p_latency[i] );
+            priv->counters.p_latency[i] = stats_CounterCreate( STATS_HISTOGRAM );
+        }
         priv->counters.p_sout_send_bitrate = NULL;
         priv->counters.p_sout_sent_packets = NULL;
         priv->counters.p_sout_sent_bytes = NULL;
@@ -1332,6 +1347,26 @@ static int Init( input_thread_t * p_input )
         var_SetBool( p_input, "sub-autodetect-file", false );
     }
 
+    /* A warm standby input does not use the shared resource until it is
+     * switched to, as it may still belong to the playing input. Stream
+     * outputs cannot wait, so standby is refused for inputs using one. */
+    if( !priv->b_preparsing && var_GetBool( p_input, "standby" ) )
+    {
+        char *psz_sout = var_GetNonEmptyString( p_input, "sout" );
+        bool b_sout = psz_sout != NULL;
+        free( psz_sout );
+
+        priv->b_standby = true;
+        if( b_sout || priv->p_renderer != NULL )
+        {
+            msg_Err( p_input, "warm standby is not supported with a stream "
+                     "output" );
+            goto error;
+        }
+    }
+    if( !priv->b_standby )
+        input_resource_SetInput( priv->p_resource, p_input );
+
     InitStatistics( p_input );
 #ifdef ENABLE_SOUT
     if( InitSout( p_input ) )
@@ -1343,6 +1378,8 @@ static int Init( input_thread_t * p_input )
                                               priv->i_rate );
     if( priv->p_es_out == NULL )
         goto error;
+    if( priv->b_standby )
+        es_out_SetStandby( priv->p_es_out, true );
 
     /* */
     input_ChangeState( p_input, OPENING_S );
@@ -1426,7 +1463,8 @@ error:
         if( input_priv(p_input)->p_sout )
             input_resource_RequestSout( input_priv(p_input)->p_resource,
                                          input_priv(p_input)->p_sout, NULL );
-        input_resource_SetInput( input_priv(p_input)->p_resource, NULL );
+        if( !priv->b_standby )
+            input_resource_SetInput( input_priv(p_input)->p_resource, NULL );
         if( input_priv(p_input)->p_resource_private )
             input_resource_Terminate( input_priv(p_input)->p_resource_private );
     }
@@ -1450,6 +1488,9 @@ error:
         EXIT_COUNTER( decoded_audio );
         EXIT_COUNTER( decoded_video );
         EXIT_COUNTER( decoded_sub );
+        EXIT_COUNTER( latency[INPUT_LATENCY_DEMUX_DECODE] );
+        EXIT_COUNTER( latency[INPUT_LATENCY_DECODE] );
+        EXIT_COUNTER( latency[INPUT_LATENCY_DECODE_DISPLAY] );
 
         if( input_priv(p_input)->p_sout )
         {
@@ -1526,6 +1567,9 @@ do { \
             CL_CO( decoded_audio) ;
             CL_CO( decoded_video );
             CL_CO( decoded_sub) ;
+            CL_CO( latency[INPUT_LATENCY_DEMUX_DECODE] );
+            CL_CO( latency[INPUT_LATENCY_DECODE] );
+            CL_CO( latency[INPUT_LATENCY_DECODE_DISPLAY] );
         }
 
         /* Close optional stream output instance */
@@ -1558,7 +1602,8 @@ do { \
     /* */
     input_resource_RequestSout( input_priv(p_input)->p_resource,
                                  input_priv(p_input)->p_sout, NULL );
-    input_resource_SetInput( input_priv(p_input)->p_resource, NULL );
+    if( !priv->b_standby )
+        input_resource_SetInput( input_priv(p_input)->p_resource, NULL );
     if( input_priv(p_input)->p_resource_private )
         input_resource_Terminate( input_priv(p_input)->p_resource_private );
 }
@@ -2426,6 +2471,17 @@ static bool Control( input_thread_t *p_input,
             ControlNav( p_input, i_type );
             break;
 
+        case INPUT_CONTROL_SET_STANDBY:
+            /* Only leaving the standby is supported: the outputs of a
+             * playing input cannot be given back to the resource */
+            if( val.b_bool || !input_priv(p_input)->b_standby )
+                break;
+            input_priv(p_input)->b_standby = false;
+            input_resource_SetInput( input_priv(p_input)->p_resource, p_input );
+            es_out_SetStandby( input_priv(p_input)->p_es_out, false );
+            b_force_update = true;
+            break;
+
         default:
             msg_Err( p_input, "not yet implemented" );
             break;
@@ -3486,10 +3542,9 @@ void input_UpdateStatistic( input_thread_t *p_input,
 {
     assert( input_priv(p_input)->i_state != INIT_S );
 
-    vlc_mutex_lock( &input_priv(p_input)->counters.counters_lock);
     switch( i_type )
     {
-#define I(c) stats_Update( input_priv(p_input)->counters.c, i_delta, NULL )
+#define I(c) stats_Update( input_priv(p_input)->counters.c, i_delta )
     case INPUT_STATISTIC_DECODED_VIDEO:
         I(p_decoded_video);
         break;
@@ -3502,20 +3557,14 @@ void input_UpdateStatistic( input_thread_t *p_input,
     case INPUT_STATISTIC_SENT_PACKET:
         I(p_sout_sent_packets);
         break;
-#undef I
     case INPUT_STATISTIC_SENT_BYTE:
-    {
-        uint64_t bytes;
-
-        stats_Update( input_priv(p_input)->counters.p_sout_sent_bytes, i_delta, &bytes );
-        stats_Update( input_priv(p_input)->counters.p_sout_send_bitrate, bytes, NULL );
+        I(p_sout_sent_bytes);
         break;
-    }
+#undef I
     default:
         msg_Err( p_input, "Invalid statistic type %d (internal error)", i_type );
         break;
     }
-    vlc_mutex_unlock( &input_priv(p_input)->counters.counters_lock);
 }
 
 /**/
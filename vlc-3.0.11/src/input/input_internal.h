@@ -33,6 +33,7 @@
 #include <libvlc.h>
 #include "input_interface.h"
 #include "misc/interrupt.h"
+#include "trace.h"
 
 /*****************************************************************************
  *  Private input fields
@@ -97,6 +98,7 @@ typedef struct input_thread_private_t
     bool        is_running;
     bool        is_stopped;
     bool        b_recording;
+    bool        b_standby; /* warm standby: not decoding nor using the resource */
     int         i_rate;
 
     /* Playtime configuration and state */
@@ -146,7 +148,7 @@ typedef struct input_thread_private_t
     input_resource_t *p_resource;
     input_resource_t *p_resource_private;
 
-    /* Stats counters */
+    /* Stats counters (lock-free, see stats_Update) */
     struct {
         counter_t *p_read_packets;
         counter_t *p_read_bytes;
@@ -165,9 +167,12 @@ typedef struct input_thread_private_t
         counter_t *p_lost_abuffers;
         counter_t *p_displayed_pictures;
         counter_t *p_lost_pictures;
-        vlc_mutex_t counters_lock;
+        counter_t *p_latency[INPUT_LATENCY_COUNT];
     } counters;
 
+    /* Latency trace (NULL if disabled) */
+    input_trace_t *p_trace;
+
     /* Buffer of pending actions */
     vlc_mutex_t lock_control;
     vlc_cond_t  wait_control;
@@ -233,6 +238,8 @@ enum input_control_e
     INPUT_CONTROL_SET_FRAME_NEXT,
 
     INPUT_CONTROL_SET_RENDERER,
+
+    INPUT_CONTROL_SET_STANDBY,
 };
 
 /* Internal helpers */
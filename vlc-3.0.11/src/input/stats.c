@@ -28,16 +28,58 @@
 #include <vlc_common.h>
 #include "input/input_internal.h"
 
+#include <assert.h>
+
+/* Size of a cache line, so that threads do not update the same one */
+#define STATS_CACHE_LINE 64
+
+static atomic_uint stats_next_shard = ATOMIC_VAR_INIT(0);
+static thread_local unsigned stats_shard = STATS_SHARDS;
+
+/**
+ * Get the counter shard of the calling thread
+ *
+ * Threads are assigned shards in turn the first time they update a counter.
+ */
+static unsigned stats_GetShard( void )
+{
+    if( unlikely(stats_shard >= STATS_SHARDS) )
+        stats_shard = atomic_fetch_add_explicit( &stats_next_shard, 1,
+                                            memory_order_relaxed ) % STATS_SHARDS;
+    return stats_shard;
+}
+
 /**
  * Create a statistics counter
- * \param i_compute_type the aggregation type. One of STATS_LAST (always
- * keep the last value), STATS_COUNTER (increment by the passed value),
- * STATS_MAX (keep the maximum passed value), STATS_MIN, or STATS_DERIVATIVE
- * (keep a time derivative of the value)
+ * \param i_compute_type the aggregation type. One of STATS_COUNTER (increment
+ * by the passed value), STATS_DERIVATIVE (keep a time derivative of the
+ * value, see stats_ComputeInputStats) or STATS_HISTOGRAM (count the passed
+ * values by power of two)
  */
 counter_t * stats_CounterCreate( int i_compute_type )
 {
-    counter_t *p_counter = (counter_t*) malloc( sizeof( counter_t ) ) ;
+    unsigned i_values;
+
+    switch( i_compute_type )
+    {
+        case STATS_COUNTER:
+            i_values = 1;
+            break;
+        case STATS_HISTOGRAM:
+            i_values = STATS_BUCKETS;
+            break;
+        default:
+            i_values = 0;
+            break;
+    }
+
+    /* Round each shard up to a whole number of cache lines */
+    size_t i_stride = ( i_values * sizeof( atomic_uint_fast64_t )
+                        + STATS_CACHE_LINE - 1 ) / STATS_CACHE_LINE
+                      * STATS_CACHE_LINE / sizeof( atomic_uint_fast64_t );
+
+    counter_t *p_counter = malloc( sizeof( counter_t ) + STATS_SHARDS
+                                   * i_stride * sizeof( atomic_uint_fast64_t ) );
 
     if( !p_counter ) return NULL;
     p_counter->i_compute_type = i_compute_type;
@@ -46,14 +88,37 @@ counter_t * stats_CounterCreate( int i_compute_type )
 
     p_counter->last_update = 0;
 
+    p_counter->i_stride = i_stride;
+    for( size_t i = 0; i < STATS_SHARDS * i_stride; i++ )
+        atomic_init( &p_counter->values[i], 0 );
+
     return p_counter;
 }
 
+static uint64_t stats_GetValue(const counter_t *counter, unsigned index)
+{
+    uint64_t value = 0;
+
+    for (unsigned i = 0; i < STATS_SHARDS; i++)
+        value += atomic_load_explicit(&counter->values[i * counter->i_stride
+                                                       + index],
+                                      memory_order_relaxed);
+    return value;
+}
+
 static inline int64_t stats_GetTotal(const counter_t *counter)
 {
-    if (counter == NULL || counter->i_samples == 0)
+    if (counter == NULL)
         return 0;
-    return counter->pp_samples[0]->value;
+    assert(counter->i_compute_type == STATS_COUNTER);
+    return stats_GetValue(counter, 0);
+}
+
+static void stats_GetHistogram(const counter_t *counter,
+                               uint64_t buckets[STATS_BUCKETS])
+{
+    for (unsigned i = 0; i < STATS_BUCKETS; i++)
+        buckets[i] = counter ? stats_GetValue(counter, i) : 0;
 }
 
 static inline float stats_GetRate(const counter_t *counter)
@@ -65,6 +130,41 @@ static inline float stats_GetRate(const counter_t *counter)
         / (float)(counter->pp_samples[0]->date - counter->pp_samples[1]->date);
 }
 
+/**
+ * Sample a total for a derivative counter
+ *
+ * Unlike stats_Update(), this is not thread-safe: derivative counters are
+ * only sampled when the statistics are computed.
+ */
+static void stats_Sample( counter_t *p_counter, uint64_t val )
+{
+    counter_sample_t *p_new, *p_old;
+    mtime_t now = mdate();
+
+    if( !p_counter )
+        return;
+    assert( p_counter->i_compute_type == STATS_DERIVATIVE );
+
+    if( now - p_counter->last_update < CLOCK_FREQ )
+        return;
+    p_counter->last_update = now;
+    /* Insert the new one at the beginning */
+    p_new = (counter_sample_t*)malloc( sizeof( counter_sample_t ) );
+    if (unlikely(p_new == NULL))
+        return; /* NOTE: Losing sample here */
+
+    p_new->value = val;
+    p_new->date = p_counter->last_update;
+    TAB_INSERT(p_counter->i_samples, p_counter->pp_samples, p_new, 0);
+
+    if( p_counter->i_samples == 3 )
+    {
+        p_old = p_counter->pp_samples[2];
+        TAB_ERASE(p_counter->i_samples, p_counter->pp_samples, 2);
+        free( p_old );
+    }
+}
+
 input_stats_t *stats_NewInputStats( input_thread_t *p_input )
 {
     (void)p_input;
@@ -78,6 +178,12 @@ input_stats_t *stats_NewInputStats( input_thread_t *p_input )
     return p_stats;
 }
 
+/**
+ * Aggregate the counters of an input into its statistics
+ *
+ * This must be called from the input thread only, as it also samples the
+ * totals for the bitrates.
+ */
 void stats_ComputeInputStats(input_thread_t *input, input_stats_t *st)
 {
     input_thread_private_t *priv = input_priv(input);
@@ -85,14 +191,21 @@ void stats_ComputeInputStats(input_thread_t *input, input_stats_t *st)
     if (!libvlc_stats(input))
         return;
 
-    vlc_mutex_lock(&priv->counters.counters_lock);
+    int64_t read_bytes = stats_GetTotal(priv->counters.p_read_bytes);
+    int64_t demux_read = stats_GetTotal(priv->counters.p_demux_read);
+    int64_t sent_bytes = stats_GetTotal(priv->counters.p_sout_sent_bytes);
+
+    stats_Sample(priv->counters.p_input_bitrate, read_bytes);
+    stats_Sample(priv->counters.p_demux_bitrate, demux_read);
+    stats_Sample(priv->counters.p_sout_send_bitrate, sent_bytes);
+
     vlc_mutex_lock(&st->lock);
 
     /* Input */
     st->i_read_packets = stats_GetTotal(priv->counters.p_read_packets);
-    st->i_read_bytes = stats_GetTotal(priv->counters.p_read_bytes);
+    st->i_read_bytes = read_bytes;
     st->f_input_bitrate = stats_GetRate(priv->counters.p_input_bitrate);
-    st->i_demux_read_bytes = stats_GetTotal(priv->counters.p_demux_read);
+    st->i_demux_read_bytes = demux_read;
     st->f_demux_bitrate = stats_GetRate(priv->counters.p_demux_bitrate);
     st->i_demux_corrupted = stats_GetTotal(priv->counters.p_demux_corrupted);
     st->i_demux_discontinuity = stats_GetTotal(priv->counters.p_demux_discontinuity);
@@ -105,7 +218,7 @@ void stats_ComputeInputStats(input_thread_t *input, input_stats_t *st)
     if (priv->counters.p_sout_send_bitrate)
     {
         st->i_sent_packets = stats_GetTotal(priv->counters.p_sout_sent_packets);
-        st->i_sent_bytes = stats_GetTotal(priv->counters.p_sout_sent_bytes);
+        st->i_sent_bytes = sent_bytes;
         st->f_send_bitrate = stats_GetRate(priv->counters.p_sout_send_bitrate);
     }
 
@@ -117,8 +230,11 @@ void stats_ComputeInputStats(input_thread_t *input, input_stats_t *st)
     st->i_displayed_pictures = stats_GetTotal(priv->counters.p_displayed_pictures);
     st->i_lost_pictures = stats_GetTotal(priv->counters.p_lost_pictures);
 
+    /* Latencies */
+    for (unsigned i = 0; i < INPUT_LATENCY_COUNT; i++)
+        stats_GetHistogram(priv->counters.p_latency[i], st->latency[i]);
+
     vlc_mutex_unlock(&st->lock);
-    vlc_mutex_unlock(&priv->counters.counters_lock);
 }
 
 void stats_ReinitInputStats( input_stats_t *p_stats )
@@ -134,6 +250,7 @@ void stats_ReinitInputStats( input_stats_t *p_stats )
     p_stats->i_decoded_video = p_stats->i_decoded_audio =
     p_stats->i_sent_bytes = p_stats->i_sent_packets = p_stats->f_send_bitrate
      = 0;
+    memset( p_stats->latency, 0, sizeof( p_stats->latency ) );
     vlc_mutex_unlock( &p_stats->lock );
 }
 
@@ -149,61 +266,39 @@ void stats_CounterClean( counter_t *p_c )
 }
 
 
-/** Update a counter element with new values
+/** Update a counter element with a new value
+ *
+ * This is lock-free and can be called from any thread.
  * \param p_counter the counter to update
- * \param val the vlc_value union containing the new value to aggregate. For
- * more information on how data is aggregated, \see stats_Create
- * \param val_new a pointer that will be filled with new data
+ * \param val the value to add (STATS_COUNTER) or count (STATS_HISTOGRAM)
  */
-void stats_Update( counter_t *p_counter, uint64_t val, uint64_t *new_val )
+void stats_Update( counter_t *p_counter, uint64_t val )
 {
     if( !p_counter )
         return;
 
+    atomic_uint_fast64_t *p_values =
+        &p_counter->values[stats_GetShard() * p_counter->i_stride];
+
     switch( p_counter->i_compute_type )
     {
-    case STATS_DERIVATIVE:
-    {
-        counter_sample_t *p_new, *p_old;
-        mtime_t now = mdate();
-        if( now - p_counter->last_update < CLOCK_FREQ )
-            return;
-        p_counter->last_update = now;
-        /* Insert the new one at the beginning */
-        p_new = (counter_sample_t*)malloc( sizeof( counter_sample_t ) );
-        if (unlikely(p_new == NULL))
-            return; /* NOTE: Losing sample here */
-
-        p_new->value = val;
-        p_new->date = p_counter->last_update;
-        TAB_INSERT(p_counter->i_samples, p_counter->pp_samples, p_new, 0);
-
-        if( p_counter->i_samples == 3 )
-        {
-            p_old = p_counter->pp_samples[2];
-            TAB_ERASE(p_counter->i_samples, p_counter->pp_samples, 2);
-            free( p_old );
-        }
-        break;
-    }
     case STATS_COUNTER:
-        if( p_counter->i_samples == 0 )
-        {
-            counter_sample_t *p_new = (counter_sample_t*)malloc(
-                                               sizeof( counter_sample_t ) );
-            if (unlikely(p_new == NULL))
-                return; /* NOTE: Losing sample here */
-
-            p_new->value = 0;
+        atomic_fetch_add_explicit( p_values, val, memory_order_relaxed );
+        break;
+    case STATS_HISTOGRAM:
+    {
+        unsigned i_bucket = 0;
 
-            TAB_APPEND(p_counter->i_samples, p_counter->pp_samples, p_new);
-        }
-        if( p_counter->i_samples == 1 )
+        while( val > 1 && i_bucket < STATS_BUCKETS - 1 )
         {
-            p_counter->pp_samples[0]->value += val;
-            if( new_val )
-                *new_val = p_counter->pp_samples[0]->value;
+            val >>= 1;
+            i_bucket++;
         }
+        atomic_fetch_add_explicit( &p_values[i_bucket], 1,
+                                   memory_order_relaxed );
         break;
     }
+    default:
+        vlc_assert_unreachable();
+    }
 }
@@ -495,6 +495,19 @@ ssize_t vlc_stream_Peek(stream_t *s, const uint8_t **restrict bufp, size_t len)
         priv->block = NULL;
     }
 
+    if (peek == NULL && s->pf_block != NULL && !vlc_killed())
+    {   /* Peek into the next block as is: there is no copy if it is large
+         * enough, as memory-mapped blocks usually are */
+        bool eof = false;
+
+        peek = s->pf_block(s, &eof);
+        if (peek != NULL && peek->i_buffer == 0)
+        {
+            block_Release(peek);
+            peek = NULL;
+        }
+    }
+
     if (peek == NULL)
     {
         peek = block_Alloc(len);
@@ -0,0 +1,379 @@
+/*****************************************************************************
+ * trace.c: elementary streams latency tracing
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <errno.h>
+
+#include <vlc_common.h>
+#include <vlc_atomic.h>
+#include <vlc_fs.h>
+
+#include "trace.h"
+
+/* Events kept per elementary stream (the oldest ones are overwritten) */
+#define ES_TRACE_EVENTS 65536
+/* How far the matching events of a block or a frame are looked up */
+#define ES_TRACE_MATCH_WINDOW 4096
+
+typedef struct
+{
+    mtime_t date;    /* when the event happened */
+    mtime_t ts;      /* block or frame timestamp */
+    mtime_t display; /* frame display date */
+    int     type;
+} es_trace_event_t;
+
+struct es_trace_t
+{
+    input_trace_t *owner;
+    int            i_id;
+    int            i_cat;
+    char           psz_name[32];
+
+    atomic_size_t    i_next;
+    es_trace_event_t events[ES_TRACE_EVENTS];
+};
+
+struct input_trace_t
+{
+    atomic_uint    refs;
+    vlc_object_t  *p_libvlc; /* outlives the input, for logging */
+    char          *psz_path;
+    char          *psz_name;
+    mtime_t        i_start;
+
+    vlc_mutex_t    lock;
+    int            i_es;
+    es_trace_t   **pp_es;
+};
+
+#undef input_trace_New
+input_trace_t *input_trace_New( vlc_object_t *p_obj, const char *psz_name )
+{
+    char *psz_path = var_InheritString( p_obj, "es-trace-file" );
+    if( psz_path == NULL )
+        return NULL;
+
+    input_trace_t *p_trace = malloc( sizeof( *p_trace ) );
+    if( unlikely(p_trace == NULL) )
+    {
+        free( psz_path );
+        return NULL;
+    }
+
+    atomic_init( &p_trace->refs, 1 );
+    p_trace->p_libvlc = VLC_OBJECT(p_obj->obj.libvlc);
+    p_trace->psz_path = psz_path;
+    p_trace->psz_name = strdup( psz_name ? psz_name : "" );
+    p_trace->i_start = mdate();
+    vlc_mutex_init( &p_trace->lock );
+    TAB_INIT( p_trace->i_es, p_trace->pp_es );
+
+    msg_Dbg( p_obj, "tracing elementary streams to %s", psz_path );
+    return p_trace;
+}
+
+es_trace_t *input_trace_GetEs( input_trace_t *p_trace, const es_format_t *p_fmt )
+{
+    es_trace_t *p_es = NULL;
+
+    vlc_mutex_lock( &p_trace->lock );
+    for( int i = 0; i < p_trace->i_es; i++ )
+    {
+        if( p_trace->pp_es[i]->i_id == p_fmt->i_id )
+        {
+            p_es = p_trace->pp_es[i];
+            goto out;
+        }
+    }
+
+    p_es = malloc( sizeof( *p_es ) );
+    if( unlikely(p_es == NULL) )
+        goto out;
+
+    static const char *const ppsz_cat[] = {
+        [UNKNOWN_ES] = "data",
+        [VIDEO_ES] = "video",
+        [AUDIO_ES] = "audio",
+        [SPU_ES] = "spu",
+        [DATA_ES] = "data",
+    };
+    const char *psz_cat = ( (unsigned)p_fmt->i_cat < ARRAY_SIZE(ppsz_cat) )
+                          ? ppsz_cat[p_fmt->i_cat] : "data";
+
+    p_es->owner = p_trace;
+    p_es->i_id = p_fmt->i_id;
+    p_es->i_cat = p_fmt->i_cat;
+    snprintf( p_es->psz_name, sizeof( p_es->psz_name ), "%s %d (%4.4s)",
+              psz_cat, p_fmt->i_id, (const char *)&p_fmt->i_codec );
+    atomic_init( &p_es->i_next, 0 );
+    TAB_APPEND( p_trace->i_es, p_trace->pp_es, p_es );
+out:
+    vlc_mutex_unlock( &p_trace->lock );
+    return p_es;
+}
+
+void es_trace_Add( es_trace_t *p_es, enum es_trace_event_e type,
+                   mtime_t i_ts, mtime_t i_date )
+{
+    size_t i = atomic_fetch_add_explicit( &p_es->i_next, 1,
+                                          memory_order_relaxed );
+    es_trace_event_t *p_event = &p_es->events[i % ES_TRACE_EVENTS];
+
+    p_event->date = mdate();
+    p_event->ts = i_ts;
+    p_event->display = i_date;
+    p_event->type = type;
+}
+
+/*****************************************************************************
+ * Chrome trace JSON writer
+ *****************************************************************************/
+typedef struct
+{
+    FILE    *p_file;
+    mtime_t  i_origin;
+    unsigned i_id;
+} trace_writer_t;
+
+static void TraceWriteString( FILE *p_file, const char *psz )
+{
+    fputc( '"', p_file );
+    for( ; *psz; psz++ )
+    {
+        unsigned char c = *psz;
+
+        if( c == '"' || c == '\\' )
+            fprintf( p_file, "\\%c", c );
+        else if( c < 0x20 )
+            fprintf( p_file, "\\u%04x", c );
+        else
+            fputc( c, p_file );
+    }
+    fputc( '"', p_file );
+}
+
+/* Writes an asynchronous slice: slices of the same name may overlap */
+static void TraceWriteSlice( trace_writer_t *p_writer, const es_trace_t *p_es,
+                             const char *psz_stage, mtime_t i_begin,
+                             mtime_t i_end, mtime_t i_ts )
+{
+    FILE *p_file = p_writer->p_file;
+    unsigned i_id = p_writer->i_id++;
+    char psz_name[48];
+
+    snprintf( psz_name, sizeof( psz_name ), "%s %s", p_es->psz_name,
+              psz_stage );
+
+    fputs( ",\n{\"name\":", p_file );
+    TraceWriteString( p_file, psz_name );
+    fprintf( p_file, ",\"cat\":\"es\",\"ph\":\"b\",\"id\":%u,\"pid\":1,"
+             "\"tid\":%d,\"ts\":%"PRId64",\"args\":{\"ts\":%"PRId64"}}",
+             i_id, p_es->i_id, i_begin - p_writer->i_origin, i_ts );
+    fputs( ",\n{\"name\":", p_file );
+    TraceWriteString( p_file, psz_name );
+    fprintf( p_file, ",\"cat\":\"es\",\"ph\":\"e\",\"id\":%u,\"pid\":1,"
+             "\"tid\":%d,\"ts\":%"PRId64"}",
+             i_id, p_es->i_id, i_end - p_writer->i_origin );
+}
+
+static void TraceWriteEs( trace_writer_t *p_writer, const es_trace_t *p_es )
+{
+    size_t i_next = atomic_load( &p_es->i_next );
+    size_t i_first = i_next > ES_TRACE_EVENTS ? i_next - ES_TRACE_EVENTS : 0;
+    size_t i_count = i_next - i_first;
+
+    /* Sort the events by type, in the order they were recorded */
+    const es_trace_event_t **pp_events = vlc_alloc( i_count,
+                                                    sizeof( *pp_events ) );
+    if( unlikely(pp_events == NULL) )
+        return;
+
+    const es_trace_event_t **pp_demux, **pp_decode, **pp_output, **pp_display;
+    size_t i_demux = 0, i_decode = 0, i_output = 0, i_display = 0;
+
+    for( size_t i = i_first; i < i_next; i++ )
+    {
+        switch( p_es->events[i % ES_TRACE_EVENTS].type )
+        {
+            case ES_TRACE_DEMUX:   i_demux++;   break;
+            case ES_TRACE_DECODE:  i_decode++;  break;
+            case ES_TRACE_OUTPUT:  i_output++;  break;
+            case ES_TRACE_DISPLAY: i_display++; break;
+        }
+    }
+    pp_demux = pp_events;
+    pp_decode = pp_demux + i_demux;
+    pp_output = pp_decode + i_decode;
+    pp_display = pp_output + i_output;
+    i_demux = i_decode = i_output = i_display = 0;
+
+    for( size_t i = i_first; i < i_next; i++ )
+    {
+        const es_trace_event_t *p_event = &p_es->events[i % ES_TRACE_EVENTS];
+
+        switch( p_event->type )
+        {
+            case ES_TRACE_DEMUX:   pp_demux[i_demux++] = p_event;     break;
+            case ES_TRACE_DECODE:  pp_decode[i_decode++] = p_event;   break;
+            case ES_TRACE_OUTPUT:  pp_output[i_output++] = p_event;   break;
+            case ES_TRACE_DISPLAY: pp_display[i_display++] = p_event; break;
+        }
+    }
+
+    /* Queueing: from the demuxer to the decoder, for the same block. Blocks
+     * are decoded in order, but some of them are flushed. */
+    for( size_t i = 0, i_cur = 0; i < i_decode; i++ )
+    {
+        size_t i_end = __MIN( i_cur + ES_TRACE_MATCH_WINDOW, i_demux );
+
+        for( size_t j = i_cur; j < i_end; j++ )
+        {
+            if( pp_demux[j]->ts == pp_decode[i]->ts )
+            {
+                TraceWriteSlice( p_writer, p_es, "queue", pp_demux[j]->date,
+                                 pp_decode[i]->date, pp_decode[i]->ts );
+                i_cur = j + 1;
+                break;
+            }
+        }
+    }
+
+    /* Decoding: from the last block taken by the decoder to the frame.
+     * Frames are reordered, so they cannot be matched with their block. */
+    for( size_t i = 0, i_cur = 0; i < i_output && i_decode > 0; i++ )
+    {
+        while( i_cur + 1 < i_decode
+            && pp_decode[i_cur + 1]->date <= pp_output[i]->date )
+            i_cur++;
+        if( pp_decode[i_cur]->date <= pp_output[i]->date )
+            TraceWriteSlice( p_writer, p_es, "decode", pp_decode[i_cur]->date,
+                             pp_output[i]->date, pp_output[i]->ts );
+    }
+
+    /* Output: from the decoder to the display. Only the video output traces
+     * the pictures it displays: other frames end at their play date. */
+    if( p_es->i_cat == VIDEO_ES )
+    {
+        for( size_t i = 0, i_cur = 0; i < i_display; i++ )
+        {
+            size_t i_end = __MIN( i_cur + ES_TRACE_MATCH_WINDOW, i_output );
+
+            for( size_t j = i_cur; j < i_end; j++ )
+            {
+                if( pp_output[j]->display == pp_display[i]->display )
+                {
+                    TraceWriteSlice( p_writer, p_es, "output",
+                                     pp_output[j]->date, pp_display[i]->date,
+                                     pp_output[j]->ts );
+                    i_cur = j + 1;
+                    break;
+                }
+            }
+        }
+    }
+    else
+    {
+        for( size_t i = 0; i < i_output; i++ )
+            if( pp_output[i]->display > VLC_TS_INVALID )
+                TraceWriteSlice( p_writer, p_es, "output", pp_output[i]->date,
+                                 __MAX( pp_output[i]->display,
+                                        pp_output[i]->date ),
+                                 pp_output[i]->ts );
+    }
+
+    free( pp_events );
+}
+
+static void TraceWrite( input_trace_t *p_trace )
+{
+    FILE *p_file = vlc_fopen( p_trace->psz_path, "w" );
+    if( p_file == NULL )
+    {
+        msg_Err( p_trace->p_libvlc, "cannot write trace file %s: %s",
+                 p_trace->psz_path, vlc_strerror_c( errno ) );
+        return;
+    }
+
+    trace_writer_t writer = {
+        .p_file = p_file,
+        .i_origin = p_trace->i_start,
+        .i_id = 0,
+    };
+
+    fputs( "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+           "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+           "\"args\":{\"name\":", p_file );
+    TraceWriteString( p_file, p_trace->psz_name );
+    fputs( "}}", p_file );
+
+    for( int i = 0; i < p_trace->i_es; i++ )
+        TraceWriteEs( &writer, p_trace->pp_es[i] );
+
+    fputs( "\n]}\n", p_file );
+
+    bool b_error = ferror( p_file );
+    if( fclose( p_file ) )
+        b_error = true;
+
+    if( b_error )
+        msg_Err( p_trace->p_libvlc, "cannot write trace file %s",
+                 p_trace->psz_path );
+    else
+        msg_Dbg( p_trace->p_libvlc, "wrote %u trace slices to %s",
+                 writer.i_id, p_trace->psz_path );
+}
+
+static input_trace_t *input_trace_Hold( input_trace_t *p_trace )
+{
+    atomic_fetch_add( &p_trace->refs, 1 );
+    return p_trace;
+}
+
+void input_trace_Release( input_trace_t *p_trace )
+{
+    if( atomic_fetch_sub( &p_trace->refs, 1 ) != 1 )
+        return;
+
+    TraceWrite( p_trace );
+
+    for( int i = 0; i < p_trace->i_es; i++ )
+        free( p_trace->pp_es[i] );
+    TAB_CLEAN( p_trace->i_es, p_trace->pp_es );
+    vlc_mutex_destroy( &p_trace->lock );
+    free( p_trace->psz_name );
+    free( p_trace->psz_path );
+    free( p_trace );
+}
+
+es_trace_t *es_trace_Hold( es_trace_t *p_es )
+{
+    input_trace_Hold( p_es->owner );
+    return p_es;
+}
+
+void es_trace_Release( es_trace_t *p_es )
+{
+    input_trace_Release( p_es->owner );
+}
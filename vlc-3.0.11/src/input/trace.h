@@ -0,0 +1,99 @@
+/*****************************************************************************
+ * trace.h: elementary streams latency tracing
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_INPUT_TRACE_H
+#define LIBVLC_INPUT_TRACE_H 1
+
+#include <vlc_common.h>
+#include <vlc_es.h>
+
+/**
+ * Input trace
+ *
+ * The input trace records when the blocks and frames of each elementary
+ * stream of an input go through the demuxer, the decoder and the output, in
+ * one ring buffer per elementary stream. The trace is written as a Chrome
+ * trace JSON file (readable by Perfetto or chrome://tracing) once it is
+ * released by all its users.
+ *
+ * Tracing is enabled with the "es-trace-file" option. When it is disabled,
+ * input_trace_New() returns NULL and there is nothing to record.
+ */
+typedef struct input_trace_t input_trace_t;
+
+/**
+ * Elementary stream trace
+ *
+ * es_trace_Add() can be called from any thread, without locking.
+ */
+typedef struct es_trace_t es_trace_t;
+
+enum es_trace_event_e
+{
+    ES_TRACE_DEMUX,   /**< Block sent to the decoder */
+    ES_TRACE_DECODE,  /**< Block taken by the decoder */
+    ES_TRACE_OUTPUT,  /**< Frame queued to the output */
+    ES_TRACE_DISPLAY, /**< Picture displayed */
+};
+
+/**
+ * Creates the trace of an input
+ *
+ * \param psz_name name of the input, for the trace file
+ * \return the trace, or NULL if tracing is disabled or on error
+ */
+input_trace_t *input_trace_New( vlc_object_t *, const char *psz_name );
+#define input_trace_New(a, b) input_trace_New(VLC_OBJECT(a), b)
+
+/**
+ * Releases the trace of an input
+ *
+ * The trace is written when its last user releases it.
+ */
+void input_trace_Release( input_trace_t * );
+
+/**
+ * Gets the trace of an elementary stream
+ *
+ * The trace is created on first use, and belongs to the input trace.
+ */
+es_trace_t *input_trace_GetEs( input_trace_t *, const es_format_t * );
+
+/**
+ * Holds the input trace an elementary stream trace belongs to
+ */
+es_trace_t *es_trace_Hold( es_trace_t * );
+
+/**
+ * Releases the input trace an elementary stream trace belongs to
+ */
+void es_trace_Release( es_trace_t * );
+
+/**
+ * Records an event
+ *
+ * \param i_ts timestamp of the block or frame (stream time)
+ * \param i_date display date of the frame (system time), for
+ * ES_TRACE_OUTPUT and ES_TRACE_DISPLAY
+ */
+void es_trace_Add( es_trace_t *, enum es_trace_event_e,
+                   mtime_t i_ts, mtime_t i_date );
+
+#endif
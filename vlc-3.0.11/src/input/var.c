@@ -75,6 +75,9 @@ static int RecordCallback( vlc_object_t *p_this, char const *psz_cmd,
 static int FrameNextCallback( vlc_object_t *p_this, char const *psz_cmd,
                               vlc_value_t oldval, vlc_value_t newval,
                               void *p_data );
+static int StandbyCallback( vlc_object_t *p_this, char const *psz_cmd,
+                            vlc_value_t oldval, vlc_value_t newval,
+                            void *p_data );
 
 typedef struct
 {
@@ -108,6 +111,7 @@ static const vlc_input_callback_t p_input_callbacks[] =
     CALLBACK( "spu-es", EsSpuCallback ),
     CALLBACK( "record", RecordCallback ),
     CALLBACK( "frame-next", FrameNextCallback ),
+    CALLBACK( "standby", StandbyCallback ),
 
     CALLBACK( NULL, NULL )
 };
@@ -140,6 +144,9 @@ void input_ControlVarInit ( input_thread_t *p_input )
 
     var_Create( p_input, "frame-next", VLC_VAR_VOID );
 
+    /* Warm standby (set before starting the input, cleared to switch to it) */
+    var_Create( p_input, "standby", VLC_VAR_BOOL );
+
     /* Position */
     var_Create( p_input, "position",  VLC_VAR_FLOAT );
 
@@ -850,3 +857,15 @@ static int FrameNextCallback( vlc_object_t *p_this, char const *psz_cmd,
     return VLC_SUCCESS;
 }
 
+static int StandbyCallback( vlc_object_t *p_this, char const *psz_cmd,
+                            vlc_value_t oldval, vlc_value_t newval,
+                            void *p_data )
+{
+    input_thread_t *p_input = (input_thread_t*)p_this;
+    VLC_UNUSED(psz_cmd); VLC_UNUSED(oldval); VLC_UNUSED(p_data);
+
+    input_ControlPush( p_input, INPUT_CONTROL_SET_STANDBY, &newval );
+
+    return VLC_SUCCESS;
+}
+
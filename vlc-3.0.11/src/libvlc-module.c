@@ -514,6 +514,18 @@ static const char *const ppsz_pos_descriptions[] =
 #define NETWORK_CACHING_LONGTEXT N_( \
     "Caching value for network resources, in milliseconds." )
 
+#define NETWORK_CACHING_AUTO_TEXT N_("Adaptive network caching")
+#define NETWORK_CACHING_AUTO_LONGTEXT N_( \
+    "Measure the arrival jitter of real-time streams, and lower the " \
+    "caching down to what it requires (the network caching value is then " \
+    "the highest caching). The caching is raised again as soon as data " \
+    "arrives late." )
+
+#define NETWORK_CACHING_MIN_TEXT N_("Minimum adaptive network caching (ms)")
+#define NETWORK_CACHING_MIN_LONGTEXT N_( \
+    "Lowest caching value for real-time streams with adaptive network " \
+    "caching, in milliseconds." )
+
 #define CR_AVERAGE_TEXT N_("Clock reference average counter")
 #define CR_AVERAGE_LONGTEXT N_( \
     "When using the PVR input (or a very irregular source), you should " \
@@ -530,6 +542,13 @@ static const char *const ppsz_pos_descriptions[] =
     "This defines the maximum input delay jitter that the synchronization " \
     "algorithms should try to compensate (in milliseconds)." )
 
+#define STANDBY_GOP_TEXT N_("Warm standby cache")
+#define STANDBY_GOP_LONGTEXT N_( \
+    "Duration of the stream kept by inputs opened in warm standby, on top " \
+    "of the input caching, so that a key frame is available when they are " \
+    "switched to (in milliseconds). It should be at least as long as the " \
+    "interval between key frames of the streams." )
+
 #define NETSYNC_TEXT N_("Network synchronisation" )
 #define NETSYNC_LONGTEXT N_( "This allows you to remotely " \
         "synchronise clocks for server and client. The detailed settings " \
@@ -821,6 +840,11 @@ static const char *const ppsz_prefres[] = {
     "However allocation of port numbers below 1025 is usually restricted " \
     "by the operating system." )
 
+#define HTTP_THREADS_TEXT N_( "HTTP server threads" )
+#define HTTP_THREADS_LONGTEXT N_( \
+    "Number of threads serving the clients of each HTTP, HTTPS or RTSP " \
+    "server. 0 means one per CPU, up to 4." )
+
 #define HTTPS_PORT_TEXT N_( "HTTPS server port" )
 #define HTTPS_PORT_LONGTEXT N_( \
     "The HTTPS server will listen on this TCP port. " \
@@ -917,6 +941,15 @@ static const char *const ppsz_prefres[] = {
     "This allows you to select a list of encoders that VLC will use in " \
     "priority.")
 
+#define DECODER_POOL_TEXT N_("Shared decoder threads")
+#define DECODER_POOL_LONGTEXT N_( \
+    "Number of threads shared by the video and subtitle decoders of all " \
+    "the inputs, instead of one thread per decoder. This saves threads " \
+    "when playing many streams at once. 0 disables the shared threads. " \
+    "The threads are shared by all the instances in the process: the " \
+    "value used by the first decoder applies until all the decoders " \
+    "using them are closed.")
+
 /*****************************************************************************
  * Sout
  ****************************************************************************/
@@ -1063,6 +1096,13 @@ static const char *const ppsz_prefres[] = {
 #define STATS_LONGTEXT N_( \
      "Collect miscellaneous local statistics about the playing media.")
 
+#define ES_TRACE_TEXT N_("Latency trace file")
+#define ES_TRACE_LONGTEXT N_( \
+     "Record the time each block and frame of the elementary streams goes " \
+     "through the demuxer, the decoder and the output, and write it to " \
+     "this file (in the Chrome trace JSON format) when the input ends. " \
+     "Each input overwrites the file. Leave empty to disable tracing.")
+
 #define DAEMON_TEXT N_("Run as daemon process")
 #define DAEMON_LONGTEXT N_( \
      "Runs VLC as a background daemon process.")
@@ -1123,6 +1163,15 @@ static const char *const ppsz_prefres[] = {
 #define PREPARSE_TIMEOUT_LONGTEXT N_( \
     "Maximum time allowed to preparse an item, in milliseconds" )
 
+#define PREPARSE_THREADS_TEXT N_( "Preparsing threads" )
+#define PREPARSE_THREADS_LONGTEXT N_( \
+    "Maximum number of items preparsed at the same time" )
+
+#define PREPARSE_CACHE_SIZE_TEXT N_( "Preparsing cache size (kiB)" )
+#define PREPARSE_CACHE_SIZE_LONGTEXT N_( \
+    "The results of the preparsing of local files are kept in the user " \
+    "cache directory, up to this size. Set to 0 to disable the cache." )
+
 #define METADATA_NETWORK_TEXT N_( "Allow metadata network access" )
 
 static const char *const psz_recursive_list[] = {
@@ -1800,6 +1849,8 @@ vlc_module_begin ()
         change_integer_range( 1, 65535 )
     add_integer( "https-port", 8443, HTTPS_PORT_TEXT, HTTPS_PORT_LONGTEXT, true )
         change_integer_range( 1, 65535 )
+    add_integer( "http-threads", 0, HTTP_THREADS_TEXT, HTTP_THREADS_LONGTEXT, true )
+        change_integer_range( 0, 16 )
     add_string( "rtsp-host", NULL, RTSP_HOST_TEXT, RTSP_HOST_LONGTEXT, true )
     add_integer( "rtsp-port", 554, RTSP_PORT_TEXT, RTSP_PORT_LONGTEXT, true )
         change_integer_range( 1, 65535 )
@@ -1895,6 +1946,13 @@ vlc_module_begin ()
                  NETWORK_CACHING_TEXT, NETWORK_CACHING_LONGTEXT, true )
         change_integer_range( 0, 60000 )
         change_safe()
+    add_bool( "network-caching-auto", false, NETWORK_CACHING_AUTO_TEXT,
+              NETWORK_CACHING_AUTO_LONGTEXT, true )
+        change_safe()
+    add_integer( "network-caching-min", 100, NETWORK_CACHING_MIN_TEXT,
+                 NETWORK_CACHING_MIN_LONGTEXT, true )
+        change_integer_range( 0, 60000 )
+        change_safe()
     add_obsolete_integer( "ftp-caching" ) /* 2.0.0 */
     add_obsolete_integer( "http-caching" ) /* 2.0.0 */
     add_obsolete_integer( "mms-caching" ) /* 2.0.0 */
@@ -1914,6 +1972,9 @@ vlc_module_begin ()
     add_integer( "clock-jitter", 5 * CLOCK_FREQ/1000, CLOCK_JITTER_TEXT,
               CLOCK_JITTER_LONGTEXT, true )
         change_safe()
+    add_integer( "standby-gop", 2000, STANDBY_GOP_TEXT,
+                 STANDBY_GOP_LONGTEXT, true )
+        change_integer_range( 0, 60000 )
 
     add_bool( "network-synchronisation", false, NETSYNC_TEXT,
               NETSYNC_LONGTEXT, true )
@@ -1939,6 +2000,8 @@ vlc_module_begin ()
                 CODEC_LONGTEXT, true )
     add_string( "encoder",  NULL, ENCODER_TEXT,
                 ENCODER_LONGTEXT, true )
+    add_integer_with_range( "decoder-pool-threads", 0, 0, 256,
+                            DECODER_POOL_TEXT, DECODER_POOL_LONGTEXT, true )
 
     set_subcategory( SUBCAT_INPUT_ACCESS )
     add_category_hint( N_("Input"), INPUT_CAT_LONGTEXT , false )
@@ -2112,6 +2175,13 @@ vlc_module_begin ()
     add_integer( "preparse-timeout", 5000, PREPARSE_TIMEOUT_TEXT,
                  PREPARSE_TIMEOUT_LONGTEXT, false )
 
+    add_integer_with_range( "preparse-threads", 1, 1, 32,
+                            PREPARSE_THREADS_TEXT, PREPARSE_THREADS_LONGTEXT,
+                            true )
+
+    add_integer( "preparse-cache-size", 16384, PREPARSE_CACHE_SIZE_TEXT,
+                 PREPARSE_CACHE_SIZE_LONGTEXT, true )
+
     add_obsolete_integer( "album-art" )
     add_bool( "metadata-network-access", false, METADATA_NETWORK_TEXT,
                  METADATA_NETWORK_TEXT, false )
@@ -2161,6 +2231,8 @@ vlc_module_begin ()
               INTERACTION_LONGTEXT, false )
 
     add_bool ( "stats", true, STATS_TEXT, STATS_LONGTEXT, true )
+    add_savefile( "es-trace-file", NULL, ES_TRACE_TEXT, ES_TRACE_LONGTEXT,
+                  true )
 
     set_subcategory( SUBCAT_INTERFACE_MAIN )
     add_module_cat( "intf", SUBCAT_INTERFACE_MAIN, NULL, INTF_TEXT,
@@ -504,7 +504,8 @@ int vlc_MetadataRequest(libvlc_int_t *libvlc, input_item_t *item,
         item->b_preparse_interact = true;
         vlc_mutex_unlock( &item->lock );
     }
-    playlist_preparser_Push( priv->parser, item, i_options, timeout, id );
+    playlist_preparser_Push( priv->parser, item, i_options, timeout, id,
+                             false );
     return VLC_SUCCESS;
 
 }
@@ -529,7 +530,10 @@ int libvlc_MetadataRequest(libvlc_int_t *libvlc, input_item_t *item,
     if( i_options & META_REQUEST_OPTION_DO_INTERACT )
         item->b_preparse_interact = true;
     vlc_mutex_unlock( &item->lock );
-    playlist_preparser_Push( priv->parser, item, i_options, timeout, id );
+    /* Explicit requests are usually for items being shown: serve them before
+     * the background preparsing of the playlist */
+    playlist_preparser_Push( priv->parser, item, i_options, timeout, id,
+                             true );
     return VLC_SUCCESS;
 }
 
@@ -25,6 +25,7 @@
 #ifndef LIBVLC_LIBVLC_H
 # define LIBVLC_LIBVLC_H 1
 
+#include <vlc_atomic.h>
 #include <vlc_input_item.h>
 
 extern const char psz_vlc_changeset[];
@@ -223,8 +224,15 @@ enum
 {
     STATS_COUNTER,
     STATS_DERIVATIVE,
+    STATS_HISTOGRAM,
 };
 
+/* Counters are updated from any thread without locking: each thread adds to
+ * one of several shards, and the shards are summed up when read. */
+#define STATS_SHARDS 8
+/* Histogram bucket n counts the values in [2^n, 2^(n+1)[ */
+#define STATS_BUCKETS INPUT_STATS_LATENCY_BUCKETS
+
 typedef struct counter_sample_t
 {
     uint64_t value;
@@ -234,10 +242,16 @@ typedef struct counter_sample_t
 typedef struct counter_t
 {
     int                 i_compute_type;
+
+    /* Derivative counters are only sampled by the reading thread */
     int                 i_samples;
     counter_sample_t ** pp_samples;
 
     mtime_t             last_update;
+
+    /* Values, one shard after the other (i_stride values per shard) */
+    unsigned            i_stride;
+    atomic_uint_fast64_t values[];
 } counter_t;
 
 enum
@@ -264,7 +278,7 @@ enum
 };
 
 counter_t * stats_CounterCreate (int);
-void stats_Update (counter_t *, uint64_t, uint64_t *);
+void stats_Update (counter_t *, uint64_t);
 void stats_CounterClean (counter_t * );
 
 void stats_ComputeInputStats(input_thread_t*, input_stats_t*);
@@ -25,7 +25,6 @@
 #include <vlc_threads.h>
 #include <vlc_arrays.h>
 
-#include "libvlc.h"
 #include "background_worker.h"
 
 struct bg_queued_item {
@@ -34,88 +33,93 @@ struct bg_queued_item {
     int timeout; /**< timeout duration in microseconds */
 };
 
+struct bg_thread {
+    struct background_worker* worker;
+    vlc_thread_t handle;
+    struct bg_thread* next; /**< next ended thread, not joined yet */
+    vlc_cond_t wait; /**< wait for probe request or cancelation */
+    struct bg_queued_item* item; /**< the current task, NULL if idle */
+    mtime_t deadline; /**< deadline of the current task */
+    bool probe_request; /**< true if a probe is requested */
+    bool cancel; /**< true if the current task shall be stopped */
+};
+
 struct background_worker {
     void* owner;
     struct background_worker_config conf;
 
     vlc_mutex_t lock; /**< acquire to inspect members that follow */
     struct {
-        bool probe_request; /**< true if a probe is requested */
-        vlc_cond_t wait; /**< wait for update in terms of head */
-        vlc_cond_t worker_wait; /**< wait for probe request or cancelation */
-        mtime_t deadline; /**< deadline of the current task */
-        void* id; /**< id of the current task */
-        bool active; /**< true if there is an active thread */
+        vlc_cond_t wait; /**< wait for a task to complete or a thread to end */
+        vlc_array_t threads; /**< threads, running a task or idle */
+        size_t idle; /**< number of threads waiting for an entity */
+        struct bg_thread* ended; /**< threads that ended, to be joined */
+        bool closing; /**< true if the threads shall terminate */
     } head;
 
     struct {
         vlc_cond_t wait; /**< wait for update in terms of tail */
         vlc_array_t data; /**< queue of pending entities to process */
+        size_t urgent; /**< number of urgent entities at the front */
     } tail;
 };
 
-static void* Thread( void* data )
+static struct bg_queued_item* TakeItem( struct background_worker* worker )
 {
-    struct background_worker* worker = data;
+    /* Wait 1 seconds for new inputs before terminating */
+    mtime_t deadline = mdate() + INT64_C(1000000);
 
-    for( ;; )
+    while( !worker->head.closing && vlc_array_count( &worker->tail.data ) == 0 )
     {
-        struct bg_queued_item* item = NULL;
-        void* handle;
+        worker->head.idle++;
+        int ret = vlc_cond_timedwait( &worker->tail.wait, &worker->lock,
+                                      deadline );
+        worker->head.idle--;
+        if( ret != 0 )
+            break;
+    }
 
-        vlc_mutex_lock( &worker->lock );
-        for( ;; )
-        {
-            if( vlc_array_count( &worker->tail.data ) )
-            {
-                item = vlc_array_item_at_index( &worker->tail.data, 0 );
-                handle = NULL;
+    if( worker->head.closing || vlc_array_count( &worker->tail.data ) == 0 )
+        return NULL;
 
-                vlc_array_remove( &worker->tail.data, 0 );
-            }
+    struct bg_queued_item* item =
+        vlc_array_item_at_index( &worker->tail.data, 0 );
+    vlc_array_remove( &worker->tail.data, 0 );
+    if( worker->tail.urgent > 0 )
+        worker->tail.urgent--;
+    return item;
+}
 
-            if( worker->head.deadline == VLC_TS_0 && item == NULL )
-                worker->head.active = false;
-            worker->head.id = item ? item->id : NULL;
-            vlc_cond_broadcast( &worker->head.wait );
+static void* Thread( void* data )
+{
+    struct bg_thread* thread = data;
+    struct background_worker* worker = thread->worker;
 
-            if( item )
-            {
-                if( item->timeout > 0 )
-                    worker->head.deadline = mdate() + item->timeout * 1000;
-                else
-                    worker->head.deadline = INT64_MAX;
-            }
-            else if( worker->head.deadline != VLC_TS_0 )
-            {
-                /* Wait 1 seconds for new inputs before terminating */
-                mtime_t deadline = mdate() + INT64_C(1000000);
-                int ret = vlc_cond_timedwait( &worker->tail.wait,
-                                              &worker->lock, deadline );
-                if( ret != 0 )
-                {
-                    /* Timeout: if there is still no items, the thread will be
-                     * terminated at next loop iteration (active = false). */
-                    worker->head.deadline = VLC_TS_0;
-                }
-                continue;
-            }
-            break;
-        }
+    vlc_mutex_lock( &worker->lock );
+    for( ;; )
+    {
+        struct bg_queued_item* item = TakeItem( worker );
+        void* handle;
 
-        if( !worker->head.active )
-        {
-            vlc_mutex_unlock( &worker->lock );
+        if( item == NULL )
             break;
-        }
-        vlc_mutex_unlock( &worker->lock );
 
-        assert( item != NULL );
+        thread->item = item;
+        thread->cancel = false;
+        thread->probe_request = false;
+        if( item->timeout > 0 )
+            thread->deadline = mdate() + item->timeout * 1000;
+        else
+            thread->deadline = INT64_MAX;
+        vlc_mutex_unlock( &worker->lock );
 
         if( worker->conf.pf_start( worker->owner, item->entity, &handle ) )
         {
             worker->conf.pf_release( item->entity );
             free( item );
+            vlc_mutex_lock( &worker->lock );
+            thread->item = NULL;
+            vlc_cond_broadcast( &worker->head.wait );
             continue;
         }
 
@@ -123,34 +127,99 @@ static void* Thread( void* data )
         {
             vlc_mutex_lock( &worker->lock );
 
-            bool const b_timeout = worker->head.deadline <= mdate();
-            worker->head.probe_request = false;
+            bool const b_stop = thread->cancel || thread->deadline <= mdate();
+            thread->probe_request = false;
 
             vlc_mutex_unlock( &worker->lock );
 
-            if( b_timeout ||
-                worker->conf.pf_probe( worker->owner, handle ) )
-            {
-                worker->conf.pf_stop( worker->owner, handle );
-                worker->conf.pf_release( item->entity );
-                free( item );
+            if( b_stop || worker->conf.pf_probe( worker->owner, handle ) )
                 break;
-            }
 
             vlc_mutex_lock( &worker->lock );
-            if( worker->head.probe_request == false &&
-                worker->head.deadline > mdate() )
+            if( thread->probe_request == false && thread->cancel == false &&
+                thread->deadline > mdate() )
             {
-                vlc_cond_timedwait( &worker->head.worker_wait, &worker->lock,
-                                     worker->head.deadline );
+                vlc_cond_timedwait( &thread->wait, &worker->lock,
+                                     thread->deadline );
             }
             vlc_mutex_unlock( &worker->lock );
         }
+
+        worker->conf.pf_stop( worker->owner, handle );
+        worker->conf.pf_release( item->entity );
+        free( item );
+
+        vlc_mutex_lock( &worker->lock );
+        thread->item = NULL;
+        vlc_cond_broadcast( &worker->head.wait );
     }
 
+    vlc_array_remove( &worker->head.threads,
+        vlc_array_index_of_item( &worker->head.threads, thread ) );
+    thread->next = worker->head.ended;
+    worker->head.ended = thread;
+    vlc_cond_broadcast( &worker->head.wait );
+    vlc_mutex_unlock( &worker->lock );
     return NULL;
 }
 
+static void JoinThreads( struct bg_thread* thread )
+{
+    while( thread != NULL )
+    {
+        struct bg_thread* next = thread->next;
+
+        vlc_join( thread->handle, NULL );
+        vlc_cond_destroy( &thread->wait );
+        free( thread );
+        thread = next;
+    }
+}
+
+/* The lock must be held */
+static int SpawnThread( struct background_worker* worker )
+{
+    struct bg_thread* thread = malloc( sizeof( *thread ) );
+
+    if( unlikely( !thread ) )
+        return VLC_ENOMEM;
+
+    thread->worker = worker;
+    thread->item = NULL;
+    vlc_cond_init( &thread->wait );
+
+    if( vlc_array_append( &worker->head.threads, thread ) )
+        goto error;
+
+    if( vlc_clone( &thread->handle, Thread, thread,
+                   VLC_THREAD_PRIORITY_LOW ) )
+    {
+        vlc_array_remove( &worker->head.threads,
+            vlc_array_count( &worker->head.threads ) - 1 );
+        goto error;
+    }
+    return VLC_SUCCESS;
+
+error:
+    vlc_cond_destroy( &thread->wait );
+    free( thread );
+    return VLC_EGENERIC;
+}
+
+/* The lock must be held */
+static bool IsRunning( struct background_worker* worker, void* id )
+{
+    for( size_t i = 0; i < vlc_array_count( &worker->head.threads ); ++i )
+    {
+        struct bg_thread* thread =
+            vlc_array_item_at_index( &worker->head.threads, i );
+
+        if( thread->item != NULL && ( id == NULL || thread->item->id == id ) )
+            return true;
+    }
+    return false;
+}
+
 static void BackgroundWorkerCancel( struct background_worker* worker, void* id)
 {
     vlc_mutex_lock( &worker->lock );
@@ -162,6 +231,8 @@ static void BackgroundWorkerCancel( struct background_worker* worker, void* id)
         if( id == NULL || item->id == id )
         {
             vlc_array_remove( &worker->tail.data, i );
+            if( i < worker->tail.urgent )
+                worker->tail.urgent--;
             worker->conf.pf_release( item->entity );
             free( item );
             continue;
@@ -170,14 +241,20 @@ static void BackgroundWorkerCancel( struct background_worker* worker, void* id)
         ++i;
     }
 
-    while( ( id == NULL && worker->head.active )
-        || ( id != NULL && worker->head.id == id ) )
+    for( size_t i = 0; i < vlc_array_count( &worker->head.threads ); ++i )
     {
-        worker->head.deadline = VLC_TS_0;
-        vlc_cond_signal( &worker->head.worker_wait );
-        vlc_cond_signal( &worker->tail.wait );
-        vlc_cond_wait( &worker->head.wait, &worker->lock );
+        struct bg_thread* thread =
+            vlc_array_item_at_index( &worker->head.threads, i );
+
+        if( thread->item != NULL && ( id == NULL || thread->item->id == id ) )
+        {
+            thread->cancel = true;
+            vlc_cond_signal( &thread->wait );
+        }
     }
+
+    while( IsRunning( worker, id ) )
+        vlc_cond_wait( &worker->head.wait, &worker->lock );
     vlc_mutex_unlock( &worker->lock );
 }
 
@@ -190,14 +267,17 @@ struct background_worker* background_worker_New( void* owner,
         return NULL;
 
     worker->conf = *conf;
+    if( worker->conf.max_threads < 1 )
+        worker->conf.max_threads = 1;
     worker->owner = owner;
-    worker->head.id = NULL;
-    worker->head.active = false;
-    worker->head.deadline = VLC_TS_INVALID;
+    worker->head.idle = 0;
+    worker->head.ended = NULL;
+    worker->head.closing = false;
+    worker->tail.urgent = 0;
 
     vlc_mutex_init( &worker->lock );
     vlc_cond_init( &worker->head.wait );
-    vlc_cond_init( &worker->head.worker_wait );
+    vlc_array_init( &worker->head.threads );
 
     vlc_array_init( &worker->tail.data );
     vlc_cond_init( &worker->tail.wait );
@@ -205,8 +285,8 @@ struct background_worker* background_worker_New( void* owner,
     return worker;
 }
 
-int background_worker_Push( struct background_worker* worker, void* entity,
-                        void* id, int timeout )
+static int BackgroundWorkerPush( struct background_worker* worker,
+    void* entity, void* id, int timeout, bool urgent )
 {
     struct bg_queued_item* item = malloc( sizeof( *item ) );
 
@@ -218,28 +298,57 @@ int background_worker_Push( struct background_worker* worker, void* entity,
     item->timeout = timeout < 0 ? worker->conf.default_timeout : timeout;
 
     vlc_mutex_lock( &worker->lock );
-    int i_ret = vlc_array_append( &worker->tail.data, item );
-    vlc_cond_signal( &worker->tail.wait );
-    if( i_ret != 0 )
+    /* Urgent entities go after the other urgent ones, before the others */
+    size_t index = urgent ? worker->tail.urgent
+                          : vlc_array_count( &worker->tail.data );
+    if( vlc_array_insert( &worker->tail.data, item, index ) )
     {
+        vlc_mutex_unlock( &worker->lock );
         free( item );
         return VLC_EGENERIC;
     }
+    if( urgent )
+        worker->tail.urgent++;
+
+    /* Start another thread if the idle ones cannot take all the entities */
+    size_t threads = vlc_array_count( &worker->head.threads );
+    if( vlc_array_count( &worker->tail.data ) > worker->head.idle
+     && threads < (size_t)worker->conf.max_threads
+     && SpawnThread( worker ) == VLC_SUCCESS )
+        threads++;
+    vlc_cond_signal( &worker->tail.wait );
 
-    if( worker->head.active == false )
+    if( threads == 0 )
     {
-        worker->head.probe_request = false;
-        worker->head.active =
-            !vlc_clone_detach( NULL, Thread, worker, VLC_THREAD_PRIORITY_LOW );
+        vlc_array_remove( &worker->tail.data, index );
+        if( urgent )
+            worker->tail.urgent--;
+        vlc_mutex_unlock( &worker->lock );
+        free( item );
+        return VLC_EGENERIC;
     }
 
-    if( worker->head.active )
-        worker->conf.pf_hold( item->entity );
+    worker->conf.pf_hold( item->entity );
 
-    int ret = worker->head.active ? VLC_SUCCESS : VLC_EGENERIC;
+    /* Reap the threads that ended since, for want of entities */
+    struct bg_thread* ended = worker->head.ended;
+    worker->head.ended = NULL;
     vlc_mutex_unlock( &worker->lock );
 
-    return ret;
+    JoinThreads( ended );
+    return VLC_SUCCESS;
+}
+
+int background_worker_Push( struct background_worker* worker, void* entity,
+                        void* id, int timeout )
+{
+    return BackgroundWorkerPush( worker, entity, id, timeout, false );
+}
+
+int background_worker_PushUrgent( struct background_worker* worker,
+                                  void* entity, void* id, int timeout )
+{
+    return BackgroundWorkerPush( worker, entity, id, timeout, true );
 }
 
 void background_worker_Cancel( struct background_worker* worker, void* id )
@@ -250,18 +359,38 @@ void background_worker_Cancel( struct background_worker* worker, void* id )
 void background_worker_RequestProbe( struct background_worker* worker )
 {
     vlc_mutex_lock( &worker->lock );
-    worker->head.probe_request = true;
-    vlc_cond_signal( &worker->head.worker_wait );
+    for( size_t i = 0; i < vlc_array_count( &worker->head.threads ); ++i )
+    {
+        struct bg_thread* thread =
+            vlc_array_item_at_index( &worker->head.threads, i );
+
+        thread->probe_request = true;
+        vlc_cond_signal( &thread->wait );
+    }
     vlc_mutex_unlock( &worker->lock );
 }
 
 void background_worker_Delete( struct background_worker* worker )
 {
+    vlc_mutex_lock( &worker->lock );
+    worker->head.closing = true;
+    vlc_cond_broadcast( &worker->tail.wait );
+    vlc_mutex_unlock( &worker->lock );
+
     BackgroundWorkerCancel( worker, NULL );
+
+    /* Wait for the idle threads to terminate */
+    vlc_mutex_lock( &worker->lock );
+    while( vlc_array_count( &worker->head.threads ) > 0 )
+        vlc_cond_wait( &worker->head.wait, &worker->lock );
+    vlc_mutex_unlock( &worker->lock );
+
+    JoinThreads( worker->head.ended );
+
+    vlc_array_clear( &worker->head.threads );
     vlc_array_clear( &worker->tail.data );
     vlc_mutex_destroy( &worker->lock );
     vlc_cond_destroy( &worker->head.wait );
-    vlc_cond_destroy( &worker->head.worker_wait );
     vlc_cond_destroy( &worker->tail.wait );
     free( worker );
 }
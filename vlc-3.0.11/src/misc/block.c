@@ -32,6 +32,7 @@
 #include <fcntl.h>
 
 #include <vlc_common.h>
+#include <vlc_atomic.h>
 #include <vlc_block.h>
 #include <vlc_fs.h>
 
@@ -145,6 +146,135 @@ block_t *block_Alloc (size_t size)
     return b;
 }
 
+typedef struct
+{
+    atomic_uint refs;
+    block_t    *payload;
+} block_payload_t;
+
+typedef struct
+{
+    block_t          self;
+    block_payload_t *payload;
+} block_shared_t;
+
+static void block_shared_Release (block_t *block)
+{
+    block_shared_t *sh = container_of (block, block_shared_t, self);
+    block_payload_t *payload = sh->payload;
+
+    block_Invalidate (block);
+    free (sh);
+
+    if (atomic_fetch_sub_explicit (&payload->refs, 1,
+                                   memory_order_acq_rel) == 1)
+    {
+        block_Release (payload->payload);
+        free (payload);
+    }
+}
+
+static block_t *block_shared_New (block_payload_t *payload)
+{
+    block_shared_t *sh = malloc (sizeof (*sh));
+    if (unlikely(sh == NULL))
+        return NULL;
+
+    /* No head or tail room: the surroundings of the payload are shared too */
+    block_t *block = payload->payload;
+    block_Init (&sh->self, block->p_buffer, block->i_buffer);
+    block_CopyProperties (&sh->self, block);
+    sh->self.pf_release = block_shared_Release;
+    sh->payload = payload;
+    return &sh->self;
+}
+
+/**
+ * Whether the payload of a block may also be read through other blocks,
+ * in which case it must be copied before being written to.
+ */
+static bool block_IsShared (const block_t *block)
+{
+    if (block->pf_release != block_shared_Release)
+        return false;
+
+    const block_shared_t *sh = container_of (block, block_shared_t, self);
+    return atomic_load_explicit (&sh->payload->refs,
+                                 memory_order_acquire) > 1;
+}
+
+block_t *block_shared_Alloc (block_t *block)
+{
+    block_Check (block);
+
+    block_payload_t *payload = malloc (sizeof (*payload));
+    if (unlikely(payload == NULL))
+    {
+        block_Release (block);
+        return NULL;
+    }
+
+    atomic_init (&payload->refs, 1);
+    payload->payload = block;
+
+    block_t *sh = block_shared_New (payload);
+    if (unlikely(sh == NULL))
+    {
+        block_Release (block);
+        free (payload);
+        return NULL;
+    }
+    sh->p_next = block->p_next;
+    block->p_next = NULL;
+    return sh;
+}
+
+block_t *block_Share (block_t *block)
+{
+    block_Check (block);
+
+    if (block->pf_release != block_shared_Release)
+        return block_Duplicate (block);
+
+    block_shared_t *sh = container_of (block, block_shared_t, self);
+    block_payload_t *payload = sh->payload;
+
+    atomic_fetch_add_explicit (&payload->refs, 1, memory_order_relaxed);
+
+    block_t *dup = block_shared_New (payload);
+    if (unlikely(dup == NULL))
+    {
+        atomic_fetch_sub_explicit (&payload->refs, 1, memory_order_relaxed);
+        return NULL;
+    }
+    /* The payload may have been trimmed since it was wrapped */
+    dup->p_buffer = block->p_buffer;
+    dup->i_buffer = block->i_buffer;
+    dup->p_start = block->p_start;
+    dup->i_size = block->i_size;
+    block_CopyProperties (dup, block);
+    return dup;
+}
+
+block_t *block_Unshare (block_t *block)
+{
+    block_Check (block);
+
+    if (!block_IsShared (block))
+        return block;
+
+    block_t *dup = block_Duplicate (block);
+    if (likely(dup != NULL))
+    {
+        dup->p_next = block->p_next;
+        block->p_next = NULL;
+    }
+    else
+        block_ChainRelease (block->p_next);
+    block_Release (block);
+    return dup;
+}
+
 block_t *block_TryRealloc (block_t *p_block, ssize_t i_prebody, size_t i_body)
 {
     block_Check( p_block );
@@ -179,9 +309,12 @@ block_t *block_TryRealloc (block_t *p_block, ssize_t i_prebody, size_t i_body)
 
     size_t requested = i_prebody + i_body;
 
+    /* Copy-on-write: do not extend a payload other blocks are reading */
+    bool b_shared = block_IsShared( p_block );
+
     if( p_block->i_buffer == 0 )
     {   /* Corner case: nothing to preserve */
-        if( requested <= p_block->i_size )
+        if( requested <= p_block->i_size && !b_shared )
         {   /* Enough room: recycle buffer */
             size_t extra = p_block->i_size - requested;
 
@@ -206,7 +339,8 @@ block_t *block_TryRealloc (block_t *p_block, ssize_t i_prebody, size_t i_body)
     /* Second, reallocate the buffer if we lack space. */
     assert( i_prebody >= 0 );
     if( (size_t)(p_block->p_buffer - p_start) < (size_t)i_prebody
-     || (size_t)(p_end - p_block->p_buffer) < i_body )
+     || (size_t)(p_end - p_block->p_buffer) < i_body
+     || ( b_shared && ( i_prebody > 0 || i_body > p_block->i_buffer ) ) )
     {
         block_t *p_rea = block_Alloc( requested );
         if( p_rea == NULL )
@@ -0,0 +1,228 @@
+/*****************************************************************************
+ * executor.c: bounded pool of worker threads
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <assert.h>
+#include <vlc_common.h>
+#include <vlc_threads.h>
+#include <vlc_executor.h>
+
+#include "libvlc.h"
+
+struct vlc_executor {
+    unsigned max_threads;
+    unsigned max_blocked;
+    int priority;
+
+    vlc_mutex_t lock; /**< acquire to inspect members that follow */
+    vlc_cond_t wait_runnable; /**< wait for a runnable to be submitted */
+    vlc_cond_t wait_end; /**< wait for all threads to end */
+    struct vlc_runnable* first; /**< queue of pending runnables */
+    struct vlc_runnable** pp_last;
+    unsigned queued; /**< number of pending runnables */
+    unsigned threads; /**< number of threads, running, blocked or idle */
+    unsigned idle; /**< number of threads waiting for a runnable */
+    unsigned blocked; /**< number of threads blocked in a runnable */
+    bool closing; /**< true if the threads shall terminate */
+};
+
+/** Executor of the calling thread, NULL if not a worker */
+static thread_local struct vlc_executor* current;
+
+/* Number of threads counted against max_threads. The lock must be held. */
+static unsigned RunningThreads( const struct vlc_executor* executor )
+{
+    unsigned spare = executor->blocked < executor->max_blocked
+                   ? executor->blocked : executor->max_blocked;
+    return executor->threads - spare;
+}
+
+static struct vlc_runnable* TakeRunnable( struct vlc_executor* executor )
+{
+    /* Wait 5 seconds for new runnables before terminating */
+    mtime_t deadline = mdate() + INT64_C(5000000);
+
+    while( !executor->closing && executor->first == NULL )
+    {
+        executor->idle++;
+        int ret = vlc_cond_timedwait( &executor->wait_runnable,
+                                      &executor->lock, deadline );
+        executor->idle--;
+        if( ret != 0 )
+            break;
+    }
+
+    struct vlc_runnable* runnable = executor->first;
+    if( runnable == NULL )
+        return NULL;
+
+    executor->first = runnable->next;
+    if( executor->first == NULL )
+        executor->pp_last = &executor->first;
+    executor->queued--;
+    return runnable;
+}
+
+static void* Thread( void* data )
+{
+    struct vlc_executor* executor = data;
+
+    current = executor;
+
+    vlc_mutex_lock( &executor->lock );
+    for( ;; )
+    {
+        /* Terminate the threads in excess, once the runnables which were
+         * blocked have been resumed */
+        if( RunningThreads( executor ) > executor->max_threads )
+            break;
+
+        struct vlc_runnable* runnable = TakeRunnable( executor );
+        if( runnable == NULL )
+            break;
+        vlc_mutex_unlock( &executor->lock );
+
+        runnable->pf_run( runnable->data );
+
+        vlc_mutex_lock( &executor->lock );
+    }
+
+    executor->threads--;
+    if( executor->threads == 0 )
+        vlc_cond_signal( &executor->wait_end );
+    vlc_mutex_unlock( &executor->lock );
+    return NULL;
+}
+
+/* The lock must be held */
+static int SpawnThread( struct vlc_executor* executor )
+{
+    if( vlc_clone_detach( NULL, Thread, executor, executor->priority ) )
+        return VLC_EGENERIC;
+
+    executor->threads++;
+    return VLC_SUCCESS;
+}
+
+/* The lock must be held */
+static bool CanSpawnThread( struct vlc_executor* executor )
+{
+    return RunningThreads( executor ) < executor->max_threads;
+}
+
+struct vlc_executor* vlc_executor_New( unsigned max_threads,
+                                       unsigned max_blocked, int priority )
+{
+    struct vlc_executor* executor = malloc( sizeof( *executor ) );
+
+    if( unlikely( !executor ) )
+        return NULL;
+
+    executor->max_threads = max_threads > 0 ? max_threads : 1;
+    executor->max_blocked = max_blocked;
+    executor->priority = priority;
+
+    vlc_mutex_init( &executor->lock );
+    vlc_cond_init( &executor->wait_runnable );
+    vlc_cond_init( &executor->wait_end );
+    executor->first = NULL;
+    executor->pp_last = &executor->first;
+    executor->queued = 0;
+    executor->threads = 0;
+    executor->idle = 0;
+    executor->blocked = 0;
+    executor->closing = false;
+    return executor;
+}
+
+void vlc_executor_Delete( struct vlc_executor* executor )
+{
+    vlc_mutex_lock( &executor->lock );
+    assert( executor->first == NULL );
+
+    executor->closing = true;
+    vlc_cond_broadcast( &executor->wait_runnable );
+    while( executor->threads > 0 )
+        vlc_cond_wait( &executor->wait_end, &executor->lock );
+    vlc_mutex_unlock( &executor->lock );
+
+    vlc_cond_destroy( &executor->wait_end );
+    vlc_cond_destroy( &executor->wait_runnable );
+    vlc_mutex_destroy( &executor->lock );
+    free( executor );
+}
+
+int vlc_executor_Submit( struct vlc_executor* executor,
+                         struct vlc_runnable* runnable )
+{
+    vlc_mutex_lock( &executor->lock );
+    assert( !executor->closing );
+
+    runnable->next = NULL;
+    *executor->pp_last = runnable;
+    executor->pp_last = &runnable->next;
+    executor->queued++;
+
+    if( executor->idle > 0 )
+        vlc_cond_signal( &executor->wait_runnable );
+
+    if( executor->queued > executor->idle && CanSpawnThread( executor )
+     && SpawnThread( executor ) && executor->threads == 0 )
+    {   /* No thread to ever run it: this is the only queued runnable */
+        executor->first = NULL;
+        executor->pp_last = &executor->first;
+        executor->queued = 0;
+        vlc_mutex_unlock( &executor->lock );
+        return VLC_EGENERIC;
+    }
+    vlc_mutex_unlock( &executor->lock );
+    return VLC_SUCCESS;
+}
+
+void vlc_executor_BlockingBegin( void )
+{
+    struct vlc_executor* executor = current;
+
+    if( executor == NULL )
+        return;
+
+    vlc_mutex_lock( &executor->lock );
+    executor->blocked++;
+    /* Let another thread run the pending runnables meanwhile */
+    if( executor->queued > executor->idle && CanSpawnThread( executor ) )
+        SpawnThread( executor );
+    vlc_mutex_unlock( &executor->lock );
+}
+
+void vlc_executor_BlockingEnd( void )
+{
+    struct vlc_executor* executor = current;
+
+    if( executor == NULL )
+        return;
+
+    vlc_mutex_lock( &executor->lock );
+    assert( executor->blocked > 0 );
+    executor->blocked--;
+    vlc_mutex_unlock( &executor->lock );
+}
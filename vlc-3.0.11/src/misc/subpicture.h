@@ -29,3 +29,10 @@ struct subpicture_region_private_t {
 subpicture_region_private_t *subpicture_region_private_New(video_format_t *);
 void subpicture_region_private_Delete(subpicture_region_private_t *);
 
+/**
+ * Creates a region sharing the given picture instead of allocating a new one.
+ * The picture is held by the region.
+ */
+subpicture_region_t *subpicture_region_NewRef(const video_format_t *,
+                                              picture_t *);
+
@@ -40,14 +40,20 @@
 #include <vlc_url.h>
 #include <vlc_mime.h>
 #include <vlc_block.h>
+#include <vlc_fs.h>
 #include "../libvlc.h"
 
 #include <string.h>
 #include <errno.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 #ifdef HAVE_SYS_UIO_H
 # include <sys/uio.h>
 #endif
+#ifdef HAVE_SENDFILE
+# include <sys/sendfile.h>
+#endif
 
 #ifdef HAVE_POLL
 # include <poll.h>
@@ -66,10 +72,32 @@
 #define HTTPD_CL_BUFSIZE 10000
 #endif
 
-static void httpd_ClientDestroy(httpd_client_t *cl);
+/* upper bound of the number of threads serving one host */
+#define HTTPD_MAX_WORKERS 16
+
+/* largest chunk of a disk file sent at once */
+#define HTTPD_FILE_CHUNK 16384
+
+static void httpd_ClientDestroy(httpd_host_t *, httpd_client_t *);
 static void httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data);
 
-/* each host run in his own thread */
+/*
+ * The clients of a host are spread over several threads. Each of them polls
+ * the listening sockets along with its own clients, and keeps the clients it
+ * accepted.
+ */
+typedef struct
+{
+    httpd_host_t *host;
+    vlc_thread_t  thread;
+
+    /* protects the client table and the client states; when both are
+     * needed, the worker lock is taken before the host lock */
+    vlc_mutex_t      lock;
+    int              i_client;
+    httpd_client_t **client;
+} httpd_worker_t;
+
 struct httpd_host_t
 {
     VLC_COMMON_MEMBERS
@@ -82,7 +110,8 @@ struct httpd_host_t
     unsigned     nfd;
     unsigned     port;
 
-    vlc_thread_t thread;
+    unsigned        i_worker;
+    httpd_worker_t *worker;
     vlc_mutex_t lock;
     vlc_cond_t  wait;
 
@@ -93,9 +122,6 @@ struct httpd_host_t
     int         i_url;
     httpd_url_t **url;
 
-    int            i_client;
-    httpd_client_t **client;
-
     /* TLS data */
     vlc_tls_creds_t *p_tls;
 };
@@ -160,6 +186,22 @@ struct httpd_client_t
      */
     int64_t i_keyframe_wait_to_pass;
 
+    /* Stream statistics */
+    mtime_t  i_stream_start;    /* date the first body bytes were sent */
+    uint64_t i_stream_bytes;
+    unsigned i_stream_resyncs;  /* times the client lagged behind */
+
+    /* Stream the body is sent from, straight out of its circular buffer */
+    httpd_stream_t *stream;
+
+    /* File the body is sent from, straight from the disk, or -1 */
+    int      body_fd;
+    uint64_t i_body_fd_pos;
+    uint64_t i_body_fd_end;
+
+    /* Blocks the body is sent from, released once sent, or NULL */
+    block_t *body_chain;
+
     /* */
     httpd_message_t query;  /* client -> httpd */
     httpd_message_t answer; /* httpd -> client */
@@ -392,6 +434,177 @@ httpd_file_sys_t *httpd_FileDelete(httpd_file_t *file)
     return p_sys;
 }
 
+/*****************************************************************************
+ * High Level Functions: httpd_disk_file_t
+ *****************************************************************************/
+struct httpd_disk_file_t
+{
+    httpd_url_t *url;
+    char        *psz_path;
+    char mime[1];
+};
+
+int httpd_ParseRange(const char *psz_range, uint64_t i_size,
+                     uint64_t *pi_start, uint64_t *pi_end)
+{
+    unsigned long long i_first, i_last;
+    char *end;
+
+    if (strncasecmp(psz_range, "bytes=", 6))
+        return -1;
+    psz_range += 6;
+    if (strchr(psz_range, ',') != NULL)
+        return -1; /* multiple ranges, send the whole file instead */
+
+    if (*psz_range == '-') {
+        /* suffix range: the last bytes of the file */
+        i_last = strtoull(psz_range + 1, &end, 10);
+        if (end == psz_range + 1 || *end != '\0')
+            return -1;
+        if (i_last == 0 || i_size == 0)
+            return 1;
+        *pi_start = i_size - __MIN(i_last, i_size);
+        *pi_end = i_size;
+        return 0;
+    }
+
+    i_first = strtoull(psz_range, &end, 10);
+    if (end == psz_range || *end != '-')
+        return -1;
+    psz_range = end + 1;
+    if (*psz_range == '\0')
+        i_last = i_size - 1;
+    else {
+        i_last = strtoull(psz_range, &end, 10);
+        if (*end != '\0' || i_last < i_first)
+            return -1;
+    }
+
+    if (i_first >= i_size)
+        return 1;
+    *pi_start = i_first;
+    *pi_end = __MIN(i_last, i_size - 1) + 1;
+    return 0;
+}
+
+static int
+httpd_DiskFileCallBack(httpd_callback_sys_t *p_sys, httpd_client_t *cl,
+                       httpd_message_t *answer, const httpd_message_t *query)
+{
+    httpd_disk_file_t *file = (httpd_disk_file_t*)p_sys;
+    struct stat st; /* struct _stati64 on Win32, see vlc_fs.h */
+
+    if (!answer || !query || !cl)
+        return VLC_SUCCESS;
+
+    answer->i_proto  = HTTPD_PROTO_HTTP;
+    answer->i_version= 1;
+    answer->i_type   = HTTPD_MSG_ANSWER;
+
+    /* We respect client request */
+    if (httpd_MsgGet(&cl->query, "Connection") != NULL)
+        httpd_MsgAdd(answer, "Connection", "close");
+
+    int fd = vlc_open(file->psz_path, O_RDONLY);
+    if (fd == -1 || fstat(fd, &st) || !S_ISREG(st.st_mode)) {
+        char *p;
+
+        if (fd != -1)
+            vlc_close(fd);
+        answer->i_status = 404;
+        answer->i_body = httpd_HtmlError(&p, 404, query->psz_url);
+        answer->p_body = (uint8_t *)p;
+        httpd_MsgAdd(answer, "Content-Type", "%s", "text/html");
+        httpd_MsgAdd(answer, "Content-Length", "%d", answer->i_body);
+        return VLC_SUCCESS;
+    }
+
+    uint64_t i_size = st.st_size, i_start = 0, i_end = i_size;
+    const char *psz_range = httpd_MsgGet(query, "Range");
+    int i_range = (psz_range != NULL)
+        ? httpd_ParseRange(psz_range, i_size, &i_start, &i_end) : -1;
+
+    httpd_MsgAdd(answer, "Content-Type", "%s", file->mime);
+    httpd_MsgAdd(answer, "Accept-Ranges", "bytes");
+
+    if (i_range > 0) {
+        vlc_close(fd);
+        answer->i_status = 416;
+        httpd_MsgAdd(answer, "Content-Range", "bytes */%"PRIu64, i_size);
+        httpd_MsgAdd(answer, "Content-Length", "0");
+        return VLC_SUCCESS;
+    }
+
+    if (i_range == 0) {
+        answer->i_status = 206;
+        httpd_MsgAdd(answer, "Content-Range", "bytes %"PRIu64"-%"PRIu64
+                     "/%"PRIu64, i_start, i_end - 1, i_size);
+    } else {
+        answer->i_status = 200;
+        i_start = 0;
+        i_end = i_size;
+    }
+    httpd_MsgAdd(answer, "Content-Length", "%"PRIu64, i_end - i_start);
+
+    if (query->i_type == HTTPD_MSG_HEAD || i_start == i_end) {
+        vlc_close(fd);
+        return VLC_SUCCESS;
+    }
+
+    /* the body is sent by httpd_ClientSendFile() */
+    if (cl->body_fd != -1)
+        vlc_close(cl->body_fd);
+    cl->body_fd = fd;
+    cl->i_body_fd_pos = i_start;
+    cl->i_body_fd_end = i_end;
+    return VLC_SUCCESS;
+}
+
+httpd_disk_file_t *httpd_DiskFileNew(httpd_host_t *host,
+                                     const char *psz_url, const char *psz_path,
+                                     const char *psz_mime,
+                                     const char *psz_user,
+                                     const char *psz_password)
+{
+    const char *mime = psz_mime;
+    if (mime == NULL || mime[0] == '\0')
+        mime = vlc_mime_Ext2Mime(psz_path);
+
+    size_t mimelen = strlen(mime);
+    httpd_disk_file_t *file = malloc(sizeof(*file) + mimelen);
+    if (unlikely(file == NULL))
+        return NULL;
+
+    file->psz_path = strdup(psz_path);
+    if (unlikely(file->psz_path == NULL)) {
+        free(file);
+        return NULL;
+    }
+
+    file->url = httpd_UrlNew(host, psz_url, psz_user, psz_password);
+    if (!file->url) {
+        free(file->psz_path);
+        free(file);
+        return NULL;
+    }
+
+    memcpy(file->mime, mime, mimelen + 1);
+
+    httpd_UrlCatch(file->url, HTTPD_MSG_HEAD, httpd_DiskFileCallBack,
+                    (httpd_callback_sys_t*)file);
+    httpd_UrlCatch(file->url, HTTPD_MSG_GET,  httpd_DiskFileCallBack,
+                    (httpd_callback_sys_t*)file);
+
+    return file;
+}
+
+void httpd_DiskFileDelete(httpd_disk_file_t *file)
+{
+    httpd_UrlDelete(file->url);
+    free(file->psz_path);
+    free(file);
+}
+
 /*****************************************************************************
  * High Level Functions: httpd_handler_t (for CGIs)
  *****************************************************************************/
@@ -587,6 +800,8 @@ void httpd_RedirectDelete(httpd_redirect_t *rdir)
 /*****************************************************************************
  * High Level Funtions: httpd_stream_t
  *****************************************************************************/
+#define HTTPD_STREAM_KEYFRAMES 64
+
 struct httpd_stream_t
 {
     vlc_mutex_t lock;
@@ -606,6 +821,11 @@ struct httpd_stream_t
     bool        b_has_keyframes;
     int64_t     i_last_keyframe_seen_pos;
 
+    /* Byte positions of the last keyframes, so that lagging clients can be
+     * moved to a keyframe still in the buffer */
+    int64_t     pi_keyframe_pos[HTTPD_STREAM_KEYFRAMES];
+    unsigned    i_keyframe_count;   /* keyframes seen so far */
+
     /* circular buffer */
     int         i_buffer_size;      /* buffer size, can't be reallocated smaller */
     uint8_t     *p_buffer;          /* buffer */
@@ -617,57 +837,144 @@ struct httpd_stream_t
     httpd_header * p_http_headers;
 };
 
-static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
-                                 httpd_client_t *cl, httpd_message_t *answer,
-                                 const httpd_message_t *query)
+/**
+ * Finds a keyframe at or after the given position.
+ * The stream lock must be held.
+ * \param b_latest whether to find the latest keyframe instead of the first
+ * \return the keyframe position, or -1 if there is none
+ */
+static int64_t httpd_StreamFindKeyframe(const httpd_stream_t *stream,
+                                        int64_t i_min, bool b_latest)
 {
-    httpd_stream_t *stream = (httpd_stream_t*)p_sys;
+    unsigned i_count = __MIN(stream->i_keyframe_count, HTTPD_STREAM_KEYFRAMES);
+    int64_t i_found = -1;
 
-    if (!answer || !query || !cl)
-        return VLC_SUCCESS;
+    for (unsigned i = 1; i <= i_count; i++) {
+        int64_t i_pos = stream->pi_keyframe_pos[(stream->i_keyframe_count - i)
+                                                % HTTPD_STREAM_KEYFRAMES];
+        if (i_pos < i_min)
+            break;
+        i_found = i_pos;
+        if (b_latest)
+            break;
+    }
+    return i_found;
+}
 
-    if (answer->i_body_offset > 0) {
-        int     i_pos;
+/**
+ * Moves the client to the next data to send: the next keyframe if it is
+ * waiting for one, or a keyframe still in the buffer if it has lagged behind
+ * too much. Without keyframes, the client is moved to the last block.
+ * The stream lock must be held.
+ * \return the number of bytes available for the client
+ */
+static int64_t httpd_StreamAvailable(httpd_stream_t *stream, httpd_client_t *cl)
+{
+    httpd_message_t *answer = &cl->answer;
 
-        if (answer->i_body_offset >= stream->i_buffer_pos)
-            return VLC_EGENERIC;    /* wait, no data available */
+    /* Data is sent without holding the lock, keep half the buffer between
+     * the client and the data being overwritten */
+    int64_t i_min = stream->i_buffer_pos - stream->i_buffer_size / 2;
 
-        if (cl->i_keyframe_wait_to_pass >= 0) {
-            if (stream->i_last_keyframe_seen_pos <= cl->i_keyframe_wait_to_pass)
-                /* still waiting for the next keyframe */
-                return VLC_EGENERIC;
+    if (answer->i_body_offset >= stream->i_buffer_pos)
+        return 0;    /* wait, no data available */
 
-            /* seek to the new keyframe */
-            answer->i_body_offset = stream->i_last_keyframe_seen_pos;
-            cl->i_keyframe_wait_to_pass = -1;
+    if (cl->i_keyframe_wait_to_pass < 0 && answer->i_body_offset < i_min) {
+        /* this client isn't fast enough */
+        cl->i_stream_resyncs++;
+
+        if (!stream->b_has_keyframes)
+            answer->i_body_offset = stream->i_buffer_last_pos;
+        else {
+            /* Skip as little as possible the first time; if the client
+             * keeps lagging, give it as much headroom as possible */
+            int64_t i_pos = httpd_StreamFindKeyframe(stream, i_min,
+                                                     cl->i_stream_resyncs > 1);
+            if (i_pos >= 0)
+                answer->i_body_offset = i_pos;
+            else /* the keyframes are too far apart, wait for the next one */
+                cl->i_keyframe_wait_to_pass = stream->i_last_keyframe_seen_pos;
         }
+    }
+
+    if (cl->i_keyframe_wait_to_pass >= 0) {
+        if (stream->i_last_keyframe_seen_pos <= cl->i_keyframe_wait_to_pass)
+            /* still waiting for the next keyframe */
+            return 0;
+
+        /* seek to the new keyframe */
+        answer->i_body_offset = stream->i_last_keyframe_seen_pos;
+        cl->i_keyframe_wait_to_pass = -1;
+    }
 
-        if (answer->i_body_offset + stream->i_buffer_size < stream->i_buffer_pos)
-            answer->i_body_offset = stream->i_buffer_last_pos; /* this client isn't fast enough */
+    return stream->i_buffer_pos - answer->i_body_offset;
+}
+
+/**
+ * Sends stream data to a client straight from the circular buffer, which is
+ * shared by all the clients instead of being copied for each of them.
+ * \return the number of bytes sent, 0 if no data is available yet,
+ * -1 on error (see errno)
+ */
+static ssize_t httpd_StreamSendClient(httpd_stream_t *stream, httpd_client_t *cl)
+{
+    vlc_mutex_lock(&stream->lock);
+    int64_t i_write = httpd_StreamAvailable(stream, cl);
+    vlc_mutex_unlock(&stream->lock);
 
-        i_pos   = answer->i_body_offset % stream->i_buffer_size;
-        int64_t i_write = stream->i_buffer_pos - answer->i_body_offset;
+    if (i_write <= 0)
+        return 0;
 
-        if (i_write > HTTPD_CL_BUFSIZE)
-            i_write = HTTPD_CL_BUFSIZE;
-        else if (i_write <= 0)
-            return VLC_EGENERIC;    /* wait, no data available */
+    /* Bytes up to the current position are not written to anymore, until
+     * the buffer wraps around */
+    int64_t i_offset = cl->answer.i_body_offset;
+    int i_pos = i_offset % stream->i_buffer_size;
+    struct iovec iov[2];
+    int iovcnt = 1;
 
+    iov[0].iov_base = &stream->p_buffer[i_pos];
+    iov[0].iov_len = __MIN(i_write, stream->i_buffer_size - i_pos);
+    if ((int64_t)iov[0].iov_len < i_write) {
         /* Don't go past the end of the circular buffer */
-        i_write = __MIN(i_write, stream->i_buffer_size - i_pos);
+        iov[1].iov_base = stream->p_buffer;
+        iov[1].iov_len = i_write - iov[0].iov_len;
+        iovcnt = 2;
+    }
 
-        /* using HTTPD_MSG_ANSWER -> data available */
-        answer->i_proto  = HTTPD_PROTO_HTTP;
-        answer->i_version= 0;
-        answer->i_type   = HTTPD_MSG_ANSWER;
+    vlc_tls_t *sock = cl->sock;
+    ssize_t val = sock->writev(sock, iov, iovcnt);
+    if (val <= 0)
+        return val < 0 ? -1 : 0;
 
-        answer->i_body = i_write;
-        answer->p_body = xmalloc(i_write);
-        memcpy(answer->p_body, &stream->p_buffer[i_pos], i_write);
+    vlc_mutex_lock(&stream->lock);
+    bool b_overwritten = i_offset + stream->i_buffer_size < stream->i_buffer_pos;
+    vlc_mutex_unlock(&stream->lock);
 
-        answer->i_body_offset += i_write;
+    if (b_overwritten) {
+        /* the sender lapped us while the data was being sent */
+        errno = EIO;
+        return -1;
+    }
+
+    if (cl->i_stream_bytes == 0)
+        cl->i_stream_start = mdate();
+    cl->i_stream_bytes += val;
+    cl->answer.i_body_offset += val;
+    return val;
+}
+
+static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
+                                 httpd_client_t *cl, httpd_message_t *answer,
+                                 const httpd_message_t *query)
+{
+    httpd_stream_t *stream = (httpd_stream_t*)p_sys;
 
+    if (!answer || !query || !cl)
         return VLC_SUCCESS;
+
+    if (answer->i_body_offset > 0) {
+        /* body data is sent by httpd_StreamSendClient() */
+        return VLC_EGENERIC;
     } else {
         answer->i_proto  = HTTPD_PROTO_HTTP;
         answer->i_version= 0;
@@ -693,6 +1000,7 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
 
         if (query->i_type != HTTPD_MSG_HEAD) {
             cl->b_stream_mode = true;
+            cl->stream = stream;
             vlc_mutex_lock(&stream->lock);
             /* Send the header */
             if (stream->i_header > 0) {
@@ -701,10 +1009,16 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
                 memcpy(answer->p_body, stream->p_header, stream->i_header);
             }
             answer->i_body_offset = stream->i_buffer_last_pos;
-            if (stream->b_has_keyframes)
-                cl->i_keyframe_wait_to_pass = stream->i_last_keyframe_seen_pos;
-            else
-                cl->i_keyframe_wait_to_pass = -1;
+            cl->i_keyframe_wait_to_pass = -1;
+            if (stream->b_has_keyframes) {
+                /* Start from the latest keyframe if it is still in the
+                 * buffer, rather than waiting for the next one */
+                if (stream->i_last_keyframe_seen_pos
+                     >= stream->i_buffer_pos - stream->i_buffer_size / 2)
+                    answer->i_body_offset = stream->i_last_keyframe_seen_pos;
+                else
+                    cl->i_keyframe_wait_to_pass = stream->i_last_keyframe_seen_pos;
+            }
             vlc_mutex_unlock(&stream->lock);
         } else {
             httpd_MsgAdd(answer, "Content-Length", "0");
@@ -771,6 +1085,7 @@ httpd_stream_t *httpd_StreamNew(httpd_host_t *host,
     stream->i_buffer_last_pos = 1;
     stream->b_has_keyframes = false;
     stream->i_last_keyframe_seen_pos = 0;
+    stream->i_keyframe_count = 0;
     stream->i_http_headers = 0;
     stream->p_http_headers = NULL;
 
@@ -831,6 +1146,8 @@ int httpd_StreamSend(httpd_stream_t *stream, const block_t *p_block)
     if (p_block->i_flags & BLOCK_FLAG_TYPE_I) {
         stream->b_has_keyframes = true;
         stream->i_last_keyframe_seen_pos = stream->i_buffer_pos;
+        stream->pi_keyframe_pos[stream->i_keyframe_count++
+                                % HTTPD_STREAM_KEYFRAMES] = stream->i_buffer_pos;
     }
 
     httpd_AppendData(stream, p_block->p_buffer, p_block->i_buffer);
@@ -857,7 +1174,7 @@ void httpd_StreamDelete(httpd_stream_t *stream)
 /*****************************************************************************
  * Low level
  *****************************************************************************/
-static void* httpd_HostThread(void *);
+static void* httpd_WorkerThread(void *);
 static httpd_host_t *httpd_HostCreate(vlc_object_t *, const char *,
                                        const char *, vlc_tls_creds_t *);
 
@@ -904,6 +1221,29 @@ static struct httpd
     int          i_host;
 } httpd = { VLC_STATIC_MUTEX, NULL, 0 };
 
+/* stop the threads and close the remaining connections */
+static void httpd_HostStopWorkers(httpd_host_t *host)
+{
+    for (unsigned i = 0; i < host->i_worker; i++)
+        vlc_cancel(host->worker[i].thread);
+
+    for (unsigned i = 0; i < host->i_worker; i++) {
+        httpd_worker_t *worker = &host->worker[i];
+
+        vlc_join(worker->thread, NULL);
+
+        for (int j = 0; j < worker->i_client; j++) {
+            msg_Warn(host, "client still connected");
+            httpd_ClientDestroy(host, worker->client[j]);
+        }
+        TAB_CLEAN(worker->i_client, worker->client);
+        vlc_mutex_destroy(&worker->lock);
+    }
+    free(host->worker);
+    host->worker = NULL;
+    host->i_worker = 0;
+}
+
 static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
                                        const char *hostvar,
                                        const char *portvar,
@@ -946,6 +1286,8 @@ static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
     vlc_mutex_init(&host->lock);
     vlc_cond_init(&host->wait);
     host->i_ref = 1;
+    host->i_worker = 0;
+    host->worker = NULL;
 
     char *hostname = var_InheritString(p_this, hostvar);
 
@@ -961,16 +1303,34 @@ static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
     host->port     = port;
     host->i_url    = 0;
     host->url      = NULL;
-    host->i_client = 0;
-    host->client   = NULL;
     host->p_tls    = p_tls;
 
-    /* create the thread */
-    if (vlc_clone(&host->thread, httpd_HostThread, host,
-                   VLC_THREAD_PRIORITY_LOW)) {
-        msg_Err(p_this, "cannot spawn http host thread");
+    /* create the threads */
+    int i_worker = var_InheritInteger(p_this, "http-threads");
+    if (i_worker <= 0)
+        i_worker = __MIN(vlc_GetCPUCount(), 4);
+    i_worker = VLC_CLIP(i_worker, 1, HTTPD_MAX_WORKERS);
+
+    host->worker = malloc(i_worker * sizeof (*host->worker));
+    if (unlikely(host->worker == NULL))
         goto error;
+
+    for (; host->i_worker < (unsigned)i_worker; host->i_worker++) {
+        httpd_worker_t *worker = &host->worker[host->i_worker];
+
+        worker->host = host;
+        vlc_mutex_init(&worker->lock);
+        worker->i_client = 0;
+        worker->client = NULL;
+
+        if (vlc_clone(&worker->thread, httpd_WorkerThread, worker,
+                       VLC_THREAD_PRIORITY_LOW)) {
+            msg_Err(p_this, "cannot spawn http host thread");
+            vlc_mutex_destroy(&worker->lock);
+            goto error;
+        }
     }
+    msg_Dbg(host, "serving clients from %u thread(s)", host->i_worker);
 
     /* now add it to httpd */
     TAB_APPEND(httpd.i_host, httpd.host, host);
@@ -982,6 +1342,7 @@ error:
     vlc_mutex_unlock(&httpd.mutex);
 
     if (host) {
+        httpd_HostStopWorkers(host);
         net_ListenClose(host->fds);
         vlc_cond_destroy(&host->wait);
         vlc_mutex_destroy(&host->lock);
@@ -1012,20 +1373,13 @@ void httpd_HostDelete(httpd_host_t *host)
     }
     TAB_REMOVE(httpd.i_host, httpd.host, host);
 
-    vlc_cancel(host->thread);
-    vlc_join(host->thread, NULL);
+    httpd_HostStopWorkers(host);
 
     msg_Dbg(host, "HTTP host removed");
 
     for (int i = 0; i < host->i_url; i++)
         msg_Err(host, "url still registered: %s", host->url[i]->psz_url);
 
-    for (int i = 0; i < host->i_client; i++) {
-        msg_Warn(host, "client still connected");
-        httpd_ClientDestroy(host->client[i]);
-    }
-    TAB_CLEAN(host->i_client, host->client);
-
     vlc_tls_Delete(host->p_tls);
     net_ListenClose(host->fds);
     vlc_cond_destroy(&host->wait);
@@ -1063,7 +1417,7 @@ httpd_url_t *httpd_UrlNew(httpd_host_t *host, const char *psz_url,
     }
 
     TAB_APPEND(host->i_url, host->url, url);
-    vlc_cond_signal(&host->wait);
+    vlc_cond_broadcast(&host->wait);
     vlc_mutex_unlock(&host->lock);
 
     return url;
@@ -1088,26 +1442,33 @@ void httpd_UrlDelete(httpd_url_t *url)
 
     vlc_mutex_lock(&host->lock);
     TAB_REMOVE(host->i_url, host->url, url);
+    vlc_mutex_unlock(&host->lock);
 
-    vlc_mutex_destroy(&url->lock);
-    free(url->psz_url);
-    free(url->psz_user);
-    free(url->psz_password);
+    /* No new client can be bound to the url anymore */
+    for (unsigned w = 0; w < host->i_worker; w++) {
+        httpd_worker_t *worker = &host->worker[w];
 
-    for (int i = 0; i < host->i_client; i++) {
-        httpd_client_t *client = host->client[i];
+        vlc_mutex_lock(&worker->lock);
+        for (int i = 0; i < worker->i_client; i++) {
+            httpd_client_t *client = worker->client[i];
 
-        if (client->url != url)
-            continue;
+            if (client->url != url)
+                continue;
 
-        /* TODO complete it */
-        msg_Warn(host, "force closing connections");
-        TAB_REMOVE(host->i_client, host->client, client);
-        httpd_ClientDestroy(client);
-        i--;
+            /* TODO complete it */
+            msg_Warn(host, "force closing connections");
+            TAB_REMOVE(worker->i_client, worker->client, client);
+            httpd_ClientDestroy(host, client);
+            i--;
+        }
+        vlc_mutex_unlock(&worker->lock);
     }
+
+    vlc_mutex_destroy(&url->lock);
+    free(url->psz_url);
+    free(url->psz_user);
+    free(url->psz_password);
     free(url);
-    vlc_mutex_unlock(&host->lock);
 }
 
 static void httpd_MsgInit(httpd_message_t *msg)
@@ -1188,7 +1549,13 @@ static void httpd_ClientInit(httpd_client_t *cl, mtime_t now)
     cl->i_buffer = 0;
     cl->p_buffer = xmalloc(cl->i_buffer_size);
     cl->i_keyframe_wait_to_pass = -1;
+    cl->i_stream_start = 0;
+    cl->i_stream_bytes = 0;
+    cl->i_stream_resyncs = 0;
     cl->b_stream_mode = false;
+    cl->stream = NULL;
+    cl->body_fd = -1;
+    cl->body_chain = NULL;
 
     httpd_MsgInit(&cl->query);
     httpd_MsgInit(&cl->answer);
@@ -1204,10 +1571,35 @@ char* httpd_ServerIP(const httpd_client_t *cl, char *ip, int *port)
     return net_GetSockAddress(vlc_tls_GetFD(cl->sock), ip, port) ? NULL : ip;
 }
 
-static void httpd_ClientDestroy(httpd_client_t *cl)
+void httpd_ClientSetBodyChain(httpd_client_t *cl, block_t *chain)
 {
-    vlc_tls_Close(cl->sock);
+    if (cl->body_chain != NULL)
+        block_ChainRelease(cl->body_chain);
+    cl->body_chain = chain;
+}
+
+static void httpd_ClientCleanAnswer(httpd_client_t *cl)
+{
+    httpd_ClientSetBodyChain(cl, NULL);
     httpd_MsgClean(&cl->answer);
+}
+
+static void httpd_ClientDestroy(httpd_host_t *host, httpd_client_t *cl)
+{
+    if (cl->i_stream_bytes > 0) {
+        mtime_t i_duration = mdate() - cl->i_stream_start;
+
+        msg_Dbg(host, "stream client: %"PRIu64" bytes in %"PRId64" ms "
+                "(%"PRIu64" kbit/s), %u resync(s)", cl->i_stream_bytes,
+                i_duration / 1000, i_duration > 0
+                ? cl->i_stream_bytes * 8 * 1000 / i_duration : 0,
+                cl->i_stream_resyncs);
+    }
+
+    if (cl->body_fd != -1)
+        vlc_close(cl->body_fd);
+    vlc_tls_Close(cl->sock);
+    httpd_ClientCleanAnswer(cl);
     httpd_MsgClean(&cl->query);
 
     free(cl->p_buffer);
@@ -1551,10 +1943,173 @@ static void httpd_ClientRecv(httpd_client_t *cl)
         cl->i_activity_timeout = 0;
 }
 
-static void httpd_ClientSend(httpd_client_t *cl)
+static void httpd_ClientSendStream(httpd_client_t *cl)
+{
+    ssize_t i_len = httpd_StreamSendClient(cl->stream, cl);
+
+    if (i_len == 0) {
+        /* no more data for now, wait for the stream */
+        cl->i_state = HTTPD_CLIENT_SEND_DONE;
+        return;
+    }
+#if defined(_WIN32)
+    if (i_len < 0 && WSAGetLastError() != WSAEWOULDBLOCK)
+#else
+    if (i_len < 0 && errno != EAGAIN)
+#endif
+        cl->i_state = HTTPD_CLIENT_DEAD;
+}
+
+/**
+ * Moves a disk file to a 64-bits offset, also where off_t is 32-bits wide.
+ */
+static int httpd_FileSeek(int fd, uint64_t i_offset)
+{
+#ifdef _WIN32
+    return _lseeki64(fd, i_offset, SEEK_SET) == -1 ? -1 : 0;
+#else
+    return lseek(fd, i_offset, SEEK_SET) == (off_t)-1 ? -1 : 0;
+#endif
+}
+
+/**
+ * Sends a disk file to a client, until the socket would block. Plain
+ * connections use sendfile() where available; otherwise, the file goes
+ * through a bounded buffer, so that memory use does not depend on its size.
+ */
+static void httpd_ClientSendFile(httpd_host_t *host, httpd_client_t *cl)
+{
+    bool b_seek = true;
+
+#ifndef HAVE_SENDFILE
+    VLC_UNUSED(host);
+#endif
+    while (cl->i_body_fd_pos < cl->i_body_fd_end) {
+        size_t i_chunk = __MIN(cl->i_body_fd_end - cl->i_body_fd_pos,
+                               HTTPD_FILE_CHUNK);
+        ssize_t i_len;
+
+#ifdef HAVE_SENDFILE
+        if (host->p_tls == NULL) {
+            off_t i_offset = cl->i_body_fd_pos;
+
+            i_len = sendfile(vlc_tls_GetFD(cl->sock), cl->body_fd, &i_offset,
+                             i_chunk);
+            if (i_len == 0) /* the file was truncated */
+                goto error;
+        } else
+#endif
+        {
+            uint8_t buf[HTTPD_FILE_CHUNK];
+
+            if (b_seek && httpd_FileSeek(cl->body_fd, cl->i_body_fd_pos))
+                goto error;
+            ssize_t i_read = read(cl->body_fd, buf, i_chunk);
+            if (i_read <= 0)
+                goto error;
+            i_len = httpd_NetSend(cl, buf, i_read);
+            /* What could not be sent is read again */
+            b_seek = i_len != i_read;
+        }
+
+        if (i_len < 0) {
+#if defined(_WIN32)
+            if (WSAGetLastError() != WSAEWOULDBLOCK)
+#else
+            if (errno != EAGAIN)
+#endif
+                cl->i_state = HTTPD_CLIENT_DEAD;
+            return;
+        }
+        cl->i_body_fd_pos += i_len;
+    }
+
+    /* send finished */
+    vlc_close(cl->body_fd);
+    cl->body_fd = -1;
+    cl->i_state = HTTPD_CLIENT_SEND_DONE;
+    return;
+
+error:
+    cl->i_state = HTTPD_CLIENT_DEAD;
+}
+
+/**
+ * Sends a body made of a chain of blocks to a client, until the socket would
+ * block. The blocks are released as soon as they are sent.
+ */
+static void httpd_ClientSendChain(httpd_client_t *cl)
+{
+    block_t *chain = cl->body_chain;
+
+    while (chain != NULL) {
+        struct iovec iov[16];
+        int i_iov = 0;
+
+        for (block_t *b = chain; b != NULL && i_iov < 16; b = b->p_next)
+            if (b->i_buffer > 0) {
+                iov[i_iov].iov_base = b->p_buffer;
+                iov[i_iov].iov_len = b->i_buffer;
+                i_iov++;
+            }
+
+        ssize_t i_len = 0;
+        if (i_iov > 0)
+            i_len = cl->sock->writev(cl->sock, iov, i_iov);
+        if (i_len < 0) {
+            cl->body_chain = chain;
+#if defined(_WIN32)
+            if (WSAGetLastError() != WSAEWOULDBLOCK)
+#else
+            if (errno != EAGAIN)
+#endif
+                cl->i_state = HTTPD_CLIENT_DEAD;
+            return;
+        }
+
+        /* Release what was sent, skip into a partly sent block */
+        while (chain != NULL && (size_t)i_len >= chain->i_buffer) {
+            block_t *next = chain->p_next;
+
+            i_len -= chain->i_buffer;
+            block_Release(chain);
+            chain = next;
+        }
+        if (chain != NULL) {
+            chain->p_buffer += i_len;
+            chain->i_buffer -= i_len;
+        }
+    }
+
+    cl->body_chain = NULL;
+    cl->i_state = HTTPD_CLIENT_SEND_DONE;
+}
+
+static void httpd_ClientSend(httpd_host_t *host, httpd_client_t *cl)
 {
     int i_len;
 
+    if (cl->i_buffer >= 0 && cl->i_buffer >= cl->i_buffer_size
+     && cl->stream != NULL && cl->answer.i_body_offset > 0) {
+        /* headers sent, the body comes from the stream buffer */
+        httpd_ClientSendStream(cl);
+        return;
+    }
+
+    if (cl->i_buffer >= 0 && cl->i_buffer >= cl->i_buffer_size
+     && cl->body_fd != -1) {
+        /* headers sent, the body comes from the disk */
+        httpd_ClientSendFile(host, cl);
+        return;
+    }
+
+    if (cl->i_buffer >= 0 && cl->i_buffer >= cl->i_buffer_size
+     && cl->body_chain != NULL) {
+        /* headers sent, the body comes from blocks */
+        httpd_ClientSendChain(cl);
+        return;
+    }
+
     if (cl->i_buffer < 0) {
         /* We need to create the header */
         int i_size = 0;
@@ -1592,16 +2147,33 @@ static void httpd_ClientSend(httpd_client_t *cl)
         cl->i_buffer += i_len;
 
         if (cl->i_buffer >= cl->i_buffer_size) {
+            if (cl->body_fd != -1) {
+                httpd_ClientSendFile(host, cl);
+                return;
+            }
+
+            if (cl->body_chain != NULL) {
+                httpd_ClientSendChain(cl);
+                return;
+            }
+
             if (cl->answer.i_body == 0  && cl->answer.i_body_offset > 0) {
+                if (cl->stream != NULL) {
+                    httpd_ClientSendStream(cl);
+                    return;
+                }
+
                 /* catch more body data */
                 int     i_msg = cl->query.i_type;
                 int64_t i_offset = cl->answer.i_body_offset;
 
-                httpd_MsgClean(&cl->answer);
+                httpd_ClientCleanAnswer(cl);
                 cl->answer.i_body_offset = i_offset;
 
+                vlc_mutex_lock(&host->lock);
                 cl->url->catch[i_msg].cb(cl->url->catch[i_msg].p_sys, cl,
                                           &cl->answer, &cl->query);
+                vlc_mutex_unlock(&host->lock);
             }
 
             if (cl->answer.i_body > 0) {
@@ -1680,9 +2252,22 @@ auth_failed:
     return false;
 }
 
-static void httpdLoop(httpd_host_t *host)
+static void httpdLoop(httpd_worker_t *worker)
 {
-    int arraySize = host->nfd + host->i_client;
+    httpd_host_t *host = worker->host;
+
+    /* add all socket that should be read/write and close dead connection */
+    vlc_mutex_lock(&host->lock);
+    while (host->i_url <= 0) {
+        mutex_cleanup_push(&host->lock);
+        vlc_cond_wait(&host->wait, &host->lock);
+        vlc_cleanup_pop();
+    }
+    vlc_mutex_unlock(&host->lock);
+
+    vlc_mutex_lock(&worker->lock);
+
+    int arraySize = host->nfd + worker->i_client;
 #ifdef __STDC_NO_VLA__
     struct pollfd* ufd = (struct pollfd*)malloc(arraySize * sizeof(struct pollfd));
 #else
@@ -1695,27 +2280,20 @@ static void httpdLoop(httpd_host_t *host)
         ufd[nfd].revents = 0;
     }
 
-    /* add all socket that should be read/write and close dead connection */
-    while (host->i_url <= 0) {
-        mutex_cleanup_push(&host->lock);
-        vlc_cond_wait(&host->wait, &host->lock);
-        vlc_cleanup_pop();
-    }
-
     mtime_t now = mdate();
     bool b_low_delay = false;
 
     int canc = vlc_savecancel();
-    for (int i_client = 0; i_client < host->i_client; i_client++) {
+    for (int i_client = 0; i_client < worker->i_client; i_client++) {
         int64_t i_offset;
-        httpd_client_t *cl = host->client[i_client];
+        httpd_client_t *cl = worker->client[i_client];
         if (cl->i_ref < 0 || (cl->i_ref == 0 &&
                     (cl->i_state == HTTPD_CLIENT_DEAD ||
                       (cl->i_activity_timeout > 0 &&
                         cl->i_activity_date+cl->i_activity_timeout < now)))) {
-            TAB_REMOVE(host->i_client, host->client, cl);
+            TAB_REMOVE(worker->i_client, worker->client, cl);
             i_client--;
-            httpd_ClientDestroy(cl);
+            httpd_ClientDestroy(host, cl);
             continue;
         }
 
@@ -1821,6 +2399,7 @@ static void httpdLoop(httpd_host_t *host)
                         bool b_auth_failed = false;
 
                         /* Search the url and trigger callbacks */
+                        vlc_mutex_lock(&host->lock);
                         for (int i = 0; i < host->i_url; i++) {
                             httpd_url_t *url = host->url[i];
 
@@ -1850,6 +2429,7 @@ static void httpdLoop(httpd_host_t *host)
                             if (!cl->url)
                                 cl->url = url;
                         }
+                        vlc_mutex_unlock(&host->lock);
 
                         if (answer) {
                             answer->i_proto  = query->i_proto;
@@ -1886,6 +2466,7 @@ static void httpdLoop(httpd_host_t *host)
                     bool do_close = false;
 
                     cl->url = NULL;
+                    cl->stream = NULL;
 
                     if (cl->query.i_proto != HTTPD_PROTO_HTTP
                      || cl->query.i_version > 0)
@@ -1910,10 +2491,10 @@ static void httpdLoop(httpd_host_t *host)
                         cl->i_state = HTTPD_CLIENT_RECEIVING;
                     } else
                         cl->i_state = HTTPD_CLIENT_DEAD;
-                    httpd_MsgClean(&cl->answer);
+                    httpd_ClientCleanAnswer(cl);
                 } else {
                     i_offset = cl->answer.i_body_offset;
-                    httpd_MsgClean(&cl->answer);
+                    httpd_ClientCleanAnswer(cl);
 
                     cl->answer.i_body_offset = i_offset;
                     free(cl->p_buffer);
@@ -1926,14 +2507,29 @@ static void httpdLoop(httpd_host_t *host)
                 break;
 
             case HTTPD_CLIENT_WAITING:
+                if (cl->stream != NULL) {
+                    vlc_mutex_lock(&cl->stream->lock);
+                    bool b_data = httpd_StreamAvailable(cl->stream, cl) > 0;
+                    vlc_mutex_unlock(&cl->stream->lock);
+
+                    if (b_data) {
+                        /* we have new data, send it from the stream buffer */
+                        cl->i_state = HTTPD_CLIENT_SENDING;
+                        pufd->events = POLLOUT;
+                    }
+                    break;
+                }
+
                 i_offset = cl->answer.i_body_offset;
                 int i_msg = cl->query.i_type;
 
                 httpd_MsgInit(&cl->answer);
                 cl->answer.i_body_offset = i_offset;
 
+                vlc_mutex_lock(&host->lock);
                 cl->url->catch[i_msg].cb(cl->url->catch[i_msg].p_sys, cl,
                         &cl->answer, &cl->query);
+                vlc_mutex_unlock(&host->lock);
                 if (cl->answer.i_type != HTTPD_MSG_NONE) {
                     /* we have new data, so re-enter send mode */
                     cl->i_buffer      = 0;
@@ -1950,7 +2546,7 @@ static void httpdLoop(httpd_host_t *host)
         else
             b_low_delay = true;
     }
-    vlc_mutex_unlock(&host->lock);
+    vlc_mutex_unlock(&worker->lock);
     vlc_restorecancel(canc);
 
     /* we will wait 20ms (not too big) if HTTPD_CLIENT_WAITING */
@@ -1961,14 +2557,14 @@ static void httpdLoop(httpd_host_t *host)
     }
 
     canc = vlc_savecancel();
-    vlc_mutex_lock(&host->lock);
+    vlc_mutex_lock(&worker->lock);
 
     /* Handle client sockets */
     now = mdate();
     nfd = host->nfd;
 
-    for (int i_client = 0; i_client < host->i_client; i_client++) {
-        httpd_client_t *cl = host->client[i_client];
+    for (int i_client = 0; i_client < worker->i_client; i_client++) {
+        httpd_client_t *cl = worker->client[i_client];
         const struct pollfd *pufd = &ufd[nfd];
 
         assert(pufd < &ufd[sizeof(ufd) / sizeof(ufd[0])]);
@@ -1983,7 +2579,7 @@ static void httpdLoop(httpd_host_t *host)
 
         switch (cl->i_state) {
             case HTTPD_CLIENT_RECEIVING: httpd_ClientRecv(cl); break;
-            case HTTPD_CLIENT_SENDING:   httpd_ClientSend(cl); break;
+            case HTTPD_CLIENT_SENDING:   httpd_ClientSend(host, cl); break;
             case HTTPD_CLIENT_TLS_HS_IN:
             case HTTPD_CLIENT_TLS_HS_OUT:
                 httpd_ClientTlsHandshake(host, cl);
@@ -2034,9 +2630,10 @@ static void httpdLoop(httpd_host_t *host)
         if (host->p_tls != NULL)
             cl->i_state = HTTPD_CLIENT_TLS_HS_OUT;
 
-        TAB_APPEND(host->i_client, host->client, cl);
+        TAB_APPEND(worker->i_client, worker->client, cl);
     }
 
+    vlc_mutex_unlock(&worker->lock);
     vlc_restorecancel(canc);
 
 #ifdef __STDC_NO_VLA__
@@ -2044,15 +2641,14 @@ static void httpdLoop(httpd_host_t *host)
 #endif
 }
 
-static void* httpd_HostThread(void *data)
+static void* httpd_WorkerThread(void *data)
 {
-    httpd_host_t *host = data;
+    httpd_worker_t *worker = data;
 
-    vlc_mutex_lock(&host->lock);
-    while (host->i_ref > 0)
-        httpdLoop(host);
-    vlc_mutex_unlock(&host->lock);
-    return NULL;
+    /* until cancelled by httpd_HostDelete() */
+    for (;;)
+        httpdLoop(worker);
+    vlc_assert_unreachable();
 }
 
 int httpd_StreamSetHTTPHeaders(httpd_stream_t * p_stream,
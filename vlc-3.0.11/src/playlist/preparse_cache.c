@@ -0,0 +1,382 @@
+/*****************************************************************************
+ * preparse_cache.c: on-disk cache of preparsing results
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <sys/stat.h>
+#include <errno.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_input_item.h>
+#include <vlc_meta.h>
+#include <vlc_es.h>
+#include <vlc_fs.h>
+#include <vlc_url.h>
+#include <vlc_md5.h>
+
+#include "input/item.h"
+#include "preparse_cache.h"
+#include "preparse_entry.h"
+
+struct playlist_preparse_cache_t
+{
+    vlc_object_t *obj;
+    char         *psz_dir;
+    uint64_t      i_max;    /**< size limit of the entries, in bytes */
+
+    vlc_mutex_t   lock;
+    bool          b_scanned;
+    uint64_t      i_size;   /**< size of the entries, if scanned */
+};
+
+playlist_preparse_cache_t *playlist_preparse_cache_New( vlc_object_t *obj )
+{
+    int64_t i_max = var_InheritInteger( obj, "preparse-cache-size" );
+    if( i_max <= 0 )
+        return NULL;
+
+    playlist_preparse_cache_t *cache = malloc( sizeof( *cache ) );
+    if( unlikely( !cache ) )
+        return NULL;
+
+    char *psz_cachedir = config_GetUserDir( VLC_CACHE_DIR );
+    if( !psz_cachedir || asprintf( &cache->psz_dir, "%s" DIR_SEP "preparse",
+                                   psz_cachedir ) == -1 )
+    {
+        free( psz_cachedir );
+        free( cache );
+        return NULL;
+    }
+    free( psz_cachedir );
+
+    cache->obj = obj;
+    cache->i_max = (uint64_t)i_max * 1024;
+    cache->b_scanned = false;
+    cache->i_size = 0;
+    vlc_mutex_init( &cache->lock );
+    return cache;
+}
+
+void playlist_preparse_cache_Delete( playlist_preparse_cache_t *cache )
+{
+    vlc_mutex_destroy( &cache->lock );
+    free( cache->psz_dir );
+    free( cache );
+}
+
+/**
+ * Identifies the file of an item.
+ * \return the item URI, or NULL if the item is not a local file
+ */
+static char *CacheGetFile( input_item_t *item, struct stat *st )
+{
+    char *psz_uri = NULL;
+
+    vlc_mutex_lock( &item->lock );
+    if( item->i_type == ITEM_TYPE_FILE && !item->b_net && item->psz_uri )
+        psz_uri = strdup( item->psz_uri );
+    vlc_mutex_unlock( &item->lock );
+
+    if( !psz_uri )
+        return NULL;
+
+    char *psz_path = vlc_uri2path( psz_uri );
+    if( !psz_path || vlc_stat( psz_path, st ) || !S_ISREG( st->st_mode ) )
+    {
+        free( psz_uri );
+        psz_uri = NULL;
+    }
+    free( psz_path );
+    return psz_uri;
+}
+
+static char *CacheEntryPath( playlist_preparse_cache_t *cache,
+                             const char *psz_uri )
+{
+    struct md5_s md5;
+    char *psz_path;
+
+    InitMD5( &md5 );
+    AddMD5( &md5, psz_uri, strlen( psz_uri ) );
+    EndMD5( &md5 );
+
+    char *psz_hash = psz_md5_hash( &md5 );
+    if( !psz_hash )
+        return NULL;
+    if( asprintf( &psz_path, "%s" DIR_SEP "%s", cache->psz_dir,
+                  psz_hash ) == -1 )
+        psz_path = NULL;
+    free( psz_hash );
+    return psz_path;
+}
+
+/*****************************************************************************
+ * Size limit
+ *****************************************************************************/
+struct cache_file
+{
+    char    *psz_name;
+    time_t   i_mtime;
+    uint64_t i_size;
+};
+
+static int CacheFileCompare( const void *a, const void *b )
+{
+    const struct cache_file *fa = a, *fb = b;
+    return ( fa->i_mtime > fb->i_mtime ) - ( fa->i_mtime < fb->i_mtime );
+}
+
+/**
+ * Computes the size of the entries, and removes the oldest ones if they
+ * exceed the limit. The lock must be held.
+ */
+static void CacheTrim( playlist_preparse_cache_t *cache )
+{
+    DIR *dir = vlc_opendir( cache->psz_dir );
+    if( !dir )
+        return;
+
+    struct cache_file *files = NULL;
+    size_t i_files = 0, i_alloc = 0;
+    uint64_t i_size = 0;
+    const char *psz_name;
+
+    while( ( psz_name = vlc_readdir( dir ) ) != NULL )
+    {
+        char *psz_path;
+        struct stat st;
+
+        if( psz_name[0] == '.' )
+            continue;
+        if( asprintf( &psz_path, "%s" DIR_SEP "%s", cache->psz_dir,
+                      psz_name ) == -1 )
+            continue;
+        bool b_ok = !vlc_stat( psz_path, &st ) && S_ISREG( st.st_mode );
+        free( psz_path );
+        if( !b_ok )
+            continue;
+
+        if( i_files == i_alloc )
+        {
+            size_t i_new = i_alloc ? i_alloc * 2 : 64;
+            struct cache_file *p = realloc( files, i_new * sizeof( *p ) );
+            if( unlikely( !p ) )
+                break;
+            files = p;
+            i_alloc = i_new;
+        }
+        files[i_files].psz_name = strdup( psz_name );
+        if( unlikely( !files[i_files].psz_name ) )
+            break;
+        files[i_files].i_mtime = st.st_mtime;
+        files[i_files].i_size = st.st_size;
+        i_size += st.st_size;
+        i_files++;
+    }
+    closedir( dir );
+
+    if( i_size > cache->i_max )
+    {
+        /* Leave some room, not to trim again on the next store */
+        uint64_t i_target = cache->i_max / 4 * 3;
+        unsigned i_removed = 0;
+
+        qsort( files, i_files, sizeof( *files ), CacheFileCompare );
+        for( size_t i = 0; i < i_files && i_size > i_target; i++ )
+        {
+            char *psz_path;
+            if( asprintf( &psz_path, "%s" DIR_SEP "%s", cache->psz_dir,
+                          files[i].psz_name ) == -1 )
+                continue;
+            if( !vlc_unlink( psz_path ) )
+            {
+                i_size -= files[i].i_size;
+                i_removed++;
+            }
+            free( psz_path );
+        }
+        msg_Dbg( cache->obj, "preparse cache: removed %u old entries",
+                 i_removed );
+    }
+
+    for( size_t i = 0; i < i_files; i++ )
+        free( files[i].psz_name );
+    free( files );
+
+    cache->b_scanned = true;
+    cache->i_size = i_size;
+}
+
+/*****************************************************************************
+ * Store
+ *****************************************************************************/
+static void CacheCreateDir( const char *psz_dir )
+{
+    char *psz_newdir = strdup( psz_dir );
+    if( unlikely( !psz_newdir ) )
+        return;
+
+    for( char *psz = psz_newdir + 1; *psz; psz++ )
+        if( *psz == DIR_SEP_CHAR )
+        {
+            *psz = '\0';
+            vlc_mkdir( psz_newdir, 0700 );
+            *psz = DIR_SEP_CHAR;
+        }
+    vlc_mkdir( psz_newdir, 0700 );
+    free( psz_newdir );
+}
+
+void playlist_preparse_cache_Store( playlist_preparse_cache_t *cache,
+                                    input_item_t *item )
+{
+    struct stat st;
+    char *psz_uri = CacheGetFile( item, &st );
+    if( !psz_uri )
+        return;
+
+    size_t i_length;
+    char *psz_entry = playlist_preparse_entry_Write( item, psz_uri,
+                                                     (uint64_t)st.st_size,
+                                                     (int64_t)st.st_mtime,
+                                                     &i_length );
+    char *psz_path = NULL, *psz_tmp = NULL;
+    if( !psz_entry )
+        goto out;
+
+    psz_path = CacheEntryPath( cache, psz_uri );
+    if( !psz_path || asprintf( &psz_tmp, "%s.XXXXXX", psz_path ) == -1 )
+    {
+        psz_tmp = NULL;
+        goto out;
+    }
+
+    vlc_mutex_lock( &cache->lock );
+    if( !cache->b_scanned )
+        CacheTrim( cache );
+    vlc_mutex_unlock( &cache->lock );
+
+    /* Write to a temporary file first, so that readers never see a partial
+     * entry */
+    int fd = vlc_mkstemp( psz_tmp );
+    if( fd == -1 && errno == ENOENT )
+    {
+        CacheCreateDir( cache->psz_dir );
+        memcpy( psz_tmp + strlen( psz_tmp ) - 6, "XXXXXX", 6 );
+        fd = vlc_mkstemp( psz_tmp );
+    }
+    if( fd == -1 )
+    {
+        msg_Dbg( cache->obj, "cannot create preparse cache entry %s: %s",
+                 psz_tmp, vlc_strerror_c( errno ) );
+        goto out;
+    }
+
+    bool b_ok = vlc_write( fd, psz_entry, i_length ) == (ssize_t)i_length;
+    vlc_close( fd );
+    if( !b_ok || vlc_rename( psz_tmp, psz_path ) )
+    {
+        vlc_unlink( psz_tmp );
+        goto out;
+    }
+
+    vlc_mutex_lock( &cache->lock );
+    cache->i_size += i_length;
+    if( cache->i_size > cache->i_max )
+        CacheTrim( cache );
+    vlc_mutex_unlock( &cache->lock );
+
+out:
+    free( psz_entry );
+    free( psz_tmp );
+    free( psz_path );
+    free( psz_uri );
+}
+
+/*****************************************************************************
+ * Load
+ *****************************************************************************/
+int playlist_preparse_cache_Load( playlist_preparse_cache_t *cache,
+                                  input_item_t *item )
+{
+    struct stat st;
+    char *psz_uri = CacheGetFile( item, &st );
+    if( !psz_uri )
+        return VLC_EGENERIC;
+
+    char *psz_path = CacheEntryPath( cache, psz_uri );
+    FILE *file = psz_path ? vlc_fopen( psz_path, "rt" ) : NULL;
+    if( !file )
+    {
+        free( psz_path );
+        free( psz_uri );
+        return VLC_EGENERIC;
+    }
+
+    playlist_preparse_entry_t entry;
+    int ret = playlist_preparse_entry_Read( file, psz_uri,
+                                            (uint64_t)st.st_size,
+                                            (int64_t)st.st_mtime, &entry );
+    fclose( file );
+
+    if( ret != VLC_SUCCESS )
+    {
+        /* Invalidate the entry, it would never match again */
+        vlc_unlink( psz_path );
+        free( psz_path );
+        free( psz_uri );
+        return ret;
+    }
+
+    for( int i = 0; i < VLC_META_TYPE_COUNT; i++ )
+    {
+        const char *psz = vlc_meta_Get( entry.p_meta, i );
+        if( psz )
+            input_item_SetMeta( item, i, psz );
+    }
+
+    char **ppsz_names = vlc_meta_CopyExtraNames( entry.p_meta );
+    vlc_mutex_lock( &item->lock );
+    if( !item->p_meta )
+        item->p_meta = vlc_meta_New();
+    for( int i = 0; ppsz_names && ppsz_names[i]; i++ )
+    {
+        if( item->p_meta )
+            vlc_meta_AddExtra( item->p_meta, ppsz_names[i],
+                               vlc_meta_GetExtra( entry.p_meta,
+                                                  ppsz_names[i] ) );
+        free( ppsz_names[i] );
+    }
+    vlc_mutex_unlock( &item->lock );
+    free( ppsz_names );
+
+    if( entry.i_duration >= 0 )
+        input_item_SetDuration( item, entry.i_duration );
+    for( int i = 0; i < entry.i_es; i++ )
+        input_item_UpdateTracksInfo( item, entry.es[i] );
+
+    playlist_preparse_entry_Clean( &entry );
+    free( psz_path );
+    free( psz_uri );
+    return VLC_SUCCESS;
+}
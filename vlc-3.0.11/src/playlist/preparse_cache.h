@@ -0,0 +1,65 @@
+/*****************************************************************************
+ * preparse_cache.h: on-disk cache of preparsing results
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef _PLAYLIST_PREPARSE_CACHE_H
+#define _PLAYLIST_PREPARSE_CACHE_H 1
+
+#include <vlc_input_item.h>
+
+/**
+ * Preparse cache opaque structure.
+ *
+ * The preparse cache keeps the result of the preparsing of local files (meta
+ * data, duration and elementary streams) in the user cache directory, so
+ * that unchanged files do not need to be opened again. An entry is only
+ * valid for the file size and modification time it was stored with.
+ */
+typedef struct playlist_preparse_cache_t playlist_preparse_cache_t;
+
+/**
+ * This function creates the preparse cache object.
+ *
+ * \return the cache, or NULL if it is disabled ("preparse-cache-size" is 0)
+ * or on error
+ */
+playlist_preparse_cache_t *playlist_preparse_cache_New( vlc_object_t * );
+
+/**
+ * This function restores the preparsing result of an item, if it is cached.
+ *
+ * \return VLC_SUCCESS on cache hit, an error code otherwise
+ */
+int playlist_preparse_cache_Load( playlist_preparse_cache_t *, input_item_t * );
+
+/**
+ * This function stores the preparsing result of an item.
+ *
+ * Items which are not local files, or which have no elementary streams
+ * (playlists, directories...), are not cached.
+ */
+void playlist_preparse_cache_Store( playlist_preparse_cache_t *,
+                                    input_item_t * );
+
+/**
+ * This function destroys the preparse cache object.
+ */
+void playlist_preparse_cache_Delete( playlist_preparse_cache_t * );
+
+#endif
@@ -0,0 +1,399 @@
+/*****************************************************************************
+ * preparse_entry.c: serialization of the preparse cache entries
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_input_item.h>
+#include <vlc_meta.h>
+#include <vlc_es.h>
+#include <vlc_memstream.h>
+
+#include "preparse_entry.h"
+
+/* Entries are text files, one field per line, the values being separated by
+ * tabulations. The first line identifies the format and the VLC version,
+ * since other versions may preparse files differently. The last line marks
+ * the end, so that truncated entries are detected. */
+#define CACHE_MAGIC "vlc-preparse-cache-2"
+
+static void WriteString( struct vlc_memstream *ms, const char *psz )
+{
+    vlc_memstream_putc( ms, '\t' );
+    for( ; psz && *psz; psz++ )
+        switch( *psz )
+        {
+            case '\\': vlc_memstream_puts( ms, "\\\\" ); break;
+            case '\t': vlc_memstream_puts( ms, "\\t" ); break;
+            case '\n': vlc_memstream_puts( ms, "\\n" ); break;
+            case '\r': vlc_memstream_puts( ms, "\\r" ); break;
+            default:   vlc_memstream_putc( ms, *psz ); break;
+        }
+}
+
+/* Unescapes a string written by WriteString() in place */
+static char *ReadString( char *psz )
+{
+    char *out = psz;
+
+    for( const char *in = psz; *in; in++ )
+    {
+        if( *in == '\\' && in[1] != '\0' )
+            switch( *++in )
+            {
+                case 't': *out++ = '\t'; continue;
+                case 'n': *out++ = '\n'; continue;
+                case 'r': *out++ = '\r'; continue;
+            }
+        *out++ = *in;
+    }
+    *out = '\0';
+    return psz;
+}
+
+static void WriteEs( struct vlc_memstream *ms, const es_format_t *fmt )
+{
+    vlc_memstream_printf( ms, "es\t%d\t%"PRIu32"\t%"PRIu32"\t%d\t%d\t%d\t%d"
+                          "\t%u", fmt->i_cat, fmt->i_codec,
+                          fmt->i_original_fourcc, fmt->i_id, fmt->i_group,
+                          fmt->i_profile, fmt->i_level, fmt->i_bitrate );
+    WriteString( ms, fmt->psz_language );
+    WriteString( ms, fmt->psz_description );
+
+    switch( fmt->i_cat )
+    {
+        case AUDIO_ES:
+            vlc_memstream_printf( ms, "\t%u\t%u\t%u", fmt->audio.i_rate,
+                                  fmt->audio.i_channels,
+                                  fmt->audio.i_bitspersample );
+            break;
+        case VIDEO_ES:
+            vlc_memstream_printf( ms, "\t%u\t%u\t%u\t%u\t%u\t%u\t%u\t%u\t%d"
+                                  "\t%d", fmt->video.i_width,
+                                  fmt->video.i_height,
+                                  fmt->video.i_visible_width,
+                                  fmt->video.i_visible_height,
+                                  fmt->video.i_sar_num, fmt->video.i_sar_den,
+                                  fmt->video.i_frame_rate,
+                                  fmt->video.i_frame_rate_base,
+                                  (int)fmt->video.orientation,
+                                  (int)fmt->video.projection_mode );
+            break;
+        case SPU_ES:
+            WriteString( ms, fmt->subs.psz_encoding );
+            break;
+        default:
+            break;
+    }
+    vlc_memstream_putc( ms, '\n' );
+}
+
+/* Splits the next tab separated field of a line */
+static char *NextField( char **ppsz_line )
+{
+    char *psz = *ppsz_line;
+    if( !psz )
+        return NULL;
+
+    char *psz_end = strchr( psz, '\t' );
+    if( psz_end )
+        *psz_end++ = '\0';
+    *ppsz_line = psz_end;
+    return psz;
+}
+
+static unsigned NextUnsigned( char **ppsz_line, bool *pb_error )
+{
+    char *psz = NextField( ppsz_line ), *end;
+    if( !psz )
+    {
+        *pb_error = true;
+        return 0;
+    }
+    unsigned long i = strtoul( psz, &end, 10 );
+    if( *end != '\0' )
+        *pb_error = true;
+    return i;
+}
+
+static int NextInt( char **ppsz_line, bool *pb_error )
+{
+    char *psz = NextField( ppsz_line ), *end;
+    if( !psz )
+    {
+        *pb_error = true;
+        return 0;
+    }
+    long i = strtol( psz, &end, 10 );
+    if( *end != '\0' )
+        *pb_error = true;
+    return i;
+}
+
+static char *NextString( char **ppsz_line, bool *pb_error )
+{
+    char *psz = NextField( ppsz_line );
+    if( !psz )
+    {
+        *pb_error = true;
+        return NULL;
+    }
+    ReadString( psz );
+    return *psz ? strdup( psz ) : NULL;
+}
+
+static int ReadEs( char *psz_line, es_format_t *fmt )
+{
+    bool b_error = false;
+    int i_cat = NextInt( &psz_line, &b_error );
+
+    if( i_cat != UNKNOWN_ES && i_cat != VIDEO_ES && i_cat != AUDIO_ES
+     && i_cat != SPU_ES && i_cat != DATA_ES )
+        return VLC_EGENERIC;
+
+    es_format_Init( fmt, i_cat, NextUnsigned( &psz_line, &b_error ) );
+    fmt->i_original_fourcc = NextUnsigned( &psz_line, &b_error );
+    fmt->i_id = NextInt( &psz_line, &b_error );
+    fmt->i_group = NextInt( &psz_line, &b_error );
+    fmt->i_profile = NextInt( &psz_line, &b_error );
+    fmt->i_level = NextInt( &psz_line, &b_error );
+    fmt->i_bitrate = NextUnsigned( &psz_line, &b_error );
+    fmt->psz_language = NextString( &psz_line, &b_error );
+    fmt->psz_description = NextString( &psz_line, &b_error );
+
+    switch( i_cat )
+    {
+        case AUDIO_ES:
+            fmt->audio.i_rate = NextUnsigned( &psz_line, &b_error );
+            fmt->audio.i_channels = NextUnsigned( &psz_line, &b_error );
+            fmt->audio.i_bitspersample = NextUnsigned( &psz_line, &b_error );
+            break;
+        case VIDEO_ES:
+            fmt->video.i_width = NextUnsigned( &psz_line, &b_error );
+            fmt->video.i_height = NextUnsigned( &psz_line, &b_error );
+            fmt->video.i_visible_width = NextUnsigned( &psz_line, &b_error );
+            fmt->video.i_visible_height = NextUnsigned( &psz_line, &b_error );
+            fmt->video.i_sar_num = NextUnsigned( &psz_line, &b_error );
+            fmt->video.i_sar_den = NextUnsigned( &psz_line, &b_error );
+            fmt->video.i_frame_rate = NextUnsigned( &psz_line, &b_error );
+            fmt->video.i_frame_rate_base = NextUnsigned( &psz_line, &b_error );
+            fmt->video.orientation = NextInt( &psz_line, &b_error );
+            fmt->video.projection_mode = NextInt( &psz_line, &b_error );
+            break;
+        case SPU_ES:
+            fmt->subs.psz_encoding = NextString( &psz_line, &b_error );
+            break;
+        default:
+            break;
+    }
+
+    if( b_error )
+    {
+        es_format_Clean( fmt );
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+char *playlist_preparse_entry_Write( input_item_t *item, const char *psz_uri,
+                                     uint64_t i_size, int64_t i_mtime,
+                                     size_t *pi_length )
+{
+    struct vlc_memstream ms;
+    if( vlc_memstream_open( &ms ) )
+        return NULL;
+
+    vlc_memstream_puts( &ms, CACHE_MAGIC );
+    WriteString( &ms, PACKAGE_VERSION );
+    vlc_memstream_printf( &ms, "\nfile\t%"PRIu64"\t%"PRId64, i_size,
+                          i_mtime );
+    WriteString( &ms, psz_uri );
+    vlc_memstream_putc( &ms, '\n' );
+
+    vlc_mutex_lock( &item->lock );
+    int i_es = item->i_es;
+    vlc_memstream_printf( &ms, "duration\t%"PRId64"\n", item->i_duration );
+    if( item->p_meta )
+    {
+        for( int i = 0; i < VLC_META_TYPE_COUNT; i++ )
+        {
+            const char *psz = vlc_meta_Get( item->p_meta, i );
+
+            /* Attachments can only be retrieved from an opened input */
+            if( !psz || ( i == vlc_meta_ArtworkURL
+                       && !strncmp( psz, "attachment://", 13 ) ) )
+                continue;
+            vlc_memstream_printf( &ms, "meta\t%d", i );
+            WriteString( &ms, psz );
+            vlc_memstream_putc( &ms, '\n' );
+        }
+
+        char **ppsz_names = vlc_meta_CopyExtraNames( item->p_meta );
+        for( int i = 0; ppsz_names && ppsz_names[i]; i++ )
+        {
+            vlc_memstream_puts( &ms, "extra" );
+            WriteString( &ms, ppsz_names[i] );
+            WriteString( &ms, vlc_meta_GetExtra( item->p_meta,
+                                                 ppsz_names[i] ) );
+            vlc_memstream_putc( &ms, '\n' );
+            free( ppsz_names[i] );
+        }
+        free( ppsz_names );
+    }
+    for( int i = 0; i < item->i_es; i++ )
+        WriteEs( &ms, item->es[i] );
+    vlc_mutex_unlock( &item->lock );
+    vlc_memstream_puts( &ms, "end\n" );
+
+    if( vlc_memstream_close( &ms ) )
+        return NULL;
+    if( i_es == 0 ) /* not a media file */
+    {
+        free( ms.ptr );
+        return NULL;
+    }
+    *pi_length = ms.length;
+    return ms.ptr;
+}
+
+int playlist_preparse_entry_Read( FILE *file, const char *psz_uri,
+                                  uint64_t i_size, int64_t i_mtime,
+                                  playlist_preparse_entry_t *entry )
+{
+    entry->p_meta = vlc_meta_New();
+    entry->es = NULL;
+    entry->i_es = 0;
+    entry->i_duration = -1;
+
+    bool b_valid = false, b_end = false, b_error = entry->p_meta == NULL;
+    char *psz_line = NULL;
+    size_t i_line = 0;
+    ssize_t i_read;
+
+    for( unsigned i = 0; !b_error && !b_end
+          && ( i_read = getline( &psz_line, &i_line, file ) ) != -1; i++ )
+    {
+        char *psz_fields = psz_line;
+
+        /* A line cut short is a truncated entry */
+        if( i_read == 0 || psz_line[i_read - 1] != '\n' )
+        {
+            b_error = true;
+            break;
+        }
+        psz_line[i_read - 1] = '\0';
+
+        const char *psz_key = NextField( &psz_fields );
+
+        if( i == 0 )
+        {
+            /* Stale entries are removed */
+            char *psz_version = NextString( &psz_fields, &b_error );
+            if( strcmp( psz_key, CACHE_MAGIC ) || !psz_version
+             || strcmp( psz_version, PACKAGE_VERSION ) )
+                b_error = true;
+            free( psz_version );
+        }
+        else if( i == 1 )
+        {
+            char *psz_size = NextField( &psz_fields );
+            char *psz_mtime = NextField( &psz_fields );
+            uint64_t i_file_size = psz_size ? strtoull( psz_size, NULL, 10 )
+                                            : 0;
+            int64_t i_file_mtime = psz_mtime ? strtoll( psz_mtime, NULL, 10 )
+                                             : 0;
+            char *psz_file_uri = NextString( &psz_fields, &b_error );
+
+            if( strcmp( psz_key, "file" ) || i_file_size != i_size
+             || i_file_mtime != i_mtime || !psz_file_uri
+             || strcmp( psz_file_uri, psz_uri ) )
+                b_error = true;
+            free( psz_file_uri );
+            b_valid = !b_error;
+        }
+        else if( !strcmp( psz_key, "end" ) )
+            b_end = true;
+        else if( !strcmp( psz_key, "duration" ) )
+        {
+            char *psz = NextField( &psz_fields );
+            entry->i_duration = psz ? strtoll( psz, NULL, 10 ) : -1;
+        }
+        else if( !strcmp( psz_key, "meta" ) )
+        {
+            int i_type = NextInt( &psz_fields, &b_error );
+            char *psz = NextString( &psz_fields, &b_error );
+
+            if( !b_error && i_type >= 0 && i_type < VLC_META_TYPE_COUNT )
+                vlc_meta_Set( entry->p_meta, i_type, psz );
+            else
+                b_error = true;
+            free( psz );
+        }
+        else if( !strcmp( psz_key, "extra" ) )
+        {
+            char *psz_name = NextString( &psz_fields, &b_error );
+            char *psz_value = NextString( &psz_fields, &b_error );
+
+            if( !b_error && psz_name )
+                vlc_meta_AddExtra( entry->p_meta, psz_name, psz_value );
+            free( psz_name );
+            free( psz_value );
+        }
+        else if( !strcmp( psz_key, "es" ) )
+        {
+            es_format_t *fmt = malloc( sizeof( *fmt ) );
+
+            if( !fmt || ReadEs( psz_fields, fmt ) )
+            {
+                free( fmt );
+                b_error = true;
+            }
+            else
+                TAB_APPEND( entry->i_es, entry->es, fmt );
+        }
+    }
+    free( psz_line );
+
+    if( b_error || !b_valid || !b_end || entry->i_es == 0 )
+    {
+        playlist_preparse_entry_Clean( entry );
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+void playlist_preparse_entry_Clean( playlist_preparse_entry_t *entry )
+{
+    for( int i = 0; i < entry->i_es; i++ )
+    {
+        es_format_Clean( entry->es[i] );
+        free( entry->es[i] );
+    }
+    free( entry->es );
+    entry->es = NULL;
+    entry->i_es = 0;
+    if( entry->p_meta )
+        vlc_meta_Delete( entry->p_meta );
+    entry->p_meta = NULL;
+}
@@ -0,0 +1,74 @@
+/*****************************************************************************
+ * preparse_entry.h: serialization of the preparse cache entries
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef _PLAYLIST_PREPARSE_ENTRY_H
+#define _PLAYLIST_PREPARSE_ENTRY_H 1
+
+#include <stdio.h>
+
+#include <vlc_input_item.h>
+#include <vlc_meta.h>
+#include <vlc_es.h>
+
+/**
+ * Preparsing result read from a cache entry.
+ */
+typedef struct
+{
+    vlc_meta_t   *p_meta;
+    es_format_t **es;
+    int           i_es;
+    mtime_t       i_duration; /**< -1 if unknown */
+} playlist_preparse_entry_t;
+
+/**
+ * This function serializes the preparsing result of an item.
+ *
+ * \param psz_uri URI of the file of the item
+ * \param i_size size of the file
+ * \param i_mtime modification time of the file
+ * \param pi_length [OUT] length of the entry
+ * \return the entry (to be freed), or NULL on error or if the item has no
+ * elementary streams (playlists, directories...)
+ */
+char *playlist_preparse_entry_Write( input_item_t *, const char *psz_uri,
+                                     uint64_t i_size, int64_t i_mtime,
+                                     size_t *pi_length );
+
+/**
+ * This function parses a cache entry.
+ *
+ * The entry is only valid if it was written by this VLC version, for the
+ * file with the same URI, size and modification time.
+ *
+ * \return VLC_SUCCESS if the entry is valid, in which case
+ * playlist_preparse_entry_Clean() must be called, or an error code if the
+ * entry is stale, corrupt or truncated
+ */
+int playlist_preparse_entry_Read( FILE *, const char *psz_uri,
+                                  uint64_t i_size, int64_t i_mtime,
+                                  playlist_preparse_entry_t * );
+
+/**
+ * This function releases the resources of a parsed entry.
+ */
+void playlist_preparse_entry_Clean( playlist_preparse_entry_t * );
+
+#endif
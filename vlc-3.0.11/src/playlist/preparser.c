@@ -29,12 +29,14 @@
 #include "input/input_interface.h"
 #include "input/input_internal.h"
 #include "preparser.h"
+#include "preparse_cache.h"
 #include "fetcher.h"
 
 struct playlist_preparser_t
 {
     vlc_object_t* owner;
     playlist_fetcher_t* fetcher;
+    playlist_preparse_cache_t* cache;
     struct background_worker* worker;
     atomic_bool deactivated;
 };
@@ -50,10 +52,31 @@ static int InputEvent( vlc_object_t* obj, const char* varname,
     return VLC_SUCCESS;
 }
 
+static void PreparserDone( playlist_preparser_t* preparser,
+                           input_item_t* item, int status )
+{
+    if( preparser->fetcher )
+    {
+        if( !playlist_fetcher_Push( preparser->fetcher, item, 0, status ) )
+            return;
+    }
+
+    input_item_SetPreparsed( item, true );
+    input_item_SignalPreparseEnded( item, status );
+}
+
 static int PreparserOpenInput( void* preparser_, void* item_, void** out )
 {
     playlist_preparser_t* preparser = preparser_;
 
+    /* On a cache hit, the item is done without starting any task */
+    if( preparser->cache
+     && !playlist_preparse_cache_Load( preparser->cache, item_ ) )
+    {
+        PreparserDone( preparser, item_, ITEM_PREPARSE_DONE );
+        return VLC_EGENERIC;
+    }
+
     input_thread_t* input = input_CreatePreparser( preparser->owner, item_ );
     if( !input )
     {
@@ -105,14 +128,10 @@ static void PreparserCloseInput( void* preparser_, void* input_ )
     input_Stop( input );
     input_Close( input );
 
-    if( preparser->fetcher )
-    {
-        if( !playlist_fetcher_Push( preparser->fetcher, item, 0, status ) )
-            return;
-    }
+    if( preparser->cache && status == ITEM_PREPARSE_DONE )
+        playlist_preparse_cache_Store( preparser->cache, item );
 
-    input_item_SetPreparsed( item, true );
-    input_item_SignalPreparseEnded( item, status );
+    PreparserDone( preparser, item, status );
 }
 
 static void InputItemRelease( void* item ) { input_item_Release( item ); }
@@ -124,6 +143,7 @@ playlist_preparser_t* playlist_preparser_New( vlc_object_t *parent )
 
     struct background_worker_config conf = {
         .default_timeout = var_InheritInteger( parent, "preparse-timeout" ),
+        .max_threads = var_InheritInteger( parent, "preparse-threads" ),
         .pf_start = PreparserOpenInput,
         .pf_probe = PreparserProbeInput,
         .pf_stop = PreparserCloseInput,
@@ -141,6 +161,7 @@ playlist_preparser_t* playlist_preparser_New( vlc_object_t *parent )
     }
 
     preparser->owner = parent;
+    preparser->cache = playlist_preparse_cache_New( parent );
     preparser->fetcher = playlist_fetcher_New( parent );
     atomic_init( &preparser->deactivated, false );
 
@@ -152,7 +173,7 @@ playlist_preparser_t* playlist_preparser_New( vlc_object_t *parent )
 
 void playlist_preparser_Push( playlist_preparser_t *preparser,
     input_item_t *item, input_item_meta_request_option_t i_options,
-    int timeout, void *id )
+    int timeout, void *id, bool b_urgent )
 {
     if( atomic_load( &preparser->deactivated ) )
         return;
@@ -175,7 +196,10 @@ void playlist_preparser_Push( playlist_preparser_t *preparser,
             return;
     }
 
-    if( background_worker_Push( preparser->worker, item, id, timeout ) )
+    int ret = b_urgent
+        ? background_worker_PushUrgent( preparser->worker, item, id, timeout )
+        : background_worker_Push( preparser->worker, item, id, timeout );
+    if( ret )
         input_item_SignalPreparseEnded( item, ITEM_PREPARSE_FAILED );
 }
 
@@ -203,6 +227,8 @@ void playlist_preparser_Delete( playlist_preparser_t *preparser )
 
     if( preparser->fetcher )
         playlist_fetcher_Delete( preparser->fetcher );
+    if( preparser->cache )
+        playlist_preparse_cache_Delete( preparser->cache );
 
     free( preparser );
 }
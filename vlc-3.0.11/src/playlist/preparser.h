@@ -53,10 +53,12 @@ playlist_preparser_t *playlist_preparser_New( vlc_object_t * );
  * indefinitely. If > 0, the timeout will be used (in milliseconds).
  * @param id unique id provided by the caller. This is can be used to cancel
  * the request with playlist_preparser_Cancel()
+ * @param b_urgent whether the item shall be preparsed before the non-urgent
+ * pending ones, e.g. because it is being shown
  */
 void playlist_preparser_Push( playlist_preparser_t *, input_item_t *,
                               input_item_meta_request_option_t,
-                              int timeout, void *id );
+                              int timeout, void *id, bool b_urgent );
 
 void playlist_preparser_fetcher_Push( playlist_preparser_t *, input_item_t *,
                                       input_item_meta_request_option_t );
@@ -0,0 +1,221 @@
+/*****************************************************************************
+ * background_worker.c: test src/misc/background_worker.c
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include "../misc/background_worker.h"
+
+#define CONCURRENT_TASKS 4
+
+static vlc_mutex_t lock = VLC_STATIC_MUTEX;
+static vlc_cond_t wait;
+
+static char trace[32]; /* names of the entities, in start order */
+static size_t trace_len;
+static bool gate_open;
+static unsigned running, max_running, started, stopped;
+static bool barrier_timeout;
+
+struct entity
+{
+    char name;
+    bool gate; /* the task lasts until the gate is opened */
+    bool barrier; /* the task starts once CONCURRENT_TASKS tasks started */
+};
+
+static void Reset(void)
+{
+    memset(trace, 0, sizeof (trace));
+    trace_len = 0;
+    gate_open = false;
+    running = max_running = started = stopped = 0;
+    barrier_timeout = false;
+}
+
+static void Hold(void *entity)
+{
+    (void) entity;
+}
+
+static void Release(void *entity)
+{
+    (void) entity;
+}
+
+static int Start(void *owner, void *data, void **out)
+{
+    struct entity *entity = data;
+
+    (void) owner;
+    vlc_mutex_lock(&lock);
+    assert(trace_len < sizeof (trace) - 1);
+    trace[trace_len++] = entity->name;
+    started++;
+    running++;
+    if (running > max_running)
+        max_running = running;
+    vlc_cond_broadcast(&wait);
+
+    if (entity->barrier)
+    {   /* Only returns if enough tasks really run at the same time */
+        mtime_t deadline = mdate() + 5 * CLOCK_FREQ;
+
+        while (started < CONCURRENT_TASKS)
+            if (vlc_cond_timedwait(&wait, &lock, deadline))
+            {
+                barrier_timeout = true;
+                break;
+            }
+    }
+    vlc_mutex_unlock(&lock);
+
+    *out = entity;
+    return VLC_SUCCESS;
+}
+
+static int Probe(void *owner, void *handle)
+{
+    struct entity *entity = handle;
+    int ret;
+
+    (void) owner;
+    vlc_mutex_lock(&lock);
+    ret = !entity->gate || gate_open;
+    vlc_mutex_unlock(&lock);
+    return ret;
+}
+
+static void Stop(void *owner, void *handle)
+{
+    (void) owner; (void) handle;
+    vlc_mutex_lock(&lock);
+    running--;
+    stopped++;
+    vlc_cond_broadcast(&wait);
+    vlc_mutex_unlock(&lock);
+}
+
+static struct background_worker *WorkerNew(int max_threads)
+{
+    struct background_worker_config conf = {
+        .default_timeout = 0,
+        .max_threads = max_threads,
+        .pf_release = Release,
+        .pf_hold = Hold,
+        .pf_start = Start,
+        .pf_probe = Probe,
+        .pf_stop = Stop,
+    };
+
+    struct background_worker *worker = background_worker_New(NULL, &conf);
+    assert(worker != NULL);
+    return worker;
+}
+
+static void WaitStopped(unsigned count)
+{
+    vlc_mutex_lock(&lock);
+    while (stopped < count)
+        vlc_cond_wait(&wait, &lock);
+    vlc_mutex_unlock(&lock);
+}
+
+static void test_urgent(void)
+{
+    struct background_worker *worker = WorkerNew(1);
+    struct entity gate = { '-', true, false };
+    struct entity a = { 'A', false, false }, b = { 'B', false, false },
+                  c = { 'C', false, false };
+    struct entity u = { 'U', false, false }, v = { 'V', false, false };
+
+    Reset();
+
+    /* Occupy the single thread, so that the others are queued */
+    assert(background_worker_Push(worker, &gate, NULL, -1) == VLC_SUCCESS);
+    vlc_mutex_lock(&lock);
+    while (started < 1)
+        vlc_cond_wait(&wait, &lock);
+    vlc_mutex_unlock(&lock);
+
+    assert(background_worker_Push(worker, &a, NULL, -1) == VLC_SUCCESS);
+    assert(background_worker_Push(worker, &b, NULL, -1) == VLC_SUCCESS);
+    assert(background_worker_PushUrgent(worker, &u, NULL, -1) == VLC_SUCCESS);
+    assert(background_worker_Push(worker, &c, NULL, -1) == VLC_SUCCESS);
+    assert(background_worker_PushUrgent(worker, &v, NULL, -1) == VLC_SUCCESS);
+
+    vlc_mutex_lock(&lock);
+    gate_open = true;
+    vlc_mutex_unlock(&lock);
+    background_worker_RequestProbe(worker);
+
+    /* Urgent entities run first, in their order, then the others */
+    WaitStopped(6);
+    printf("start order: %s\n", trace);
+    assert(!strcmp(trace, "-UVABC"));
+    assert(max_running == 1);
+
+    background_worker_Delete(worker);
+}
+
+static void test_concurrency(void)
+{
+    struct background_worker *worker = WorkerNew(CONCURRENT_TASKS);
+    struct entity entities[CONCURRENT_TASKS + 2];
+
+    Reset();
+    for (size_t i = 0; i < ARRAY_SIZE(entities); i++)
+    {
+        entities[i].name = 'a' + i;
+        entities[i].gate = false;
+        entities[i].barrier = true;
+        assert(background_worker_Push(worker, &entities[i], NULL, -1)
+               == VLC_SUCCESS);
+    }
+
+    /* Every task was started, and the first ones waited for each other:
+     * they did run concurrently, and never more than allowed */
+    WaitStopped(ARRAY_SIZE(entities));
+    printf("max running: %u\n", max_running);
+    assert(!barrier_timeout);
+    assert(max_running == CONCURRENT_TASKS);
+
+    background_worker_Delete(worker);
+}
+
+int main(void)
+{
+    alarm(20);
+    vlc_cond_init(&wait);
+
+    test_urgent();
+    test_concurrency();
+
+    vlc_cond_destroy(&wait);
+    return 0;
+}
@@ -86,11 +86,54 @@ static void test_block (void)
     //assert (block == NULL);
 }
 
+static void test_block_Share (void)
+{
+    block_t *block = block_Alloc (sizeof (text));
+    assert (block != NULL);
+    memcpy (block->p_buffer, text, sizeof (text));
+    block->i_pts = 42;
+
+    block = block_shared_Alloc (block);
+    assert (block != NULL);
+
+    block_t *dup = block_Share (block);
+    assert (dup != NULL);
+    assert (dup->p_buffer == block->p_buffer);
+    assert (dup->i_buffer == sizeof (text));
+    assert (dup->i_pts == 42);
+
+    /* metadata are per block */
+    dup->i_pts = 43;
+    assert (block->i_pts == 42);
+
+    /* copy on write */
+    dup = block_Realloc (dup, 1, sizeof (text));
+    assert (dup != NULL);
+    assert (dup->p_buffer + 1 != block->p_buffer);
+    dup->p_buffer[0] = '>';
+    assert (!memcmp (dup->p_buffer + 1, text, sizeof (text)));
+    assert (!memcmp (block->p_buffer, text, sizeof (text)));
+
+    dup = block_Unshare (dup);
+    assert (dup != NULL);
+    block_Release (dup);
+
+    /* sole owner: no copy needed */
+    dup = block_Share (block);
+    assert (dup != NULL);
+    block_Release (block);
+    block = block_Unshare (dup);
+    assert (block == dup);
+    assert (!memcmp (block->p_buffer, text, sizeof (text)));
+    block_Release (block);
+}
+
 int main (void)
 {
     test_block_File(false);
     test_block_File(true);
     test_block ();
+    test_block_Share ();
     return 0;
 }
 
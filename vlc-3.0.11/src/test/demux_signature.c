@@ -0,0 +1,110 @@
+/*****************************************************************************
+ * demux_signature.c: test src/input/demux_signature.h
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include "../input/demux_signature.h"
+
+static const struct {
+    const char *magic;
+    size_t length;
+    const char *name;
+} testcase[] = {
+    { "\x1A\x45\xDF\xA3\x01\x00", 6, "mkv" },
+    { "OggS\x00\x02", 6, "ogg" },
+    { "fLaC\x00\x00\x00\x22", 8, "flac" },
+    { "caff\x00\x01", 6, "caf" },
+    { "MPCK", 4, "mpc" },
+    { "MP+\x17", 4, "mpc" },
+    { "TTA1\x01\x00", 6, "tta" },
+    { ".snd\x00\x00\x00\x18", 8, "au" },
+    { "FORM\x00\x00\x10\x00" "AIFF", 12, "aiff" },
+    { "FORM\x00\x00\x10\x00" "AIFC", 12, "aiff" },
+    { "MThd\x00\x00\x00\x06", 8, "smf" },
+    { "Creative Voice File\x1A", 20, "voc" },
+    { "NSVf", 4, "nsv" },
+    { "NSVs", 4, "nsv" },
+
+    /* unknown contents */
+    { "RIFF\x24\x00\x00\x00WAVE", 12, NULL },
+    { "FORM\x00\x00\x10\x00" "8SVX", 12, NULL },
+    { "ID3\x04\x00", 5, NULL },
+    { "\x00\x00\x01\xBA", 4, NULL },
+    { "oggs", 4, NULL },
+
+    /* too short for the signature */
+    { "Ogg", 3, NULL },
+    { "FORM\x00\x00\x10\x00" "AIF", 11, NULL },
+    { "Creative Voice Fil", 18, NULL },
+    { "", 0, NULL },
+};
+
+static void test_transport_stream(void)
+{
+    uint8_t buf[3 * 188];
+
+    memset(buf, 0xff, sizeof(buf));
+    buf[0] = buf[188] = buf[2 * 188] = 0x47;
+    assert(!strcmp(demux_NameFromSignature(buf, sizeof(buf)), "ts"));
+
+    /* the third sync byte is needed */
+    assert(!strcmp(demux_NameFromSignature(buf, 2 * 188 + 1), "ts"));
+    assert(demux_NameFromSignature(buf, 2 * 188) == NULL);
+
+    /* all sync bytes are needed */
+    buf[188] = 0x00;
+    assert(demux_NameFromSignature(buf, sizeof(buf)) == NULL);
+}
+
+int main (void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(testcase); ++i)
+    {
+        /* pad with garbage, only the first bytes count */
+        uint8_t buf[64];
+        memset(buf, 0xAA, sizeof(buf));
+        memcpy(buf, testcase[i].magic, testcase[i].length);
+
+        const char *name = demux_NameFromSignature(buf, testcase[i].length);
+        printf("%zu: %s\n", i, name ? name : "(null)");
+        if (testcase[i].name == NULL)
+            assert(name == NULL);
+        else
+        {
+            assert(name != NULL);
+            assert(!strcmp(name, testcase[i].name));
+        }
+
+        if (testcase[i].length > 0 && testcase[i].name != NULL)
+            assert(!strcmp(demux_NameFromSignature(buf, sizeof(buf)),
+                           testcase[i].name));
+    }
+
+    test_transport_stream();
+    return 0;
+}
@@ -0,0 +1,268 @@
+/*****************************************************************************
+ * preparse_entry.c: test src/playlist/preparse_entry.c
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_input_item.h>
+#include <vlc_meta.h>
+#include <vlc_es.h>
+#include "../playlist/preparse_entry.h"
+
+#define TEST_URI   "file:///media/test.mkv"
+#define TEST_SIZE  UINT64_C(123456789)
+#define TEST_MTIME INT64_C(1600000000)
+#define TEST_TITLE "A\ttitle\nwith \\special\r characters"
+
+static void AddEs( input_item_t *item, const es_format_t *fmt )
+{
+    es_format_t *copy = malloc( sizeof( *copy ) );
+    assert( copy != NULL );
+    assert( es_format_Copy( copy, fmt ) == VLC_SUCCESS );
+    vlc_mutex_lock( &item->lock );
+    TAB_APPEND( item->i_es, item->es, copy );
+    vlc_mutex_unlock( &item->lock );
+}
+
+static input_item_t *CreateItem( void )
+{
+    input_item_t *item = input_item_NewExt( TEST_URI, "test", 42 * CLOCK_FREQ,
+                                            ITEM_TYPE_FILE, ITEM_LOCAL );
+    assert( item != NULL );
+
+    input_item_SetMeta( item, vlc_meta_Title, TEST_TITLE );
+    input_item_SetMeta( item, vlc_meta_Artist, "Artist" );
+    /* not stored: only available from an opened input */
+    input_item_SetMeta( item, vlc_meta_ArtworkURL, "attachment://cover.jpg" );
+    vlc_mutex_lock( &item->lock );
+    vlc_meta_AddExtra( item->p_meta, "extra\tname", "extra\nvalue" );
+    vlc_mutex_unlock( &item->lock );
+
+    es_format_t fmt;
+
+    es_format_Init( &fmt, VIDEO_ES, VLC_CODEC_H264 );
+    fmt.i_id = 1;
+    fmt.i_profile = 100;
+    fmt.i_level = 41;
+    fmt.video.i_width = fmt.video.i_visible_width = 1920;
+    fmt.video.i_height = 1088;
+    fmt.video.i_visible_height = 1080;
+    fmt.video.i_sar_num = fmt.video.i_sar_den = 1;
+    fmt.video.i_frame_rate = 24000;
+    fmt.video.i_frame_rate_base = 1001;
+    fmt.video.orientation = ORIENT_ROTATED_90;
+    AddEs( item, &fmt );
+    es_format_Clean( &fmt );
+
+    es_format_Init( &fmt, AUDIO_ES, VLC_CODEC_MP4A );
+    fmt.i_id = 2;
+    fmt.i_bitrate = 128000;
+    fmt.psz_language = strdup( "fre" );
+    fmt.psz_description = strdup( "Commentary\t(5.1)" );
+    fmt.audio.i_rate = 48000;
+    fmt.audio.i_channels = 6;
+    AddEs( item, &fmt );
+    es_format_Clean( &fmt );
+
+    es_format_Init( &fmt, SPU_ES, VLC_CODEC_SUBT );
+    fmt.i_id = 3;
+    fmt.subs.psz_encoding = strdup( "UTF-8" );
+    AddEs( item, &fmt );
+    es_format_Clean( &fmt );
+
+    return item;
+}
+
+static FILE *OpenEntry( const char *psz_entry, size_t i_length )
+{
+    FILE *file = tmpfile();
+    assert( file != NULL );
+    assert( fwrite( psz_entry, 1, i_length, file ) == i_length );
+    rewind( file );
+    return file;
+}
+
+static int ReadEntry( const char *psz_entry, size_t i_length,
+                      const char *psz_uri, uint64_t i_size, int64_t i_mtime,
+                      playlist_preparse_entry_t *entry )
+{
+    FILE *file = OpenEntry( psz_entry, i_length );
+    int ret = playlist_preparse_entry_Read( file, psz_uri, i_size, i_mtime,
+                                            entry );
+    fclose( file );
+    return ret;
+}
+
+static bool StrEqual( const char *a, const char *b )
+{
+    return a == NULL ? b == NULL : b != NULL && !strcmp( a, b );
+}
+
+static void test_roundtrip( const char *psz_entry, size_t i_length,
+                            input_item_t *item )
+{
+    playlist_preparse_entry_t entry;
+
+    assert( ReadEntry( psz_entry, i_length, TEST_URI, TEST_SIZE, TEST_MTIME,
+                       &entry ) == VLC_SUCCESS );
+
+    assert( entry.i_duration == 42 * CLOCK_FREQ );
+    assert( StrEqual( vlc_meta_Get( entry.p_meta, vlc_meta_Title ),
+                      TEST_TITLE ) );
+    assert( StrEqual( vlc_meta_Get( entry.p_meta, vlc_meta_Artist ),
+                      "Artist" ) );
+    assert( vlc_meta_Get( entry.p_meta, vlc_meta_ArtworkURL ) == NULL );
+    assert( StrEqual( vlc_meta_GetExtra( entry.p_meta, "extra\tname" ),
+                      "extra\nvalue" ) );
+
+    assert( entry.i_es == item->i_es );
+    for( int i = 0; i < entry.i_es; i++ )
+    {
+        const es_format_t *a = entry.es[i], *b = item->es[i];
+
+        assert( a->i_cat == b->i_cat );
+        assert( a->i_codec == b->i_codec );
+        assert( a->i_id == b->i_id );
+        assert( a->i_profile == b->i_profile );
+        assert( a->i_level == b->i_level );
+        assert( a->i_bitrate == b->i_bitrate );
+        assert( StrEqual( a->psz_language, b->psz_language ) );
+        assert( StrEqual( a->psz_description, b->psz_description ) );
+        switch( a->i_cat )
+        {
+            case VIDEO_ES:
+                assert( a->video.i_width == b->video.i_width );
+                assert( a->video.i_height == b->video.i_height );
+                assert( a->video.i_visible_width == b->video.i_visible_width );
+                assert( a->video.i_visible_height
+                        == b->video.i_visible_height );
+                assert( a->video.i_sar_num == b->video.i_sar_num );
+                assert( a->video.i_sar_den == b->video.i_sar_den );
+                assert( a->video.i_frame_rate == b->video.i_frame_rate );
+                assert( a->video.i_frame_rate_base
+                        == b->video.i_frame_rate_base );
+                assert( a->video.orientation == b->video.orientation );
+                break;
+            case AUDIO_ES:
+                assert( a->audio.i_rate == b->audio.i_rate );
+                assert( a->audio.i_channels == b->audio.i_channels );
+                break;
+            case SPU_ES:
+                assert( StrEqual( a->subs.psz_encoding,
+                                  b->subs.psz_encoding ) );
+                break;
+            default:
+                assert( 0 );
+        }
+    }
+    playlist_preparse_entry_Clean( &entry );
+}
+
+static void test_invalidation( const char *psz_entry, size_t i_length )
+{
+    playlist_preparse_entry_t entry;
+
+    /* The file changed, or another file has the same entry name */
+    assert( ReadEntry( psz_entry, i_length, TEST_URI, TEST_SIZE + 1,
+                       TEST_MTIME, &entry ) != VLC_SUCCESS );
+    assert( ReadEntry( psz_entry, i_length, TEST_URI, TEST_SIZE,
+                       TEST_MTIME + 1, &entry ) != VLC_SUCCESS );
+    assert( ReadEntry( psz_entry, i_length, "file:///media/other.mkv",
+                       TEST_SIZE, TEST_MTIME, &entry ) != VLC_SUCCESS );
+}
+
+static void test_truncated( const char *psz_entry, size_t i_length )
+{
+    playlist_preparse_entry_t entry;
+
+    for( size_t i = 0; i < i_length; i++ )
+        assert( ReadEntry( psz_entry, i, TEST_URI, TEST_SIZE, TEST_MTIME,
+                           &entry ) != VLC_SUCCESS );
+}
+
+/* Replaces the first occurrence of a string in the entry */
+static void test_corrupt_one( const char *psz_entry, const char *psz_from,
+                              const char *psz_to )
+{
+    const char *psz = strstr( psz_entry, psz_from );
+    assert( psz != NULL );
+
+    char *psz_corrupt;
+    int i_length = asprintf( &psz_corrupt, "%.*s%s%s",
+                             (int)( psz - psz_entry ), psz_entry, psz_to,
+                             psz + strlen( psz_from ) );
+    assert( i_length != -1 );
+
+    playlist_preparse_entry_t entry;
+    assert( ReadEntry( psz_corrupt, i_length, TEST_URI, TEST_SIZE,
+                       TEST_MTIME, &entry ) != VLC_SUCCESS );
+    free( psz_corrupt );
+}
+
+static void test_corrupt( const char *psz_entry )
+{
+    /* Another format, or another VLC version */
+    test_corrupt_one( psz_entry, "vlc-preparse-cache-", "vlc-preparse-cachf-" );
+    test_corrupt_one( psz_entry, PACKAGE_VERSION, "0.0.0" );
+
+    /* Invalid fields */
+    test_corrupt_one( psz_entry, "es\t1\t", "es\tx\t" );
+    test_corrupt_one( psz_entry, "es\t2\t", "es\t42\t" );
+    test_corrupt_one( psz_entry, "\t48000\t", "\t48000k\t" );
+    test_corrupt_one( psz_entry, "\t48000\t6", "\t48000" );
+    test_corrupt_one( psz_entry, "meta\t0\t", "meta\t1000\t" );
+    test_corrupt_one( psz_entry, "file\t", "fila\t" );
+    test_corrupt_one( psz_entry, "\nend\n", "\n" );
+}
+
+int main( void )
+{
+    input_item_t *item = CreateItem();
+    size_t i_length;
+    char *psz_entry = playlist_preparse_entry_Write( item, TEST_URI,
+                                                     TEST_SIZE, TEST_MTIME,
+                                                     &i_length );
+    assert( psz_entry != NULL );
+    assert( strlen( psz_entry ) == i_length );
+    printf( "%s", psz_entry );
+
+    test_roundtrip( psz_entry, i_length, item );
+    test_invalidation( psz_entry, i_length );
+    test_truncated( psz_entry, i_length );
+    test_corrupt( psz_entry );
+    free( psz_entry );
+    input_item_Release( item );
+
+    /* Items without elementary streams are not cached */
+    item = input_item_NewExt( TEST_URI, "test", -1, ITEM_TYPE_FILE,
+                              ITEM_LOCAL );
+    assert( item != NULL );
+    assert( playlist_preparse_entry_Write( item, TEST_URI, TEST_SIZE,
+                                           TEST_MTIME, &i_length ) == NULL );
+    input_item_Release( item );
+    return 0;
+}
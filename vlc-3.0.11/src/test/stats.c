@@ -0,0 +1,182 @@
+/*****************************************************************************
+ * stats.c: test src/input/stats.c
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include "../input/stats.c"
+
+/* More threads than shards, so that every shard gets used */
+#define THREADS    (2 * STATS_SHARDS)
+#define ITERATIONS 10000
+
+static counter_t *counter;
+
+static void *UpdateCounter( void *data )
+{
+    uint64_t value = (uintptr_t)data;
+
+    for( unsigned i = 0; i < ITERATIONS; i++ )
+        stats_Update( counter, value );
+    return NULL;
+}
+
+static void *UpdateHistogram( void *data )
+{
+    uint64_t value = (uintptr_t)data;
+
+    for( unsigned i = 0; i < ITERATIONS; i++ )
+        stats_Update( counter, value << ( i % 8 ) );
+    return NULL;
+}
+
+static void RunThreads( void *(*entry)( void * ) )
+{
+    vlc_thread_t threads[THREADS];
+
+    for( unsigned i = 0; i < THREADS; i++ )
+        assert( vlc_clone( &threads[i], entry, (void *)(uintptr_t)( i + 1 ),
+                           VLC_THREAD_PRIORITY_LOW ) == 0 );
+    for( unsigned i = 0; i < THREADS; i++ )
+        vlc_join( threads[i], NULL );
+}
+
+static void test_layout( int type, unsigned values )
+{
+    counter_t *c = stats_CounterCreate( type );
+    assert( c != NULL );
+
+    /* Every shard starts on its own cache line */
+    assert( c->i_stride >= values );
+    assert( c->i_stride * sizeof( c->values[0] ) % STATS_CACHE_LINE == 0 );
+    stats_CounterClean( c );
+}
+
+static void test_counter( void )
+{
+    counter = stats_CounterCreate( STATS_COUNTER );
+    assert( counter != NULL );
+    assert( stats_GetTotal( counter ) == 0 );
+
+    RunThreads( UpdateCounter );
+
+    /* No update is lost, whatever the shard */
+    uint64_t expected = 0;
+    for( unsigned i = 0; i < THREADS; i++ )
+        expected += (uint64_t)( i + 1 ) * ITERATIONS;
+    printf( "total: %"PRIu64"\n", (uint64_t)stats_GetTotal( counter ) );
+    assert( (uint64_t)stats_GetTotal( counter ) == expected );
+
+    /* The threads were spread over all the shards */
+    for( unsigned i = 0; i < STATS_SHARDS; i++ )
+        assert( atomic_load( &counter->values[i * counter->i_stride] ) > 0 );
+
+    stats_CounterClean( counter );
+}
+
+static unsigned BucketOf( uint64_t value )
+{
+    uint64_t buckets[STATS_BUCKETS];
+    unsigned index = STATS_BUCKETS;
+
+    counter_t *c = stats_CounterCreate( STATS_HISTOGRAM );
+    assert( c != NULL );
+    stats_Update( c, value );
+    stats_GetHistogram( c, buckets );
+    stats_CounterClean( c );
+
+    for( unsigned i = 0; i < STATS_BUCKETS; i++ )
+        if( buckets[i] != 0 )
+        {
+            assert( buckets[i] == 1 );
+            assert( index == STATS_BUCKETS );
+            index = i;
+        }
+    assert( index < STATS_BUCKETS );
+    return index;
+}
+
+static void test_buckets( void )
+{
+    /* The first bucket also counts 0 */
+    assert( BucketOf( 0 ) == 0 );
+    assert( BucketOf( 1 ) == 0 );
+    assert( BucketOf( 2 ) == 1 );
+    assert( BucketOf( 3 ) == 1 );
+    assert( BucketOf( 4 ) == 2 );
+    assert( BucketOf( 1000 ) == 9 );
+    assert( BucketOf( 1024 ) == 10 );
+
+    /* Bucket n counts [2^n, 2^(n+1)[ */
+    for( unsigned i = 1; i < STATS_BUCKETS - 1; i++ )
+    {
+        assert( BucketOf( UINT64_C(1) << i ) == i );
+        assert( BucketOf( ( UINT64_C(1) << ( i + 1 ) ) - 1 ) == i );
+    }
+
+    /* The last bucket is open-ended */
+    assert( BucketOf( UINT64_C(1) << ( STATS_BUCKETS - 1 ) )
+            == STATS_BUCKETS - 1 );
+    assert( BucketOf( UINT64_C(1) << 40 ) == STATS_BUCKETS - 1 );
+    assert( BucketOf( UINT64_MAX ) == STATS_BUCKETS - 1 );
+
+    /* No histogram: all zeroes */
+    uint64_t buckets[STATS_BUCKETS];
+    stats_GetHistogram( NULL, buckets );
+    for( unsigned i = 0; i < STATS_BUCKETS; i++ )
+        assert( buckets[i] == 0 );
+}
+
+static void test_histogram( void )
+{
+    uint64_t buckets[STATS_BUCKETS], expected[STATS_BUCKETS] = { 0 };
+
+    counter = stats_CounterCreate( STATS_HISTOGRAM );
+    assert( counter != NULL );
+
+    RunThreads( UpdateHistogram );
+
+    for( unsigned i = 0; i < THREADS; i++ )
+        for( unsigned j = 0; j < 8; j++ )
+            expected[BucketOf( (uint64_t)( i + 1 ) << j )] += ITERATIONS / 8;
+
+    stats_GetHistogram( counter, buckets );
+    for( unsigned i = 0; i < STATS_BUCKETS; i++ )
+        assert( buckets[i] == expected[i] );
+
+    stats_CounterClean( counter );
+}
+
+int main( void )
+{
+    test_layout( STATS_COUNTER, 1 );
+    test_layout( STATS_HISTOGRAM, STATS_BUCKETS );
+
+    test_counter();
+    test_buckets();
+    test_histogram();
+    return 0;
+}
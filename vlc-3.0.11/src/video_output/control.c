@@ -28,6 +28,7 @@
 #include <vlc_common.h>
 #include <vlc_vout.h>
 #include "control.h"
+#include "../input/trace.h"
 
 /* */
 void vout_control_cmd_Init(vout_control_cmd_t *cmd, int type)
@@ -49,6 +50,10 @@ void vout_control_cmd_Clean(vout_control_cmd_t *cmd)
     case VOUT_CONTROL_CHANGE_SUB_FILTERS:
         free(cmd->u.string);
         break;
+    case VOUT_CONTROL_TRACE:
+        if (cmd->u.trace)
+            es_trace_Release(cmd->u.trace);
+        break;
     default:
         break;
     }
@@ -31,12 +31,19 @@
 typedef struct {
     atomic_uint displayed;
     atomic_uint lost;
+
+    /* Subpicture regions blended from the SPU cache or (re)rendered,
+     * cumulative over the vout lifetime */
+    atomic_uint spu_cached;
+    atomic_uint spu_rendered;
 } vout_statistic_t;
 
 static inline void vout_statistic_Init(vout_statistic_t *stat)
 {
     atomic_init(&stat->displayed, 0);
     atomic_init(&stat->lost, 0);
+    atomic_init(&stat->spu_cached, 0);
+    atomic_init(&stat->spu_rendered, 0);
 }
 
 static inline void vout_statistic_Clean(vout_statistic_t *stat)
@@ -63,4 +70,21 @@ static inline void vout_statistic_AddLost(vout_statistic_t *stat, int lost)
     atomic_fetch_add(&stat->lost, lost);
 }
 
+static inline void vout_statistic_AddSpu(vout_statistic_t *stat,
+                                         unsigned cached, unsigned rendered)
+{
+    if (cached)
+        atomic_fetch_add(&stat->spu_cached, cached);
+    if (rendered)
+        atomic_fetch_add(&stat->spu_rendered, rendered);
+}
+
+static inline void vout_statistic_GetSpu(vout_statistic_t *stat,
+                                         unsigned *restrict cached,
+                                         unsigned *restrict rendered)
+{
+    *cached   = atomic_load(&stat->spu_cached);
+    *rendered = atomic_load(&stat->spu_rendered);
+}
+
 #endif
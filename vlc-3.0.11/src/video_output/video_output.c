@@ -274,6 +274,13 @@ void vout_Close(vout_thread_t *vout)
     if (vout->p->window != NULL)
         vout_display_window_Delete(vout->p->window);
 
+    unsigned spu_cached, spu_rendered;
+    vout_statistic_GetSpu(&vout->p->statistic, &spu_cached, &spu_rendered);
+    if (spu_cached + spu_rendered > 0)
+        msg_Dbg(vout, "subpicture regions: %u blended from cache, %u rendered "
+                "(%u%% hit rate)", spu_cached, spu_rendered,
+                (unsigned)(100ULL * spu_cached / (spu_cached + spu_rendered)));
+
     vlc_mutex_lock(&vout->p->spu_lock);
     spu_Destroy(vout->p->spu);
     vout->p->spu = NULL;
@@ -294,6 +301,8 @@ static void VoutDestructor(vlc_object_t *object)
     vlc_mutex_destroy(&vout->p->spu_lock);
     vlc_mutex_destroy(&vout->p->filter.lock);
     vout_control_Clean(&vout->p->control);
+    if (vout->p->trace.es)
+        es_trace_Release(vout->p->trace.es);
 
     /* */
     vout_statistic_Clean(&vout->p->statistic);
@@ -566,6 +575,14 @@ void vout_ControlChangeViewpoint(vout_thread_t *vout,
     vout_control_Push(&vout->p->control, &cmd);
 }
 
+void vout_SetTrace(vout_thread_t *vout, es_trace_t *trace)
+{
+    vout_control_cmd_t cmd;
+    vout_control_cmd_Init(&cmd, VOUT_CONTROL_TRACE);
+    cmd.u.trace = trace ? es_trace_Hold(trace) : NULL;
+    vout_control_Push(&vout->p->control, &cmd);
+}
+
 /* */
 static void VoutGetDisplayCfg(vout_thread_t *vout, vout_display_cfg_t *cfg, const char *title)
 {
@@ -1176,6 +1193,12 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
 
     /* Display the direct buffer returned by vout_RenderPicture */
     vout->p->displayed.date = mdate();
+    if (vout->p->trace.es && vout->p->trace.date != todisplay->date) {
+        /* Only the first display of a picture, not its redisplays */
+        vout->p->trace.date = todisplay->date;
+        es_trace_Add(vout->p->trace.es, ES_TRACE_DISPLAY, VLC_TS_INVALID,
+                     todisplay->date);
+    }
     vout_display_Display(vd, todisplay, subpic);
 
     vout_statistic_AddDisplayed(&vout->p->statistic, 1);
@@ -1773,6 +1796,13 @@ static int ThreadControl(vout_thread_t *vout, vout_control_cmd_t cmd)
     case VOUT_CONTROL_VIEWPOINT:
         ThreadExecuteViewpoint(vout, &cmd.u.viewpoint);
         break;
+    case VOUT_CONTROL_TRACE:
+        if (vout->p->trace.es)
+            es_trace_Release(vout->p->trace.es);
+        vout->p->trace.es   = cmd.u.trace;
+        vout->p->trace.date = VLC_TS_INVALID;
+        cmd.u.trace = NULL;
+        break;
     default:
         break;
     }
@@ -25,6 +25,8 @@
 #ifndef LIBVLC_VOUT_CONTROL_H
 #define LIBVLC_VOUT_CONTROL_H 1
 
+#include "../input/trace.h"
+
 typedef struct vout_window_mouse_event_t vout_window_mouse_event_t;
 
 /**
@@ -74,4 +76,10 @@ void vout_WindowMouseEvent( vout_thread_t *p_vout,
  */
 bool vout_IsEmpty( vout_thread_t *p_vout );
 
+/**
+ * This function will set the latency trace of the displayed pictures.
+ * The trace is held by the video output until it is replaced.
+ */
+void vout_SetTrace( vout_thread_t *p_vout, es_trace_t *p_trace );
+
 #endif
@@ -92,6 +92,12 @@ struct vout_thread_sys_t
         picture_t   *next;
     } displayed;
 
+    /* Latency trace */
+    struct {
+        es_trace_t  *es;
+        mtime_t     date;
+    } trace;
+
     struct {
         mtime_t     last;
         mtime_t     timestamp;
@@ -653,9 +653,15 @@ static void SpuSelectSubpictures(spu_t *spu,
 
 /**
  * It will transform the provided region into another region suitable for rendering.
+ *
+ * The rendered text and the scaled/converted picture are kept within the
+ * source region (region->fmt and region->p_private), so an unchanged region
+ * is blended straight from that cache on the following frames; *is_cached
+ * tells whether this happened.
  */
 static void SpuRenderRegion(spu_t *spu,
                             subpicture_region_t **dst_ptr, spu_area_t *dst_area,
+                            bool *is_cached,
                             subpicture_t *subpic, subpicture_region_t *region,
                             const spu_scale_t scale_size,
                             const vlc_fourcc_t *chroma_list,
@@ -676,9 +682,12 @@ static void SpuRenderRegion(spu_t *spu,
     /* Invalidate area by default */
     *dst_area = spu_area_create(0,0, 0,0, scale_size);
     *dst_ptr  = NULL;
+    *is_cached = true;
 
     /* Render text region */
     if (region->fmt.i_chroma == VLC_CODEC_TEXT) {
+        *is_cached = false;
+
         // assume rendered text is in sRGB if nothing is set
         if (region->fmt.transfer == TRANSFER_FUNC_UNDEF)
             region->fmt.transfer = TRANSFER_FUNC_SRGB;
@@ -841,6 +850,8 @@ static void SpuRenderRegion(spu_t *spu,
         if (!region->p_private && dst_width > 0 && dst_height > 0) {
             filter_t *scale = sys->scale;
 
+            *is_cached = false;
+
             picture_t *picture = region->p_picture;
             picture_Hold(picture);
 
@@ -961,14 +972,13 @@ static void SpuRenderRegion(spu_t *spu,
         }
     }
 
-    subpicture_region_t *dst = *dst_ptr = subpicture_region_New(&region_fmt);
+    /* The output region only references the (possibly cached) picture */
+    subpicture_region_t *dst = *dst_ptr = subpicture_region_NewRef(&region_fmt,
+                                                                   region_picture);
     if (dst) {
         dst->i_x       = x_offset;
         dst->i_y       = y_offset;
         dst->i_align   = 0;
-        if (dst->p_picture)
-            picture_Release(dst->p_picture);
-        dst->p_picture = picture_Hold(region_picture);
         int fade_alpha = 255;
         if (subpic->b_fade) {
             mtime_t fade_start = subpic->i_start + 3 * (subpic->i_stop - subpic->i_start) / 4;
@@ -1039,6 +1049,9 @@ static subpicture_t *SpuRenderSubpictures(spu_t *spu,
     output->i_original_picture_height = fmt_dst->i_visible_height;
     subpicture_region_t **output_last_ptr = &output->p_region;
 
+    unsigned cached_count   = 0;
+    unsigned rendered_count = 0;
+
     /* Allocate area array for subtitle overlap */
     spu_area_t subtitle_area_buffer[VOUT_MAX_SUBPICTURES];
     spu_area_t *subtitle_area;
@@ -1086,6 +1099,7 @@ static subpicture_t *SpuRenderSubpictures(spu_t *spu,
          */
         for (region = subpic->p_region; region != NULL; region = region->p_next) {
             spu_area_t area;
+            bool is_cached;
 
             /* Compute region scale AR */
             video_format_t region_fmt = region->fmt;
@@ -1114,13 +1128,17 @@ static subpicture_t *SpuRenderSubpictures(spu_t *spu,
                 continue;
 
             /* */
-            SpuRenderRegion(spu, output_last_ptr, &area,
+            SpuRenderRegion(spu, output_last_ptr, &area, &is_cached,
                             subpic, region, scale,
                             chroma_list, fmt_dst,
                             subtitle_area, subtitle_area_count,
                             subpic->b_subtitle ? render_subtitle_date : render_osd_date);
             if (*output_last_ptr)
                 output_last_ptr = &(*output_last_ptr)->p_next;
+            if (is_cached)
+                cached_count++;
+            else
+                rendered_count++;
 
             if (subpic->b_subtitle) {
                 area = spu_area_unscaled(area, scale);
@@ -1140,6 +1158,10 @@ static subpicture_t *SpuRenderSubpictures(spu_t *spu,
     if (subtitle_area != subtitle_area_buffer)
         free(subtitle_area);
 
+    if (sys->vout)
+        vout_statistic_AddSpu(&sys->vout->p->statistic,
+                              cached_count, rendered_count);
+
     return output;
 }
 
@@ -190,6 +190,60 @@ static void test_media_player_pause_stop(const char** argv, int argc)
     libvlc_release (vlc);
 }
 
+static void test_media_player_standby(const char** argv, int argc)
+{
+    libvlc_instance_t *vlc;
+    libvlc_media_t *md, *md_standby, *md_sout;
+    libvlc_media_player_t *mi;
+    const char * file = test_default_sample;
+
+    log ("Testing warm standby of %s\n", file);
+
+    vlc = libvlc_new (argc, argv);
+    assert (vlc != NULL);
+
+    md = libvlc_media_new_path (vlc, file);
+    assert (md != NULL);
+    md_standby = libvlc_media_new_path (vlc, file);
+    assert (md_standby != NULL);
+    md_sout = libvlc_media_new_path (vlc, file);
+    assert (md_sout != NULL);
+    libvlc_media_add_option (md_sout, ":sout=#dummy");
+
+    mi = libvlc_media_player_new_from_media (md);
+    assert (mi != NULL);
+
+    /* Add, twice, and remove a standby media while nothing is playing */
+    assert (libvlc_media_player_add_standby (mi, md_standby) == 0);
+    assert (libvlc_media_player_add_standby (mi, md_standby) == 0);
+    libvlc_media_player_remove_standby (mi, md_standby);
+    libvlc_media_player_remove_standby (mi, md_standby); /* no-op */
+
+    /* Stream outputs are refused */
+    assert (libvlc_media_player_add_standby (mi, md_sout) == -1);
+
+    libvlc_media_player_play (mi);
+    log ("Waiting for playing\n");
+    wait_playing (mi);
+
+    /* Switch to a standby media while playing */
+    assert (libvlc_media_player_add_standby (mi, md_standby) == 0);
+    libvlc_media_player_set_media (mi, md_standby);
+    libvlc_media_player_play (mi);
+    log ("Waiting for playing the standby media\n");
+    wait_playing (mi);
+
+    /* The standby media was consumed, the previous one can be added back */
+    libvlc_media_player_remove_standby (mi, md_standby); /* no-op */
+    assert (libvlc_media_player_add_standby (mi, md) == 0);
+
+    libvlc_media_player_stop (mi);
+    libvlc_media_player_release (mi);
+    libvlc_media_release (md_sout);
+    libvlc_media_release (md_standby);
+    libvlc_media_release (md);
+    libvlc_release (vlc);
+}
 
 int main (void)
 {
@@ -198,6 +252,7 @@ int main (void)
     test_media_player_set_media (test_defaults_args, test_defaults_nargs);
     test_media_player_play_stop (test_defaults_args, test_defaults_nargs);
     test_media_player_pause_stop (test_defaults_args, test_defaults_nargs);
+    test_media_player_standby (test_defaults_args, test_defaults_nargs);
 
     return 0;
 }
@@ -0,0 +1,261 @@
+/*****************************************************************************
+ * livehttp.c: HTTP Live Streaming in-memory origin test
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Feeds a constant bit rate stream to the livehttp access output serving
+ * from memory, then checks the index and the (partial) segments served.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_sout.h>
+
+#include "../../libvlc/test.h"
+#include "../../../lib/libvlc_internal.h"
+
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define TEST_PORT      18082
+#define TEST_INDEX     "/live.m3u8"
+#define TEST_SEGMENT   "/live.ts"
+#define BLOCK_SIZE     (7 * 188)
+#define BLOCK_LENGTH   (CLOCK_FREQ / 25)
+#define BLOCK_COUNT    250 /* 10 seconds */
+#define GOP_BLOCKS     25  /* one keyframe per second */
+#define PART_LENGTH_MS 200 /* 5 blocks */
+
+struct answer
+{
+    int      i_status;
+    char     psz_range[64];
+    uint8_t *p_body;
+    size_t   i_body;
+};
+
+/* Sends one HTTP/1.0 request and reads the answer until the server closes */
+static void Request( const char *psz_url, const char *psz_range,
+                     struct answer *ans )
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons( TEST_PORT ),
+    };
+    addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+
+    int fd = socket( AF_INET, SOCK_STREAM, 0 );
+    assert( fd != -1 );
+    assert( connect( fd, (struct sockaddr *)&addr, sizeof(addr) ) == 0 );
+
+    char req[256];
+    int i_req;
+    if( psz_range != NULL )
+        i_req = snprintf( req, sizeof(req), "GET %s HTTP/1.0\r\n"
+                          "Range: %s\r\n\r\n", psz_url, psz_range );
+    else
+        i_req = snprintf( req, sizeof(req), "GET %s HTTP/1.0\r\n\r\n",
+                          psz_url );
+    assert( write( fd, req, i_req ) == i_req );
+
+    size_t i_size = BLOCK_SIZE * BLOCK_COUNT, i_total = 0;
+    char *p_data = malloc( i_size + 1 );
+    assert( p_data != NULL );
+    for( ;; )
+    {
+        assert( i_total < i_size );
+        ssize_t i_read = read( fd, p_data + i_total, i_size - i_total );
+        assert( i_read >= 0 );
+        if( i_read == 0 )
+            break;
+        i_total += i_read;
+    }
+    close( fd );
+    p_data[i_total] = '\0';
+
+    char *psz_eoh = strstr( p_data, "\r\n\r\n" );
+    assert( psz_eoh != NULL );
+    *psz_eoh = '\0';
+    assert( sscanf( p_data, "HTTP/1.%*d %d", &ans->i_status ) == 1 );
+
+    const char *psz = strstr( p_data, "\r\nContent-Range: " );
+    ans->psz_range[0] = '\0';
+    if( psz != NULL )
+        sscanf( psz + 17, "%63[^\r]", ans->psz_range );
+    psz = strstr( p_data, "\r\nContent-Length: " );
+    assert( psz != NULL );
+
+    ans->i_body = p_data + i_total - ( psz_eoh + 4 );
+    assert( ans->i_body == strtoull( psz + 18, NULL, 10 ) );
+    ans->p_body = malloc( ans->i_body + 1 );
+    assert( ans->p_body != NULL );
+    memcpy( ans->p_body, psz_eoh + 4, ans->i_body );
+    ans->p_body[ans->i_body] = '\0';
+    free( p_data );
+}
+
+/* The stream bytes count modulo a prime, so that any slice can be checked */
+static void CheckStreamBytes( const uint8_t *p, size_t i_size )
+{
+    for( size_t i = 1; i < i_size; i++ )
+        assert( p[i] == ( p[i - 1] + 1 ) % 251 );
+}
+
+struct part
+{
+    unsigned i_duration_ms;
+    char     psz_uri[64];
+    size_t   i_size;
+    size_t   i_offset;
+};
+
+static void test_index( void )
+{
+    struct answer index;
+
+    Request( TEST_INDEX, NULL, &index );
+    assert( index.i_status == 200 );
+    log( "index:\n%s", (char *)index.p_body );
+
+    /* No part is longer than the part target, which is the part length */
+    assert( strstr( (char *)index.p_body,
+                    "#EXT-X-PART-INF:PART-TARGET=0.200\n" ) != NULL );
+
+    struct part prev = { .i_offset = 0 };
+    unsigned i_parts = 0;
+    for( const char *psz = strstr( (char *)index.p_body, "#EXT-X-PART:" );
+         psz != NULL; psz = strstr( psz + 1, "#EXT-X-PART:" ) )
+    {
+        struct part part;
+        unsigned i_sec, i_msec;
+
+        assert( sscanf( psz, "#EXT-X-PART:DURATION=%u.%u,URI=\"%63[^\"]\","
+                        "BYTERANGE=\"%zu@%zu\"", &i_sec, &i_msec,
+                        part.psz_uri, &part.i_size, &part.i_offset ) == 5 );
+        part.i_duration_ms = i_sec * 1000 + i_msec;
+        assert( part.i_duration_ms > 0 );
+        assert( part.i_duration_ms <= PART_LENGTH_MS );
+        assert( part.i_size > 0 && part.i_size % BLOCK_SIZE == 0 );
+
+        /* Parts of a segment follow each other */
+        if( i_parts > 0 && !strcmp( part.psz_uri, prev.psz_uri ) )
+            assert( part.i_offset == prev.i_offset + prev.i_size );
+        else
+            assert( part.i_offset == 0 );
+
+        /* A part is a byte range of its segment */
+        char psz_range[64];
+        struct answer ans;
+        snprintf( psz_range, sizeof(psz_range), "bytes=%zu-%zu",
+                  part.i_offset, part.i_offset + part.i_size - 1 );
+        Request( part.psz_uri, psz_range, &ans );
+        assert( ans.i_status == 206 );
+        assert( ans.i_body == part.i_size );
+        CheckStreamBytes( ans.p_body, ans.i_body );
+        free( ans.p_body );
+
+        prev = part;
+        i_parts++;
+    }
+    assert( i_parts > 0 );
+
+    /* Complete segments are served whole, not beyond their end */
+    const char *psz = strstr( (char *)index.p_body, "#EXTINF:" );
+    assert( psz != NULL );
+    psz = strchr( psz, '\n' ) + 1;
+    char psz_uri[64];
+    assert( sscanf( psz, "%63[^\n]", psz_uri ) == 1 );
+
+    struct answer ans;
+    Request( psz_uri, NULL, &ans );
+    assert( ans.i_status == 200 );
+    assert( ans.i_body > 0 && ans.i_body % BLOCK_SIZE == 0 );
+    CheckStreamBytes( ans.p_body, ans.i_body );
+    size_t i_segment = ans.i_body;
+    free( ans.p_body );
+
+    char psz_range[64], psz_expected[64];
+    snprintf( psz_range, sizeof(psz_range), "bytes=%zu-", i_segment );
+    snprintf( psz_expected, sizeof(psz_expected), "bytes */%zu", i_segment );
+    Request( psz_uri, psz_range, &ans );
+    assert( ans.i_status == 416 );
+    assert( !strcmp( ans.psz_range, psz_expected ) );
+    free( ans.p_body );
+
+    Request( TEST_SEGMENT "?seq=100000", NULL, &ans );
+    assert( ans.i_status == 404 );
+    free( ans.p_body );
+
+    free( index.p_body );
+}
+
+int main( void )
+{
+    char psz_port[32];
+
+    test_init();
+    snprintf( psz_port, sizeof(psz_port), "--http-port=%d", TEST_PORT );
+
+    const char * const args[] = {
+        "-v",
+        "--ignore-config",
+        "-I",
+        "dummy",
+        "--no-media-library",
+        "--http-host=127.0.0.1",
+        psz_port,
+    };
+
+    libvlc_instance_t *vlc = libvlc_new( ARRAY_SIZE(args), args );
+    assert( vlc != NULL );
+
+    sout_access_out_t *access =
+        sout_AccessOutNew( vlc->p_libvlc_int,
+                           "livehttp{http,seglen=2,numsegs=3,"
+                           "index=" TEST_INDEX ",part-length=200}",
+                           TEST_SEGMENT );
+    assert( access != NULL );
+
+    unsigned i_byte = 0;
+    for( unsigned i = 0; i < BLOCK_COUNT; i++ )
+    {
+        block_t *block = block_Alloc( BLOCK_SIZE );
+        assert( block != NULL );
+        for( size_t j = 0; j < BLOCK_SIZE; j++ )
+            block->p_buffer[j] = i_byte++ % 251;
+        block->i_dts = block->i_pts = VLC_TS_0 + i * BLOCK_LENGTH;
+        block->i_length = BLOCK_LENGTH;
+        if( i % GOP_BLOCKS == 0 )
+            block->i_flags |= BLOCK_FLAG_HEADER;
+        assert( sout_AccessOutWrite( access, block ) >= 0 );
+    }
+
+    /* The last segment is still being filled: it is only listed as parts */
+    test_index();
+
+    sout_AccessOutDelete( access );
+    libvlc_release( vlc );
+    return 0;
+}
@@ -0,0 +1,324 @@
+/*****************************************************************************
+ * executor.c test the bounded pool of worker threads
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#include "../../libvlc/test.h"
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <vlc_common.h>
+#include <vlc_executor.h>
+#include <assert.h>
+#include <string.h>
+
+static vlc_mutex_t lock = VLC_STATIC_MUTEX;
+static vlc_cond_t wait;
+
+static bool gate_open; /* the gate task may return */
+static bool released; /* the blocked tasks may return */
+static unsigned entered; /* number of tasks started */
+static unsigned done; /* number of tasks completed */
+static char trace[32]; /* names of the tasks, in run order */
+static size_t trace_len;
+
+struct task
+{
+    struct vlc_runnable runnable;
+    struct vlc_executor *executor;
+    char name;
+    unsigned rounds; /* number of times the task submits itself again */
+    bool blocking;
+};
+
+static void Reset( void )
+{
+    gate_open = false;
+    released = false;
+    entered = 0;
+    done = 0;
+    trace_len = 0;
+    memset( trace, 0, sizeof( trace ) );
+}
+
+static void TaskInit( struct task *task, struct vlc_executor *executor,
+                      char name, void (*pf_run)( void * ) )
+{
+    task->runnable.pf_run = pf_run;
+    task->runnable.data = task;
+    task->executor = executor;
+    task->name = name;
+    task->rounds = 0;
+    task->blocking = false;
+}
+
+static void TaskDone( void )
+{
+    done++;
+    vlc_cond_broadcast( &wait );
+}
+
+static void WaitDone( unsigned count )
+{
+    vlc_mutex_lock( &lock );
+    while( done < count )
+        vlc_cond_wait( &wait, &lock );
+    vlc_mutex_unlock( &lock );
+}
+
+/* Occupies the thread (without blocking it) until the gate is opened, so
+ * that the other tasks get queued in a known order */
+static void RunGate( void *data )
+{
+    (void) data;
+    vlc_mutex_lock( &lock );
+    while( !gate_open )
+        vlc_cond_wait( &wait, &lock );
+    TaskDone();
+    vlc_mutex_unlock( &lock );
+}
+
+static void OpenGate( void )
+{
+    vlc_mutex_lock( &lock );
+    gate_open = true;
+    vlc_cond_broadcast( &wait );
+    vlc_mutex_unlock( &lock );
+}
+
+static void RunTrace( void *data )
+{
+    struct task *task = data;
+
+    vlc_mutex_lock( &lock );
+    assert( trace_len < sizeof( trace ) - 1 );
+    trace[trace_len++] = task->name;
+    if( task->rounds > 0 )
+    {   /* Yield to the queued tasks */
+        task->rounds--;
+        vlc_mutex_unlock( &lock );
+        int ret = vlc_executor_Submit( task->executor, &task->runnable );
+        assert( ret == VLC_SUCCESS );
+        return;
+    }
+    TaskDone();
+    vlc_mutex_unlock( &lock );
+}
+
+static void RunBlocked( void *data )
+{
+    struct task *task = data;
+
+    vlc_mutex_lock( &lock );
+    entered++;
+    vlc_cond_broadcast( &wait );
+    if( task->blocking )
+        vlc_executor_BlockingBegin();
+    while( !released )
+        vlc_cond_wait( &wait, &lock );
+    if( task->blocking )
+        vlc_executor_BlockingEnd();
+    TaskDone();
+    vlc_mutex_unlock( &lock );
+}
+
+static void RunRelease( void *data )
+{
+    (void) data;
+    vlc_mutex_lock( &lock );
+    released = true;
+    TaskDone();
+    vlc_mutex_unlock( &lock );
+}
+
+static void test_order( void )
+{
+    struct vlc_executor *executor = vlc_executor_New( 1, 0,
+                                                      VLC_THREAD_PRIORITY_LOW );
+    assert( executor != NULL );
+
+    struct task gate, tasks[10];
+
+    Reset();
+    TaskInit( &gate, executor, '-', RunGate );
+    assert( vlc_executor_Submit( executor, &gate.runnable ) == VLC_SUCCESS );
+    for( size_t i = 0; i < ARRAY_SIZE( tasks ); i++ )
+    {
+        TaskInit( &tasks[i], executor, '0' + i, RunTrace );
+        assert( vlc_executor_Submit( executor,
+                                     &tasks[i].runnable ) == VLC_SUCCESS );
+    }
+    OpenGate();
+
+    WaitDone( 1 + ARRAY_SIZE( tasks ) );
+    assert( !strcmp( trace, "0123456789" ) );
+
+    vlc_executor_Delete( executor );
+}
+
+static void test_yield( void )
+{
+    struct vlc_executor *executor = vlc_executor_New( 1, 0,
+                                                      VLC_THREAD_PRIORITY_LOW );
+    assert( executor != NULL );
+
+    struct task gate, a, b, c;
+
+    Reset();
+    TaskInit( &gate, executor, '-', RunGate );
+    TaskInit( &a, executor, 'A', RunTrace );
+    TaskInit( &b, executor, 'B', RunTrace );
+    TaskInit( &c, executor, 'C', RunTrace );
+    a.rounds = 2;
+
+    assert( vlc_executor_Submit( executor, &gate.runnable ) == VLC_SUCCESS );
+    assert( vlc_executor_Submit( executor, &a.runnable ) == VLC_SUCCESS );
+    assert( vlc_executor_Submit( executor, &b.runnable ) == VLC_SUCCESS );
+    assert( vlc_executor_Submit( executor, &c.runnable ) == VLC_SUCCESS );
+    OpenGate();
+
+    /* A task submitting itself goes back to the end of the queue */
+    WaitDone( 4 );
+    assert( !strcmp( trace, "ABCAA" ) );
+
+    vlc_executor_Delete( executor );
+}
+
+static void test_blocking( void )
+{
+    struct vlc_executor *executor = vlc_executor_New( 1, 1,
+                                                      VLC_THREAD_PRIORITY_LOW );
+    assert( executor != NULL );
+
+    struct task blocked, release;
+
+    /* The single running thread is blocked: the releasing task must run on
+     * an extra thread */
+    Reset();
+    TaskInit( &blocked, executor, 'B', RunBlocked );
+    TaskInit( &release, executor, 'R', RunRelease );
+    blocked.blocking = true;
+    assert( vlc_executor_Submit( executor, &blocked.runnable ) == VLC_SUCCESS );
+    vlc_mutex_lock( &lock );
+    while( entered < 1 )
+        vlc_cond_wait( &wait, &lock );
+    vlc_mutex_unlock( &lock );
+    assert( vlc_executor_Submit( executor, &release.runnable ) == VLC_SUCCESS );
+
+    WaitDone( 2 );
+    vlc_executor_Delete( executor );
+}
+
+static void test_blocking_limit( void )
+{
+    struct vlc_executor *executor = vlc_executor_New( 1, 1,
+                                                      VLC_THREAD_PRIORITY_LOW );
+    assert( executor != NULL );
+
+    struct task tasks[3];
+
+    Reset();
+    for( size_t i = 0; i < ARRAY_SIZE( tasks ); i++ )
+    {
+        TaskInit( &tasks[i], executor, 'B', RunBlocked );
+        tasks[i].blocking = true;
+        assert( vlc_executor_Submit( executor,
+                                     &tasks[i].runnable ) == VLC_SUCCESS );
+    }
+
+    /* One running thread, plus one extra thread for the blocked one */
+    vlc_mutex_lock( &lock );
+    while( entered < 2 )
+        vlc_cond_wait( &wait, &lock );
+    vlc_mutex_unlock( &lock );
+    msleep( CLOCK_FREQ / 10 );
+    vlc_mutex_lock( &lock );
+    assert( entered == 2 );
+    released = true;
+    vlc_cond_broadcast( &wait );
+    vlc_mutex_unlock( &lock );
+
+    /* The last task runs once a thread is unblocked */
+    WaitDone( ARRAY_SIZE( tasks ) );
+    assert( entered == ARRAY_SIZE( tasks ) );
+    vlc_executor_Delete( executor );
+}
+
+static void RunStarted( void *data )
+{
+    (void) data;
+    vlc_mutex_lock( &lock );
+    entered++;
+    TaskDone();
+    vlc_mutex_unlock( &lock );
+}
+
+static void test_blocking_starved( void )
+{
+    struct vlc_executor *executor = vlc_executor_New( 1, 1,
+                                                      VLC_THREAD_PRIORITY_LOW );
+    assert( executor != NULL );
+
+    struct task blocked[3], late;
+
+    /* More blocked tasks than running and extra threads: the third blocked
+     * task and the next one stay queued, without ever being started */
+    Reset();
+    for( size_t i = 0; i < ARRAY_SIZE( blocked ); i++ )
+    {
+        TaskInit( &blocked[i], executor, 'B', RunBlocked );
+        blocked[i].blocking = true;
+        assert( vlc_executor_Submit( executor,
+                                     &blocked[i].runnable ) == VLC_SUCCESS );
+    }
+    TaskInit( &late, executor, 'L', RunStarted );
+    assert( vlc_executor_Submit( executor, &late.runnable ) == VLC_SUCCESS );
+
+    /* A waiter must give up on its own, as input_DecoderWait() does for a
+     * decoder task that has not started */
+    mtime_t deadline = mdate() + CLOCK_FREQ / 5;
+    bool timeout = false;
+
+    vlc_mutex_lock( &lock );
+    while( entered < ARRAY_SIZE( blocked ) + 1 && !timeout )
+        timeout = vlc_cond_timedwait( &wait, &lock, deadline ) != 0;
+    assert( timeout );
+    assert( entered == 2 );
+    released = true;
+    vlc_cond_broadcast( &wait );
+    vlc_mutex_unlock( &lock );
+
+    /* Every task runs once the threads are unblocked */
+    WaitDone( ARRAY_SIZE( blocked ) + 1 );
+    assert( entered == ARRAY_SIZE( blocked ) + 1 );
+    vlc_executor_Delete( executor );
+}
+
+int main( void )
+{
+    test_init();
+
+    vlc_cond_init( &wait );
+
+    test_order();
+    test_yield();
+    test_blocking();
+    test_blocking_limit();
+    test_blocking_starved();
+
+    vlc_cond_destroy( &wait );
+    return 0;
+}
@@ -0,0 +1,231 @@
+/*****************************************************************************
+ * httpd.c: HTTP server stream fan-out load test
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Serves one MPEG-TS like stream to a swarm of local clients, checks that
+ * every client receives whole packets, that clients join and are resynced
+ * on keyframes, and reports the aggregate throughput.
+ *
+ * Usage: test_src_network_httpd [clients] [server threads]
+ */
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_atomic.h>
+#include <vlc_block.h>
+#include <vlc_httpd.h>
+
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define TEST_PORT     18080
+#define TEST_URL      "/stream.ts"
+#define TS_PACKET     188
+#define TS_PER_BLOCK  7
+#define TS_GOP        16    /* blocks between keyframes */
+#define CLIENT_BYTES  (4 * 1024 * 1024)
+
+struct client
+{
+    vlc_thread_t thread;
+    uint64_t     i_received;
+    unsigned     i_skips;
+    unsigned     i_resyncs;
+    unsigned     i_bad_resyncs; /* discontinuities not on a keyframe */
+    bool         b_ok;
+};
+
+static atomic_uint done = ATOMIC_VAR_INIT(0);
+
+static void *client_thread( void *data )
+{
+    struct client *cl = data;
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons( TEST_PORT ),
+    };
+    addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+
+    int fd = socket( AF_INET, SOCK_STREAM, 0 );
+    assert( fd != -1 );
+    if( connect( fd, (struct sockaddr *)&addr, sizeof(addr) ) )
+        goto out;
+
+    static const char req[] = "GET " TEST_URL " HTTP/1.0\r\n\r\n";
+    if( write( fd, req, sizeof(req) - 1 ) != sizeof(req) - 1 )
+        goto out;
+
+    /* skip the answer headers */
+    unsigned i_eoh = 0;
+    while( i_eoh < 4 )
+    {
+        char c;
+        if( read( fd, &c, 1 ) != 1 )
+            goto out;
+        i_eoh = ( c == "\r\n\r\n"[i_eoh] ) ? i_eoh + 1 : ( c == '\r' );
+    }
+
+    /* Clients start on a keyframe. When lagging behind, they are moved to
+     * a later keyframe, which starts with a packet with the unit start
+     * indicator set: the continuity counter must only ever jump there. In
+     * case a packet is cut short anyway, resynchronize on the next sync byte,
+     * which never appears in the payload. */
+    uint8_t buf[65536];
+    uint8_t hdr[4];
+    unsigned i_phase = 0;
+    int i_cc = -1;
+    bool b_synced = true;
+    while( cl->i_received < CLIENT_BYTES )
+    {
+        ssize_t i_read = read( fd, buf, sizeof(buf) );
+        if( i_read <= 0 )
+            goto out;
+
+        for( ssize_t i = 0; i < i_read; i++ )
+        {
+            if( i_phase == 0 && buf[i] != 0x47 )
+            {
+                if( b_synced )
+                    cl->i_skips++;
+                b_synced = false;
+                continue;
+            }
+            b_synced = true;
+            if( i_phase < sizeof(hdr) )
+                hdr[i_phase] = buf[i];
+            if( i_phase == sizeof(hdr) - 1 )
+            {
+                bool b_keyframe = hdr[1] & 0x40;
+                if( i_cc == -1 ? !b_keyframe : hdr[3] != ( ( i_cc + 1 ) & 0xf ) )
+                {
+                    cl->i_resyncs++;
+                    if( !b_keyframe )
+                        cl->i_bad_resyncs++;
+                }
+                i_cc = hdr[3];
+            }
+            i_phase = ( i_phase + 1 ) % TS_PACKET;
+        }
+        cl->i_received += i_read;
+    }
+    cl->b_ok = true;
+out:
+    close( fd );
+    atomic_fetch_add( &done, 1 );
+    return NULL;
+}
+
+int main( int argc, char **argv )
+{
+    unsigned i_clients = ( argc > 1 ) ? strtoul( argv[1], NULL, 0 ) : 64;
+    char psz_port[32], psz_threads[32];
+
+    snprintf( psz_port, sizeof(psz_port), "--http-port=%d", TEST_PORT );
+    snprintf( psz_threads, sizeof(psz_threads), "--http-threads=%s",
+              ( argc > 2 ) ? argv[2] : "0" );
+
+    test_init();
+    alarm( 60 );
+
+    const char * const args[] = {
+        "-v",
+        "--ignore-config",
+        "-I",
+        "dummy",
+        "--no-media-library",
+        "--http-host=127.0.0.1",
+        psz_port,
+        psz_threads,
+    };
+
+    libvlc_instance_t *vlc = libvlc_new( ARRAY_SIZE(args), args );
+    assert( vlc != NULL );
+
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+    httpd_host_t *host = vlc_http_HostNew( obj );
+    assert( host != NULL );
+    httpd_stream_t *stream = httpd_StreamNew( host, TEST_URL, "video/MP2T",
+                                              NULL, NULL );
+    assert( stream != NULL );
+
+    struct client *clients = calloc( i_clients, sizeof(*clients) );
+    assert( clients != NULL );
+    for( unsigned i = 0; i < i_clients; i++ )
+        assert( !vlc_clone( &clients[i].thread, client_thread, &clients[i],
+                            VLC_THREAD_PRIORITY_LOW ) );
+
+    log( "serving %u clients\n", i_clients );
+
+    block_t *block = block_Alloc( TS_PACKET * TS_PER_BLOCK );
+    assert( block != NULL );
+    memset( block->p_buffer, 0xff, block->i_buffer );
+
+    mtime_t start = mdate();
+    uint64_t i_sent = 0;
+    for( unsigned i_block = 0; atomic_load( &done ) < i_clients; i_block++ )
+    {
+        bool b_keyframe = i_block % TS_GOP == 0;
+
+        for( unsigned i = 0; i < TS_PER_BLOCK; i++ )
+        {
+            block->p_buffer[i * TS_PACKET] = 0x47;
+            block->p_buffer[i * TS_PACKET + 1] = ( b_keyframe && i == 0 ) ? 0x40 : 0;
+            block->p_buffer[i * TS_PACKET + 3] = i_sent++ & 0xf;
+        }
+        if( b_keyframe )
+            block->i_flags |= BLOCK_FLAG_TYPE_I;
+        else
+            block->i_flags &= ~BLOCK_FLAG_TYPE_I;
+        httpd_StreamSend( stream, block );
+
+        /* leave the CPU to the server every 64 kiB or so */
+        if( i_sent % ( TS_PER_BLOCK * 50 ) == 0 )
+            msleep( 1000 );
+    }
+    mtime_t elapsed = mdate() - start;
+    block_Release( block );
+
+    uint64_t i_total = 0;
+    unsigned i_skips = 0, i_resyncs = 0;
+    for( unsigned i = 0; i < i_clients; i++ )
+    {
+        vlc_join( clients[i].thread, NULL );
+        assert( clients[i].b_ok );
+        assert( clients[i].i_bad_resyncs == 0 );
+        i_total += clients[i].i_received;
+        i_skips += clients[i].i_skips;
+        i_resyncs += clients[i].i_resyncs;
+    }
+    free( clients );
+
+    log( "%"PRIu64" bytes in %"PRId64" ms: %.1f MiB/s to %u clients "
+         "(%u lagging skips, %u keyframe resyncs)\n", i_total, elapsed / 1000,
+         (double)i_total * CLOCK_FREQ / elapsed / ( 1024 * 1024 ), i_clients,
+         i_skips, i_resyncs );
+
+    httpd_StreamDelete( stream );
+    httpd_HostDelete( host );
+    libvlc_release( vlc );
+    return 0;
+}
@@ -0,0 +1,266 @@
+/*****************************************************************************
+ * httpd_file.c: HTTP server disk file and byte range test
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+
+#include <vlc_common.h>
+#include <vlc_httpd.h>
+
+#include <assert.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define TEST_PORT  18081
+#define TEST_URL   "/file.bin"
+/* larger than one send chunk, so that the file is sent in several steps */
+#define FILE_SIZE  300000
+
+static void test_parse_one( const char *psz_range, uint64_t i_size,
+                            int i_expected, uint64_t i_start, uint64_t i_end )
+{
+    uint64_t i_got_start = 0, i_got_end = 0;
+    int i_ret = httpd_ParseRange( psz_range, i_size,
+                                  &i_got_start, &i_got_end );
+
+    log( "range \"%s\" of %"PRIu64" bytes: %d\n", psz_range, i_size, i_ret );
+    if( i_expected == 0 )
+    {
+        assert( i_ret == 0 );
+        assert( i_got_start == i_start );
+        assert( i_got_end == i_end );
+    }
+    else if( i_expected > 0 )
+        assert( i_ret > 0 );
+    else
+        assert( i_ret < 0 );
+}
+
+static void test_parse( void )
+{
+    test_parse_one( "bytes=0-99", 1000, 0, 0, 100 );
+    test_parse_one( "bytes=900-", 1000, 0, 900, 1000 );
+    test_parse_one( "bytes=990-2000", 1000, 0, 990, 1000 );
+    test_parse_one( "bytes=-100", 1000, 0, 900, 1000 );
+    test_parse_one( "bytes=-2000", 1000, 0, 0, 1000 );
+    test_parse_one( "Bytes=1-2", 1000, 0, 1, 3 );
+
+    /* not satisfiable */
+    test_parse_one( "bytes=1000-", 1000, 1, 0, 0 );
+    test_parse_one( "bytes=1000-1001", 1000, 1, 0, 0 );
+    test_parse_one( "bytes=-0", 1000, 1, 0, 0 );
+    test_parse_one( "bytes=0-", 0, 1, 0, 0 );
+
+    /* ignored */
+    test_parse_one( "bytes=5-1", 1000, -1, 0, 0 );
+    test_parse_one( "bytes=0-1,5-6", 1000, -1, 0, 0 );
+    test_parse_one( "bytes=0-1x", 1000, -1, 0, 0 );
+    test_parse_one( "bytes=-", 1000, -1, 0, 0 );
+    test_parse_one( "bytes=abc", 1000, -1, 0, 0 );
+    test_parse_one( "items=0-1", 1000, -1, 0, 0 );
+}
+
+static uint8_t FileByte( uint64_t i_offset )
+{
+    return ( i_offset * 7 + ( i_offset >> 8 ) ) & 0xff;
+}
+
+struct answer
+{
+    int      i_status;
+    char     psz_range[64];
+    int64_t  i_length;
+    uint8_t *p_body;
+    size_t   i_body;
+};
+
+/* Sends one HTTP/1.0 request and reads the answer until the server closes */
+static void Request( const char *psz_method, const char *psz_range,
+                     struct answer *ans )
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons( TEST_PORT ),
+    };
+    addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+
+    int fd = socket( AF_INET, SOCK_STREAM, 0 );
+    assert( fd != -1 );
+    assert( connect( fd, (struct sockaddr *)&addr, sizeof(addr) ) == 0 );
+
+    char req[256];
+    int i_req;
+    if( psz_range != NULL )
+        i_req = snprintf( req, sizeof(req), "%s " TEST_URL " HTTP/1.0\r\n"
+                          "Range: %s\r\n\r\n", psz_method, psz_range );
+    else
+        i_req = snprintf( req, sizeof(req), "%s " TEST_URL " HTTP/1.0\r\n"
+                          "\r\n", psz_method );
+    assert( write( fd, req, i_req ) == i_req );
+
+    size_t i_size = FILE_SIZE + 4096, i_total = 0;
+    char *p_data = malloc( i_size + 1 );
+    assert( p_data != NULL );
+    for( ;; )
+    {
+        assert( i_total < i_size );
+        ssize_t i_read = read( fd, p_data + i_total, i_size - i_total );
+        assert( i_read >= 0 );
+        if( i_read == 0 )
+            break;
+        i_total += i_read;
+    }
+    close( fd );
+    p_data[i_total] = '\0';
+
+    char *psz_eoh = strstr( p_data, "\r\n\r\n" );
+    assert( psz_eoh != NULL );
+    *psz_eoh = '\0';
+    log( "%s %s:\n%s\n", psz_method, psz_range ? psz_range : "", p_data );
+
+    assert( sscanf( p_data, "HTTP/1.%*d %d", &ans->i_status ) == 1 );
+
+    const char *psz = strstr( p_data, "\r\nContent-Range: " );
+    ans->psz_range[0] = '\0';
+    if( psz != NULL )
+        sscanf( psz + 17, "%63[^\r]", ans->psz_range );
+    psz = strstr( p_data, "\r\nContent-Length: " );
+    assert( psz != NULL );
+    ans->i_length = strtoll( psz + 18, NULL, 10 );
+
+    ans->i_body = p_data + i_total - ( psz_eoh + 4 );
+    ans->p_body = malloc( ans->i_body + 1 );
+    assert( ans->p_body != NULL );
+    memcpy( ans->p_body, psz_eoh + 4, ans->i_body );
+    free( p_data );
+}
+
+static void CheckBody( const struct answer *ans, uint64_t i_start,
+                       uint64_t i_end )
+{
+    assert( ans->i_length == (int64_t)( i_end - i_start ) );
+    assert( ans->i_body == i_end - i_start );
+    for( size_t i = 0; i < ans->i_body; i++ )
+        assert( ans->p_body[i] == FileByte( i_start + i ) );
+}
+
+static void test_serve( void )
+{
+    char psz_path[] = "/tmp/vlc-httpd-file-XXXXXX";
+    int fd = mkstemp( psz_path );
+    assert( fd != -1 );
+    for( uint64_t i = 0; i < FILE_SIZE; i++ )
+    {
+        uint8_t c = FileByte( i );
+        assert( write( fd, &c, 1 ) == 1 );
+    }
+    close( fd );
+
+    char psz_port[32];
+    snprintf( psz_port, sizeof(psz_port), "--http-port=%d", TEST_PORT );
+
+    const char * const args[] = {
+        "-v",
+        "--ignore-config",
+        "-I",
+        "dummy",
+        "--no-media-library",
+        "--http-host=127.0.0.1",
+        psz_port,
+    };
+
+    libvlc_instance_t *vlc = libvlc_new( ARRAY_SIZE(args), args );
+    assert( vlc != NULL );
+
+    httpd_host_t *host = vlc_http_HostNew( VLC_OBJECT(vlc->p_libvlc_int) );
+    assert( host != NULL );
+    httpd_disk_file_t *file = httpd_DiskFileNew( host, TEST_URL, psz_path,
+                                                 "application/octet-stream",
+                                                 NULL, NULL );
+    assert( file != NULL );
+
+    struct answer ans;
+
+    /* whole file */
+    Request( "GET", NULL, &ans );
+    assert( ans.i_status == 200 );
+    assert( ans.psz_range[0] == '\0' );
+    CheckBody( &ans, 0, FILE_SIZE );
+    free( ans.p_body );
+
+    /* partial content */
+    Request( "GET", "bytes=100-199", &ans );
+    assert( ans.i_status == 206 );
+    assert( !strcmp( ans.psz_range, "bytes 100-199/300000" ) );
+    CheckBody( &ans, 100, 200 );
+    free( ans.p_body );
+
+    Request( "GET", "bytes=20000-", &ans );
+    assert( ans.i_status == 206 );
+    assert( !strcmp( ans.psz_range, "bytes 20000-299999/300000" ) );
+    CheckBody( &ans, 20000, FILE_SIZE );
+    free( ans.p_body );
+
+    Request( "GET", "bytes=-10", &ans );
+    assert( ans.i_status == 206 );
+    assert( !strcmp( ans.psz_range, "bytes 299990-299999/300000" ) );
+    CheckBody( &ans, FILE_SIZE - 10, FILE_SIZE );
+    free( ans.p_body );
+
+    /* no body for HEAD */
+    Request( "HEAD", "bytes=0-9", &ans );
+    assert( ans.i_status == 206 );
+    assert( ans.i_length == 10 );
+    assert( ans.i_body == 0 );
+    free( ans.p_body );
+
+    /* not satisfiable */
+    Request( "GET", "bytes=300000-", &ans );
+    assert( ans.i_status == 416 );
+    assert( !strcmp( ans.psz_range, "bytes */300000" ) );
+    assert( ans.i_length == 0 && ans.i_body == 0 );
+    free( ans.p_body );
+
+    /* multiple ranges are not supported: whole file */
+    Request( "GET", "bytes=0-1,5-6", &ans );
+    assert( ans.i_status == 200 );
+    CheckBody( &ans, 0, FILE_SIZE );
+    free( ans.p_body );
+
+    httpd_DiskFileDelete( file );
+    httpd_HostDelete( host );
+    libvlc_release( vlc );
+    unlink( psz_path );
+}
+
+int main( void )
+{
+    test_init();
+
+    test_parse();
+    test_serve();
+    return 0;
+}